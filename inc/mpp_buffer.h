@@ -182,6 +182,36 @@ typedef struct MppBufferInfo_t {
 
 #define BUFFER_GROUP_SIZE_DEFAULT           (SZ_1M*80)
 
+/*
+ * internal mode group keeps unused buffer for reuse. When a request can not be
+ * served by unused buffers the undersized ones may be released to allocator.
+ *
+ * MPP_BUFFER_TRIM_NONE     : never release undersized unused buffer
+ * MPP_BUFFER_TRIM_ON_MISS  : release undersized unused buffer only when no unused
+ *                            buffer fits and a new buffer will be allocated (default)
+ * MPP_BUFFER_TRIM_ALWAYS   : release undersized unused buffer on every request
+ */
+typedef enum {
+    MPP_BUFFER_TRIM_NONE,
+    MPP_BUFFER_TRIM_ON_MISS,
+    MPP_BUFFER_TRIM_ALWAYS,
+    MPP_BUFFER_TRIM_BUTT,
+} MppBufferTrimPolicy;
+
+/*
+ * buffer lock statistic for benchmark
+ *
+ * lock_count    - group / service lock acquisition count
+ * contend_count - acquisitions that found the lock held by another thread
+ *
+ * Counting is enabled by bit 0x20 of env mpp_buffer_debug which must be set
+ * before the first buffer group is created.
+ */
+typedef struct MppBufferLockStat_t {
+    RK_U32          lock_count;
+    RK_U32          contend_count;
+} MppBufferLockStat;
+
 /*
  * mpp_buffer_import_with_tag(MppBufferGroup group, MppBufferInfo *info, MppBuffer *buffer)
  *
@@ -274,6 +304,9 @@ MppBufferType mpp_buffer_group_type(MppBufferGroup group);
  * count : 0 - no limit, other - max buffer count
  */
 MPP_RET mpp_buffer_group_limit_config(MppBufferGroup group, size_t size, RK_S32 count);
+MPP_RET mpp_buffer_group_trim_config(MppBufferGroup group, MppBufferTrimPolicy policy);
+
+MPP_RET mpp_buffer_lock_stat(MppBufferLockStat *stat);
 
 #ifdef __cplusplus
 }
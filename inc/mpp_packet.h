@@ -30,6 +30,11 @@ extern "C" {
  *
  * mpp_packet_init = mpp_packet_new + mpp_packet_set_data + mpp_packet_set_size
  * mpp_packet_copy_init = mpp_packet_init + memcpy
+ *
+ * NOTE: when the source packet has MppBuffer mpp_packet_copy_init only adds a
+ *       reference to the buffer. Decoder input packet with MppBuffer will be
+ *       sent to hardware without memcpy if the parser does not need to modify
+ *       the stream.
  */
 MPP_RET mpp_packet_new(MppPacket *packet);
 MPP_RET mpp_packet_init(MppPacket *packet, void *data, size_t size);
@@ -90,6 +90,19 @@ typedef enum {
     MPP_TASK_WORK_MODE_BUTT,
 } MppTaskWorkMode;
 
+/*
+ * Mpp port poll timeout setting:
+ * MPP_POLL_BLOCK       - wait until there is a task on the port
+ * MPP_POLL_NON_BLOCK   - return immediately when there is no task
+ * positive value       - wait at most the given time in millisecond
+ */
+typedef enum {
+    MPP_POLL_BUTT       = -2,
+    MPP_POLL_BLOCK      = -1,
+    MPP_POLL_NON_BLOCK  = 0,
+    MPP_POLL_MAX        = 8000,
+} MppPollType;
+
 /*
  * MppTask is descriptor of a task which send to mpp for process
  * mpp can support different type of work mode, for example:
@@ -220,6 +233,8 @@ MPP_RET mpp_task_queue_deinit(MppTaskQueue queue);
 MppPort mpp_task_queue_get_port(MppTaskQueue queue, MppPortType type);
 
 MPP_RET mpp_port_can_dequeue(MppPort port);
+/* timeout is MPP_POLL_BLOCK / MPP_POLL_NON_BLOCK or a time in millisecond */
+MPP_RET mpp_port_poll(MppPort port, RK_S64 timeout);
 MPP_RET mpp_port_dequeue(MppPort port, MppTask *task);
 MPP_RET mpp_port_enqueue(MppPort port, MppTask task);
 
@@ -125,6 +125,48 @@ typedef struct MppEncConfig_t {
     RK_S32  cabac_en;
 } MppEncConfig;
 
+/*
+ * software isp config for MPP_CTX_ISP context and decoder output stage
+ *
+ * Isp converts yuv frame (YUV420SP / YUV420SP_VU / YUV420P / YUV422SP /
+ * YUV422SP_VU / YUV422P) to rgb frame in one pass with crop and scaling.
+ *
+ * crop_x / crop_y  - top left corner of source rectangle
+ * crop_w / crop_h  - size of source rectangle, 0 for the rest of the frame
+ * width / height   - output size, 0 for no scaling
+ * hor_stride       - output line size in byte, 0 for line size aligned to 16
+ * format           - output format, MPP_FMT_RGB565 / MPP_FMT_BGR565 /
+ *                    MPP_FMT_RGB888 / MPP_FMT_BGR888 /
+ *                    MPP_FMT_ARGB8888 / MPP_FMT_ABGR8888
+ *                    RGB888 is stored as R G B bytes and BGR888 as B G R,
+ *                    ARGB8888 / RGB565 are native 32-bit / 16-bit words with
+ *                    R on high bits and ABGR8888 / BGR565 with B on high bits
+ * scale_mode       - MppIspScaleMode
+ *
+ * Color matrix is BT.709 when source colorspace is MPP_FRAME_SPC_BT709 and
+ * BT.601 for the others, full range when source color range is
+ * MPP_FRAME_RANGE_JPEG.
+ */
+typedef enum {
+    MPP_ISP_SCALE_BILINEAR,
+    MPP_ISP_SCALE_AREA,                 /* box average, for large downscale */
+    MPP_ISP_SCALE_BUTT,
+} MppIspScaleMode;
+
+typedef struct MppIspConfig_t {
+    RK_S32  crop_x;
+    RK_S32  crop_y;
+    RK_S32  crop_w;
+    RK_S32  crop_h;
+
+    RK_S32  width;
+    RK_S32  height;
+    RK_S32  hor_stride;
+    RK_S32  format;
+
+    RK_S32  scale_mode;
+} MppIspConfig;
+
 /*
  * mpp main work function set
  * size     : MppApi structure size
@@ -140,6 +182,11 @@ typedef struct MppEncConfig_t {
  *            decoder at the same time.
  * encode   : both send video frame to encoder and get encoded video stream from
  *            encoder at the same time.
+ *            decode / encode are synchronous interface. Decoding / encoding
+ *            runs on the caller thread and they can not be mixed with the
+ *            async interface on the same context. Decode consumes the whole
+ *            packet and returns the first frame ready or NULL, the other
+ *            ready frames are returned by the following calls.
  *
  * decode_put_packet: send video stream packet to decoder only, async interface
  * decode_get_frame : get video frame from decoder only, async interface
@@ -147,6 +194,13 @@ typedef struct MppEncConfig_t {
  * encode_put_frame : send video frame to encoder only, async interface
  * encode_get_packet: get encoded video packet from encoder only, async interface
  *
+ * isp              : convert src frame to dst frame on caller thread. dst
+ *                    frame provides the buffer, its format / width / height /
+ *                    hor_stride override the context isp config when set.
+ * isp_put_frame    : send yuv frame to isp context only, async interface
+ * isp_get_frame    : get converted rgb frame from isp context only, async
+ *                    interface. Frames keep the input order.
+ *
  * advance task api set:
  *
  *
@@ -59,6 +59,9 @@ typedef enum {
     MPP_ENABLE_DEINTERLACE,
     MPP_SET_INPUT_BLOCK,
     MPP_SET_OUTPUT_BLOCK,
+    MPP_SET_INPUT_TIMEOUT,              /* parameter type RK_S64, timeout in ms, -1 for block, 0 for non-block */
+    MPP_SET_OUTPUT_TIMEOUT,             /* parameter type RK_S64, timeout in ms, -1 for block, 0 for non-block */
+    MPP_SET_WORKER_MODE,                /* parameter type RK_U32, 0 for dedicated threads, 1 for shared worker pool, set before init */
     MPP_CMD_END,
 
     MPP_CODEC_CMD_BASE                  = CMD_MODULE_CODEC,
@@ -76,6 +79,8 @@ typedef enum {
     MPP_DEC_GET_VPUMEM_USED_COUNT,
     MPP_DEC_SET_VC1_EXTRA_DATA,
     MPP_DEC_SET_OUTPUT_FORMAT,
+    MPP_DEC_SET_TASK_COUNT,             /* Need to setup before init, parameter is RK_S32 task mode (MJPEG) decoder pipeline depth */
+    MPP_DEC_SET_ISP_CFG,                /* Need to setup before init, parameter is MppIspConfig, NULL to disable, convert output frame on hal thread */
     MPP_DEC_CMD_END,
 
     MPP_ENC_CMD_BASE                    = CMD_MODULE_CODEC | CMD_CTX_ID_ENC,
@@ -94,9 +99,12 @@ typedef enum {
     MPP_ENC_SET_IDR_FRAME,
     MPP_ENC_SET_SEI_CFG,               /*SEI: Supplement Enhancemant Information, parameter is MppSeiMode */
     MPP_ENC_GET_SEI_DATA,              /*SEI: Supplement Enhancemant Information, parameter is MppPacket */
+    MPP_ENC_SET_TASK_COUNT,             /* Need to setup before init, parameter is RK_S32 encoder input and output task queue depth */
     MPP_ENC_CMD_END,
 
     MPP_ISP_CMD_BASE                    = CMD_MODULE_CODEC | CMD_CTX_ID_ISP,
+    MPP_ISP_SET_CFG,                    /* parameter is MppIspConfig */
+    MPP_ISP_GET_CFG,                    /* parameter is MppIspConfig */
     MPP_ISP_CMD_END,
 
     MPP_HAL_CMD_BASE                    = CMD_MODULE_HAL,
@@ -127,15 +127,15 @@ typedef   void (*LOG_FUN)(void *ctx, ...);
     } while (0)
 
 typedef struct bitread_ctx_t {
-    // Pointer to the next unread (not in curr_byte_) byte in the stream.
+    // Pointer to the next byte which is not loaded into cache_.
     RK_U8 *data_;
-    // Bytes left in the stream (without the curr_byte_).
+    // Bytes left in the stream (without the bytes in cache_).
     RK_U32 bytes_left_;
-    // Contents of the current byte; first unread bit starting at position
-    // 8 - num_remaining_bits_in_curr_byte_ from MSB.
-    RK_S64 curr_byte_;
-    // Number of bits remaining in curr_byte_
-    RK_S32 num_remaining_bits_in_curr_byte_;
+    // Bit cache, first unread bit is the MSB. Unused low bits are zero.
+    // Bytes in cache_ are always continuous bytes just before data_.
+    RK_U64 cache_;
+    // Number of valid bits in cache_
+    RK_S32 cache_bits_;
     // Used in emulation prevention three byte detection (see spec).
     // Initially set to 0xffff to accept all initial two-byte sequences.
     RK_S64 prev_two_bytes_;
@@ -193,6 +193,9 @@ RK_U32  mpp_has_more_rbsp_data(BitReadCtx_t * bitctx);
 //!< align bits and get current pointer
 RK_U8  *mpp_align_get_bits(BitReadCtx_t *bitctx);
 
+//!< get bits left in stream including emulation prevention bytes not reached
+RK_S32  mpp_get_bits_left(BitReadCtx_t *bitctx);
+
 #ifdef  __cplusplus
 }
 #endif
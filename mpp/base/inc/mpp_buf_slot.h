@@ -218,6 +218,22 @@ typedef enum SlotQueueType_e {
 MPP_RET mpp_buf_slot_enqueue(MppBufSlots slots, RK_S32  index, SlotQueueType type);
 MPP_RET mpp_buf_slot_dequeue(MppBufSlots slots, RK_S32 *index, SlotQueueType type);
 
+/*
+ * batched operations for hal task done, each call takes slots lock once
+ *
+ * mpp_buf_slot_clr_hal_flag
+ *      - clear SLOT_HAL_OUTPUT on output slot and SLOT_HAL_INPUT on each refer slot
+ *        negative index is skipped
+ *
+ * mpp_buf_slot_dequeue_frame
+ *      - dequeue one slot, copy its frame like get_prop SLOT_FRAME and clear
+ *        SLOT_QUEUE_USE on it
+ */
+MPP_RET mpp_buf_slot_clr_hal_flag(MppBufSlots slots, RK_S32 output,
+                                  const RK_S32 *refer, RK_S32 count);
+MPP_RET mpp_buf_slot_dequeue_frame(MppBufSlots slots, RK_S32 *index,
+                                   MppFrame *frame, SlotQueueType type);
+
 typedef enum SlotPropType_e {
     SLOT_EOS,
     SLOT_FRAME,
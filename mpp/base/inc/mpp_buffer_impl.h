@@ -20,12 +20,22 @@
 #include "mpp_list.h"
 #include "mpp_common.h"
 #include "mpp_allocator.h"
+#include "mpp_ring_log.h"
 
 #define MPP_BUF_DBG_FUNCTION            (0x00000001)
 #define MPP_BUF_DBG_OPS_RUNTIME         (0x00000002)
 #define MPP_BUF_DBG_OPS_HISTORY         (0x00000004)
 #define MPP_BUF_DBG_CLR_ON_EXIT         (0x00000008)
 #define MPP_BUF_DBG_CHECK_SIZE          (0x00000010)
+#define MPP_BUF_DBG_LOCK_STAT           (0x00000020)
+
+/*
+ * unused buffers are kept in size class lists sorted by size
+ * class 0 is for size up to 4K and each class doubles the max size
+ * the last class holds all the remaining large buffers
+ */
+#define MPP_BUFFER_SIZE_CLASS_SHIFT     12
+#define MPP_BUFFER_SIZE_CLASS_COUNT     16
 
 #define mpp_buf_dbg(flag, fmt, ...)     _mpp_dbg(mpp_buffer_debug, flag, fmt, ## __VA_ARGS__)
 #define mpp_buf_dbg_f(flag, fmt, ...)   _mpp_dbg_f(mpp_buffer_debug, flag, fmt, ## __VA_ARGS__)
@@ -77,10 +87,14 @@ struct MppBufferGroupImpl_t {
     RK_S32              buffer_count;
     RK_S32              count_used;
     RK_S32              count_unused;
+    MppBufferTrimPolicy trim_policy;
 
     MppAllocator        allocator;
     MppAllocatorApi     *alloc_api;
 
+    // Mutex protecting buffer lists, counters and logs of this group
+    void                *lock;
+
     // thread that will be signal on buffer return
     void                *listener;
 
@@ -92,15 +106,14 @@ struct MppBufferGroupImpl_t {
     // buffer log function
     RK_U32              log_runtime_en;
     RK_U32              log_history_en;
-    RK_U32              log_count;
-    struct list_head    list_logs;
+    MppRingLog          logs;
 
     // link to the other MppBufferGroupImpl
     struct list_head    list_group;
 
     // link to list_status in MppBufferImpl
     struct list_head    list_used;
-    struct list_head    list_unused;
+    struct list_head    list_unused[MPP_BUFFER_SIZE_CLASS_COUNT];
 };
 
 #ifdef __cplusplus
@@ -145,6 +158,7 @@ MPP_RET mpp_buffer_group_set_listener(MppBufferGroupImpl *p, void *listener);
 // mpp_buffer_group helper function
 void mpp_buffer_group_dump(MppBufferGroupImpl *p);
 void mpp_buffer_service_dump();
+void mpp_buffer_service_lock_stat(RK_U32 *lock_count, RK_U32 *contend_count);
 MppBufferGroupImpl *mpp_buffer_get_misc_group(MppBufferMode mode, MppBufferType type);
 
 #ifdef __cplusplus
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_PS_CACHE_H__
+#define __MPP_PS_CACHE_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+/*
+ * raw nal cache for parameter set repeat detection
+ *
+ * The decoder keeps one cache entry per parameter set id holding the raw
+ * nal the stored parameter set was parsed from. A new parameter set nal is
+ * looked up by length and fingerprint first and confirmed by memcmp, so a
+ * repeated parameter set is found before parsing without any allocation.
+ *
+ * mpp_ps_cache_hash   - fingerprint of the raw nal
+ * mpp_ps_cache_find   - return the index of the entry holding the same nal
+ *                       in an array of count entries, or -1 when not found
+ * mpp_ps_cache_update - save the nal to the entry, buffer only grows
+ * mpp_ps_cache_clear  - invalidate the entry and keep its buffer
+ * mpp_ps_cache_deinit - release the buffers of count entries
+ */
+typedef struct MppPsCache_t {
+    RK_U8   *data;
+    RK_S32  len;
+    RK_S32  size;
+    RK_U32  hash;
+} MppPsCache;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+RK_U32  mpp_ps_cache_hash(const RK_U8 *buf, RK_S32 len);
+RK_S32  mpp_ps_cache_find(MppPsCache *cache, RK_S32 count, const RK_U8 *buf, RK_S32 len, RK_U32 hash);
+MPP_RET mpp_ps_cache_update(MppPsCache *cache, const RK_U8 *buf, RK_S32 len, RK_U32 hash);
+void    mpp_ps_cache_clear(MppPsCache *cache);
+void    mpp_ps_cache_deinit(MppPsCache *cache, RK_S32 count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_PS_CACHE_H__*/
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_SPLIT_H__
+#define __MPP_SPLIT_H__
+
+#include "rk_mpi.h"
+
+/*
+ * elementary stream splitter
+ *
+ * The splitter gathers input data of any size into complete frames. For
+ * start code based streams it scans for start codes with mpp_find_startcode
+ * and applies the access unit boundary rule of the coding type on each start
+ * code found. VP8 is split by IVF frame header with the IVF headers removed
+ * from output and MJPEG is split by SOI / EOI marker.
+ * Each input byte is scanned only once.
+ *
+ * supported coding: H.264, H.265, MPEG-2, VP8 (IVF), MJPEG
+ *
+ * mpp_split_frame - feed data and return the consumed size. When a frame is
+ *                   complete *out and *out_size are set to the frame data,
+ *                   otherwise *out_size is zero and more data is required.
+ *                   On eos the remaining data is returned as the last frame.
+ * mpp_split_get_pts / dts - timestamp of the last frame returned
+ */
+typedef void* MppSplit;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_split_init(MppSplit *split, MppCodingType coding);
+MPP_RET mpp_split_deinit(MppSplit split);
+MPP_RET mpp_split_reset(MppSplit split);
+
+void    mpp_split_set_eos(MppSplit split, RK_U32 eos);
+RK_S32  mpp_split_frame(MppSplit split, const RK_U8 **out, RK_S32 *out_size,
+                        const RK_U8 *buf, RK_S32 size, RK_S64 pts, RK_S64 dts);
+RK_S64  mpp_split_get_pts(MppSplit split);
+RK_S64  mpp_split_get_dts(MppSplit split);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_SPLIT_H__*/
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_STARTCODE_H__
+#define __MPP_STARTCODE_H__
+
+#include "rk_type.h"
+
+/*
+ * start code (00 00 01) scanner shared by the annex-b stream parsers
+ *
+ * The scanner skips a whole block of bytes at a time when the block has no
+ * zero byte. The block check uses SSE2 / NEON when available and a 64bit
+ * word test otherwise.
+ *
+ * mpp_find_startcode  - return the offset of the first byte of the first
+ *                       00 00 01 in buf, or -1 when there is no start code
+ * mpp_find_startcodes - store the offsets of up to max start codes in pos
+ *                       and return the number of start codes found
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 len);
+RK_S32 mpp_find_startcodes(const RK_U8 *buf, RK_S32 len, RK_S32 *pos, RK_S32 max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_STARTCODE_H__*/
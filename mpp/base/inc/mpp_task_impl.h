@@ -61,7 +61,6 @@ typedef enum MppTaskStatus_e {
 
 typedef struct MppTaskImpl_t {
     const char          *name;
-    struct list_head    list;
     MppTaskQueue        *queue;
     RK_S32              index;
     MppTaskStatus       status;
@@ -21,35 +21,197 @@
 #include "mpp_mem.h"
 #include "mpp_bitread.h"
 
+#define BITREAD_BYTES_MASK(n)   (~0ULL << (64 - (n) * 8))
+#define BITREAD_HAS_ZERO(x)     (((x) - 0x0101010101010101ULL) & ~(x) & 0x8080808080808080ULL)
+
 static void log_info(void *ctx, ...)
 {
     (void)ctx;
 }
 
-static MPP_RET update_curbyte(BitReadCtx_t *bitctx)
+static RK_S32 bitread_clz64(RK_U64 val)
 {
-    if (bitctx->bytes_left_ < 1)
-        return  MPP_ERR_READ_BIT;
+#if defined(__GNUC__)
+    return __builtin_clzll(val);
+#else
+    RK_S32 n = 0;
+
+    while (!(val & (1ULL << 63))) {
+        val <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/*
+ * slow refill with emulation prevention detection byte by byte
+ * To keep bytes in cache continuous in the stream the 0x03 byte is only
+ * skipped when the cache is empty, otherwise refill stops before it.
+ */
+static void refill_cache_slow(BitReadCtx_t *bitctx)
+{
+    while (bitctx->cache_bits_ <= 56 && bitctx->bytes_left_) {
+        RK_U64 byte = *bitctx->data_;
 
-    // Emulation prevention three-byte detection.
-    // If a sequence of 0x000003 is found, skip (ignore) the last byte (0x03).
-    if (bitctx->need_prevention_detection
-        && (*bitctx->data_ == 0x03)
-        && ((bitctx->prev_two_bytes_ & 0xffff) == 0)) {
-        // Detected 0x000003, skip last byte.
+        // Emulation prevention three-byte detection.
+        // If a sequence of 0x000003 is found, skip (ignore) the last byte (0x03).
+        if (bitctx->need_prevention_detection && byte == 0x03 &&
+            (bitctx->prev_two_bytes_ & 0xffff) == 0) {
+            if (bitctx->cache_bits_)
+                break;
+
+            // Detected 0x000003, skip last byte.
+            ++bitctx->data_;
+            --bitctx->bytes_left_;
+            ++bitctx->emulation_prevention_bytes_;
+            // Need another full three bytes before we can detect the sequence again.
+            bitctx->prev_two_bytes_ = 0xffff;
+            continue;
+        }
+
+        bitctx->cache_ |= byte << (56 - bitctx->cache_bits_);
+        bitctx->cache_bits_ += 8;
+        bitctx->prev_two_bytes_ = (bitctx->prev_two_bytes_ << 8) | byte;
         ++bitctx->data_;
         --bitctx->bytes_left_;
-        ++bitctx->emulation_prevention_bytes_;
-        // Need another full three bytes before we can detect the sequence again.
-        bitctx->prev_two_bytes_ = 0xffff;
-        if (bitctx->bytes_left_ < 1)
-            return  MPP_ERR_READ_BIT;
     }
-    // Load a new byte and advance pointers.
-    bitctx->curr_byte_ = *bitctx->data_++ & 0xff;
-    --bitctx->bytes_left_;
-    bitctx->num_remaining_bits_in_curr_byte_ = 8;
-    bitctx->prev_two_bytes_ = (bitctx->prev_two_bytes_ << 8) | bitctx->curr_byte_;
+}
+
+/*
+ * load as many whole bytes as possible into cache with one 64bit word
+ * When emulation prevention detection is on and there is no 0x03 byte in
+ * the word the whole word can be taken directly.
+ */
+static void refill_cache(BitReadCtx_t *bitctx)
+{
+    RK_S32 bits = bitctx->cache_bits_;
+    RK_U32 count = (64 - bits) >> 3;
+    RK_U8 *p = bitctx->data_;
+    RK_U64 word = 0;
+    RK_U32 i;
+
+    if (count > bitctx->bytes_left_)
+        count = bitctx->bytes_left_;
+    if (!count)
+        return;
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    if (bitctx->bytes_left_ >= 8) {
+        memcpy(&word, p, sizeof(word));
+        word = __builtin_bswap64(word) & BITREAD_BYTES_MASK(count);
+    } else
+#endif
+    {
+        for (i = 0; i < count; i++)
+            word |= (RK_U64)p[i] << (56 - i * 8);
+    }
+
+    if (bitctx->need_prevention_detection) {
+        RK_U64 check = (word ^ 0x0303030303030303ULL) | ~BITREAD_BYTES_MASK(count);
+
+        if (BITREAD_HAS_ZERO(check)) {
+            refill_cache_slow(bitctx);
+            return;
+        }
+
+        if (count >= 2)
+            bitctx->prev_two_bytes_ = (word >> (64 - count * 8)) & 0xffff;
+        else
+            bitctx->prev_two_bytes_ = (bitctx->prev_two_bytes_ << 8) | p[0];
+    }
+
+    bitctx->cache_ |= word >> bits;
+    bitctx->cache_bits_ += count * 8;
+    bitctx->data_ += count;
+    bitctx->bytes_left_ -= count;
+}
+
+static void skip_cache(BitReadCtx_t *bitctx, RK_S32 num_bits)
+{
+    // num_bits is less than 64 and not larger than cache_bits_
+    bitctx->cache_ <<= num_bits;
+    bitctx->cache_bits_ -= num_bits;
+    bitctx->used_bits += num_bits;
+}
+
+/*
+ * read across emulation prevention byte or the end of stream
+ * num_bits is not larger than 32
+ */
+static MPP_RET read_bits_slow(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
+{
+    RK_U64 val = 0;
+
+    while (num_bits) {
+        RK_S32 take;
+
+        if (!bitctx->cache_bits_) {
+            refill_cache(bitctx);
+            if (!bitctx->cache_bits_)
+                return MPP_ERR_READ_BIT;
+        }
+
+        take = MPP_MIN(num_bits, bitctx->cache_bits_);
+        val = (val << take) | (bitctx->cache_ >> (64 - take));
+        skip_cache(bitctx, take);
+        num_bits -= take;
+    }
+
+    *out = (RK_U32)val;
+    return MPP_OK;
+}
+
+static MPP_RET read_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
+{
+    if (!num_bits) {
+        *out = 0;
+        return MPP_OK;
+    }
+
+    if (bitctx->cache_bits_ < num_bits) {
+        refill_cache(bitctx);
+        if (bitctx->cache_bits_ < num_bits)
+            return read_bits_slow(bitctx, num_bits, out);
+    }
+
+    *out = (RK_U32)(bitctx->cache_ >> (64 - num_bits));
+    skip_cache(bitctx, num_bits);
+
+    return MPP_OK;
+}
+
+static MPP_RET show_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
+{
+    if (!num_bits) {
+        *out = 0;
+        return MPP_OK;
+    }
+
+    if (bitctx->cache_bits_ < num_bits) {
+        refill_cache(bitctx);
+        if (bitctx->cache_bits_ < num_bits) {
+            BitReadCtx_t tmp_ctx = *bitctx;
+            return read_bits_slow(&tmp_ctx, num_bits, out);
+        }
+    }
+
+    *out = (RK_U32)(bitctx->cache_ >> (64 - num_bits));
+
+    return MPP_OK;
+}
+
+static MPP_RET skip_bits(BitReadCtx_t *bitctx, RK_S32 num_bits)
+{
+    if (bitctx->cache_bits_ < num_bits) {
+        refill_cache(bitctx);
+        if (bitctx->cache_bits_ < num_bits) {
+            RK_U32 val;
+            return read_bits_slow(bitctx, num_bits, &val);
+        }
+    }
+
+    skip_cache(bitctx, num_bits);
 
     return MPP_OK;
 }
@@ -64,25 +226,12 @@ static MPP_RET update_curbyte(BitReadCtx_t *bitctx)
 */
 MPP_RET mpp_read_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 {
-    RK_S32 bits_left = num_bits;
     *out = 0;
-    if (num_bits > 31) {
+    if (num_bits > 31 || num_bits < 0) {
         return  MPP_ERR_READ_BIT;
     }
-    while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
-        // Take all that's left in current byte, shift to make space for the rest.
-        *out |= (bitctx->curr_byte_ << (bits_left - bitctx->num_remaining_bits_in_curr_byte_));
-        bits_left -= bitctx->num_remaining_bits_in_curr_byte_;
-        if (update_curbyte(bitctx)) {
-            return  MPP_ERR_READ_BIT;
-        }
-    }
-    *out |= (bitctx->curr_byte_ >> (bitctx->num_remaining_bits_in_curr_byte_ - bits_left));
-    *out &= ((1 << num_bits) - 1);
-    bitctx->num_remaining_bits_in_curr_byte_ -= bits_left;
-    bitctx->used_bits += num_bits;
 
-    return MPP_OK;
+    return read_bits(bitctx, num_bits, (RK_U32 *)out);
 }
 /*!
 ***********************************************************************
@@ -92,39 +241,32 @@ MPP_RET mpp_read_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 */
 MPP_RET mpp_read_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
 {
-    RK_S32 val = 0, val1 = 0;
-    if (mpp_read_bits(bitctx, 16, &val)) {
+    if (num_bits > 32 || num_bits < 0) {
         return  MPP_ERR_READ_BIT;
     }
-    if (mpp_read_bits(bitctx, (num_bits - 16), &val1)) {
-        return  MPP_ERR_READ_BIT;
-    }
-    val = val << 16;
-    *out = (RK_U32)(val | val1);
 
-    return MPP_OK;
+    return read_bits(bitctx, num_bits, out);
 }
 /*!
 ***********************************************************************
 * \brief
-*   skip bits (0 - 31)
+*   skip bits (0 - any), skipped in 32 bits chunks
 ***********************************************************************
 */
 MPP_RET mpp_skip_bits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 {
-    RK_S32 bits_left = num_bits;
+    if (num_bits < 0) {
+        return  MPP_ERR_READ_BIT;
+    }
 
-    while (bitctx->num_remaining_bits_in_curr_byte_ < bits_left) {
-        // Take all that's left in current byte, shift to make space for the rest.
-        bits_left -= bitctx->num_remaining_bits_in_curr_byte_;
-        if (update_curbyte(bitctx)) {
+    while (num_bits > 32) {
+        if (skip_bits(bitctx, 32)) {
             return  MPP_ERR_READ_BIT;
         }
+        num_bits -= 32;
     }
-    bitctx->num_remaining_bits_in_curr_byte_ -= bits_left;
-    bitctx->used_bits += num_bits;
 
-    return MPP_OK;
+    return skip_bits(bitctx, num_bits);
 }
 /*!
 ***********************************************************************
@@ -134,13 +276,11 @@ MPP_RET mpp_skip_bits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 */
 MPP_RET mpp_skip_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 {
-    if (mpp_skip_bits(bitctx, 16)) {
-        return  MPP_ERR_READ_BIT;
-    }
-    if (mpp_skip_bits(bitctx, (num_bits - 16))) {
+    if (num_bits > 32 || num_bits < 0) {
         return  MPP_ERR_READ_BIT;
     }
-    return MPP_OK;
+
+    return skip_bits(bitctx, num_bits);
 }
 /*!
 ***********************************************************************
@@ -150,15 +290,12 @@ MPP_RET mpp_skip_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits)
 */
 MPP_RET mpp_show_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 {
-    MPP_RET ret = MPP_ERR_UNKNOW;
-    BitReadCtx_t tmp_ctx = *bitctx;
-    if (num_bits <= 31)
-        ret = mpp_read_bits(bitctx, num_bits, out);
-    else
-        ret = mpp_read_longbits(bitctx, num_bits, (RK_U32*)out);
-    memcpy(bitctx, &tmp_ctx, sizeof(BitReadCtx_t));
-
-    return ret;
+    *out = 0;
+    if (num_bits > 32 || num_bits < 0) {
+        return  MPP_ERR_READ_BIT;
+    }
+
+    return show_bits(bitctx, num_bits, (RK_U32 *)out);
 }
 /*!
 ***********************************************************************
@@ -168,25 +305,41 @@ MPP_RET mpp_show_bits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_S32 *out)
 */
 MPP_RET mpp_show_longbits(BitReadCtx_t *bitctx, RK_S32 num_bits, RK_U32 *out)
 {
-    MPP_RET ret = MPP_ERR_UNKNOW;
-    BitReadCtx_t tmp_ctx = *bitctx;
-
-    ret = mpp_read_longbits(bitctx, num_bits, out);
-    memcpy(bitctx, &tmp_ctx, sizeof(BitReadCtx_t));
+    *out = 0;
+    if (num_bits > 32 || num_bits < 0) {
+        return  MPP_ERR_READ_BIT;
+    }
 
-    return ret;
+    return show_bits(bitctx, num_bits, out);
 }
 /*!
 ***********************************************************************
 * \brief
 *   read unsigned data
+*   the leading zero bits are counted on cache directly, the code with
+*   up to 31 leading zeros takes at most 63 bits and can be read at once
 ***********************************************************************
 */
 MPP_RET mpp_read_ue(BitReadCtx_t *bitctx, RK_U32 *val)
 {
     RK_S32 num_bits = -1;
     RK_S32 bit;
-    RK_S32 rest;
+    RK_U32 rest;
+
+    if (bitctx->cache_bits_ < 32)
+        refill_cache(bitctx);
+
+    if (bitctx->cache_) {
+        RK_S32 zeros = bitread_clz64(bitctx->cache_);
+        RK_S32 len = zeros * 2 + 1;
+
+        if (zeros < 32 && len <= bitctx->cache_bits_) {
+            *val = (RK_U32)(bitctx->cache_ >> (64 - len)) - 1;
+            skip_cache(bitctx, len);
+            return MPP_OK;
+        }
+    }
+
     // Count the number of contiguous zero bits.
     do {
         if (mpp_read_bits(bitctx, 1, &bit)) {
@@ -200,7 +353,7 @@ MPP_RET mpp_read_ue(BitReadCtx_t *bitctx, RK_U32 *val)
     // Calculate exp-Golomb code value of size num_bits.
     *val = (1 << num_bits) - 1;
     if (num_bits > 0) {
-        if (mpp_read_bits(bitctx, num_bits, &rest)) {
+        if (read_bits(bitctx, num_bits, &rest)) {
             return  MPP_ERR_READ_BIT;
         }
         *val += rest;
@@ -217,15 +370,16 @@ MPP_RET mpp_read_ue(BitReadCtx_t *bitctx, RK_U32 *val)
 MPP_RET mpp_read_se(BitReadCtx_t *bitctx, RK_S32 *val)
 {
     RK_U32 ue;
+    RK_S32 abs;
 
     if (mpp_read_ue(bitctx, &ue)) {
         return  MPP_ERR_READ_BIT;
     }
-    if (ue % 2 == 0) { // odd
-        *val = -(RK_S32)(ue >> 1);
-    } else {
-        *val = (RK_S32)((ue >> 1) + 1);
-    }
+
+    // odd for positive and even for negative
+    abs = (RK_S32)((ue >> 1) + (ue & 1));
+    *val = (ue & 1) ? abs : -abs;
+
     return MPP_OK;
 }
 
@@ -237,18 +391,24 @@ MPP_RET mpp_read_se(BitReadCtx_t *bitctx, RK_S32 *val)
 */
 RK_U32 mpp_has_more_rbsp_data(BitReadCtx_t *bitctx)
 {
-    // Make sure we have more bits, if we are at 0 bits in current byte
-    // and updating current byte fails, we don't have more data anyway.
-    if (bitctx->num_remaining_bits_in_curr_byte_ == 0 && update_curbyte(bitctx))
+    RK_S32 bits_left = mpp_get_bits_left(bitctx);
+    RK_S32 bits_in_byte;
+    RK_U32 val;
+
+    // no more bits at all
+    if (bits_left <= 0)
         return 0;
     // On last byte?
-    if (bitctx->bytes_left_)
+    bits_in_byte = (bits_left & 7) ? (bits_left & 7) : 8;
+    if (bits_left > bits_in_byte)
         return 1;
     // Last byte, look for stop bit;
     // We have more RBSP data if the last non-zero bit we find is not the
     // first available bit.
-    return (bitctx->curr_byte_ &
-            ((1 << (bitctx->num_remaining_bits_in_curr_byte_ - 1)) - 1)) != 0;
+    if (show_bits(bitctx, bits_in_byte, &val))
+        return 0;
+
+    return (val & ((1 << (bits_in_byte - 1)) - 1)) != 0;
 }
 /*!
 ***********************************************************************
@@ -261,7 +421,8 @@ void mpp_set_bitread_ctx(BitReadCtx_t *bitctx, RK_U8 *data, RK_S32 size)
     memset(bitctx, 0, sizeof(BitReadCtx_t));
     bitctx->data_ = data;
     bitctx->bytes_left_ = size;
-    bitctx->num_remaining_bits_in_curr_byte_ = 0;
+    bitctx->cache_ = 0;
+    bitctx->cache_bits_ = 0;
     // Initially set to 0xffff to accept all initial two-byte sequences.
     bitctx->prev_two_bytes_ = 0xffff;
     bitctx->emulation_prevention_bytes_ = 0;
@@ -286,22 +447,51 @@ void mpp_set_pre_detection(BitReadCtx_t *bitctx)
 ***********************************************************************
 * \brief
 *   align data and get current point
+*   the whole bytes in cache are given back to stream so that data_ points
+*   to the next unread byte
 ***********************************************************************
 */
 RK_U8 *mpp_align_get_bits(BitReadCtx_t *bitctx)
 {
-    int n = bitctx->num_remaining_bits_in_curr_byte_;
+    RK_S32 n = bitctx->cache_bits_ & 7;
+    RK_U32 bytes;
+
     if (n)
-        mpp_skip_bits(bitctx, n);
+        skip_cache(bitctx, n);
+
+    bytes = bitctx->cache_bits_ >> 3;
+    if (bytes) {
+        bitctx->data_ -= bytes;
+        bitctx->bytes_left_ += bytes;
+        bitctx->cache_ = 0;
+        bitctx->cache_bits_ = 0;
+        bitctx->prev_two_bytes_ = 0xffff;
+        if (bitctx->data_ - bitctx->buf >= 2)
+            bitctx->prev_two_bytes_ = (bitctx->data_[-2] << 8) | bitctx->data_[-1];
+    }
+
     return bitctx->data_;
 }
 /*!
 ***********************************************************************
 * \brief
+*   get bits left in stream
+***********************************************************************
+*/
+RK_S32 mpp_get_bits_left(BitReadCtx_t *bitctx)
+{
+    return bitctx->bytes_left_ * 8 + bitctx->cache_bits_;
+}
+/*!
+***********************************************************************
+* \brief
 *   get current data value
 ***********************************************************************
 */
 RK_U8 mpp_get_curdata_value(BitReadCtx_t *bitctx)
 {
+    if (bitctx->cache_bits_ >= 8)
+        return (RK_U8)(bitctx->cache_ >> 56);
+
     return (*bitctx->data_);
 }
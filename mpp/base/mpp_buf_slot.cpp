@@ -23,6 +23,8 @@
 #include "mpp_env.h"
 #include "mpp_list.h"
 #include "mpp_common.h"
+#include "mpp_atomic.h"
+#include "mpp_ring_log.h"
 
 #include "mpp_frame_impl.h"
 #include "mpp_buf_slot.h"
@@ -216,9 +218,11 @@ struct MppBufSlotsImpl_t {
 
     // list for display
     struct list_head    queue[QUEUE_BUTT];
+    // non-zero when queue is not empty, written with lock and read without lock
+    RK_S32              queue_ready[QUEUE_BUTT];
 
-    // list for log
-    mpp_list            *logs;
+    // operation history
+    MppRingLog          logs;
 
     MppBufSlotEntry     *slots;
 };
@@ -268,6 +272,16 @@ static void generate_info_set(MppBufSlotsImpl *impl, MppFrame frame, RK_U32 forc
 
 #define dump_slots(...) _dump_slots(__FUNCTION__, ## __VA_ARGS__)
 
+static void dump_slot_log(void *ctx, MppRingLogInfo *info, void *entry)
+{
+    MppBufSlotLog *log = (MppBufSlotLog *)entry;
+
+    (void)ctx;
+    mpp_log("%lld tid %5d index %2d op: %s status in %08x out %08x",
+            info->time, info->tid, log->index, op_string[log->ops],
+            log->status_in.val, log->status_out.val);
+}
+
 static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
 {
     RK_S32 i;
@@ -286,22 +300,15 @@ static void _dump_slots(const char *caller, MppBufSlotsImpl *impl)
 
     mpp_log("\nslot operation history:\n\n");
 
-    mpp_list *logs = impl->logs;
-    if (logs) {
-        while (logs->list_size()) {
-            MppBufSlotLog log;
-            logs->del_at_head(&log, sizeof(log));
-            mpp_log("index %2d op: %s status in %08x out %08x",
-                    log.index, op_string[log.ops], log.status_in.val, log.status_out.val);
-        }
-    }
+    if (impl->logs)
+        mpp_ring_log_dump(impl->logs, dump_slot_log, NULL);
 
     mpp_assert(0);
 
     return;
 }
 
-static void add_slot_log(mpp_list *logs, RK_S32 index, MppBufSlotOps op, SlotStatus before, SlotStatus after)
+static void add_slot_log(MppRingLog logs, RK_S32 index, MppBufSlotOps op, SlotStatus before, SlotStatus after)
 {
     if (logs) {
         MppBufSlotLog log = {
@@ -310,9 +317,7 @@ static void add_slot_log(mpp_list *logs, RK_S32 index, MppBufSlotOps op, SlotSta
             before,
             after,
         };
-        if (logs->list_size() >= SLOT_OPS_MAX_COUNT)
-            logs->del_at_head(NULL, sizeof(log));
-        logs->add_at_tail(&log, sizeof(log));
+        mpp_ring_log_add(logs, &log);
     }
 }
 
@@ -457,6 +462,24 @@ static void check_entry_unused(MppBufSlotsImpl *impl, MppBufSlotEntry *entry)
     }
 }
 
+static void update_queue_ready(MppBufSlotsImpl *impl)
+{
+    for (RK_U32 i = 0; i < MPP_ARRAY_ELEMS(impl->queue); i++)
+        MPP_ATOMIC_STORE(&impl->queue_ready[i], !list_empty(&impl->queue[i]));
+}
+
+static void slot_clr_flag(MppBufSlotsImpl *impl, RK_S32 index, SlotUsageType type)
+{
+    slot_assert(impl, (index >= 0) && (index < impl->buf_count));
+    MppBufSlotEntry *slot = &impl->slots[index];
+    slot_ops_with_log(impl, slot, clr_flag_op[type], NULL);
+
+    if (type == SLOT_HAL_OUTPUT)
+        impl->decode_count++;
+
+    check_entry_unused(impl, slot);
+}
+
 static void clear_slots_impl(MppBufSlotsImpl *impl)
 {
     for (RK_U32 i = 0; i < MPP_ARRAY_ELEMS(impl->queue); i++) {
@@ -465,9 +488,11 @@ static void clear_slots_impl(MppBufSlotsImpl *impl)
     MppBufSlotEntry *slot = (MppBufSlotEntry *)impl->slots;
     RK_S32 i;
     for (i = 0; i < impl->buf_count; i++, slot++) {
-        if (slot->status.on_used)
+        // history is not consumed by dump so dump once for all slots
+        if (slot->status.on_used) {
             dump_slots(impl);
-        mpp_assert(!slot->status.on_used);
+            break;
+        }
     }
 
     if (impl->info)
@@ -477,7 +502,7 @@ static void clear_slots_impl(MppBufSlotsImpl *impl)
         mpp_frame_deinit(&impl->info_set);
 
     if (impl->logs)
-        delete impl->logs;
+        mpp_ring_log_deinit(impl->logs);
 
     if (impl->lock)
         delete impl->lock;
@@ -501,7 +526,7 @@ MPP_RET mpp_buf_slot_init(MppBufSlots *slots)
     mpp_env_get_u32("buf_slot_debug", &buf_slot_debug, BUF_SLOT_DBG_OPS_HISTORY);
 
     do {
-        impl->lock = new Mutex();
+        impl->lock = new Mutex(MPP_MUTEX_ADAPTIVE);
         if (NULL == impl->lock)
             break;
 
@@ -510,8 +535,7 @@ MPP_RET mpp_buf_slot_init(MppBufSlots *slots)
         }
 
         if (buf_slot_debug & BUF_SLOT_DBG_OPS_HISTORY) {
-            impl->logs = new mpp_list(NULL);
-            if (NULL == impl->logs)
+            if (mpp_ring_log_init(&impl->logs, sizeof(MppBufSlotLog), SLOT_OPS_MAX_COUNT))
                 break;
         }
 
@@ -587,8 +611,7 @@ RK_U32 mpp_buf_slot_is_changed(MppBufSlots slots)
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    return impl->info_changed;
+    return MPP_ATOMIC_LOAD(&impl->info_changed);
 }
 
 MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
@@ -615,12 +638,9 @@ MPP_RET mpp_buf_slot_ready(MppBufSlots slots)
     mpp_frame_copy(impl->info, impl->info_set);
     impl->buf_size = mpp_frame_get_buf_size(impl->info);
 
-    if (impl->logs) {
-        mpp_list *logs = impl->logs;
-        while (logs->list_size())
-            logs->del_at_head(NULL, sizeof(MppBufSlotLog));
-    }
-    impl->info_changed  = 0;
+    if (impl->logs)
+        mpp_ring_log_reset(impl->logs);
+    MPP_ATOMIC_STORE(&impl->info_changed, 0);
     return MPP_OK;
 }
 
@@ -705,14 +725,27 @@ MPP_RET mpp_buf_slot_clr_flag(MppBufSlots slots, RK_S32 index, SlotUsageType typ
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
     AutoMutex auto_lock(impl->lock);
-    slot_assert(impl, (index >= 0) && (index < impl->buf_count));
-    MppBufSlotEntry *slot = &impl->slots[index];
-    slot_ops_with_log(impl, slot, clr_flag_op[type], NULL);
+    slot_clr_flag(impl, index, type);
+    return MPP_OK;
+}
 
-    if (type == SLOT_HAL_OUTPUT)
-        impl->decode_count++;
+MPP_RET mpp_buf_slot_clr_hal_flag(MppBufSlots slots, RK_S32 output,
+                                  const RK_S32 *refer, RK_S32 count)
+{
+    if (NULL == slots || (count && NULL == refer)) {
+        mpp_err_f("found invalid input slots %p refer %p count %d\n", slots, refer, count);
+        return MPP_ERR_NULL_PTR;
+    }
 
-    check_entry_unused(impl, slot);
+    MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
+    AutoMutex auto_lock(impl->lock);
+    if (output >= 0)
+        slot_clr_flag(impl, output, SLOT_HAL_OUTPUT);
+
+    for (RK_S32 i = 0; i < count; i++) {
+        if (refer[i] >= 0)
+            slot_clr_flag(impl, refer[i], SLOT_HAL_INPUT);
+    }
     return MPP_OK;
 }
 
@@ -732,9 +765,28 @@ MPP_RET mpp_buf_slot_enqueue(MppBufSlots slots, RK_S32 index, SlotQueueType type
     // add slot to display list
     list_del_init(&slot->list);
     list_add_tail(&slot->list, &impl->queue[type]);
+    update_queue_ready(impl);
     return MPP_OK;
 }
 
+static MppBufSlotEntry *slot_dequeue(MppBufSlotsImpl *impl, SlotQueueType type)
+{
+    if (list_empty(&impl->queue[type]))
+        return NULL;
+
+    MppBufSlotEntry *slot = list_entry(impl->queue[type].next, MppBufSlotEntry, list);
+    if (slot->status.not_ready)
+        return NULL;
+
+    // make sure that this slot is just the next display slot
+    list_del_init(&slot->list);
+    update_queue_ready(impl);
+    slot_assert(impl, slot->index < impl->buf_count);
+    slot_ops_with_log(impl, slot, SLOT_DEQUEUE, NULL);
+    impl->display_count++;
+    return slot;
+}
+
 MPP_RET mpp_buf_slot_dequeue(MppBufSlots slots, RK_S32 *index, SlotQueueType type)
 {
     if (NULL == slots || NULL == index) {
@@ -743,21 +795,47 @@ MPP_RET mpp_buf_slot_dequeue(MppBufSlots slots, RK_S32 *index, SlotQueueType typ
     }
 
     MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
-    AutoMutex auto_lock(impl->lock);
-    if (list_empty(&impl->queue[type]))
+    // empty queue is checked without lock, enqueue racing with it is taken next time
+    if (!MPP_ATOMIC_LOAD(&impl->queue_ready[type]))
         return MPP_NOK;
 
-    MppBufSlotEntry *slot = list_entry(impl->queue[type].next, MppBufSlotEntry, list);
-    if (slot->status.not_ready)
+    AutoMutex auto_lock(impl->lock);
+    MppBufSlotEntry *slot = slot_dequeue(impl, type);
+    if (NULL == slot)
         return MPP_NOK;
 
-    // make sure that this slot is just the next display slot
-    list_del_init(&slot->list);
-    slot_assert(impl, slot->index < impl->buf_count);
-    slot_ops_with_log(impl, slot, SLOT_DEQUEUE, NULL);
-    impl->display_count++;
     *index = slot->index;
+    return MPP_OK;
+}
+
+MPP_RET mpp_buf_slot_dequeue_frame(MppBufSlots slots, RK_S32 *index,
+                                   MppFrame *frame, SlotQueueType type)
+{
+    if (NULL == slots || NULL == index || NULL == frame) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MppBufSlotsImpl *impl = (MppBufSlotsImpl *)slots;
+    if (!MPP_ATOMIC_LOAD(&impl->queue_ready[type]))
+        return MPP_NOK;
 
+    AutoMutex auto_lock(impl->lock);
+    MppBufSlotEntry *slot = slot_dequeue(impl, type);
+    if (NULL == slot)
+        return MPP_NOK;
+
+    mpp_assert(slot->status.has_frame);
+    if (slot->status.has_frame) {
+        if (NULL == *frame)
+            mpp_frame_init(frame);
+        if (*frame)
+            mpp_frame_copy(*frame, slot->frame);
+    } else
+        *frame = NULL;
+
+    *index = slot->index;
+    slot_clr_flag(impl, slot->index, SLOT_QUEUE_USE);
     return MPP_OK;
 }
 
@@ -812,7 +890,7 @@ MPP_RET mpp_buf_slot_set_prop(MppBufSlots slots, RK_S32 index, SlotPropType type
          */
         generate_info_set(impl, frame, 0);
         if (mpp_frame_info_cmp(impl->info, impl->info_set)) {
-            impl->info_changed = 1;
+            MPP_ATOMIC_STORE(&impl->info_changed, 1);
 #ifdef RKPLATFORM
             MppFrameImpl *old = (MppFrameImpl *)impl->info;
             if (old->width || old->height) {
@@ -994,6 +1072,7 @@ MPP_RET mpp_buf_slot_reset(MppBufSlots slots, RK_S32 index)
 
     // make sure that this slot is just the next display slot
     list_del_init(&slot->list);
+    update_queue_ready(impl);
     slot_ops_with_log(impl, slot, SLOT_CLR_QUEUE_USE, NULL);
     slot_ops_with_log(impl, slot, SLOT_DEQUEUE, NULL);
     slot_ops_with_log(impl, slot, SLOT_CLR_ON_USE, NULL);
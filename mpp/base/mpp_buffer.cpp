@@ -281,3 +281,25 @@ MPP_RET mpp_buffer_group_limit_config(MppBufferGroup group, size_t size, RK_S32
     return MPP_OK;
 }
 
+MPP_RET mpp_buffer_group_trim_config(MppBufferGroup group, MppBufferTrimPolicy policy)
+{
+    if (NULL == group || policy >= MPP_BUFFER_TRIM_BUTT) {
+        mpp_err_f("input invalid group %p policy %d\n", group, policy);
+        return MPP_NOK;
+    }
+
+    MppBufferGroupImpl *p = (MppBufferGroupImpl *)group;
+    p->trim_policy = policy;
+    return MPP_OK;
+}
+
+MPP_RET mpp_buffer_lock_stat(MppBufferLockStat *stat)
+{
+    if (NULL == stat) {
+        mpp_err_f("input invalid stat %p\n", stat);
+        return MPP_NOK;
+    }
+
+    mpp_buffer_service_lock_stat(&stat->lock_count, &stat->contend_count);
+    return MPP_OK;
+}
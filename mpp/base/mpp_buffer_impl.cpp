@@ -21,12 +21,16 @@
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_env.h"
+#include "mpp_atomic.h"
 
 #include "mpp_buffer_impl.h"
 
 #define BUFFER_OPS_MAX_COUNT            1024
+/* initial group table size, must be power of 2 for group id indexing */
+#define BUFFER_GROUP_TABLE_SIZE         256
 
 #define SEARCH_GROUP_BY_ID(id)  ((MppBufferService::get_instance())->get_group_by_id(id))
+#define GROUP_LOCK(group)       ((Mutex *)((group)->lock))
 
 typedef MPP_RET (*BufferOp)(MppAllocator allocator, MppBufferInfo *data);
 
@@ -44,8 +48,21 @@ typedef enum MppBufOps_e {
     BUF_OPS_BUTT,
 } MppBufOps;
 
+/*
+ * group table indexed by group_id & (size - 1)
+ * the table is doubled when it is full and the retired table is kept until
+ * service exit so a lock free lookup with the old table is still valid.
+ * destroyed group is cleared from all tables.
+ */
+typedef struct MppBufferGroupTable_t MppBufferGroupTable;
+
+struct MppBufferGroupTable_t {
+    RK_U32              size;
+    MppBufferGroupTable *retired;
+    MppBufferGroupImpl  **groups;
+};
+
 typedef struct MppBufLog_t {
-    struct list_head    list;
     RK_U32              group_id;
     RK_S32              buffer_id;
     MppBufOps           ops;
@@ -53,7 +70,16 @@ typedef struct MppBufLog_t {
     const char          *caller;
 } MppBufLog;
 
-// use this class only need it to init legacy group before main
+/*
+ * use this class only need it to init legacy group before main
+ *
+ * Locking rule:
+ * service lock - protects group create / destroy, group list and group table
+ * group lock   - protects buffer status, counters and logs inside one group
+ * When both are required service lock must be taken before group lock.
+ * Group lookup by id is done without any lock. A group is only destroyed when
+ * it has no buffer, so the group of a valid buffer is always accessible.
+ */
 class MppBufferService
 {
 private:
@@ -67,10 +93,15 @@ private:
     // buffer group final release function
     void                destroy_group(MppBufferGroupImpl *group);
 
+    MppBufferGroupTable *create_table(RK_U32 size);
+    MPP_RET             grow_table();
     RK_U32              get_group_id();
     RK_U32              group_id;
     RK_U32              group_count;
 
+    // group table indexed by group_id for lock free lookup
+    MppBufferGroupTable *mTable;
+
     MppBufferGroupImpl  *misc_ion_int;
     MppBufferGroupImpl  *misc_ion_ext;
 
@@ -120,6 +151,34 @@ static const char *ops2str[BUF_OPS_BUTT] = {
 
 RK_U32 mpp_buffer_debug = 0;
 
+static RK_U32 buffer_lock_count = 0;
+static RK_U32 buffer_lock_contend = 0;
+
+/* lock with contention counting when MPP_BUF_DBG_LOCK_STAT is set */
+static void buffer_lock(Mutex *lock)
+{
+    if (mpp_buffer_debug & MPP_BUF_DBG_LOCK_STAT) {
+        MPP_ATOMIC_ADD_FETCH(&buffer_lock_count, 1);
+        if (!lock->trylock())
+            return;
+
+        MPP_ATOMIC_ADD_FETCH(&buffer_lock_contend, 1);
+    }
+    lock->lock();
+}
+
+class BufferAutoLock
+{
+public:
+    BufferAutoLock(Mutex *lock) : mLock(lock) { buffer_lock(mLock); }
+    ~BufferAutoLock() { mLock->unlock(); }
+private:
+    Mutex *mLock;
+
+    BufferAutoLock(const BufferAutoLock &);
+    BufferAutoLock &operator=(const BufferAutoLock &);
+};
+
 void buffer_group_add_log(MppBufferGroupImpl *group, MppBufferImpl *buffer, MppBufOps ops, const char* caller)
 {
     if (group->log_runtime_en) {
@@ -130,50 +189,45 @@ void buffer_group_add_log(MppBufferGroupImpl *group, MppBufferImpl *buffer, MppB
             mpp_log("group %2d ops %s\n", group->group_id, ops2str[ops]);
         }
     }
-    if (group->log_history_en) {
-        struct list_head *logs = &group->list_logs;
-        MppBufLog *log = mpp_malloc(MppBufLog, 1);
-        if (log) {
-            INIT_LIST_HEAD(&log->list);
-            log->group_id   = group->group_id;
-            log->buffer_id  = (buffer) ? (buffer->buffer_id) : (-1);
-            log->ops        = ops;
-            log->ref_count  = (buffer) ? (buffer->ref_count) : (0);
-            log->caller     = caller;
-
-            if (group->log_count >= BUFFER_OPS_MAX_COUNT) {
-                struct list_head *tmp = logs->next;
-                list_del_init(tmp);
-                mpp_free(list_entry(tmp, MppBufLog, list));
-                group->log_count--;
-            }
-            list_add_tail(&log->list, logs);
-            group->log_count++;
-        }
+    if (group->log_history_en && group->logs) {
+        MppBufLog log = {
+            group->group_id,
+            (buffer) ? (buffer->buffer_id) : (-1),
+            ops,
+            (buffer) ? (buffer->ref_count) : (0),
+            caller,
+        };
+        mpp_ring_log_add(group->logs, &log);
     }
 }
 
-void buffer_group_dump_log(MppBufferGroupImpl *group)
+static void dump_buffer_log(void *ctx, MppRingLogInfo *info, void *entry)
 {
-    if (group->log_history_en) {
-        struct list_head *logs = &group->list_logs;
+    MppBufLog *log = (MppBufLog *)entry;
 
-        while (!list_empty(logs)) {
-            struct list_head *tmp = logs->next;
-            MppBufLog *log = list_entry(tmp, MppBufLog, list);
-            list_del_init(tmp);
-            if (log->buffer_id >= 0) {
-                mpp_log("group %2d buffer %2d ops %s ref_count %d caller %s\n", group->group_id,
-                        log->buffer_id, ops2str[log->ops], log->ref_count, log->caller);
-            } else {
-                mpp_log("group %3d ops %s\n", group->group_id, ops2str[log->ops]);
-            }
-            mpp_free(log);
-        }
+    (void)ctx;
+    if (log->buffer_id >= 0) {
+        mpp_log("%lld tid %5d group %2d buffer %2d ops %s ref_count %d caller %s\n",
+                info->time, info->tid, log->group_id, log->buffer_id,
+                ops2str[log->ops], log->ref_count, log->caller);
+    } else {
+        mpp_log("%lld tid %5d group %3d ops %s\n", info->time, info->tid,
+                log->group_id, ops2str[log->ops]);
     }
 }
 
-MPP_RET deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
+void buffer_group_dump_log(MppBufferGroupImpl *group)
+{
+    if (group->log_history_en && group->logs)
+        mpp_ring_log_dump(group->logs, dump_buffer_log, NULL);
+}
+
+/*
+ * NOTE: caller should hold the group lock
+ * return 1 when the group is an empty orphan group and should be released by
+ * caller after the group lock is released
+ */
+static RK_U32 deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
 {
     mpp_assert(buffer->ref_count == 0);
     mpp_assert(buffer->used == 0);
@@ -189,13 +243,55 @@ MPP_RET deinit_buffer_no_lock(MppBufferImpl *buffer, const char *caller)
 
     buffer_group_add_log(group, buffer, BUF_DESTROY, caller);
 
-    if (group->is_orphan && !group->usage) {
-        MppBufferService::get_instance()->put_group(group);
+    mpp_free(buffer);
+
+    return (group->is_orphan && !group->usage) ? (1) : (0);
+}
+
+static RK_S32 get_size_class(size_t size)
+{
+    size_t max_size = (size_t)1 << MPP_BUFFER_SIZE_CLASS_SHIFT;
+    RK_S32 size_class = 0;
+
+    while (size > max_size && size_class < MPP_BUFFER_SIZE_CLASS_COUNT - 1) {
+        max_size <<= 1;
+        size_class++;
     }
+    return size_class;
+}
 
-    mpp_free(buffer);
+/* keep size class list in ascending order so the first fit is the best fit */
+static void add_unused_buffer_no_lock(MppBufferGroupImpl *group, MppBufferImpl *buffer)
+{
+    struct list_head *head = &group->list_unused[get_size_class(buffer->info.size)];
+    MppBufferImpl *pos;
 
-    return MPP_OK;
+    list_for_each_entry(pos, head, MppBufferImpl, list_status) {
+        if (pos->info.size > buffer->info.size)
+            break;
+    }
+    list_add_tail(&buffer->list_status, &pos->list_status);
+    group->count_unused++;
+}
+
+/*
+ * release unused buffers smaller than size, all unused buffers when size is 0
+ */
+static void trim_unused_buffer_no_lock(MppBufferGroupImpl *group, size_t size, const char *caller)
+{
+    RK_S32 max_class = (size) ? (get_size_class(size)) : (MPP_BUFFER_SIZE_CLASS_COUNT - 1);
+    RK_S32 i;
+
+    for (i = 0; i <= max_class; i++) {
+        MppBufferImpl *pos, *n;
+        list_for_each_entry_safe(pos, n, &group->list_unused[i], MppBufferImpl, list_status) {
+            if (size && pos->info.size >= size)
+                break;
+
+            deinit_buffer_no_lock(pos, caller);
+            group->count_unused--;
+        }
+    }
 }
 
 static MPP_RET inc_buffer_ref_no_lock(MppBufferImpl *buffer, const char *caller)
@@ -232,19 +328,18 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
                           MppBufferGroupImpl *group, MppBufferInfo *info,
                           MppBufferImpl **buffer)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
+    if (NULL == group) {
+        mpp_err_f("can not create buffer without group\n");
+        return MPP_NOK;
+    }
+
+    BufferAutoLock auto_lock(GROUP_LOCK(group));
     MPP_BUF_FUNCTION_ENTER();
 
     MPP_RET ret = MPP_OK;
     BufferOp func = NULL;
     MppBufferImpl *p = NULL;
 
-    if (NULL == group) {
-        mpp_err_f("can not create buffer without group\n");
-        ret = MPP_NOK;
-        goto RET;
-    }
-
     if (group->limit_count && group->buffer_count >= group->limit_count) {
         if (group->log_runtime_en)
             mpp_log_f("group %d reach count limit %d\n", group->group_id, group->limit_count);
@@ -286,12 +381,11 @@ MPP_RET mpp_buffer_create(const char *tag, const char *caller,
     p->group_id = group->group_id;
     p->buffer_id = group->buffer_id;
     INIT_LIST_HEAD(&p->list_status);
-    list_add_tail(&p->list_status, &group->list_unused);
+    add_unused_buffer_no_lock(group, p);
 
     group->buffer_id++;
     group->usage += info->size;
     group->buffer_count++;
-    group->count_unused++;
 
     buffer_group_add_log(group, p,
                          (group->mode == MPP_BUFFER_INTERNAL) ? (BUF_CREATE) : (BUF_COMMIT),
@@ -308,7 +402,13 @@ RET:
 
 MPP_RET mpp_buffer_ref_inc(MppBufferImpl *buffer, const char* caller)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
+    MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
+    if (NULL == group) {
+        mpp_err_f("buffer %p without group caller %s\n", buffer, caller);
+        return MPP_NOK;
+    }
+
+    BufferAutoLock auto_lock(GROUP_LOCK(group));
     MPP_BUF_FUNCTION_ENTER();
 
     MPP_RET ret = inc_buffer_ref_no_lock(buffer, caller);
@@ -320,11 +420,19 @@ MPP_RET mpp_buffer_ref_inc(MppBufferImpl *buffer, const char* caller)
 
 MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
-    MPP_BUF_FUNCTION_ENTER();
+    MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
+    if (NULL == group) {
+        mpp_err_f("buffer %p without group caller %s\n", buffer, caller);
+        return MPP_NOK;
+    }
 
     MPP_RET ret = MPP_OK;
-    MppBufferGroupImpl *group = SEARCH_GROUP_BY_ID(buffer->group_id);
+    RK_U32 release = 0;
+    Mutex *lock = GROUP_LOCK(group);
+
+    buffer_lock(lock);
+    MPP_BUF_FUNCTION_ENTER();
+
     buffer_group_add_log(group, buffer, BUF_REF_DEC, caller);
 
     if (buffer->ref_count <= 0) {
@@ -338,58 +446,77 @@ MPP_RET mpp_buffer_ref_dec(MppBufferImpl *buffer, const char* caller)
             buffer->used = 0;
             list_del_init(&buffer->list_status);
             if (group == MppBufferService::get_instance()->get_misc_group(group->mode, group->type)) {
-                deinit_buffer_no_lock(buffer, caller);
+                release = deinit_buffer_no_lock(buffer, caller);
             } else {
                 if (buffer->discard) {
-                    deinit_buffer_no_lock(buffer, caller);
+                    release = deinit_buffer_no_lock(buffer, caller);
                 } else {
-                    list_add_tail(&buffer->list_status, &group->list_unused);
-                    group->count_unused++;
+                    add_unused_buffer_no_lock(group, buffer);
                 }
             }
             group->count_used--;
+            /*
+             * listener checks buffer under its thread lock before waiting so
+             * signal with the thread lock. Listener thread never gets or puts
+             * buffer of this group with its thread lock held.
+             */
             if (group->listener) {
                 MppThread *thread = (MppThread *)group->listener;
+                thread->lock();
                 thread->signal();
+                thread->unlock();
             }
         }
     }
 
     MPP_BUF_FUNCTION_LEAVE();
+    lock->unlock();
+
+    // last buffer of orphan group is gone then the group can be destroyed
+    if (release) {
+        BufferAutoLock auto_lock(MppBufferService::get_lock());
+        MppBufferService::get_instance()->put_group(group);
+    }
+
     return ret;
 }
 
 MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
+    BufferAutoLock auto_lock(GROUP_LOCK(p));
     MPP_BUF_FUNCTION_ENTER();
 
     MppBufferImpl *buffer = NULL;
 
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        RK_S32 found = 0;
-        RK_S32 search_count = 0;
-
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
-                        size, pos->buffer_id, pos->info.size);
-            if (pos->info.size >= size) {
-                buffer = pos;
-                inc_buffer_ref_no_lock(buffer, __FUNCTION__);
-                found = 1;
-                break;
-            } else {
-                if (MPP_BUFFER_INTERNAL == p->mode) {
-                    deinit_buffer_no_lock(pos, __FUNCTION__);
-                    p->count_unused--;
-                } else
-                    search_count++;
+    if (p->count_unused) {
+        MppBufferImpl *pos;
+        RK_S32 i;
+
+        /*
+         * best fit search: the request class may have smaller buffer but any
+         * buffer in higher class is large enough, so take the first one there
+         */
+        for (i = get_size_class(size); i < MPP_BUFFER_SIZE_CLASS_COUNT && !buffer; i++) {
+            list_for_each_entry(pos, &p->list_unused[i], MppBufferImpl, list_status) {
+                mpp_buf_dbg(MPP_BUF_DBG_CHECK_SIZE, "request size %d on buf idx %d size %d\n",
+                            size, pos->buffer_id, pos->info.size);
+                if (pos->info.size >= size) {
+                    buffer = pos;
+                    break;
+                }
             }
         }
 
-        if (!found && search_count)
+        if (buffer)
+            inc_buffer_ref_no_lock(buffer, __FUNCTION__);
+
+        if (MPP_BUFFER_INTERNAL == p->mode) {
+            if (p->trim_policy == MPP_BUFFER_TRIM_ALWAYS ||
+                (p->trim_policy == MPP_BUFFER_TRIM_ON_MISS && !buffer))
+                trim_unused_buffer_no_lock(p, size, __FUNCTION__);
+        } else if (!buffer) {
             mpp_err_f("can not found match buffer with size larger than %d\n", size);
+        }
     }
 
     MPP_BUF_FUNCTION_LEAVE();
@@ -399,7 +526,7 @@ MppBufferImpl *mpp_buffer_get_unused(MppBufferGroupImpl *p, size_t size)
 MPP_RET mpp_buffer_group_init(MppBufferGroupImpl **group, const char *tag, const char *caller,
                               MppBufferMode mode, MppBufferType type)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
+    BufferAutoLock auto_lock(MppBufferService::get_lock());
 
     mpp_assert(caller);
     MPP_BUF_FUNCTION_ENTER();
@@ -412,7 +539,7 @@ MPP_RET mpp_buffer_group_init(MppBufferGroupImpl **group, const char *tag, const
 
 MPP_RET mpp_buffer_group_deinit(MppBufferGroupImpl *p)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
+    BufferAutoLock auto_lock(MppBufferService::get_lock());
     if (NULL == p) {
         mpp_err_f("found NULL pointer\n");
         return MPP_ERR_NULL_PTR;
@@ -428,12 +555,13 @@ MPP_RET mpp_buffer_group_deinit(MppBufferGroupImpl *p)
 
 MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     if (NULL == p) {
         mpp_err_f("found NULL pointer\n");
         return MPP_ERR_NULL_PTR;
     }
 
+    BufferAutoLock auto_lock(GROUP_LOCK(p));
+
     MPP_BUF_FUNCTION_ENTER();
 
     if (!list_empty(&p->list_used)) {
@@ -445,13 +573,7 @@ MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
     }
 
     // remove unused list
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            deinit_buffer_no_lock(pos, __FUNCTION__);
-            p->count_unused--;
-        }
-    }
+    trim_unused_buffer_no_lock(p, 0, __FUNCTION__);
 
     MPP_BUF_FUNCTION_LEAVE();
     return MPP_OK;
@@ -459,12 +581,13 @@ MPP_RET mpp_buffer_group_reset(MppBufferGroupImpl *p)
 
 MPP_RET mpp_buffer_group_set_listener(MppBufferGroupImpl *p, void *listener)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
     if (NULL == p) {
         mpp_err_f("found NULL pointer\n");
         return MPP_ERR_NULL_PTR;
     }
 
+    BufferAutoLock auto_lock(GROUP_LOCK(p));
+
     MPP_BUF_FUNCTION_ENTER();
 
     p->listener = listener;
@@ -488,8 +611,10 @@ void mpp_buffer_group_dump(MppBufferGroupImpl *group)
     }
 
     mpp_log("unused buffer count %d\n", group->count_unused);
-    list_for_each_entry_safe(pos, n, &group->list_unused, MppBufferImpl, list_status) {
-        dump_buffer_info(pos);
+    for (RK_S32 i = 0; i < MPP_BUFFER_SIZE_CLASS_COUNT; i++) {
+        list_for_each_entry_safe(pos, n, &group->list_unused[i], MppBufferImpl, list_status) {
+            dump_buffer_info(pos);
+        }
     }
 
     buffer_group_dump_log(group);
@@ -497,22 +622,24 @@ void mpp_buffer_group_dump(MppBufferGroupImpl *group)
 
 void mpp_buffer_service_dump()
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
+    BufferAutoLock auto_lock(MppBufferService::get_lock());
     MppBufferService::get_instance()->dump_misc_group();
 }
 
 MppBufferGroupImpl *mpp_buffer_get_misc_group(MppBufferMode mode, MppBufferType type)
 {
-    AutoMutex auto_lock(MppBufferService::get_lock());
+    // misc group is created with the service and keeps alive until service exit
     return MppBufferService::get_instance()->get_misc_group(mode, type);
 }
 
 MppBufferService::MppBufferService()
     : group_id(0),
       group_count(0),
+      mTable(NULL),
       misc_ion_int(NULL),
       misc_ion_ext(NULL)
 {
+    mTable = create_table(BUFFER_GROUP_TABLE_SIZE);
     INIT_LIST_HEAD(&mListGroup);
     INIT_LIST_HEAD(&mListOrphan);
 
@@ -550,15 +677,64 @@ MppBufferService::~MppBufferService()
             deinit_buffer_no_lock(pos, __FUNCTION__);
         }
     }
+
+    // release current table and all retired tables
+    while (mTable) {
+        MppBufferGroupTable *table = mTable;
+
+        mTable = table->retired;
+        mpp_free(table);
+    }
+}
+
+MppBufferGroupTable *MppBufferService::create_table(RK_U32 size)
+{
+    MppBufferGroupTable *table = mpp_calloc_size(MppBufferGroupTable,
+                                                 sizeof(MppBufferGroupTable) +
+                                                 sizeof(MppBufferGroupImpl *) * size);
+    if (NULL == table) {
+        mpp_err("MppBufferService failed to allocate group table size %d\n", size);
+        return NULL;
+    }
+
+    table->size = size;
+    table->groups = (MppBufferGroupImpl **)(table + 1);
+    return table;
+}
+
+MPP_RET MppBufferService::grow_table()
+{
+    MppBufferGroupTable *prev = mTable;
+    MppBufferGroupTable *table = create_table(prev->size * 2);
+    RK_U32 i;
+
+    if (NULL == table)
+        return MPP_ERR_MALLOC;
+
+    /* live ids differ in the low bits of old size so they can not collide */
+    for (i = 0; i < prev->size; i++) {
+        MppBufferGroupImpl *p = prev->groups[i];
+
+        if (p)
+            table->groups[p->group_id & (table->size - 1)] = p;
+    }
+    table->retired = prev;
+
+    // publish the filled table to lock free lookup
+    MPP_ATOMIC_STORE_PTR(&mTable, table);
+    return MPP_OK;
 }
 
 RK_U32 MppBufferService::get_group_id()
 {
-    // avoid group_id reuse
-    RK_U32 id = group_id++;
-    while (get_group_by_id(group_id)) {
+    MppBufferGroupImpl **groups = mTable->groups;
+    RK_U32 mask = mTable->size - 1;
+
+    // avoid group_id reuse and find a free slot in group table
+    while (groups[group_id & mask]) {
         group_id++;
     }
+    RK_U32 id = group_id++;
     group_count++;
     return id;
 }
@@ -566,22 +742,39 @@ RK_U32 MppBufferService::get_group_id()
 MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *caller,
                                                 MppBufferMode mode, MppBufferType type)
 {
+    if (NULL == mTable)
+        return NULL;
+
+    if (group_count >= mTable->size && grow_table()) {
+        mpp_err("MppBufferService failed to grow group table from %d\n", mTable->size);
+        return NULL;
+    }
+
     MppBufferGroupImpl *p = mpp_calloc(MppBufferGroupImpl, 1);
     if (NULL == p) {
         mpp_err("MppBufferService failed to allocate group context\n");
         return NULL;
     }
 
+    p->lock = new Mutex(MPP_MUTEX_ADAPTIVE);
+    if (NULL == p->lock) {
+        mpp_err("MppBufferService failed to create group lock\n");
+        mpp_free(p);
+        return NULL;
+    }
+
     RK_U32 id = get_group_id();
 
-    INIT_LIST_HEAD(&p->list_logs);
     INIT_LIST_HEAD(&p->list_group);
     INIT_LIST_HEAD(&p->list_used);
-    INIT_LIST_HEAD(&p->list_unused);
+    for (RK_S32 i = 0; i < MPP_BUFFER_SIZE_CLASS_COUNT; i++)
+        INIT_LIST_HEAD(&p->list_unused[i]);
 
-    mpp_env_get_u32("mpp_buffer_debug", &mpp_buffer_debug, 0);
+    mpp_env_get_u32("mpp_buffer_debug", &mpp_buffer_debug, MPP_BUF_DBG_OPS_HISTORY);
     p->log_runtime_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_RUNTIME) ? (1) : (0);
     p->log_history_en   = (mpp_buffer_debug & MPP_BUF_DBG_OPS_HISTORY) ? (1) : (0);
+    if (p->log_history_en)
+        mpp_ring_log_init(&p->logs, sizeof(MppBufLog), BUFFER_OPS_MAX_COUNT);
 
     list_add_tail(&p->list_group, &mListGroup);
 
@@ -594,6 +787,7 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
     p->mode     = mode;
     p->type     = type;
     p->limit    = BUFFER_GROUP_SIZE_DEFAULT;
+    p->trim_policy = MPP_BUFFER_TRIM_ON_MISS;
     p->group_id = id;
     p->clear_on_exit = (mpp_buffer_debug & MPP_BUF_DBG_CLR_ON_EXIT) ? (1) : (0);
 
@@ -601,6 +795,8 @@ MppBufferGroupImpl *MppBufferService::get_group(const char *tag, const char *cal
 
     buffer_group_add_log(p, NULL, GRP_CREATE, __FUNCTION__);
 
+    MPP_ATOMIC_STORE_PTR(&mTable->groups[id & (mTable->size - 1)], p);
+
     return p;
 }
 
@@ -616,19 +812,18 @@ MppBufferGroupImpl *MppBufferService::get_misc_group(MppBufferMode mode, MppBuff
 
 void MppBufferService::put_group(MppBufferGroupImpl *p)
 {
+    Mutex *lock = GROUP_LOCK(p);
+    RK_U32 destroy = 0;
+
+    buffer_lock(lock);
+
     buffer_group_add_log(p, NULL, GRP_RELEASE, __FUNCTION__);
 
     // remove unused list
-    if (!list_empty(&p->list_unused)) {
-        MppBufferImpl *pos, *n;
-        list_for_each_entry_safe(pos, n, &p->list_unused, MppBufferImpl, list_status) {
-            deinit_buffer_no_lock(pos, __FUNCTION__);
-            p->count_unused--;
-        }
-    }
+    trim_unused_buffer_no_lock(p, 0, __FUNCTION__);
 
     if (list_empty(&p->list_used)) {
-        destroy_group(p);
+        destroy = 1;
     } else {
         mpp_err("mpp_group %p tag %s caller %s mode %s type %s deinit with %d bytes not released\n",
                 p, p->tag, p->caller, mode2str[p->mode], type2str[p->type], p->usage);
@@ -650,7 +845,7 @@ void MppBufferService::put_group(MppBufferGroupImpl *p)
                 p->count_used--;
             }
 
-            destroy_group(p);
+            destroy = 1;
         } else {
             // otherwise move the group to list_orphan and wait for buffer release
             list_del_init(&p->list_group);
@@ -658,6 +853,11 @@ void MppBufferService::put_group(MppBufferGroupImpl *p)
             p->is_orphan = 1;
         }
     }
+
+    lock->unlock();
+
+    if (destroy)
+        destroy_group(p);
 }
 
 void MppBufferService::destroy_group(MppBufferGroupImpl *group)
@@ -673,20 +873,22 @@ void MppBufferService::destroy_group(MppBufferGroupImpl *group)
 
     buffer_group_add_log(group, NULL, GRP_DESTROY, __FUNCTION__);
 
-    if (group->log_history_en) {
-        struct list_head *logs = &group->list_logs;
-        while (!list_empty(logs)) {
-            struct list_head *tmp = logs->next;
-            list_del_init(tmp);
-            mpp_free(list_entry(tmp, MppBufLog, list));
-            group->log_count--;
-        }
-        mpp_assert(group->log_count == 0);
+    if (group->logs) {
+        mpp_ring_log_deinit(group->logs);
+        group->logs = NULL;
     }
 
     mpp_assert(group->allocator);
     mpp_allocator_put(&group->allocator);
     list_del_init(&group->list_group);
+    // clear the group in retired tables too for lookup with an old table
+    for (MppBufferGroupTable *table = mTable; table; table = table->retired) {
+        MppBufferGroupImpl **slot = &table->groups[group->group_id & (table->size - 1)];
+
+        if (*slot == group)
+            MPP_ATOMIC_STORE_PTR(slot, (MppBufferGroupImpl *)NULL);
+    }
+    delete GROUP_LOCK(group);
     mpp_free(group);
     group_count--;
 
@@ -704,28 +906,27 @@ void MppBufferService::destroy_group(MppBufferGroupImpl *group)
 
 MppBufferGroupImpl *MppBufferService::get_group_by_id(RK_U32 id)
 {
-    MppBufferGroupImpl *pos, *n;
-    list_for_each_entry_safe(pos, n, &mListGroup, MppBufferGroupImpl, list_group) {
-        if (pos->group_id == id) {
-            return pos;
-        }
-    }
-
-    list_for_each_entry_safe(pos, n, &mListOrphan, MppBufferGroupImpl, list_group) {
-        if (pos->group_id == id) {
-            return pos;
-        }
-    }
+    MppBufferGroupTable *table = (MppBufferGroupTable *)MPP_ATOMIC_LOAD_PTR(&mTable);
+    MppBufferGroupImpl *p = (MppBufferGroupImpl *)MPP_ATOMIC_LOAD_PTR(&table->groups[id & (table->size - 1)]);
 
-    return NULL;
+    return (p && p->group_id == id) ? (p) : (NULL);
 }
 
 void MppBufferService::dump_misc_group()
 {
-    if (misc_ion_int->buffer_count)
+    if (misc_ion_int->buffer_count) {
+        BufferAutoLock auto_lock(GROUP_LOCK(misc_ion_int));
         mpp_buffer_group_dump(misc_ion_int);
+    }
 
-    if (misc_ion_ext->buffer_count)
+    if (misc_ion_ext->buffer_count) {
+        BufferAutoLock auto_lock(GROUP_LOCK(misc_ion_ext));
         mpp_buffer_group_dump(misc_ion_ext);
+    }
 }
 
+void mpp_buffer_service_lock_stat(RK_U32 *lock_count, RK_U32 *contend_count)
+{
+    *lock_count    = MPP_ATOMIC_LOAD(&buffer_lock_count);
+    *contend_count = MPP_ATOMIC_LOAD(&buffer_lock_contend);
+}
@@ -39,6 +39,12 @@ MPP_RET check_is_mpp_frame(void *frame)
     return MPP_NOK;
 }
 
+static MppMemPool get_frame_pool()
+{
+    static MppMemPool pool = mpp_mem_pool_init(sizeof(MppFrameImpl));
+    return pool;
+}
+
 MPP_RET mpp_frame_init(MppFrame *frame)
 {
     if (NULL == frame) {
@@ -46,7 +52,7 @@ MPP_RET mpp_frame_init(MppFrame *frame)
         return MPP_ERR_NULL_PTR;
     }
 
-    MppFrameImpl *p = mpp_calloc(MppFrameImpl, 1);
+    MppFrameImpl *p = (MppFrameImpl *)mpp_mem_pool_get(get_frame_pool());
     if (NULL == p) {
         mpp_err_f("malloc failed\n");
         return MPP_ERR_NULL_PTR;
@@ -69,7 +75,7 @@ MPP_RET mpp_frame_deinit(MppFrame *frame)
     if (buffer)
         mpp_buffer_put(buffer);
 
-    mpp_free(*frame);
+    mpp_mem_pool_put(get_frame_pool(), *frame);
     *frame = NULL;
     return MPP_OK;
 }
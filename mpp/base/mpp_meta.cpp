@@ -26,20 +26,40 @@
 
 #include "mpp_meta.h"
 
+/*
+ * meta data key / type table
+ * NOTE: when adding new key only this table needs to be updated
+ */
+#define META_ENTRY_TABLE(ENTRY) \
+    /* categorized by type */ \
+    /* data flow type */ \
+    ENTRY(KEY_INPUT_FRAME,      TYPE_FRAME) \
+    ENTRY(KEY_OUTPUT_FRAME,     TYPE_FRAME) \
+    ENTRY(KEY_INPUT_PACKET,     TYPE_PACKET) \
+    ENTRY(KEY_OUTPUT_PACKET,    TYPE_PACKET) \
+    /* buffer for motion detection */ \
+    ENTRY(KEY_MOTION_INFO,      TYPE_BUFFER) \
+    \
+    ENTRY(KEY_INPUT_BLOCK,      TYPE_S32) \
+    ENTRY(KEY_OUTPUT_BLOCK,     TYPE_S32)
+
+#define META_INDEX_ENUM(key, type)      META_INDEX_##key,
+#define META_DEF_ENTRY(key, type)       { key, type, },
+#define META_INDEX_CASE(key, type)      case key : return META_INDEX_##key;
+
+typedef enum MppMetaIndex_e {
+    META_ENTRY_TABLE(META_INDEX_ENUM)
+    META_INDEX_BUTT,
+} MppMetaIndex;
+
 typedef struct MppMetaDef_t {
     MppMetaKey          key;
     MppMetaType         type;
 } MppMetaDef;
 
-typedef struct MppMetaImpl_t {
-    char                tag[MPP_TAG_SIZE];
-    const char          *caller;
-    RK_S32              meta_id;
-
-    struct list_head    list_meta;
-    struct list_head    list_node;
-    RK_S32              node_count;
-} MppMetaImpl;
+static const MppMetaDef meta_defs[META_INDEX_BUTT] = {
+    META_ENTRY_TABLE(META_DEF_ENTRY)
+};
 
 typedef union MppMetaVal_u {
     RK_S32          val_s32;
@@ -51,27 +71,25 @@ typedef union MppMetaVal_u {
 } MppMetaVal;
 
 typedef struct MppMetaNode_t {
-    struct list_head    list_meta;
-    struct list_head    list_node;
-    MppMetaImpl         *meta;
-    RK_S32              node_id;
-
-    RK_S32              type_id;
+    RK_S32              valid;
     MppMetaVal          val;
 } MppMetaNode;
 
-static MppMetaDef meta_defs[] = {
-    /* categorized by type */
-    /* data flow type */
-    {   KEY_INPUT_FRAME,       TYPE_FRAME,    },
-    {   KEY_OUTPUT_FRAME,      TYPE_FRAME,    },
-    {   KEY_INPUT_PACKET,      TYPE_PACKET,   },
-    {   KEY_OUTPUT_PACKET,     TYPE_PACKET,   },
-    {   KEY_MOTION_INFO,       TYPE_BUFFER,   },  /* buffer for motion detection */
-
-    {   KEY_INPUT_BLOCK,       TYPE_S32,      },
-    {   KEY_OUTPUT_BLOCK,      TYPE_S32,      },
-};
+/*
+ * Each meta has one fixed node for each key in meta_defs. So set / get only
+ * touch the meta itself and do not need any allocation or global lock. The
+ * meta is owned by one user at one time, the task queue handover provides
+ * the required memory ordering between users.
+ */
+typedef struct MppMetaImpl_t {
+    char                tag[MPP_TAG_SIZE];
+    const char          *caller;
+    RK_S32              meta_id;
+
+    struct list_head    list_meta;
+    RK_S32              node_count;
+    MppMetaNode         nodes[META_INDEX_BUTT];
+} MppMetaImpl;
 
 class MppMetaService
 {
@@ -83,11 +101,10 @@ private:
     MppMetaService &operator=(const MppMetaService &);
 
     struct list_head    mlist_meta;
-    struct list_head    mlist_node;
+    MppMemPool          mpool_meta;
 
     RK_U32              meta_id;
     RK_U32              meta_count;
-    RK_U32              node_count;
 
 public:
     static MppMetaService *get_instance() {
@@ -99,35 +116,21 @@ public:
         return &lock;
     }
 
-    /*
-     * get_index_of_key does two things:
-     * 1. Check the key / type pair is correct or not.
-     *    If failed on check return negative value
-     * 2. Compare all exsisting meta data defines to find the non-negative index
-     */
-    RK_S32 get_index_of_key(MppMetaKey key, MppMetaType type);
-
     MppMetaImpl  *get_meta(const char *tag, const char *caller);
     void          put_meta(MppMetaImpl *meta);
-
-    MppMetaNode  *get_node(MppMetaImpl *meta, RK_S32 index);
-    void          put_node(MppMetaNode *node);
-    MppMetaNode  *find_node(MppMetaImpl *meta, RK_S32 index);
 };
 
 MppMetaService::MppMetaService()
     : meta_id(0),
-      meta_count(0),
-      node_count(0)
+      meta_count(0)
 {
     INIT_LIST_HEAD(&mlist_meta);
-    INIT_LIST_HEAD(&mlist_node);
+    mpool_meta = mpp_mem_pool_init(sizeof(MppMetaImpl));
 }
 
 MppMetaService::~MppMetaService()
 {
     mpp_assert(list_empty(&mlist_meta));
-    mpp_assert(list_empty(&mlist_node));
 
     while (!list_empty(&mlist_meta)) {
         MppMetaImpl *pos, *n;
@@ -136,39 +139,18 @@ MppMetaService::~MppMetaService()
         }
     }
 
-    mpp_assert(list_empty(&mlist_node));
-
-    while (!list_empty(&mlist_node)) {
-        MppMetaNode *pos, *n;
-        list_for_each_entry_safe(pos, n, &mlist_node, MppMetaNode, list_node) {
-            put_node(pos);
-        }
-    }
-}
-
-RK_S32 MppMetaService::get_index_of_key(MppMetaKey key, MppMetaType type)
-{
-    RK_S32 i = 0;
-    RK_S32 num = MPP_ARRAY_ELEMS(meta_defs);
-
-    for (i = 0; i < num; i++) {
-        if ((meta_defs[i].key == key) && (meta_defs[i].type == type))
-            break;
-    }
-
-    return (i < num) ? (i) : (-1);
+    mpp_mem_pool_deinit(mpool_meta);
 }
 
 MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
 {
-    MppMetaImpl *impl = mpp_malloc(MppMetaImpl, 1);
+    MppMetaImpl *impl = (MppMetaImpl *)mpp_mem_pool_get(mpool_meta);
     if (impl) {
         const char *tag_src = (tag) ? (tag) : (MODULE_TAG);
         strncpy(impl->tag, tag_src, sizeof(impl->tag));
         impl->caller = caller;
         impl->meta_id = meta_id++;
         INIT_LIST_HEAD(&impl->list_meta);
-        INIT_LIST_HEAD(&impl->list_node);
         impl->node_count = 0;
 
         list_add_tail(&impl->list_meta, &mlist_meta);
@@ -181,80 +163,34 @@ MppMetaImpl *MppMetaService::get_meta(const char *tag, const char *caller)
 
 void MppMetaService::put_meta(MppMetaImpl *meta)
 {
-    while (!list_empty(&meta->list_node)) {
-        MppMetaNode *node = list_entry(meta->list_node.next, MppMetaNode, list_meta);
-        put_node(node);
-        meta->node_count--;
-    }
+    // TODO: may be we need to release MppFrame / MppPacket / MppBuffer here
     list_del_init(&meta->list_meta);
     meta_count--;
-    mpp_free(meta);
+    mpp_mem_pool_put(mpool_meta, meta);
 }
 
-MppMetaNode *MppMetaService::find_node(MppMetaImpl *meta, RK_S32 type_id)
+/*
+ * map the key to its index in meta_defs by a switch generated from the table
+ * return negative value for unknown key
+ */
+static RK_S32 get_index_of_key(MppMetaKey key)
 {
-    MppMetaNode *node = NULL;
-    if (meta->node_count) {
-        MppMetaNode *n, *pos;
-
-        list_for_each_entry_safe(pos, n, &meta->list_node, MppMetaNode, list_meta) {
-            if (pos->type_id == type_id) {
-                node = pos;
-                break;
-            }
-        }
+    switch (key) {
+        META_ENTRY_TABLE(META_INDEX_CASE)
+    default : break;
     }
-    return node;
+    return -1;
 }
 
-MppMetaNode *MppMetaService::get_node(MppMetaImpl *meta, RK_S32 type_id)
+/* check the key / type pair and return the fixed node of the key */
+static MppMetaNode *get_node_by_key(MppMetaImpl *meta, MppMetaKey key, MppMetaType type)
 {
-    MppMetaNode *node = find_node(meta, type_id);
-
-    if (NULL == node) {
-        node = mpp_malloc(MppMetaNode, 1);
-        if (node) {
-            INIT_LIST_HEAD(&node->list_meta);
-            INIT_LIST_HEAD(&node->list_node);
-            node->meta = meta;
-            node->node_id = meta->meta_id++;
-            node->type_id = type_id;
-            memset(&node->val, 0, sizeof(node->val));
-
-            meta->node_count++;
-            list_add_tail(&node->list_meta, &meta->list_node);
-            list_add_tail(&node->list_node, &mlist_node);
-            node_count++;
-        } else {
-            mpp_err_f("failed to malloc meta data node\n");
-        }
-    }
+    RK_S32 index = get_index_of_key(key);
 
-    return node;
-}
+    if (index < 0 || meta_defs[index].type != type)
+        return NULL;
 
-void MppMetaService::put_node(MppMetaNode *node)
-{
-    MppMetaImpl *meta = node->meta;
-    list_del_init(&node->list_meta);
-    list_del_init(&node->list_node);
-    meta->node_count--;
-    node_count--;
-    // TODO: may be we need to release MppFrame / MppPacket / MppBuffer here
-    switch (meta_defs[node->type_id].type) {
-    case TYPE_FRAME : {
-        // mpp_frame_deinit(&node->val.frame);
-    } break;
-    case TYPE_PACKET : {
-        // mpp_packet_deinit(&node->val.packet);
-    } break;
-    case TYPE_BUFFER : {
-        //mpp_buffer_put(node->val.buffer);
-    } break;
-    default : {
-    } break;
-    }
-    mpp_free(node);
+    return &meta->nodes[index];
 }
 
 MPP_RET mpp_meta_get_with_tag(MppMeta *meta, const char *tag, const char *caller)
@@ -287,37 +223,29 @@ MPP_RET mpp_meta_put(MppMeta meta)
 
 static MPP_RET set_val_by_key(MppMetaImpl *meta, MppMetaKey key, MppMetaType type, MppMetaVal *val)
 {
-    MPP_RET ret = MPP_NOK;
-    MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
-    RK_S32 index = service->get_index_of_key(key, type);
-    if (index < 0)
-        return ret;
-
-    MppMetaNode *node = service->get_node(meta, index);
-    if (node) {
-        node->val = *val;
-        ret = MPP_OK;
+    MppMetaNode *node = get_node_by_key(meta, key, type);
+    if (NULL == node)
+        return MPP_NOK;
+
+    if (!node->valid) {
+        node->valid = 1;
+        meta->node_count++;
     }
-    return ret;
+    node->val = *val;
+    return MPP_OK;
 }
 
+/* NOTE: get will consume the value, same as the node release before */
 static MPP_RET get_val_by_key(MppMetaImpl *meta, MppMetaKey key, MppMetaType type, MppMetaVal *val)
 {
-    MPP_RET ret = MPP_NOK;
-    MppMetaService *service = MppMetaService::get_instance();
-    AutoMutex auto_lock(service->get_lock());
-    RK_S32 index = service->get_index_of_key(key, type);
-    if (index < 0)
-        return ret;
-
-    MppMetaNode *node = service->find_node(meta, index);
-    if (node) {
-        *val = node->val;
-        service->put_node(node);
-        ret = MPP_OK;
-    }
-    return ret;
+    MppMetaNode *node = get_node_by_key(meta, key, type);
+    if (NULL == node || !node->valid)
+        return MPP_NOK;
+
+    *val = node->val;
+    node->valid = 0;
+    meta->node_count--;
+    return MPP_OK;
 }
 
 MPP_RET mpp_meta_set_s32(MppMeta meta, MppMetaKey key, RK_S32 val)
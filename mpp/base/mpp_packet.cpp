@@ -28,6 +28,12 @@ static const char *module_name = MODULE_TAG;
 #define setup_mpp_packet_name(packet) \
     ((MppPacketImpl*)packet)->name = module_name;
 
+static MppMemPool get_packet_pool()
+{
+    static MppMemPool pool = mpp_mem_pool_init(sizeof(MppPacketImpl));
+    return pool;
+}
+
 MPP_RET check_is_mpp_packet(void *packet)
 {
     if (packet && ((MppPacketImpl*)packet)->name == module_name)
@@ -45,7 +51,7 @@ MPP_RET mpp_packet_new(MppPacket *packet)
         return MPP_ERR_NULL_PTR;
     }
 
-    MppPacketImpl *p = mpp_calloc(MppPacketImpl, 1);
+    MppPacketImpl *p = (MppPacketImpl *)mpp_mem_pool_get(get_packet_pool());
     *packet = p;
     if (NULL == p) {
         mpp_err_f("malloc failed\n");
@@ -111,9 +117,13 @@ MPP_RET mpp_packet_copy_init(MppPacket *packet, const MppPacket src)
         return ret;
 
     if (src_impl->buffer) {
-        /* if source packet has buffer just create a new reference to buffer */
+        /*
+         * if source packet has buffer just create a new reference to buffer
+         * then the stream data can be sent to hardware without copy
+         */
         memcpy(pkt, src_impl, sizeof(*src_impl));
         mpp_buffer_inc_ref(src_impl->buffer);
+        *packet = pkt;
         return MPP_OK;
     }
 
@@ -162,7 +172,7 @@ MPP_RET mpp_packet_deinit(MppPacket *packet)
         mpp_free(p->data);
     }
 
-    mpp_free(p);
+    mpp_mem_pool_put(get_packet_pool(), p);
     *packet = NULL;
     return MPP_OK;
 }
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ps_cache"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+
+#include "mpp_ps_cache.h"
+
+/* 32bit FNV-1a */
+RK_U32 mpp_ps_cache_hash(const RK_U8 *buf, RK_S32 len)
+{
+    RK_U32 hash = 2166136261u;
+    RK_S32 i;
+
+    for (i = 0; i < len; i++) {
+        hash ^= buf[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+RK_S32 mpp_ps_cache_find(MppPsCache *cache, RK_S32 count, const RK_U8 *buf, RK_S32 len, RK_U32 hash)
+{
+    RK_S32 i;
+
+    if (NULL == cache || NULL == buf || len <= 0)
+        return -1;
+
+    for (i = 0; i < count; i++) {
+        MppPsCache *p = &cache[i];
+
+        if (p->len == len && p->hash == hash && !memcmp(p->data, buf, len))
+            return i;
+    }
+
+    return -1;
+}
+
+MPP_RET mpp_ps_cache_update(MppPsCache *cache, const RK_U8 *buf, RK_S32 len, RK_U32 hash)
+{
+    if (NULL == cache || NULL == buf || len <= 0) {
+        mpp_err_f("invalid input: cache %p buf %p len %d\n", cache, buf, len);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    if (cache->size < len) {
+        RK_U8 *data = mpp_realloc(cache->data, RK_U8, len);
+
+        if (NULL == data) {
+            mpp_ps_cache_clear(cache);
+            return MPP_ERR_NOMEM;
+        }
+
+        cache->data = data;
+        cache->size = len;
+    }
+
+    memcpy(cache->data, buf, len);
+    cache->len = len;
+    cache->hash = hash;
+
+    return MPP_OK;
+}
+
+void mpp_ps_cache_clear(MppPsCache *cache)
+{
+    if (cache) {
+        cache->len = 0;
+        cache->hash = 0;
+    }
+}
+
+void mpp_ps_cache_deinit(MppPsCache *cache, RK_S32 count)
+{
+    RK_S32 i;
+
+    if (NULL == cache)
+        return;
+
+    for (i = 0; i < count; i++) {
+        MPP_FREE(cache[i].data);
+        cache[i].len = 0;
+        cache[i].size = 0;
+        cache[i].hash = 0;
+    }
+}
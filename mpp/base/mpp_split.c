@@ -0,0 +1,737 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_split"
+
+#include <string.h>
+
+#include "mpp_env.h"
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "mpp_split.h"
+#include "mpp_startcode.h"
+
+#define MPP_SPLIT_DBG_FUNCTION      (0x00000001)
+#define MPP_SPLIT_DBG_FRAME         (0x00000002)
+#define MPP_SPLIT_DBG_TIME          (0x00000004)
+
+#define split_dbg(flag, fmt, ...)   _mpp_dbg(mpp_split_debug, flag, fmt, ## __VA_ARGS__)
+#define split_dbg_f(flag, fmt, ...) _mpp_dbg_f(mpp_split_debug, flag, fmt, ## __VA_ARGS__)
+
+#define SPLIT_INIT_BUFFER_SIZE      SZ_1M
+#define SPLIT_BUFFER_PADDING_SIZE   8
+#define SPLIT_PTS_NB                4
+#define SPLIT_END_NOT_FOUND         (-100)
+#define SPLIT_START_CODE_SIZE       3
+
+#define IVF_SIGNATURE               (0x444B4946)    /* DKIF */
+#define IVF_FILE_HEADER_SIZE        32
+#define IVF_FRAME_HEADER_SIZE       12
+
+#define JPEG_SOI                    0xD8
+#define JPEG_EOI                    0xD9
+#define JPEG_SOS                    0xDA
+
+typedef enum IvfStage_e {
+    IVF_PROBE,
+    IVF_FILE_HEADER,
+    IVF_FRAME_HEADER,
+    IVF_FRAME_DATA,
+    IVF_RAW,
+} IvfStage;
+
+typedef enum JpegStage_e {
+    JPEG_FIND_SOI,
+    JPEG_MARKER,
+    JPEG_LENGTH,
+    JPEG_SEGMENT,
+    JPEG_ENTROPY,
+} JpegStage;
+
+typedef struct MppSplitImpl_t MppSplitImpl;
+
+/*
+ * frame boundary rule of one coding type
+ *
+ * lookahead    - bytes after start code required by the rule
+ * check        - called with start code and lookahead bytes in the low bytes
+ *                of state, return 1 when the start code begins next frame
+ * find         - return the position of the first byte of next frame or
+ *                SPLIT_END_NOT_FOUND
+ */
+typedef struct MppSplitRule_t {
+    MppCodingType   coding;
+    RK_S32          lookahead;
+    RK_U32          (*check)(MppSplitImpl *p, RK_U64 state);
+    RK_S32          (*find)(MppSplitImpl *p, const RK_U8 *buf, RK_S32 size);
+} MppSplitRule;
+
+struct MppSplitImpl_t {
+    const MppSplitRule *rule;
+
+    RK_U8           *buffer;
+    RK_U32          buffer_size;
+    RK_S32          index;
+    RK_S32          last_index;
+    RK_S32          frame_start_found;
+    // the number of bytes which where irreversibly read from the next frame
+    RK_S32          overread;
+    RK_S32          overread_index;
+    // the last 8 bytes in MSB order
+    RK_U64          state64;
+
+    RK_S64          pts;
+    RK_S64          dts;
+    RK_S64          frame_offset;
+    RK_S64          cur_offset;
+    RK_S64          next_frame_offset;
+    RK_S32          fetch_timestamp;
+
+    RK_S32          cur_frame_start_index;
+    RK_S64          cur_frame_offset[SPLIT_PTS_NB];
+    RK_S64          cur_frame_pts[SPLIT_PTS_NB];
+    RK_S64          cur_frame_dts[SPLIT_PTS_NB];
+    RK_S64          cur_frame_end[SPLIT_PTS_NB];
+
+    // container and marker parsing state of IVF and JPEG
+    RK_S32          stage;
+    RK_S32          count;
+    RK_U32          value;
+    RK_U32          code;
+    RK_U32          scan;
+    RK_S64          left;
+    // container header bytes in front of current frame
+    RK_S32          skip;
+
+    RK_U32          eos;
+};
+
+static RK_U32 mpp_split_debug = 0;
+
+static RK_U32 split_frame_start(MppSplitImpl *p, RK_U32 is_start)
+{
+    if (!is_start)
+        return 0;
+
+    if (!p->frame_start_found) {
+        p->frame_start_found = 1;
+        return 0;
+    }
+
+    // first slice / picture of next frame
+    p->frame_start_found = 0;
+    return 1;
+}
+
+static RK_U32 split_frame_header(MppSplitImpl *p)
+{
+    // parameter sets before the first slice of next frame
+    if (!p->frame_start_found)
+        return 0;
+
+    p->frame_start_found = 0;
+    return 1;
+}
+
+/* state: 00 00 01 | nal header | first byte of slice header */
+static RK_U32 split_check_h264(MppSplitImpl *p, RK_U64 state)
+{
+    RK_U32 nal_type = (state >> 8) & 0x1f;
+
+    switch (nal_type) {
+    case 1 :
+    case 5 : {
+        // first_mb_in_slice equals zero
+        return split_frame_start(p, state & 0x80);
+    } break;
+    case 6 :
+    case 7 :
+    case 8 :
+    case 9 :
+    case 15 : {
+        return split_frame_header(p);
+    } break;
+    default : {
+    } break;
+    }
+
+    return 0;
+}
+
+/* state: 00 00 01 | two bytes nal header | first byte of slice header */
+static RK_U32 split_check_h265(MppSplitImpl *p, RK_U64 state)
+{
+    RK_U32 nut = (state >> (2 * 8 + 1)) & 0x3F;
+    RK_U32 layer_id = (((state >> 2 * 8) & 0x01) << 5) + (((state >> 1 * 8) & 0xF8) >> 3);
+
+    if (layer_id)
+        return 0;
+
+    // vps / sps / pps / aud / prefix sei and reserved types
+    if ((nut >= 32 && nut <= 35) || nut == 39 ||
+        (nut >= 41 && nut <= 44) || (nut >= 48 && nut <= 55))
+        return split_frame_header(p);
+
+    // vcl nal with first_slice_segment_in_pic_flag
+    if (nut <= 9 || (nut >= 16 && nut <= 21))
+        return split_frame_start(p, (state & 0xff) >> 7);
+
+    return 0;
+}
+
+/* state: 00 00 01 | start code value */
+static RK_U32 split_check_m2v(MppSplitImpl *p, RK_U64 state)
+{
+    switch (state & 0xff) {
+    case 0x00 : {
+        // picture start code
+        return split_frame_start(p, 1);
+    } break;
+    case 0xb3 :
+    case 0xb8 : {
+        // sequence header and group of pictures header
+        return split_frame_header(p);
+    } break;
+    default : {
+    } break;
+    }
+
+    return 0;
+}
+
+/*
+ * Find the end of the current frame.
+ * return the position of the first byte of the next frame which may be
+ * negative when the start code begins in the previous data, or
+ * SPLIT_END_NOT_FOUND
+ */
+static RK_S32 split_find_startcode_end(MppSplitImpl *p, const RK_U8 *buf, RK_S32 size)
+{
+    const MppSplitRule *rule = p->rule;
+    RK_S32 window = SPLIT_START_CODE_SIZE + rule->lookahead;
+    RK_S32 head = MPP_MIN(window, size);
+    RK_S32 i;
+
+    // start code window which may begin in the previous data
+    for (i = 0; i < head; i++) {
+        p->state64 = (p->state64 << 8) | buf[i];
+
+        if (((p->state64 >> (rule->lookahead * 8)) & 0xFFFFFF) == 0x000001 &&
+            rule->check(p, p->state64))
+            return i + 1 - window;
+    }
+
+    // start code window inside the data, search in bulk
+    i = 1;
+    while (i + window <= size) {
+        RK_S32 pos = mpp_find_startcode(buf + i, size - i);
+        RK_U64 state = 0;
+        RK_S32 k;
+
+        if (pos < 0)
+            break;
+
+        pos += i;
+        // incomplete window is handled on next data
+        if (pos + window > size)
+            break;
+
+        for (k = 0; k < window; k++)
+            state = (state << 8) | buf[pos + k];
+
+        if (rule->check(p, state)) {
+            for (k = MPP_MAX(head, pos + window - 8); k < pos + window; k++)
+                p->state64 = (p->state64 << 8) | buf[k];
+
+            return pos;
+        }
+
+        i = pos + SPLIT_START_CODE_SIZE;
+    }
+
+    for (i = MPP_MAX(head, size - 8); i < size; i++)
+        p->state64 = (p->state64 << 8) | buf[i];
+
+    return SPLIT_END_NOT_FOUND;
+}
+
+/*
+ * IVF container: 32 bytes file header and 12 bytes frame header with frame
+ * size in little endian. Headers are parsed byte by byte and frame payload
+ * is skipped in one step. Stream without IVF signature is taken as one frame
+ * per input packet.
+ */
+static RK_S32 split_find_ivf_end(MppSplitImpl *p, const RK_U8 *buf, RK_S32 size)
+{
+    RK_S32 i = 0;
+
+    while (i < size) {
+        switch (p->stage) {
+        case IVF_PROBE : {
+            p->value = (p->value << 8) | buf[i++];
+            if (++p->count < 4)
+                break;
+
+            if (p->value == IVF_SIGNATURE) {
+                p->stage = IVF_FILE_HEADER;
+                p->left = IVF_FILE_HEADER_SIZE - 4;
+                p->skip += IVF_FILE_HEADER_SIZE;
+            } else {
+                p->stage = IVF_RAW;
+            }
+            p->count = 0;
+            p->value = 0;
+        } break;
+        case IVF_FILE_HEADER :
+        case IVF_FRAME_DATA : {
+            RK_S32 n = (RK_S32)MPP_MIN(p->left, (RK_S64)(size - i));
+
+            i += n;
+            p->left -= n;
+            if (p->left)
+                break;
+
+            if (p->stage == IVF_FRAME_DATA) {
+                p->stage = IVF_FRAME_HEADER;
+                return i;
+            }
+            p->stage = IVF_FRAME_HEADER;
+        } break;
+        case IVF_FRAME_HEADER : {
+            // frame size is in the first four bytes and pts is ignored
+            if (p->count < 4)
+                p->value |= (RK_U32)buf[i] << (8 * p->count);
+            i++;
+            if (++p->count < IVF_FRAME_HEADER_SIZE)
+                break;
+
+            p->stage = IVF_FRAME_DATA;
+            p->left = p->value;
+            p->skip += IVF_FRAME_HEADER_SIZE;
+            p->count = 0;
+            p->value = 0;
+            if (!p->left) {
+                p->stage = IVF_FRAME_HEADER;
+                return i;
+            }
+        } break;
+        case IVF_RAW :
+        default : {
+            return size;
+        } break;
+        }
+    }
+
+    return SPLIT_END_NOT_FOUND;
+}
+
+/*
+ * JPEG: frame runs from SOI to EOI. Marker segments are skipped by their
+ * length so thumbnails in APPn are not taken as frames. Entropy coded data
+ * is searched for 0xFF only. A SOI after scan data without EOI also ends the
+ * frame.
+ */
+static RK_S32 split_find_jpeg_end(MppSplitImpl *p, const RK_U8 *buf, RK_S32 size)
+{
+    RK_S32 i = 0;
+
+    while (i < size) {
+        switch (p->stage) {
+        case JPEG_FIND_SOI : {
+            RK_U8 c = buf[i++];
+
+            if (p->count && c == JPEG_SOI) {
+                p->stage = JPEG_MARKER;
+                p->count = 0;
+                p->scan = 0;
+            } else if (c == 0xFF) {
+                p->count = 1;
+            } else {
+                const RK_U8 *ff = memchr(buf + i, 0xFF, size - i);
+
+                p->count = 0;
+                i = (ff) ? (RK_S32)(ff - buf) : (size);
+            }
+        } break;
+        case JPEG_MARKER : {
+            RK_U8 c = buf[i++];
+
+            if (!p->count) {
+                p->count = (c == 0xFF);
+                break;
+            }
+            // fill bytes
+            if (c == 0xFF)
+                break;
+
+            p->count = 0;
+            if (c == JPEG_EOI) {
+                p->stage = JPEG_FIND_SOI;
+                return i;
+            }
+            if (c == JPEG_SOI) {
+                if (p->scan) {
+                    /*
+                     * EOI is lost, start next frame from this SOI. When 0xFF
+                     * is in previous data the SOI is already parsed for next
+                     * frame.
+                     */
+                    if (i < 2)
+                        p->scan = 0;
+                    else
+                        p->stage = JPEG_FIND_SOI;
+                    return i - 2;
+                }
+                break;
+            }
+            // TEM and RSTn have no length
+            if (c == 0x01 || (c >= 0xD0 && c <= 0xD7))
+                break;
+
+            p->code = c;
+            p->value = 0;
+            p->stage = JPEG_LENGTH;
+        } break;
+        case JPEG_LENGTH : {
+            p->value = (p->value << 8) | buf[i++];
+            if (++p->count < 2)
+                break;
+
+            p->count = 0;
+            p->left = (p->value > 2) ? (p->value - 2) : (0);
+            p->stage = JPEG_SEGMENT;
+        } break;
+        case JPEG_SEGMENT : {
+            RK_S32 n = (RK_S32)MPP_MIN(p->left, (RK_S64)(size - i));
+
+            i += n;
+            p->left -= n;
+            if (p->left)
+                break;
+
+            if (p->code == JPEG_SOS) {
+                p->scan = 1;
+                p->stage = JPEG_ENTROPY;
+            } else {
+                p->stage = JPEG_MARKER;
+            }
+        } break;
+        case JPEG_ENTROPY : {
+            const RK_U8 *ff = NULL;
+
+            if (p->count) {
+                RK_U8 c = buf[i];
+
+                // fill bytes
+                if (c == 0xFF) {
+                    i++;
+                    break;
+                }
+                p->count = 0;
+                // byte stuffing and restart marker are scan data
+                if (c == 0x00 || (c >= 0xD0 && c <= 0xD7)) {
+                    i++;
+                    break;
+                }
+                // marker after scan data, 0xFF has been read
+                p->stage = JPEG_MARKER;
+                p->count = 1;
+                break;
+            }
+
+            ff = memchr(buf + i, 0xFF, size - i);
+            if (NULL == ff) {
+                i = size;
+                break;
+            }
+            i = (RK_S32)(ff - buf) + 1;
+            p->count = 1;
+        } break;
+        default : {
+        } break;
+        }
+    }
+
+    return SPLIT_END_NOT_FOUND;
+}
+
+static const MppSplitRule split_rules[] = {
+    {   MPP_VIDEO_CodingAVC,    2,  split_check_h264,   split_find_startcode_end,   },
+    {   MPP_VIDEO_CodingHEVC,   3,  split_check_h265,   split_find_startcode_end,   },
+    {   MPP_VIDEO_CodingMPEG2,  1,  split_check_m2v,    split_find_startcode_end,   },
+    {   MPP_VIDEO_CodingVP8,    0,  NULL,               split_find_ivf_end,         },
+    {   MPP_VIDEO_CodingMJPEG,  0,  NULL,               split_find_jpeg_end,        },
+};
+
+static MPP_RET split_check_buffer(MppSplitImpl *p, RK_U32 size)
+{
+    RK_U8 *buf = NULL;
+
+    if (size <= p->buffer_size)
+        return MPP_OK;
+
+    size = MPP_MAX(17 * size / 16 + 32, size);
+    buf = mpp_realloc(p->buffer, RK_U8, size);
+    if (NULL == buf) {
+        mpp_err_f("failed to realloc buffer size %d\n", size);
+        return MPP_ERR_NOMEM;
+    }
+
+    p->buffer = buf;
+    p->buffer_size = size;
+    return MPP_OK;
+}
+
+static RK_S32 split_combine_frame(MppSplitImpl *p, RK_S32 next, const RK_U8 **buf, RK_S32 *buf_size)
+{
+    // copy overread bytes from last frame into buffer
+    for (; p->overread > 0; p->overread--)
+        p->buffer[p->index++] = p->buffer[p->overread_index++];
+
+    // flush remaining if EOF
+    if (!*buf_size && next == SPLIT_END_NOT_FOUND)
+        next = 0;
+
+    p->last_index = p->index;
+
+    // copy into buffer and return
+    if (next == SPLIT_END_NOT_FOUND) {
+        if (split_check_buffer(p, *buf_size + p->index + SPLIT_BUFFER_PADDING_SIZE))
+            return MPP_ERR_NOMEM;
+
+        memcpy(&p->buffer[p->index], *buf, *buf_size);
+        p->index += *buf_size;
+        return -1;
+    }
+
+    *buf_size = p->overread_index = p->index + next;
+
+    // append to buffer
+    if (p->index) {
+        if (split_check_buffer(p, next + p->index + SPLIT_BUFFER_PADDING_SIZE))
+            return MPP_ERR_NOMEM;
+
+        // overread bytes before index are kept for next frame
+        if (next > 0)
+            memcpy(&p->buffer[p->index], *buf, next);
+        if (next >= 0)
+            memset(&p->buffer[p->index + next], 0, SPLIT_BUFFER_PADDING_SIZE);
+
+        p->index = 0;
+        *buf = p->buffer;
+    }
+
+    // store overread bytes
+    for (; next < 0; next++) {
+        p->state64 = (p->state64 << 8) | p->buffer[p->last_index + next];
+        p->overread++;
+    }
+
+    if (p->overread)
+        split_dbg(MPP_SPLIT_DBG_FRAME, "overread %d next %d index %d overread index %d\n",
+                  p->overread, next, p->index, p->overread_index);
+
+    return 0;
+}
+
+static void split_fetch_timestamp(MppSplitImpl *p, RK_S32 off)
+{
+    RK_S32 i;
+
+    p->dts = p->pts = -1;
+    for (i = 0; i < SPLIT_PTS_NB; i++) {
+        split_dbg(MPP_SPLIT_DBG_TIME, "cur_offset %lld cur_frame_offset[%d] %lld frame_offset %lld next_frame_offset %lld\n",
+                  p->cur_offset, i, p->cur_frame_offset[i], p->frame_offset, p->next_frame_offset);
+
+        if (p->cur_offset + off >= p->cur_frame_offset[i] &&
+            (p->frame_offset < p->cur_frame_offset[i] ||
+             (!p->frame_offset && !p->next_frame_offset)) &&
+            p->cur_frame_end[i]) {
+            p->dts = p->cur_frame_dts[i];
+            p->pts = p->cur_frame_pts[i];
+            if (p->cur_offset + off < p->cur_frame_end[i])
+                break;
+        }
+    }
+}
+
+MPP_RET mpp_split_init(MppSplit *split, MppCodingType coding)
+{
+    MppSplitImpl *p = NULL;
+    const MppSplitRule *rule = NULL;
+    RK_U32 i;
+
+    if (NULL == split) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *split = NULL;
+
+    mpp_env_get_u32("mpp_split_debug", &mpp_split_debug, 0);
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(split_rules); i++) {
+        if (split_rules[i].coding == coding) {
+            rule = &split_rules[i];
+            break;
+        }
+    }
+
+    if (NULL == rule) {
+        mpp_err_f("coding %x is not supported\n", coding);
+        return MPP_NOK;
+    }
+
+    p = mpp_calloc(MppSplitImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->buffer = mpp_malloc(RK_U8, SPLIT_INIT_BUFFER_SIZE);
+    if (NULL == p->buffer) {
+        mpp_err_f("failed to malloc buffer\n");
+        mpp_free(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    p->rule = rule;
+    p->buffer_size = SPLIT_INIT_BUFFER_SIZE;
+    p->fetch_timestamp = 1;
+
+    *split = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_split_deinit(MppSplit split)
+{
+    MppSplitImpl *p = (MppSplitImpl *)split;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    MPP_FREE(p->buffer);
+    mpp_free(p);
+    return MPP_OK;
+}
+
+MPP_RET mpp_split_reset(MppSplit split)
+{
+    MppSplitImpl *p = (MppSplitImpl *)split;
+    const MppSplitRule *rule;
+    RK_U8 *buf;
+    RK_U32 size;
+
+    if (NULL == p)
+        return MPP_OK;
+
+    rule = p->rule;
+    buf = p->buffer;
+    size = p->buffer_size;
+
+    memset(p, 0, sizeof(*p));
+    p->rule = rule;
+    p->buffer = buf;
+    p->buffer_size = size;
+    p->fetch_timestamp = 1;
+    return MPP_OK;
+}
+
+void mpp_split_set_eos(MppSplit split, RK_U32 eos)
+{
+    MppSplitImpl *p = (MppSplitImpl *)split;
+
+    if (p)
+        p->eos = eos;
+}
+
+RK_S32 mpp_split_frame(MppSplit split, const RK_U8 **out, RK_S32 *out_size,
+                       const RK_U8 *buf, RK_S32 size, RK_S64 pts, RK_S64 dts)
+{
+    MppSplitImpl *p = (MppSplitImpl *)split;
+    RK_S32 next;
+
+    if (p->cur_offset + size != p->cur_frame_end[p->cur_frame_start_index]) {
+        // add a new packet descriptor
+        RK_S32 i = (p->cur_frame_start_index + 1) & (SPLIT_PTS_NB - 1);
+
+        p->cur_frame_start_index = i;
+        p->cur_frame_offset[i] = p->cur_offset;
+        p->cur_frame_end[i] = p->cur_offset + size;
+        p->cur_frame_pts[i] = pts;
+        p->cur_frame_dts[i] = dts;
+    }
+
+    if (p->fetch_timestamp) {
+        p->fetch_timestamp = 0;
+        split_fetch_timestamp(p, 0);
+    }
+
+    next = p->rule->find(p, buf, size);
+    // all remaining data belongs to the last frame on eos
+    if (p->eos && next == SPLIT_END_NOT_FOUND)
+        next = size;
+
+    if (split_combine_frame(p, next, &buf, &size) < 0) {
+        *out = NULL;
+        *out_size = 0;
+        p->cur_offset += size;
+        return size;
+    }
+
+    // drop container headers in front of the frame
+    if (p->skip) {
+        RK_S32 skip = MPP_MIN(p->skip, size);
+
+        buf += skip;
+        size -= skip;
+        p->skip = 0;
+    }
+
+    *out = buf;
+    *out_size = size;
+
+    if (next < 0)
+        next = 0;
+
+    if (*out_size) {
+        // fill the data for the current frame
+        p->frame_offset = p->next_frame_offset;
+        // offset of the next frame
+        p->next_frame_offset = p->cur_offset + next;
+        p->fetch_timestamp = 1;
+        split_dbg(MPP_SPLIT_DBG_FRAME, "frame size %d pts %lld\n", *out_size, p->pts);
+    }
+
+    p->cur_offset += next;
+    return next;
+}
+
+RK_S64 mpp_split_get_pts(MppSplit split)
+{
+    MppSplitImpl *p = (MppSplitImpl *)split;
+
+    return (p) ? (p->pts) : (-1);
+}
+
+RK_S64 mpp_split_get_dts(MppSplit split)
+{
+    MppSplitImpl *p = (MppSplitImpl *)split;
+
+    return (p) ? (p->dts) : (-1);
+}
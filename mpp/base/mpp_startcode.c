@@ -0,0 +1,106 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_startcode"
+
+#include <string.h>
+
+#include "mpp_startcode.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+#define STARTCODE_BLOCK_SIZE    16
+
+static RK_U32 block_has_zero(const RK_U8 *p)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+
+#define STARTCODE_BLOCK_SIZE    16
+
+static RK_U32 block_has_zero(const RK_U8 *p)
+{
+    uint8x16_t v = vld1q_u8(p);
+
+    return vmaxvq_u8(vceqq_u8(v, vdupq_n_u8(0)));
+}
+#else
+#define STARTCODE_BLOCK_SIZE    8
+
+static RK_U32 block_has_zero(const RK_U8 *p)
+{
+    RK_U64 v;
+
+    memcpy(&v, p, sizeof(v));
+    return ((v - 0x0101010101010101ULL) & ~v & 0x8080808080808080ULL) != 0;
+}
+#endif
+
+RK_S32 mpp_find_startcode(const RK_U8 *buf, RK_S32 len)
+{
+    // a start code can begin at most at len - 3
+    RK_S32 end = len - 2;
+    RK_S32 i = 0;
+
+    while (i < end) {
+        RK_S32 stop;
+
+        // no zero byte means no start code begins in this block
+        if (i + STARTCODE_BLOCK_SIZE <= end && !block_has_zero(buf + i)) {
+            i += STARTCODE_BLOCK_SIZE;
+            continue;
+        }
+
+        stop = i + STARTCODE_BLOCK_SIZE;
+        if (stop > end)
+            stop = end;
+
+        while (i < stop) {
+            // 00 00 01 can not begin at i, i + 1 or i + 2 when buf[i + 2] > 1
+            if (buf[i + 2] > 1)
+                i += 3;
+            else if (buf[i + 2] == 1 && !buf[i + 1] && !buf[i])
+                return i;
+            else
+                i++;
+        }
+    }
+
+    return -1;
+}
+
+RK_S32 mpp_find_startcodes(const RK_U8 *buf, RK_S32 len, RK_S32 *pos, RK_S32 max)
+{
+    RK_S32 offset = 0;
+    RK_S32 count = 0;
+
+    while (count < max) {
+        RK_S32 found = mpp_find_startcode(buf + offset, len - offset);
+
+        if (found < 0)
+            break;
+
+        pos[count++] = offset + found;
+        offset += found + 3;
+    }
+
+    return count;
+}
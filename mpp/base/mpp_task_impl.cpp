@@ -17,31 +17,51 @@
 #define MODULE_TAG "mpp_task_impl"
 
 #include <string.h>
+#include <time.h>
 
 #include "mpp_log.h"
 #include "mpp_mem.h"
+#include "mpp_atomic.h"
 
 #include "mpp_task_impl.h"
 
 #define MAX_TASK_COUNT      8
 
-typedef struct MppTaskStatusInfo_t {
-    struct list_head    list;
-    RK_S32              count;
-    MppTaskStatus       status;
-} MppTaskStatusInfo;
+/*
+ * Each port is used by one thread on each side. So the tasks in MPP_INPUT_PORT
+ * and MPP_OUTPUT_PORT status are kept in single producer single consumer rings:
+ *
+ * ring MPP_OUTPUT_PORT : produced by input  port enqueue, consumed by output port dequeue
+ * ring MPP_INPUT_PORT  : produced by output port enqueue, consumed by input  port dequeue
+ *
+ * Tasks in hold status are owned by port user and are not recorded in any ring.
+ * Ring size is not less than task count so the ring never overflows.
+ * Lock and condition are only used when poll has to wait on an empty ring.
+ */
+typedef struct MppTaskRing_t {
+    // read position, only changed by consumer
+    RK_U32              head;
+    // write position, only changed by producer
+    RK_U32              tail;
+    // number of poll waiting on this ring
+    RK_S32              waiting;
+    MppTaskImpl         **tasks;
+} MppTaskRing;
 
 typedef struct MppTaskQueueImpl_t {
     Mutex               *lock;
+    Condition           *cond;
     RK_S32              task_count;
+    RK_U32              ring_mask;
 
     // two ports inside of task queue
     MppPort             input;
     MppPort             output;
 
     MppTaskImpl         *tasks;
+    MppTaskImpl         **ring_buf;
 
-    MppTaskStatusInfo   info[MPP_TASK_STATUS_BUTT];
+    MppTaskRing         ring[MPP_TASK_STATUS_BUTT];
 } MppTaskQueueImpl;
 
 typedef struct MppPortImpl_t {
@@ -70,6 +90,44 @@ MPP_RET check_mpp_task_name(MppTask task)
     return MPP_NOK;
 }
 
+static RK_U32 task_ring_count(MppTaskRing *ring)
+{
+    return (RK_U32)MPP_ATOMIC_LOAD(&ring->tail) - (RK_U32)MPP_ATOMIC_LOAD(&ring->head);
+}
+
+/* NOTE: called by the only consumer of the ring */
+static MppTaskImpl *task_ring_pop(MppTaskQueueImpl *queue, MppTaskRing *ring)
+{
+    RK_U32 head = ring->head;
+
+    if (head == (RK_U32)MPP_ATOMIC_LOAD(&ring->tail))
+        return NULL;
+
+    MppTaskImpl *task = ring->tasks[head & queue->ring_mask];
+    MPP_ATOMIC_STORE(&ring->head, head + 1);
+    return task;
+}
+
+/* NOTE: called by the only producer of the ring */
+static void task_ring_push(MppTaskQueueImpl *queue, MppTaskRing *ring, MppTaskImpl *task)
+{
+    RK_U32 tail = ring->tail;
+
+    mpp_assert(tail - (RK_U32)MPP_ATOMIC_LOAD(&ring->head) <= queue->ring_mask);
+    ring->tasks[tail & queue->ring_mask] = task;
+    MPP_ATOMIC_STORE(&ring->tail, tail + 1);
+
+    /*
+     * pair with the fence in mpp_port_poll: either poll finds the new task or
+     * the waiter is found here and woken up
+     */
+    MPP_ATOMIC_FENCE();
+    if (MPP_ATOMIC_LOAD(&ring->waiting)) {
+        AutoMutex auto_lock(queue->lock);
+        queue->cond->broadcast();
+    }
+}
+
 static MPP_RET mpp_port_init(MppTaskQueueImpl *queue, MppPortType type, MppPort *port)
 {
     MppPortImpl *impl = mpp_malloc(MppPortImpl, 1);
@@ -107,43 +165,80 @@ MPP_RET mpp_port_can_dequeue(MppPort port)
     MppPortImpl *port_impl = (MppPortImpl *)port;
     MppTaskQueueImpl *queue = port_impl->queue;
 
-    AutoMutex auto_lock(queue->lock);
-    MppTaskStatusInfo *curr = &queue->info[port_impl->status_curr];
+    return (task_ring_count(&queue->ring[port_impl->status_curr])) ? (MPP_OK) : (MPP_NOK);
+}
+
+/* same clock as Condition::timedwait, in millisecond */
+static RK_S64 mpp_port_poll_time(void)
+{
+    struct timespec ts;
 
-    if (curr->count) {
-        mpp_assert(!list_empty(&curr->list));
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (RK_S64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+MPP_RET mpp_port_poll(MppPort port, RK_S64 timeout)
+{
+    MppPortImpl *port_impl = (MppPortImpl *)port;
+    MppTaskQueueImpl *queue = port_impl->queue;
+    MppTaskRing *ring = &queue->ring[port_impl->status_curr];
+    MPP_RET ret = MPP_OK;
+    RK_S64 deadline = 0;
+
+    if (task_ring_count(ring))
         return MPP_OK;
+
+    if (MPP_POLL_NON_BLOCK == timeout)
+        return MPP_NOK;
+
+    if (timeout > 0)
+        deadline = mpp_port_poll_time() + timeout;
+
+    AutoMutex auto_lock(queue->lock);
+
+    MPP_ATOMIC_ADD_FETCH(&ring->waiting, 1);
+    MPP_ATOMIC_FENCE();
+
+    /*
+     * NOTE: enqueue on any port of the queue will broadcast the condition
+     * so recheck the task count on each wake up and keep waiting until the
+     * deadline instead of restarting the full timeout
+     */
+    while (0 == task_ring_count(ring)) {
+        RK_S64 remain = 0;
+
+        if (timeout < 0) {
+            queue->cond->wait(*queue->lock);
+            continue;
+        }
+
+        remain = deadline - mpp_port_poll_time();
+        if (remain <= 0 || queue->cond->timedwait(*queue->lock, remain)) {
+            if (0 == task_ring_count(ring))
+                ret = MPP_ERR_TIMEOUT;
+            break;
+        }
     }
 
-    mpp_assert(list_empty(&curr->list));
-    return MPP_NOK;
+    MPP_ATOMIC_SUB_FETCH(&ring->waiting, 1);
+
+    return ret;
 }
 
 MPP_RET mpp_port_dequeue(MppPort port, MppTask *task)
 {
     MppPortImpl *port_impl = (MppPortImpl *)port;
     MppTaskQueueImpl *queue = port_impl->queue;
-
-    AutoMutex auto_lock(queue->lock);
-    MppTaskStatusInfo *curr = &queue->info[port_impl->status_curr];
-    MppTaskStatusInfo *next = &queue->info[port_impl->next_on_dequeue];
+    MppTaskImpl *task_impl = task_ring_pop(queue, &queue->ring[port_impl->status_curr]);
 
     *task = NULL;
-    if (curr->count == 0) {
-        mpp_assert(list_empty(&curr->list));
+    if (NULL == task_impl)
         return MPP_OK;
-    }
 
-    MppTaskImpl *task_impl = list_entry(curr->list.next, MppTaskImpl, list);
     MppTask p = (MppTask)task_impl;
     check_mpp_task_name(p);
-    list_del_init(&task_impl->list);
-    curr->count--;
-    mpp_assert(curr->count >= 0);
-
-    list_add_tail(&task_impl->list, &next->list);
-    next->count++;
-    task_impl->status = next->status;
+    mpp_assert(task_impl->status == port_impl->status_curr);
+    task_impl->status = port_impl->next_on_dequeue;
 
     *task = p;
 
@@ -160,15 +255,9 @@ MPP_RET mpp_port_enqueue(MppPort port, MppTask task)
     mpp_assert(task_impl->queue  == (MppTaskQueue *)queue);
     mpp_assert(task_impl->status == port_impl->next_on_dequeue);
 
-    AutoMutex auto_lock(queue->lock);
-    MppTaskStatusInfo *curr = &queue->info[task_impl->status];
-    MppTaskStatusInfo *next = &queue->info[port_impl->next_on_enqueue];
-
-    list_del_init(&task_impl->list);
-    curr->count--;
-    list_add_tail(&task_impl->list, &next->list);
-    next->count++;
-    task_impl->status = next->status;
+    // status must be updated before the task is visible to the other side
+    task_impl->status = port_impl->next_on_enqueue;
+    task_ring_push(queue, &queue->ring[port_impl->next_on_enqueue], task_impl);
 
     return MPP_OK;
 }
@@ -181,31 +270,28 @@ MPP_RET mpp_task_queue_init(MppTaskQueue *queue)
     }
 
     MppTaskQueueImpl *p = NULL;
-    MppTaskImpl *tasks = NULL;
     Mutex *lock = NULL;
+    Condition *cond = NULL;
 
     do {
-        RK_S32 i;
-
         p = mpp_calloc(MppTaskQueueImpl, 1);
         if (NULL == p) {
             mpp_err_f("malloc queue failed\n");
             break;
         }
-        lock = new Mutex();
+        lock = new Mutex(MPP_MUTEX_ADAPTIVE);
         if (NULL == lock) {
             mpp_err_f("new lock failed\n");
             break;;
         }
-
-        for (i = 0; i < MPP_TASK_STATUS_BUTT; i++) {
-            INIT_LIST_HEAD(&p->info[i].list);
-            p->info[i].count  = 0;
-            p->info[i].status = (MppTaskStatus)i;
+        cond = new Condition();
+        if (NULL == cond) {
+            mpp_err_f("new condition failed\n");
+            break;
         }
 
         p->lock         = lock;
-        p->tasks        = tasks;
+        p->cond         = cond;
 
         if (mpp_port_init(p, MPP_PORT_INPUT, &p->input))
             break;
@@ -223,8 +309,8 @@ MPP_RET mpp_task_queue_init(MppTaskQueue *queue)
         mpp_free(p);
     if (lock)
         delete lock;
-    if (tasks)
-        mpp_free(tasks);
+    if (cond)
+        delete cond;
 
     *queue = NULL;
     return MPP_NOK;
@@ -238,28 +324,41 @@ MPP_RET mpp_task_queue_setup(MppTaskQueue queue, RK_S32 task_count)
     // NOTE: queue can only be setup once
     mpp_assert(impl->tasks == NULL);
     mpp_assert(impl->task_count == 0);
+    mpp_assert(task_count > 0);
+
+    RK_U32 ring_size = 1;
+    while (ring_size < (RK_U32)task_count)
+        ring_size <<= 1;
+
     MppTaskImpl *tasks = mpp_calloc(MppTaskImpl, task_count);
-    if (NULL == tasks) {
+    MppTaskImpl **ring_buf = mpp_calloc(MppTaskImpl *, ring_size * 2);
+    if (NULL == tasks || NULL == ring_buf) {
         mpp_err_f("malloc tasks list failed\n");
+        mpp_free(tasks);
+        mpp_free(ring_buf);
         return MPP_ERR_MALLOC;
     }
 
     impl->tasks = tasks;
+    impl->ring_buf = ring_buf;
     impl->task_count = task_count;
+    impl->ring_mask = ring_size - 1;
+    impl->ring[MPP_INPUT_PORT].tasks  = ring_buf;
+    impl->ring[MPP_OUTPUT_PORT].tasks = ring_buf + ring_size;
 
-    MppTaskStatusInfo *info = &impl->info[MPP_INPUT_PORT];
+    MppTaskRing *ring = &impl->ring[MPP_INPUT_PORT];
 
     for (RK_S32 i = 0; i < task_count; i++) {
         setup_mpp_task_name(&tasks[i]);
-        INIT_LIST_HEAD(&tasks[i].list);
         tasks[i].index  = i;
         tasks[i].queue  = (MppTaskQueue *)queue;
         tasks[i].status = MPP_INPUT_PORT;
         mpp_meta_get(&tasks[i].meta);
 
-        list_add_tail(&tasks[i].list, &info->list);
-        info->count++;
+        ring->tasks[i] = &tasks[i];
     }
+    MPP_ATOMIC_STORE(&ring->tail, (RK_U32)task_count);
+
     return MPP_OK;
 }
 
@@ -288,8 +387,12 @@ MPP_RET mpp_task_queue_deinit(MppTaskQueue queue)
         }
         mpp_free(p->tasks);
     }
+    if (p->ring_buf)
+        mpp_free(p->ring_buf);
     if (p->lock)
         delete p->lock;
+    if (p->cond)
+        delete p->cond;
     mpp_free(p);
     return MPP_OK;
 }
@@ -304,4 +407,3 @@ MppPort mpp_task_queue_get_port(MppTaskQueue queue, MppPortType type)
     MppTaskQueueImpl *impl = (MppTaskQueueImpl *)queue;
     return (type == MPP_PORT_INPUT) ? (impl->input) : (impl->output);
 }
-
@@ -233,6 +233,8 @@ static MPP_RET free_vid_ctx(H264dVideoCtx_t *p_Vid)
     for (i = 0; i < MAXSPS; i++) {
         recycle_subsps(&p_Vid->subspsSet[i]);
     }
+    mpp_ps_cache_deinit(p_Vid->sps_cache, MAXSPS);
+    mpp_ps_cache_deinit(p_Vid->pps_cache, MAXPPS);
     for (i = 0; i < MAX_NUM_DPB_LAYERS; i++) {
         free_dpb(p_Vid->p_Dpb_layer[i]);
         MPP_FREE(p_Vid->p_Dpb_layer[i]);
@@ -338,6 +340,12 @@ static MPP_RET free_dec_ctx(H264_DecCtx_t *p_Dec)
     }
     //!< free mpp packet
     mpp_packet_deinit(&p_Dec->task_pkt);
+    if (p_Dec->split) {
+        mpp_split_deinit(p_Dec->split);
+        p_Dec->split = NULL;
+    }
+    if (p_Dec->split_pkt)
+        mpp_packet_deinit(&p_Dec->split_pkt);
 
     FunctionOut(p_Dec->logctx.parr[RUN_PARSE]);
 __RETURN:
@@ -370,6 +378,12 @@ static MPP_RET init_dec_ctx(H264_DecCtx_t *p_Dec)
     //!< malloc mpp packet
     mpp_packet_init(&p_Dec->task_pkt, p_Dec->dxva_ctx->bitstream, p_Dec->dxva_ctx->max_strm_size);
     MEM_CHECK(ret, p_Dec->task_pkt);
+    //!< split input stream into frames on need_split mode
+    if (p_Dec->need_split) {
+        FUN_CHECK(ret = mpp_split_init(&p_Dec->split, MPP_VIDEO_CodingAVC));
+        mpp_packet_init(&p_Dec->split_pkt, NULL, 0);
+        MEM_CHECK(ret, p_Dec->split_pkt);
+    }
     //!< set Dec support decoder method
     p_Dec->spt_decode_mtds = MPP_DEC_BY_FRAME;
     p_Dec->next_state = SliceSTATE_ResetSlice;
@@ -408,6 +422,7 @@ MPP_RET h264d_init(void *decoder, ParserCfg *init)
     //!< get init frame_slots and packet_slots
     p_Dec->frame_slots  = init->frame_slots;
     p_Dec->packet_slots = init->packet_slots;
+    p_Dec->need_split   = init->need_split;
     //!< malloc decoder buffer
     p_Dec->p_Inp = mpp_calloc(H264dInputCtx_t, 1);
     p_Dec->p_Cur = mpp_calloc(H264dCurCtx_t, 1);
@@ -511,11 +526,13 @@ MPP_RET h264d_reset(void *decoder)
     p_strm = &p_Dec->p_Cur->strm;
     p_strm->prefixdata      = 0xffffffff;
     p_strm->nalu_offset     = 0;
+    p_strm->nalu_pos        = NULL;
     p_strm->nalu_len        = 0;
     p_strm->head_offset     = 0;
     p_strm->startcode_found = 0;
     p_strm->endcode_found   = 0;
     p_strm->startcode_found = p_Dec->p_Inp->is_nalff;
+    mpp_split_reset(p_Dec->split);
     //!< reset decoder parameter
     p_Dec->next_state = SliceSTATE_ResetSlice;
     p_Dec->nalu_ret = NALU_NULL;
@@ -609,6 +626,71 @@ __RETURN:
 ***********************************************************************
 */
 #define MAX_STREM_IN_SIZE         (10*1024*1024)
+static MPP_RET prepare_split_frame(H264_DecCtx_t *p_Dec, MppPacket pkt, HalDecTask *task)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+    H264dInputCtx_t *p_Inp = p_Dec->p_Inp;
+    RK_U8 *buf = (RK_U8 *)mpp_packet_get_pos(pkt);
+    RK_S32 length = (RK_S32)mpp_packet_get_length(pkt);
+    RK_U32 eos = mpp_packet_get_eos(pkt);
+    const RK_U8 *out = NULL;
+    RK_S32 out_size = 0;
+    RK_S32 consume = 0;
+
+    mpp_split_set_eos(p_Dec->split, eos);
+    consume = mpp_split_frame(p_Dec->split, &out, &out_size, buf, length,
+                              mpp_packet_get_pts(pkt), mpp_packet_get_dts(pkt));
+    mpp_packet_set_pos(pkt, buf + consume);
+    mpp_packet_set_length(pkt, length - consume);
+    //!< only the last frame of eos packet carries eos
+    eos = eos && (consume == length);
+
+    task->valid = 0;
+    p_Inp->pkt_eos = 0;
+    if (out_size) {
+        //!< one whole access unit, prepare it as one input packet
+        mpp_packet_set_data(p_Dec->split_pkt, (void *)out);
+        mpp_packet_set_size(p_Dec->split_pkt, out_size);
+        mpp_packet_set_pos(p_Dec->split_pkt, (void *)out);
+        p_Inp->in_pkt    = p_Dec->split_pkt;
+        p_Inp->in_buf    = (RK_U8 *)out;
+        p_Inp->in_length = out_size;
+        p_Inp->in_pts    = mpp_split_get_pts(p_Dec->split);
+        p_Inp->in_dts    = mpp_split_get_dts(p_Dec->split);
+        fwrite_stream_to_file(p_Inp, p_Inp->in_buf, (RK_U32)p_Inp->in_length);
+        do {
+            FUN_CHECK(ret = parse_prepare_fast(p_Inp, p_Dec->p_Cur));
+            task->valid = p_Inp->task_valid;  //!< prepare valid flag
+        } while (mpp_packet_get_length(p_Dec->split_pkt) && !task->valid);
+    }
+    if (eos) {
+        p_Inp->pkt_eos     = 1;
+        p_Inp->task_eos    = 1;
+        p_Inp->has_get_eos = 1;
+        if (!task->valid)
+            h264d_flush(p_Dec);
+    }
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
+static void prepare_task_packet(H264_DecCtx_t *p_Dec, HalDecTask *task)
+{
+    task->flags.eos = p_Dec->p_Inp->pkt_eos;
+    if (task->valid) {
+        memset(p_Dec->dxva_ctx->bitstream + p_Dec->dxva_ctx->strm_offset, 0,
+               MPP_ALIGN(p_Dec->dxva_ctx->strm_offset, 16) - p_Dec->dxva_ctx->strm_offset);
+        mpp_packet_set_data(p_Dec->task_pkt, p_Dec->dxva_ctx->bitstream);
+        mpp_packet_set_length(p_Dec->task_pkt, MPP_ALIGN(p_Dec->dxva_ctx->strm_offset, 16));
+        mpp_packet_set_size(p_Dec->task_pkt, p_Dec->dxva_ctx->max_strm_size);
+        task->input_packet = p_Dec->task_pkt;
+    } else {
+        task->input_packet = NULL;
+    }
+}
+
 MPP_RET h264d_prepare(void *decoder, MppPacket pkt, HalDecTask *task)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
@@ -623,6 +705,13 @@ MPP_RET h264d_prepare(void *decoder, MppPacket pkt, HalDecTask *task)
         mpp_packet_set_length(pkt, 0);
         goto __RETURN;
     }
+    //!< annexb stream on need_split mode
+    if (p_Dec->split && !p_Inp->is_nalff &&
+        !(mpp_packet_get_flag(pkt) & MPP_PACKET_FLAG_EXTRA_DATA)) {
+        FUN_CHECK(ret = prepare_split_frame(p_Dec, pkt, task));
+        prepare_task_packet(p_Dec, task);
+        goto __RETURN;
+    }
     p_Inp->in_pkt = pkt;
     p_Inp->in_pts = mpp_packet_get_pts(pkt);
     p_Inp->in_dts = mpp_packet_get_dts(pkt);
@@ -672,17 +761,7 @@ MPP_RET h264d_prepare(void *decoder, MppPacket pkt, HalDecTask *task)
             task->valid = p_Inp->task_valid;  //!< prepare valid flag
         } while (mpp_packet_get_length(pkt) && !task->valid);
     }
-    task->flags.eos = p_Inp->pkt_eos;
-    if (task->valid) {
-        memset(p_Dec->dxva_ctx->bitstream + p_Dec->dxva_ctx->strm_offset, 0,
-               MPP_ALIGN(p_Dec->dxva_ctx->strm_offset, 16) - p_Dec->dxva_ctx->strm_offset);
-        mpp_packet_set_data(p_Dec->task_pkt, p_Dec->dxva_ctx->bitstream);
-        mpp_packet_set_length(p_Dec->task_pkt, MPP_ALIGN(p_Dec->dxva_ctx->strm_offset, 16));
-        mpp_packet_set_size(p_Dec->task_pkt, p_Dec->dxva_ctx->max_strm_size);
-        task->input_packet = p_Dec->task_pkt;
-    } else {
-        task->input_packet = NULL;
-    }
+    prepare_task_packet(p_Dec, task);
 __RETURN:
     FunctionOut(p_Dec->logctx.parr[RUN_PARSE]);
 
@@ -246,6 +246,9 @@ void fill_picparams(H264dVideoCtx_t *p_Vid, DXVA_PicParams_H264_MVC *pp)
     } else {
         pp->scaleing_list_enable_flag = 0;
     }
+    pp->seq_parameter_set_id = p_Vid->active_sps->seq_parameter_set_id;
+    pp->pic_parameter_set_id = p_Vid->active_pps->pic_parameter_set_id;
+    pp->spspps_version = p_Vid->spspps_version;
 }
 
 /*!
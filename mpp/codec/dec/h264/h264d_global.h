@@ -21,6 +21,8 @@
 #include <stdio.h>
 #include "rk_type.h"
 #include "rk_mpi.h"
+#include "mpp_split.h"
+#include "mpp_ps_cache.h"
 
 #include "h264d_api.h"
 #include "h264d_log.h"
@@ -846,6 +848,7 @@ typedef struct h264d_curstrm_t {
     RK_S32    nalu_type;
     RK_U32    nalu_len;
     RK_U8     *nalu_buf;       //!< store read nalu data
+    RK_U8     *nalu_pos;       //!< nalu data in input packet, NULL when in nalu_buf
 
     RK_U32    head_offset;
     RK_U32    head_max_size;
@@ -894,6 +897,8 @@ typedef struct h264d_video_ctx_t {
     struct h264_sps_t            spsSet[MAXSPS];      //!< MAXSPS, all sps storage
     struct h264_subsps_t         subspsSet[MAXSPS];   //!< MAXSPS, all subpps storage
     struct h264_pps_t            ppsSet[MAXPPS];      //!< MAXPPS, all pps storage
+    MppPsCache                   sps_cache[MAXSPS];   //!< raw nal of stored sps
+    MppPsCache                   pps_cache[MAXPPS];   //!< raw nal of stored pps
     struct h264_sps_t            *active_sps;
     struct h264_subsps_t         *active_subsps;
     struct h264_pps_t            *active_pps;
@@ -960,6 +965,8 @@ typedef struct h264d_video_ctx_t {
     //!< for error tolerance
     RK_U32     g_framecnt;
     RK_U32     dpb_size[MAX_NUM_DPB_LAYERS];
+    //!< increased when any sps/subsps/pps is stored
+    RK_U32     spspps_version;
 
 } H264dVideoCtx_t;
 
@@ -1049,6 +1056,10 @@ typedef struct h264_dec_ctx_t {
     MppBufSlots                packet_slots;
 
     MppPacket                  task_pkt;
+    //!< frame splitter for need_split mode
+    RK_U32                     need_split;
+    MppSplit                   split;
+    MppPacket                  split_pkt;
 
     RK_S64                     task_pts;
     RK_U32                     task_eos;
@@ -24,6 +24,7 @@
 #include "mpp_mem.h"
 #include "mpp_packet.h"
 #include "mpp_packet_impl.h"
+#include "mpp_startcode.h"
 #include "hal_task.h"
 
 #include "h264d_parse.h"
@@ -137,15 +138,113 @@ static void reset_nalu(H264dCurStream_t *p_strm)
     }
 }
 
-static void find_prefix_code(RK_U8 *p_data, H264dCurStream_t *p_strm)
+static void set_prefix_found(H264dCurStream_t *p_strm)
+{
+    if (p_strm->startcode_found) {
+        p_strm->endcode_found = 1;
+    } else {
+        p_strm->startcode_found = 1;
+    }
+}
+
+static RK_U32 find_prefix_code(RK_U8 *p_data, H264dCurStream_t *p_strm)
 {
     p_strm->prefixdata = (p_strm->prefixdata << 8) | (*p_data);
     if ((p_strm->prefixdata & 0x00FFFFFF) == 0x00000001) {
-        if (p_strm->startcode_found) {
-            p_strm->endcode_found = 1;
-        } else {
-            p_strm->startcode_found = 1;
-        }
+        set_prefix_found(p_strm);
+        return 1;
+    }
+    return 0;
+}
+
+/*!
+***********************************************************************
+* \brief
+*    find the next prefix code in bulk, return the consumed size
+*    including the prefix code
+***********************************************************************
+*/
+static RK_U32 scan_prefix_code(RK_U8 *p_data, RK_U32 len, H264dCurStream_t *p_strm)
+{
+    RK_U32 i = 0;
+    RK_S32 pos = 0;
+
+    //!< prefix code across the previous data
+    for (i = 0; i < len && i < 2; i++) {
+        if (find_prefix_code(&p_data[i], p_strm))
+            return i + 1;
+    }
+    if (len <= 2)
+        return len;
+
+    pos = mpp_find_startcode(p_data, (RK_S32)len);
+    if (pos < 0) {
+        for (i = (len > 5) ? (len - 3) : 2; i < len; i++)
+            p_strm->prefixdata = (p_strm->prefixdata << 8) | p_data[i];
+        return len;
+    }
+    p_strm->prefixdata = 0x00000001;
+    set_prefix_found(p_strm);
+
+    return pos + START_PREFIX_3BYTE;
+}
+
+static MPP_RET append_nalu_data(H264dCurStream_t *p_strm, RK_U8 *p_data, RK_U32 len)
+{
+    MPP_RET ret = MPP_ERR_UNKNOW;
+
+    if ((p_strm->nalu_len + len) >= p_strm->nalu_max_size) {
+        RK_U32 add_size = p_strm->nalu_len + len + 1 - p_strm->nalu_max_size;
+        FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
+    }
+    memcpy(&p_strm->nalu_buf[p_strm->nalu_len], p_data, len);
+    p_strm->nalu_len += len;
+
+    return ret = MPP_OK;
+__FAILED:
+    return ret;
+}
+
+/*!
+***********************************************************************
+* \brief
+*    move the nalu referenced in input packet into nalu buffer
+***********************************************************************
+*/
+static MPP_RET detach_nalu_data(H264dCurStream_t *p_strm)
+{
+    MPP_RET ret = MPP_OK;
+    RK_U8 *p_data = p_strm->nalu_pos;
+    RK_U32 len = p_strm->nalu_len;
+
+    if (p_data) {
+        p_strm->nalu_pos = NULL;
+        p_strm->nalu_len = 0;
+        ret = append_nalu_data(p_strm, p_data, len);
+    }
+    return ret;
+}
+
+static RK_U32 get_judge_size(H264dCurStream_t *p_strm)
+{
+    if (!p_strm->nalu_len)
+        return 1;
+
+    //!< nalu header bytes and four bytes of slice header
+    if ((p_strm->nalu_type == NALU_TYPE_PREFIX)
+        || (p_strm->nalu_type == NALU_TYPE_SLC_EXT))
+        return 4 + 4;
+
+    return 1 + 4;
+}
+
+static void trim_cur_nalu(H264dCurStream_t *p_strm)
+{
+    RK_U8 *p_src = (p_strm->nalu_pos) ? (p_strm->nalu_pos) : (p_strm->nalu_buf);
+
+    p_strm->nalu_len -= START_PREFIX_3BYTE;
+    while (p_strm->nalu_len && p_src[p_strm->nalu_len - 1] == 0x00) {
+        p_strm->nalu_len--;
     }
 }
 
@@ -327,6 +426,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
     RK_U8 *p_des = NULL;
+    RK_U8 *p_src = (p_strm->nalu_pos) ? (p_strm->nalu_pos) : (p_strm->nalu_buf);
 
     //!< fill head buffer
     if (   (p_strm->nalu_type == NALU_TYPE_SLICE)
@@ -348,7 +448,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
         ((H264dNaluHead_t *)p_des)->is_frame_end  = 0;
         ((H264dNaluHead_t *)p_des)->nalu_type = p_strm->nalu_type;
         ((H264dNaluHead_t *)p_des)->sodb_len = head_size;
-        memcpy(p_des + sizeof(H264dNaluHead_t), p_strm->nalu_buf, head_size);
+        memcpy(p_des + sizeof(H264dNaluHead_t), p_src, head_size);
         p_strm->head_offset += add_size;
     }    //!< fill sodb buffer
     if ((p_strm->nalu_type == NALU_TYPE_SLICE)
@@ -362,7 +462,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
 
         p_des = &dxva_ctx->bitstream[dxva_ctx->strm_offset];
         memcpy(p_des, g_start_precode, sizeof(g_start_precode));
-        memcpy(p_des + sizeof(g_start_precode), p_strm->nalu_buf, p_strm->nalu_len);
+        memcpy(p_des + sizeof(g_start_precode), p_src, p_strm->nalu_len);
         dxva_ctx->strm_offset += add_size;
     }
     if (rkv_h264d_parse_debug & H264D_DBG_WRITE_ES_EN) {
@@ -372,7 +472,7 @@ static MPP_RET store_cur_nalu(H264dCurCtx_t *p_Cur, H264dCurStream_t *p_strm, H2
             if (p_Inp->spspps_update_flag) {
                 p_des = &p_Inp->spspps_buf[p_Inp->spspps_offset];
                 memcpy(p_des, g_start_precode, sizeof(g_start_precode));
-                memcpy(p_des + sizeof(g_start_precode), p_strm->nalu_buf, p_strm->nalu_len);
+                memcpy(p_des + sizeof(g_start_precode), p_src, p_strm->nalu_len);
                 p_Inp->spspps_offset += p_strm->nalu_len + sizeof(g_start_precode);
                 p_Inp->spspps_len = p_Inp->spspps_offset;
             }
@@ -529,7 +629,6 @@ MPP_RET close_stream_file(H264dInputCtx_t *p_Inp)
 MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
 {
     MPP_RET ret = MPP_ERR_UNKNOW;
-    RK_U32 nalu_header_bytes = 0;
 
     H264dLogCtx_t   *logctx  = &p_Inp->p_Dec->logctx;
     H264_DecCtx_t   *p_Dec   = p_Inp->p_Dec;
@@ -557,24 +656,29 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
         goto __RETURN;
     }
     while (pkt_impl->length > 0) {
-        p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
-        pkt_impl->length--;
-        if (p_strm->startcode_found) {
+        RK_U8 *p_data = &p_Inp->in_buf[p_strm->nalu_offset];
+        RK_U32 used = 1;
+
+        p_strm->curdata = p_data;
+        if (!p_strm->startcode_found) {
+            //!< drop the data before the first prefix code
+            used = scan_prefix_code(p_data, (RK_U32)pkt_impl->length, p_strm);
+            if (p_strm->startcode_found)
+                p_strm->nalu_pos = p_data + used;
+        } else if (p_strm->nalu_len < get_judge_size(p_strm)) {
+            //!< nalu header is read byte by byte for new frame judgement
             if (p_strm->nalu_len >= p_strm->nalu_max_size) {
                 FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, NALU_BUF_ADD_SIZE));
             }
-            p_strm->nalu_buf[p_strm->nalu_len++] = *p_strm->curdata;
+            p_strm->nalu_buf[p_strm->nalu_len++] = *p_data;
             if (p_strm->nalu_len == 1) {
                 p_strm->nalu_type = p_strm->nalu_buf[0] & 0x1F;
-                nalu_header_bytes += 1;
-                if ((p_strm->nalu_type == NALU_TYPE_PREFIX)
-                    || (p_strm->nalu_type == NALU_TYPE_SLC_EXT)) {
-                    nalu_header_bytes += 3;
-                }
             }
-            if (p_strm->nalu_len == (nalu_header_bytes + 4)) {
+            if (p_strm->nalu_len == get_judge_size(p_strm)) {
                 FUN_CHECK(ret = judge_is_new_frame(p_Cur, p_strm));
                 if (p_Cur->p_Dec->is_new_frame) {
+                    p_strm->nalu_offset++;
+                    pkt_impl->length--;
                     FUN_CHECK(ret = add_empty_nalu(&p_Cur->strm));
                     p_Cur->strm.head_offset = 0;
                     p_Cur->p_Inp->task_valid = 1;
@@ -582,24 +686,34 @@ MPP_RET parse_prepare(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
                     break;
                 }
             }
+            find_prefix_code(p_data, p_strm);
+        } else {
+            //!< nalu payload is referenced in place when it is in this packet
+            used = scan_prefix_code(p_data, (RK_U32)pkt_impl->length, p_strm);
+            if (p_strm->nalu_pos) {
+                p_strm->nalu_len += used;
+            } else {
+                FUN_CHECK(ret = append_nalu_data(p_strm, p_data, used));
+            }
         }
-
-        find_prefix_code(p_strm->curdata, p_strm);
+        p_strm->nalu_offset += used;
+        pkt_impl->length -= used;
 
         if (p_strm->endcode_found) {
-            p_strm->nalu_len -= START_PREFIX_3BYTE;
-            while (p_strm->nalu_buf[p_strm->nalu_len - 1] == 0x00) {
-                p_strm->nalu_len--;
-            }
+            trim_cur_nalu(p_strm);
             p_Dec->nalu_ret = EndOfNalu;
             FUN_CHECK(ret = store_cur_nalu(p_Cur, &p_Dec->p_Cur->strm, p_Dec->dxva_ctx));
             reset_nalu(p_strm);
+            //!< next nalu starts right after the prefix code
+            p_strm->nalu_pos = &p_Inp->in_buf[p_strm->nalu_offset];
             break;
         }
     }
     p_Inp->in_length = pkt_impl->length;
     //!< check input
     if (!p_Inp->in_length) {
+        //!< the input packet is released, keep the unfinished nalu
+        FUN_CHECK(ret = detach_nalu_data(p_strm));
         p_strm->nalu_offset = 0;
         p_Dec->nalu_ret = HaveNoStream;
     }
@@ -646,38 +760,35 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
         goto __RETURN;
     }
     while (pkt_impl->length > 0) {
-        p_strm->curdata = &p_Inp->in_buf[p_strm->nalu_offset++];
-        pkt_impl->length--;
-        if (p_strm->startcode_found) {
-            if (p_strm->nalu_len >= p_strm->nalu_max_size) {
-                FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, NALU_BUF_ADD_SIZE));
-            }
-            p_strm->nalu_buf[p_strm->nalu_len++] = *p_strm->curdata;
-            if (p_strm->nalu_len == 1) {
-                p_strm->nalu_type = p_strm->nalu_buf[0] & 0x1F;
-
-                if (p_strm->nalu_type == NALU_TYPE_SLICE
-                    || p_strm->nalu_type == NALU_TYPE_IDR || p_strm->nalu_type == NALU_TYPE_SLC_EXT) {
-                    p_strm->nalu_len += (RK_U32)pkt_impl->length;
-                    if (p_strm->nalu_len >= p_strm->nalu_max_size) {
-                        RK_U32 add_size =  pkt_impl->length + 1 - p_strm->nalu_max_size;
-                        FUN_CHECK(ret = realloc_buffer(&p_strm->nalu_buf, &p_strm->nalu_max_size, MPP_MAX(NALU_BUF_ADD_SIZE, add_size)));
-                    }
-                    memcpy(&p_strm->nalu_buf[0], p_strm->curdata, pkt_impl->length + 1);
-                    pkt_impl->length = 0;
-                    p_Cur->p_Inp->task_valid = 1;
-                    break;
-                }
+        RK_U8 *p_data = &p_Inp->in_buf[p_strm->nalu_offset];
+        RK_U32 used = 1;
+
+        p_strm->curdata = p_data;
+        if (!p_strm->startcode_found) {
+            used = scan_prefix_code(p_data, (RK_U32)pkt_impl->length, p_strm);
+        } else if (!p_strm->nalu_len) {
+            //!< nalu never crosses packet here, so reference it in place
+            p_strm->nalu_pos = p_data;
+            p_strm->nalu_type = p_data[0] & 0x1F;
+            if (p_strm->nalu_type == NALU_TYPE_SLICE
+                || p_strm->nalu_type == NALU_TYPE_IDR || p_strm->nalu_type == NALU_TYPE_SLC_EXT) {
+                p_strm->nalu_len = (RK_U32)pkt_impl->length;
+                p_strm->nalu_offset += p_strm->nalu_len;
+                pkt_impl->length = 0;
+                p_Cur->p_Inp->task_valid = 1;
+                break;
             }
+            p_strm->nalu_len = 1;
+            find_prefix_code(p_data, p_strm);
+        } else {
+            used = scan_prefix_code(p_data, (RK_U32)pkt_impl->length, p_strm);
+            p_strm->nalu_len += used;
         }
-
-        find_prefix_code(p_strm->curdata, p_strm);
+        p_strm->nalu_offset += used;
+        pkt_impl->length -= used;
 
         if (p_strm->endcode_found) {
-            p_strm->nalu_len -= START_PREFIX_3BYTE;
-            while (p_strm->nalu_buf[p_strm->nalu_len - 1] == 0x00) {
-                p_strm->nalu_len--;
-            }
+            trim_cur_nalu(p_strm);
             p_Dec->nalu_ret = EndOfNalu;
             FUN_CHECK(ret = store_cur_nalu(p_Cur, &p_Dec->p_Cur->strm, p_Dec->dxva_ctx));
             reset_nalu(p_strm);
@@ -701,6 +812,7 @@ MPP_RET parse_prepare_fast(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
             p_Dec->nalu_ret = HaveNoStream;
         }
         p_strm->nalu_offset = 0;
+        p_strm->nalu_pos = NULL;
         p_strm->endcode_found = 1;
 
         reset_nalu(p_strm);
@@ -735,6 +847,7 @@ MPP_RET parse_prepare_extra_header(H264dInputCtx_t *p_Inp, H264dCurCtx_t *p_Cur)
     FunctionIn(logctx->parr[RUN_PARSE]);
     //!< free nalu_buffer
     MPP_FREE(p_strm->nalu_buf);
+    p_strm->nalu_pos = NULL;
     if (p_Inp->in_length < 7) {
         H264D_ERR("avcC too short, len=%d \n", p_Inp->in_length);
         goto __FAILED;
@@ -139,15 +139,27 @@ MPP_RET process_pps(H264_SLICE_t *currSlice)
     H264dCurCtx_t *p_Cur = currSlice->p_Cur;
     BitReadCtx_t *p_bitctx = &p_Cur->bitctx;
     H264_PPS_t *cur_pps = &p_Cur->pps;
+    H264dVideoCtx_t *p_Vid = currSlice->p_Vid;
+    RK_U32 nal_hash = mpp_ps_cache_hash(p_bitctx->buf, p_bitctx->buf_len);
+    RK_S32 pps_id = 0;
 
     FunctionIn(logctx->parr[RUN_PARSE]);
+    //!< repeated pps, keep the stored one without parsing
+    pps_id = mpp_ps_cache_find(p_Vid->pps_cache, MAXPPS, p_bitctx->buf, p_bitctx->buf_len, nal_hash);
+    if (pps_id >= 0 && p_Vid->ppsSet[pps_id].Valid) {
+        H264D_DBG(H264D_DBG_PARSE_NALU, "skip repeated pps %d", pps_id);
+        goto __RETURN;
+    }
     reset_curpps_data(cur_pps);// reset
     set_bitread_logctx(p_bitctx, logctx->parr[LOG_READ_PPS]);
     FUN_CHECK(ret = parser_pps(p_bitctx, &p_Cur->sps, cur_pps));
     //!< MakePPSavailable
     ASSERT(cur_pps->Valid == 1);
-    memcpy(&currSlice->p_Vid->ppsSet[cur_pps->pic_parameter_set_id], cur_pps, sizeof(H264_PPS_t));
-
+    pps_id = cur_pps->pic_parameter_set_id;
+    memcpy(&p_Vid->ppsSet[pps_id], cur_pps, sizeof(H264_PPS_t));
+    p_Vid->spspps_version++;
+    mpp_ps_cache_update(&p_Vid->pps_cache[pps_id], p_bitctx->buf, p_bitctx->buf_len, nal_hash);
+__RETURN:
     FunctionOut(logctx->parr[RUN_PARSE]);
 
     return ret = MPP_OK;
@@ -391,7 +391,7 @@ MPP_RET process_sei(H264_SLICE_t *currSlice)
         sei_msg->payload_size += tmp_byte;   // this is the last byte
 
         //--- read sei info
-        FUN_CHECK(ret = parserSEI(currSlice, p_bitctx, sei_msg, p_bitctx->data_));
+        FUN_CHECK(ret = parserSEI(currSlice, p_bitctx, sei_msg, mpp_align_get_bits(p_bitctx)));
         //--- set offset to read next sei nal
         if (SEI_MVC_SCALABLE_NESTING == sei_msg->type) {
             sei_msg->payload_size = ((p_bitctx->used_bits + 0x07) >> 3);
@@ -400,7 +400,7 @@ MPP_RET process_sei(H264_SLICE_t *currSlice)
             READ_BITS(p_bitctx, 8, &tmp_byte, "tmp_byte");
         }
 
-    } while ((p_bitctx->data_[0] != 0x80) && (p_bitctx->bytes_left_ > 1));    // more_rbsp_data()  msg[offset] != 0x80
+    } while ((mpp_align_get_bits(p_bitctx)[0] != 0x80) && (p_bitctx->bytes_left_ > 1));    // more_rbsp_data()  msg[offset] != 0x80
 
     FunctionOut(currSlice->logctx->parr[RUN_PARSE]);
 
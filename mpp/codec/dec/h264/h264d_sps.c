@@ -400,6 +400,14 @@ static RK_U32 video_pars_changed(H264dVideoCtx_t *p_Vid, H264_SPS_t *sps, RK_U8
     return ret;
 }
 
+static void clear_pps_cache(H264dVideoCtx_t *p_Vid)
+{
+    RK_U32 i = 0;
+
+    for (i = 0; i < MAXPPS; i++)
+        mpp_ps_cache_clear(&p_Vid->pps_cache[i]);
+}
+
 static void update_last_video_pars(H264dVideoCtx_t *p_Vid, H264_SPS_t *sps, RK_U8 layer_id)
 {
     p_Vid->last_pic_width_in_mbs_minus1[layer_id] = sps->pic_width_in_mbs_minus1;
@@ -422,8 +430,22 @@ MPP_RET process_sps(H264_SLICE_t *currSlice)
     H264dCurCtx_t *p_Cur = currSlice->p_Cur;
     BitReadCtx_t *p_bitctx = &p_Cur->bitctx;
     H264_SPS_t *cur_sps = &p_Cur->sps;
+    H264dVideoCtx_t *p_Vid = currSlice->p_Vid;
+    RK_U32 nal_hash = mpp_ps_cache_hash(p_bitctx->buf, p_bitctx->buf_len);
+    RK_S32 sps_id = 0;
 
     FunctionIn(logctx->parr[RUN_PARSE]);
+    //!< repeated sps, restore the stored one as current sps without parsing
+    sps_id = mpp_ps_cache_find(p_Vid->sps_cache, MAXSPS, p_bitctx->buf, p_bitctx->buf_len, nal_hash);
+    if (sps_id >= 0 && p_Vid->spsSet[sps_id].Valid) {
+        //!< pps parsing depends on current sps
+        if (cur_sps->seq_parameter_set_id != sps_id || !cur_sps->Valid) {
+            memcpy(cur_sps, &p_Vid->spsSet[sps_id], sizeof(H264_SPS_t));
+            clear_pps_cache(p_Vid);
+        }
+        H264D_DBG(H264D_DBG_PARSE_NALU, "skip repeated sps %d", sps_id);
+        goto __RETURN;
+    }
     reset_cur_sps_data(cur_sps); // reset
     set_bitread_logctx(p_bitctx, logctx->parr[LOG_READ_SPS]);
     //!< parse sps
@@ -432,8 +454,13 @@ MPP_RET process_sps(H264_SLICE_t *currSlice)
     FUN_CHECK(ret = get_max_dec_frame_buf_size(cur_sps));
     //!< make SPS available, copy
     if (cur_sps->Valid) {
-        memcpy(&currSlice->p_Vid->spsSet[cur_sps->seq_parameter_set_id], cur_sps, sizeof(H264_SPS_t));
+        sps_id = cur_sps->seq_parameter_set_id;
+        memcpy(&p_Vid->spsSet[sps_id], cur_sps, sizeof(H264_SPS_t));
+        p_Vid->spspps_version++;
+        mpp_ps_cache_update(&p_Vid->sps_cache[sps_id], p_bitctx->buf, p_bitctx->buf_len, nal_hash);
+        clear_pps_cache(p_Vid);
     }
+__RETURN:
     FunctionOut(logctx->parr[RUN_PARSE]);
 
     return ret = MPP_OK;
@@ -514,6 +541,7 @@ MPP_RET process_subsps(H264_SLICE_t *currSlice)
         recycle_subsps(p_subset);
     }
     memcpy(p_subset, cur_subsps, sizeof(H264_subSPS_t));
+    currSlice->p_Vid->spspps_version++;
     FunctionOut(logctx->parr[RUN_PARSE]);
 
     return ret = MPP_OK;
@@ -33,6 +33,7 @@
 #include "mpp_env.h"
 #include "h265d_syntax.h"
 #include "mpp_packet_impl.h"
+#include "mpp_split.h"
 #include "h265d_api.h"
 
 #define START_CODE 0x000001 ///< start_code_prefix_one_3bytes
@@ -43,268 +44,6 @@ FILE *fp = NULL;
 #endif
 //static RK_U32 start_write = 0, value = 0;
 
-/**
- * Find the end of the current frame in the bitstream.
- * @return the position of the first byte of the next frame, or END_NOT_FOUND
- */
-static RK_S32 hevc_find_frame_end(SplitContext_t *sc, const RK_U8 *buf,
-                                  int buf_size)
-{
-    RK_S32 i;
-
-    for (i = 0; i < buf_size; i++) {
-        int nut, layer_id;
-
-        sc->state64 = (sc->state64 << 8) | buf[i];
-
-        if (((sc->state64 >> 3 * 8) & 0xFFFFFF) != START_CODE)
-            continue;
-        nut = (sc->state64 >> (2 * 8 + 1)) & 0x3F;
-        layer_id  =  (((sc->state64 >> 2 * 8) & 0x01) << 5) + (((sc->state64 >> 1 * 8) & 0xF8) >> 3);
-        //mpp_log("nut = %d layer_id = %d\n",nut,layer_id);
-        // Beginning of access unit
-        if ((nut >= NAL_VPS && nut <= NAL_AUD) || nut == NAL_SEI_PREFIX ||
-            (nut >= 41 && nut <= 44) || (nut >= 48 && nut <= 55)) {
-            if (sc->frame_start_found && !layer_id) {
-                sc->frame_start_found = 0;
-                return i - 5;
-            }
-        } else if (nut <= NAL_RASL_R ||
-                   (nut >= NAL_BLA_W_LP && nut <= NAL_CRA_NUT)) {
-            int first_slice_segment_in_pic_flag = buf[i] >> 7;
-            //mpp_log("nut = %d first_slice_segment_in_pic_flag %d layer_id = %d \n",nut,
-            //    first_slice_segment_in_pic_flag,
-            //     layer_id);
-            if (first_slice_segment_in_pic_flag && !layer_id) {
-                if (!sc->frame_start_found) {
-                    sc->frame_start_found = 1;
-                } else { // First slice of next frame found
-                    sc->frame_start_found = 0;
-                    return i - 5;
-                }
-            }
-        }
-    }
-    return END_NOT_FOUND;
-}
-
-static RK_S32 mpp_combine_frame(SplitContext_t *sc, RK_S32 next, const RK_U8 **buf, RK_S32 *buf_size)
-{
-    if (sc->overread) {
-        mpp_log("overread %d, state:%X next:%d index:%d o_index:%d\n",
-                sc->overread, sc->state, next, sc->index, sc->overread_index);
-        mpp_log("%X %X %X %X\n", (*buf)[0], (*buf)[1], (*buf)[2], (*buf)[3]);
-    }
-
-    /* Copy overread bytes from last frame into buffer. */
-    for (; sc->overread > 0; sc->overread--) {
-        sc->buffer[sc->index++] = sc->buffer[sc->overread_index++];
-    }
-
-    /* flush remaining if EOF */
-    if (!*buf_size && next == END_NOT_FOUND) {
-        next = 0;
-    }
-
-    sc->last_index = sc->index;
-
-    /* copy into buffer end return */
-    if (next == END_NOT_FOUND) {
-        RK_U32 min_size = (*buf_size) + sc->index + MPP_INPUT_BUFFER_PADDING_SIZE;
-        void* new_buffer;
-        if (min_size > sc->buffer_size) {
-            min_size = MPP_MAX(17 * min_size / 16 + 32, min_size);
-            new_buffer = mpp_realloc(sc->buffer, RK_U8, min_size);
-            if (!new_buffer) {
-                sc->buffer_size = 0;
-                return MPP_ERR_NOMEM;
-            }
-            sc->buffer_size = min_size;
-            sc->buffer = new_buffer;
-        }
-
-        memcpy(&sc->buffer[sc->index], *buf, *buf_size);
-        sc->index += *buf_size;
-
-        return -1;
-    }
-
-    *buf_size =
-        sc->overread_index = sc->index + next;
-
-    /* append to buffer */
-    if (sc->index) {
-        RK_U32 min_size = next + sc->index + MPP_INPUT_BUFFER_PADDING_SIZE;
-        void* new_buffer;
-        if (min_size > sc->buffer_size) {
-            min_size = MPP_MAX(17 * min_size / 16 + 32, min_size);
-            new_buffer = mpp_realloc(sc->buffer, RK_U8, min_size);
-            if (!new_buffer) {
-                sc->buffer_size = 0;
-                return MPP_ERR_NOMEM;
-            }
-            sc->buffer_size = min_size;
-            sc->buffer = new_buffer;
-        }
-
-        if (next > -MPP_INPUT_BUFFER_PADDING_SIZE)
-            memcpy(&sc->buffer[sc->index], *buf,
-                   next + MPP_INPUT_BUFFER_PADDING_SIZE);
-        sc->index = 0;
-        *buf = sc->buffer;
-    }
-
-    /* store overread bytes */
-    for (; next < 0; next++) {
-        sc->state = (sc->state << 8) | sc->buffer[sc->last_index + next];
-        sc->state64 = (sc->state64 << 8) | sc->buffer[sc->last_index + next];
-        sc->overread++;
-    }
-
-    if (sc->overread) {
-        mpp_log("overread %d, state:%X next:%d index:%d o_index:%d\n",
-                sc->overread, sc->state, next, sc->index, sc->overread_index);
-        mpp_log("%X %X %X %X\n", (*buf)[0], (*buf)[1], (*buf)[2], (*buf)[3]);
-    }
-
-    return 0;
-}
-
-RK_S32 h265d_split_init(void **sc)
-{
-    SplitContext_t *s = NULL;
-    if (s == NULL) {
-        s = mpp_calloc(SplitContext_t, 1);
-        if (s != NULL) {
-            *sc = s;
-        } else {
-            mpp_err("split alloc context fail");
-            return MPP_ERR_NOMEM;
-        }
-    }
-    s->buffer = mpp_malloc(RK_U8, MAX_FRAME_SIZE);
-    s->buffer_size = MAX_FRAME_SIZE;
-    s->fetch_timestamp = 1;
-    return MPP_OK;
-}
-
-void mpp_fetch_timestamp(SplitContext_t *s, RK_S32 off)
-{
-    RK_S32 i;
-
-    s->dts = s->pts = -1;
-    s->offset = 0;
-    for (i = 0; i < MPP_PARSER_PTS_NB; i++) {
-        h265d_dbg(H265D_DBG_TIME, "s->cur_offset %lld s->cur_frame_offset[%d] %lld s->frame_offset %lld s->next_frame_offset %lld",
-                  s->cur_offset, i, s->cur_frame_offset[i], s->frame_offset, s->next_frame_offset);
-        if ( s->cur_offset + off >= s->cur_frame_offset[i]
-             && (s->frame_offset < s->cur_frame_offset[i] ||
-                 (!s->frame_offset && !s->next_frame_offset)) // first field/frame
-             // check disabled since MPEG-TS does not send complete PES packets
-             && /*s->next_frame_offset + off <*/  s->cur_frame_end[i]) {
-            s->dts = s->cur_frame_dts[i];
-            s->pts = s->cur_frame_pts[i];
-            s->offset = s->next_frame_offset - s->cur_frame_offset[i];
-            if (s->cur_offset + off < s->cur_frame_end[i])
-                break;
-        }
-    }
-}
-RK_S32 h265d_split_frame(void *sc,
-                         const RK_U8 **poutbuf, RK_S32 *poutbuf_size,
-                         const RK_U8 *buf, RK_S32 buf_size, RK_S64 pts, RK_S64 dts)
-{
-    RK_S32 next, i;
-
-    SplitContext_t *s = (SplitContext_t*)sc;
-
-    if (s->cur_offset + buf_size !=
-        s->cur_frame_end[s->cur_frame_start_index]) { /* skip remainder packets */
-        /* add a new packet descriptor */
-        i = (s->cur_frame_start_index + 1) & (MPP_PARSER_PTS_NB - 1);
-        s->cur_frame_start_index = i;
-        s->cur_frame_offset[i] = s->cur_offset;
-        s->cur_frame_end[i] = s->cur_offset + buf_size;
-        s->cur_frame_pts[i] = pts;
-        s->cur_frame_dts[i] = dts;
-        h265d_dbg(H265D_DBG_TIME, "s->cur_frame_start_index = %d,cur_frame_offset = %lld,s->cur_frame_end = %lld pts = %lld",
-                  s->cur_frame_start_index, s->cur_frame_offset[i], s->cur_frame_end[i], pts);
-    }
-
-    if (s->fetch_timestamp) {
-        s->fetch_timestamp = 0;
-        s->last_pts = s->pts;
-        s->last_dts = s->dts;
-        mpp_fetch_timestamp(s, 0);
-    }
-
-    if (s->eos) {
-        *poutbuf      = s->buffer;
-        *poutbuf_size = s->index;
-        return 0;
-    }
-
-    next = hevc_find_frame_end(s, buf, buf_size);
-
-    if (mpp_combine_frame(s, next, &buf, &buf_size) < 0) {
-        *poutbuf      = NULL;
-        *poutbuf_size = 0;
-        s->cur_offset += buf_size;
-        return buf_size;
-    }
-
-    *poutbuf      = buf;
-    *poutbuf_size = buf_size;
-
-    if (next < 0)
-        next = 0;
-
-    if (*poutbuf_size) {
-        /* fill the data for the current frame */
-        s->frame_offset = s->next_frame_offset;
-
-        /* offset of the next frame */
-        s->next_frame_offset = s->cur_offset + next;
-        s->fetch_timestamp = 1;
-    }
-
-    s->cur_offset += next;
-    return next;
-}
-
-RK_S32 h265d_split_reset(void *sc)
-{
-    RK_U8 *buf = NULL;
-    RK_U32 size = 0;
-    SplitContext_t *s = (SplitContext_t*)sc;
-    if (sc == NULL) {
-        return MPP_OK;
-    }
-    buf = s->buffer;
-    size = s->buffer_size;
-    memset(s, 0, sizeof(SplitContext_t));
-    s->fetch_timestamp = 1;
-    s->buffer = buf;
-    s->buffer_size = size;
-    s->eos = 0;
-    return MPP_OK;
-}
-
-
-RK_S32 h265d_split_deinit(void *sc)
-{
-    SplitContext_t *s = (SplitContext_t *)sc;
-    if (s->buffer) {
-        mpp_free(s->buffer);
-        s->buffer = NULL;
-    }
-    if (s) {
-        mpp_free(s);
-        s = NULL;
-    }
-    return MPP_OK;
-}
-
 static RK_S32 pred_weight_table(HEVCContext *s, BitReadCtx_t *gb)
 {
     RK_U32 i = 0;
@@ -1672,7 +1411,7 @@ MPP_RET h265d_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
     MPP_RET ret = MPP_OK;
     H265dContext_t *h265dctx = (H265dContext_t *)ctx;
     HEVCContext *s = (HEVCContext *)h265dctx->priv_data;
-    SplitContext_t *sc = (SplitContext_t*)h265dctx->split_cxt;
+    MppSplit sc = h265dctx->split_cxt;
     RK_S64 pts = -1, dts = -1;
     RK_U8 *buf = NULL;
     void *pos = NULL;
@@ -1680,9 +1419,7 @@ MPP_RET h265d_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
 
     //task->valid = 0;
     s->eos = mpp_packet_get_eos(pkt);
-    if (sc != NULL) {
-        sc->eos = s->eos;
-    }
+    mpp_split_set_eos(sc, s->eos);
     buf = (RK_U8 *)mpp_packet_get_pos(pkt);
     pts = mpp_packet_get_pts(pkt);
     dts = mpp_packet_get_dts(pkt);
@@ -1705,17 +1442,25 @@ MPP_RET h265d_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
         RK_U8 *split_out_buf = NULL;
         RK_S32 split_size = 0;
 
-        consume = h265d_split_frame(h265dctx->split_cxt, (const RK_U8**)&split_out_buf, &split_size,
-                                    (const RK_U8*)buf, length, pts, dts);
+        consume = mpp_split_frame(sc, (const RK_U8**)&split_out_buf, &split_size,
+                                  (const RK_U8*)buf, length, pts, dts);
         pos = buf + consume;
         mpp_packet_set_pos(pkt, pos);
+        // only the frame with the end of eos packet is the last frame
+        if (consume < length)
+            s->eos = 0;
         if (split_size) {
             buf = split_out_buf;
             length = split_size;
             s->checksum_buf = buf;  //check with openhevc
             s->checksum_buf_size = split_size;
-            h265d_dbg(H265D_DBG_TIME, "split frame get pts %lld", sc->pts);
-            s->pts = sc->pts;
+            s->pts = mpp_split_get_pts(sc);
+            h265d_dbg(H265D_DBG_TIME, "split frame get pts %lld", s->pts);
+        } else if (s->eos && consume == length) {
+            task->valid = 0;
+            task->flags.eos = 1;
+            h265d_flush(ctx);
+            return ret;
         } else {
             return MPP_FAIL_SPLIT_FRAME;
         }
@@ -1812,7 +1557,7 @@ MPP_RET h265d_deinit(void *ctx)
 {
     H265dContext_t *h265dctx = (H265dContext_t *)ctx;
     HEVCContext       *s = h265dctx->priv_data;
-    SplitContext_t *sc = h265dctx->split_cxt;
+    MppSplit sc = h265dctx->split_cxt;
     RK_U8 *buf = NULL;
     int i;
 
@@ -1827,6 +1572,9 @@ MPP_RET h265d_deinit(void *ctx)
         mpp_free(s->sps_list[i]);
     for (i = 0; i < MAX_PPS_COUNT; i++)
         mpp_hevc_pps_free(s->pps_list[i]);
+    mpp_ps_cache_deinit(s->vps_cache, MAX_VPS_COUNT);
+    mpp_ps_cache_deinit(s->sps_cache, MAX_SPS_COUNT);
+    mpp_ps_cache_deinit(s->pps_cache, MAX_PPS_COUNT);
 
     mpp_free(s->HEVClc);
 
@@ -1855,7 +1603,8 @@ MPP_RET h265d_deinit(void *ctx)
     }
 
     if (sc) {
-        h265d_split_deinit(sc);
+        mpp_split_deinit(sc);
+        h265dctx->split_cxt = NULL;
     }
     return 0;
 }
@@ -1899,7 +1648,7 @@ MPP_RET h265d_init(void *ctx, ParserCfg *parser_cfg)
 
     H265dContext_t *h265dctx = (H265dContext_t *)ctx;
     HEVCContext *s = (HEVCContext *)h265dctx->priv_data;
-    SplitContext_t *sc = (SplitContext_t*)h265dctx->split_cxt;
+    MppSplit sc = h265dctx->split_cxt;
     RK_S32 ret;
     RK_U8 *buf = NULL;
     RK_S32 size = SZ_512K;
@@ -1915,7 +1664,7 @@ MPP_RET h265d_init(void *ctx, ParserCfg *parser_cfg)
     h265dctx->need_split = parser_cfg->need_split;
 
     if (sc == NULL && h265dctx->need_split) {
-        h265d_split_init((void**)&sc);
+        mpp_split_init(&sc, MPP_VIDEO_CodingHEVC);
         if (sc == NULL) {
             mpp_err("split contxt malloc fail");
             return MPP_ERR_NOMEM;
@@ -1981,7 +1730,7 @@ MPP_RET h265d_reset(void *ctx)
         ret = mpp_hevc_output_frame(ctx, 1);
     } while (ret);
     mpp_hevc_flush_dpb(s);
-    h265d_split_reset(h265dctx->split_cxt);
+    mpp_split_reset(h265dctx->split_cxt);
     s->max_ra = INT_MAX;
     s->eos = 0;
     return MPP_OK;
@@ -30,6 +30,7 @@
 #define __H265D_PARSER_H__
 
 #include "mpp_bitread.h"
+#include "mpp_ps_cache.h"
 #include "mpp_common.h"
 #include "h265d_codec.h"
 #include "mpp_frame.h"
@@ -588,6 +589,10 @@ typedef struct HEVCContext {
     RK_U8 *vps_list[MAX_VPS_COUNT];
     RK_U8 *sps_list[MAX_SPS_COUNT];
     RK_U8 *pps_list[MAX_PPS_COUNT];
+    ///< raw nal of the stored vps/sps/pps for skipping repeated ones
+    MppPsCache vps_cache[MAX_VPS_COUNT];
+    MppPsCache sps_cache[MAX_SPS_COUNT];
+    MppPsCache pps_cache[MAX_PPS_COUNT];
 
     SliceHeader sh;
 
@@ -659,6 +664,7 @@ typedef struct HEVCContext {
     RK_U8     scaling_list_listen[81];
     RK_U8     sps_list_of_updated[MAX_SPS_COUNT];///< zrh add
     RK_U8     pps_list_of_updated[MAX_PPS_COUNT];///< zrh add
+    RK_U32    ps_version;   ///< increased when any vps/sps/pps is replaced
 
     RK_S32         rps_used[16];
     RK_S32         nb_rps_used;
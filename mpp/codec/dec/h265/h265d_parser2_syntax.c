@@ -68,6 +68,7 @@ static void fill_picture_parameters(const HEVCContext *h,
     pp->pps_id = h->sh.pps_id;
     pp->sps_id = pps->sps_id;
     pp->vps_id = sps->vps_id;
+    pp->ps_version = h->ps_version;
 
     pp->wFormatAndSequenceInfoFlags = (sps->chroma_format_idc             <<  0) |
                                       (sps->separate_colour_plane_flag    <<  2) |
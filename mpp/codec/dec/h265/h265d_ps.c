@@ -1028,9 +1028,18 @@ int mpp_hevc_decode_nal_vps(HEVCContext *s)
     BitReadCtx_t *gb = &s->HEVClc->gb;
     RK_S32 vps_id = 0;
     HEVCVPS *vps = NULL;
-    RK_U8 *vps_buf = mpp_calloc(RK_U8, sizeof(HEVCVPS));
+    RK_U8 *vps_buf = NULL;
     RK_S32 value = 0;
+    RK_U32 nal_hash = mpp_ps_cache_hash(gb->buf, gb->buf_len);
 
+    /* repeated vps is found by raw nal before parsing */
+    vps_id = mpp_ps_cache_find(s->vps_cache, MAX_VPS_COUNT, gb->buf, gb->buf_len, nal_hash);
+    if (vps_id >= 0 && s->vps_list[vps_id]) {
+        h265d_dbg(H265D_DBG_FUNCTION, "Skip repeated VPS %d\n", vps_id);
+        return 0;
+    }
+
+    vps_buf = mpp_calloc(RK_U8, sizeof(HEVCVPS));
     if (!vps_buf)
         return MPP_ERR_NOMEM;
     vps = (HEVCVPS*)vps_buf;
@@ -1150,7 +1159,9 @@ int mpp_hevc_decode_nal_vps(HEVCContext *s)
             mpp_free(s->vps_list[vps_id]);
         }
         s->vps_list[vps_id] = vps_buf;
+        s->ps_version++;
     }
+    mpp_ps_cache_update(&s->vps_cache[vps_id], gb->buf, gb->buf_len, nal_hash);
 
     return 0;
 __BITREAD_ERR:
@@ -1393,10 +1404,23 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
     RK_S32 bit_depth_chroma, start, vui_present, sublayer_ordering_info;
     RK_S32 i;
     RK_S32 value = 0;
+    RK_U32 nal_hash = mpp_ps_cache_hash(gb->buf, gb->buf_len);
 
     HEVCSPS *sps;
-    RK_U8 *sps_buf = mpp_calloc(RK_U8, sizeof(*sps));
+    RK_U8 *sps_buf = NULL;
+
+    /* repeated sps keeps the stored one and marks it as updated like parsing */
+    sps_id = mpp_ps_cache_find(s->sps_cache, MAX_SPS_COUNT, gb->buf, gb->buf_len, nal_hash);
+    if (sps_id >= 0 && s->sps_list[sps_id]) {
+        h265d_dbg(H265D_DBG_FUNCTION, "Skip repeated SPS %d\n", sps_id);
+        if (((HEVCSPS*)s->sps_list[sps_id])->scaling_list_enable_flag)
+            s->scaling_list_listen[sps_id] = 1;
+        s->sps_list_of_updated[sps_id] = 1;
+        return 0;
+    }
+    sps_id = 0;
 
+    sps_buf = mpp_calloc(RK_U8, sizeof(*sps));
     if (!sps_buf)
         return MPP_ERR_NOMEM;
     sps = (HEVCSPS*)sps_buf;
@@ -1543,7 +1567,7 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
     }
 
     READ_ONEBIT(gb, &sublayer_ordering_info);
-    h265d_dbg(H265D_DBG_SPS, "read bit left %d", gb->num_remaining_bits_in_curr_byte_ + gb->bytes_left_ * 8);
+    h265d_dbg(H265D_DBG_SPS, "read bit left %d", mpp_get_bits_left(gb));
     start = sublayer_ordering_info ? 0 : sps->max_sub_layers - 1;
     for (i = start; i < sps->max_sub_layers; i++) {
         READ_UE(gb, &sps->temporal_layer[i].max_dec_pic_buffering) ;
@@ -1576,7 +1600,7 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
         }
     }
 
-    h265d_dbg(H265D_DBG_SPS, "2 read bit left %d", gb->num_remaining_bits_in_curr_byte_ + gb->bytes_left_ * 8);
+    h265d_dbg(H265D_DBG_SPS, "2 read bit left %d", mpp_get_bits_left(gb));
     READ_UE(gb, &sps->log2_min_cb_size) ;
     sps->log2_min_cb_size += 3;
 
@@ -1823,15 +1847,18 @@ RK_S32 mpp_hevc_decode_nal_sps(HEVCContext *s)
             if (s->pps_list[i] && ((HEVCPPS*)s->pps_list[i])->sps_id == sps_id) {
                 mpp_hevc_pps_free(s->pps_list[i]);
                 s->pps_list[i] = NULL;
+                mpp_ps_cache_clear(&s->pps_cache[i]);
             }
         }
         if (s->sps_list[sps_id] != NULL)
             mpp_free(s->sps_list[sps_id]);
         s->sps_list[sps_id] = sps_buf;
+        s->ps_version++;
     }
 
     if (s->sps_list[sps_id])
         s->sps_list_of_updated[sps_id] = 1;
+    mpp_ps_cache_update(&s->sps_cache[sps_id], gb->buf, gb->buf_len, nal_hash);
 
     return 0;
 __BITREAD_ERR:
@@ -1861,8 +1888,20 @@ int mpp_hevc_decode_nal_pps(HEVCContext *s)
 
     HEVCPPS *pps = NULL;
     RK_U8 *pps_buf;
-    pps_buf = mpp_calloc(RK_U8, sizeof(*pps));
+    RK_U32 nal_hash = mpp_ps_cache_hash(gb->buf, gb->buf_len);
+
+    /* repeated pps keeps the stored one and its tile arrays */
+    pps_id = mpp_ps_cache_find(s->pps_cache, MAX_PPS_COUNT, gb->buf, gb->buf_len, nal_hash);
+    if (pps_id >= 0 && s->pps_list[pps_id]) {
+        h265d_dbg(H265D_DBG_FUNCTION, "Skip repeated PPS %d\n", pps_id);
+        if (((HEVCPPS*)s->pps_list[pps_id])->scaling_list_data_present_flag)
+            s->scaling_list_listen[pps_id + 16] = 1;
+        s->pps_list_of_updated[pps_id] = 1;
+        return 0;
+    }
+    pps_id = 0;
 
+    pps_buf = mpp_calloc(RK_U8, sizeof(*pps));
     if (!pps_buf)
         return MPP_ERR_NOMEM;
 
@@ -2040,14 +2079,14 @@ int mpp_hevc_decode_nal_pps(HEVCContext *s)
         s->scaling_list_listen[pps_id + 16] = 1;
     }
 
-    h265d_dbg(H265D_DBG_PPS, "num bit left %d", gb->num_remaining_bits_in_curr_byte_);
+    h265d_dbg(H265D_DBG_PPS, "num bit left %d", mpp_get_bits_left(gb));
     READ_ONEBIT(gb, & pps->lists_modification_present_flag);
 
 
-    h265d_dbg(H265D_DBG_PPS, "num bit left %d", gb->num_remaining_bits_in_curr_byte_);
+    h265d_dbg(H265D_DBG_PPS, "num bit left %d", mpp_get_bits_left(gb));
     READ_UE(gb, &pps->log2_parallel_merge_level);
 
-    h265d_dbg(H265D_DBG_PPS, "num bit left %d", gb->num_remaining_bits_in_curr_byte_);
+    h265d_dbg(H265D_DBG_PPS, "num bit left %d", mpp_get_bits_left(gb));
     pps->log2_parallel_merge_level += 2;
     if (pps->log2_parallel_merge_level > sps->log2_ctb_size) {
         mpp_err( "log2_parallel_merge_level_minus2 out of range: %d\n",
@@ -2095,9 +2134,11 @@ int mpp_hevc_decode_nal_pps(HEVCContext *s)
         s->pps_list[pps_id] = NULL;
     }
     s->pps_list[pps_id] = pps_buf;
+    s->ps_version++;
 
     if (s->pps_list[pps_id])
         s->pps_list_of_updated[pps_id] = 1;
+    mpp_ps_cache_update(&s->pps_cache[pps_id], gb->buf, gb->buf_len, nal_hash);
 
     return 0;
 __BITREAD_ERR:
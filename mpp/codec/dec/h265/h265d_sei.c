@@ -378,7 +378,9 @@ __BITREAD_ERR:
 
 static RK_S32 more_rbsp_data(BitReadCtx_t *gb)
 {
-    return gb->bytes_left_ > 1 &&  gb->data_[0] != 0x80;
+    RK_U8 *data = mpp_align_get_bits(gb);
+
+    return gb->bytes_left_ > 1 && data[0] != 0x80;
 }
 
 RK_S32 mpp_hevc_decode_nal_sei(HEVCContext *s)
@@ -1134,14 +1134,45 @@ MPP_RET jpegd_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
     JpegParserCtx->pts = mpp_packet_get_pts(pkt);
 
     task->valid = 0;
-    task->flags.eos = eos;
-    JpegParserCtx->eos = eos;
 
     JPEGD_INFO_LOG("pkt_length %d eos %d\n", pkt_length, eos);
 
-    if (!pkt_length) {
-        JPEGD_INFO_LOG("it is end of stream.");
-        return ret;
+    if (JpegParserCtx->split) {
+        /* split mode: cut one image from SOI to EOI from input stream */
+        const RK_U8 *frame = NULL;
+        RK_S32 frame_size = 0;
+        RK_U32 consume = 0;
+
+        mpp_split_set_eos(JpegParserCtx->split, eos);
+        consume = mpp_split_frame(JpegParserCtx->split, &frame, &frame_size,
+                                  base, pkt_length, JpegParserCtx->pts,
+                                  mpp_packet_get_dts(pkt));
+        mpp_packet_set_pos(pkt, pos + consume);
+        /* only the last image of eos packet carries eos */
+        if (consume < pkt_length)
+            eos = 0;
+
+        task->flags.eos = eos;
+        JpegParserCtx->eos = eos;
+        if (!frame_size) {
+            JPEGD_INFO_LOG("wait for more stream, eos %d", eos);
+            return ret;
+        }
+
+        base = (void *)frame;
+        pkt_length = frame_size;
+        JpegParserCtx->pts = mpp_split_get_pts(JpegParserCtx->split);
+    } else {
+        task->flags.eos = eos;
+        JpegParserCtx->eos = eos;
+
+        if (!pkt_length) {
+            JPEGD_INFO_LOG("it is end of stream.");
+            return ret;
+        }
+
+        pos += pkt_length;
+        mpp_packet_set_pos(pkt, pos);
     }
 
     if (pkt_length > JpegParserCtx->bufferSize) {
@@ -1160,8 +1191,6 @@ MPP_RET jpegd_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
 
     jpegd_parser_split_frame(base, pkt_length, JpegParserCtx->recv_buffer, &copy_length);
 
-    pos += pkt_length;
-    mpp_packet_set_pos(pkt, pos);
     if (copy_length != pkt_length) {
         JPEGD_INFO_LOG("there seems to be something wrong with split_frame. pkt_length:%d, copy_length:%d", pkt_length, copy_length);
     }
@@ -2566,7 +2595,7 @@ MPP_RET jpegd_deinit(void *ctx)
     }
 
     if (JpegParserCtx->output_frame) {
-        mpp_free(JpegParserCtx->output_frame);
+        mpp_frame_deinit(&JpegParserCtx->output_frame);
     }
 
     if (JpegParserCtx->input_packet) {
@@ -2574,6 +2603,11 @@ MPP_RET jpegd_deinit(void *ctx)
     }
 
     JpegParserCtx->output_fmt = MPP_FMT_YUV420SP;
+    if (JpegParserCtx->split) {
+        mpp_split_deinit(JpegParserCtx->split);
+        JpegParserCtx->split = NULL;
+    }
+
     JpegParserCtx->pts = 0;
     JpegParserCtx->eos = 0;
     JpegParserCtx->parser_debug_enable = 0;
@@ -2625,7 +2659,8 @@ MPP_RET jpegd_init(void *ctx, ParserCfg *parser_cfg)
     JpegParserCtx->frame_slots = parser_cfg->frame_slots;
     JpegParserCtx->packet_slots = parser_cfg->packet_slots;
     JpegParserCtx->frame_slot_index = -1;
-    mpp_buf_slot_setup(JpegParserCtx->frame_slots, 1);
+    /* one frame slot for each task in flight */
+    mpp_buf_slot_setup(JpegParserCtx->frame_slots, parser_cfg->task_count);
 
     JpegParserCtx->recv_buffer = mpp_calloc(RK_U8, JPEGD_STREAM_BUFF_SIZE);
     if (NULL == JpegParserCtx->recv_buffer) {
@@ -2670,6 +2705,13 @@ MPP_RET jpegd_init(void *ctx, ParserCfg *parser_cfg)
     JpegParserCtx->parser_debug_enable = 0;
     JpegParserCtx->input_jpeg_count = 0;
 
+    JpegParserCtx->need_split = parser_cfg->need_split;
+    if (JpegParserCtx->need_split &&
+        mpp_split_init(&JpegParserCtx->split, MPP_VIDEO_CodingMJPEG)) {
+        JPEGD_ERROR_LOG("failed to init split");
+        return MPP_ERR_NOMEM;
+    }
+
     FUN_TEST("Exit");
     return MPP_OK;
 }
@@ -2688,7 +2730,7 @@ MPP_RET jpegd_reset(void *ctx)
     FUN_TEST("Enter");
     JpegParserContext *JpegParserCtx = (JpegParserContext *)ctx;
 
-    (void)JpegParserCtx;
+    mpp_split_reset(JpegParserCtx->split);
 
     FUN_TEST("Exit");
     return MPP_OK;
@@ -27,6 +27,7 @@
 #include "mpp_dec.h"
 #include "mpp_buf_slot.h"
 #include "mpp_packet.h"
+#include "mpp_split.h"
 
 #include "jpegd_syntax.h"
 
@@ -183,6 +184,8 @@ typedef struct JpegParserContext {
 
     RK_S64 pts;
     RK_U32 eos;
+    RK_U32 need_split;
+    MppSplit split; /* SOI / EOI splitter on need_split mode */
     RK_U32 parser_debug_enable;
     RK_U32 input_jpeg_count;
 } JpegParserContext;
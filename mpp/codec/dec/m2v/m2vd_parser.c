@@ -88,7 +88,7 @@ static RK_S32 m2vd_get_readbits(BitReadCtx_t *bx)
 
 static RK_S32 m2vd_get_leftbits(BitReadCtx_t *bx)
 {
-    return  (bx->bytes_left_ * 8 + bx->num_remaining_bits_in_curr_byte_);
+    return mpp_get_bits_left(bx);
 }
 
 static RK_S32 m2vd_read_bits(BitReadCtx_t *bx, RK_U32 bits)
@@ -131,6 +131,7 @@ static MPP_RET m2vd_parser_init_ctx(M2VDParserContext *ctx, ParserCfg *cfg)
     ctx->frame_slots = cfg->frame_slots;
 
     ctx->notify_cb = cfg->notify_cb;
+    ctx->need_split = cfg->need_split;
 
     mpp_buf_slot_setup(ctx->frame_slots, 16);
 
@@ -186,6 +187,9 @@ static MPP_RET m2vd_parser_init_ctx(M2VDParserContext *ctx, ParserCfg *cfg)
     ctx->max_stream_size = M2VD_BUF_SIZE_BITMEM;
     ctx->ref_frame_cnt = 0;
 
+    if (ctx->need_split)
+        CHK_F(mpp_split_init(&ctx->split, MPP_VIDEO_CodingMPEG2));
+
 
     if (M2VD_DBG_DUMP_REG & m2vd_debug) {
         RK_S32 k = 0;
@@ -261,6 +265,11 @@ MPP_RET m2vd_parser_deinit(void *ctx)
         mpp_packet_deinit(&p->input_packet);
     }
 
+    if (p->split) {
+        mpp_split_deinit(p->split);
+        p->split = NULL;
+    }
+
     if (p->dxva_ctx) {
         mpp_free(p->dxva_ctx);
         p->dxva_ctx = NULL;
@@ -271,7 +280,8 @@ MPP_RET m2vd_parser_deinit(void *ctx)
     }
 
     for (k = 0; k < 3; k++) {
-        mpp_free(p->Framehead[k].f);
+        if (p->Framehead[k].f)
+            mpp_frame_deinit(&p->Framehead[k].f);
     }
 
     if (p) {
@@ -322,6 +332,7 @@ MPP_RET m2vd_parser_reset(void *ctx)
     p->ref_frame_cnt = 0;
     p->resetFlag = 1;
     p->eos = 0;
+    mpp_split_reset(p->split);
     FUN_T("FUN_O");
     return ret;
 }
@@ -406,6 +417,22 @@ MPP_RET m2vd_parser_split_frame(RK_U8 *src, RK_U32 src_size, RK_U8 *dst, RK_U32
 }
 
 
+static MPP_RET m2vd_parser_check_stream_size(M2VDParserContext *p, RK_U32 size)
+{
+    if (size > p->max_stream_size) {
+        mpp_free(p->bitstream_sw_buf);
+        p->bitstream_sw_buf = NULL;
+        p->bitstream_sw_buf = mpp_malloc(RK_U8, (size + 1024));
+        if (NULL == p->bitstream_sw_buf) {
+            mpp_err("m2vd_parser realloc fail");
+            return MPP_ERR_NOMEM;
+        }
+        p->max_stream_size = size + 1024;
+    }
+
+    return MPP_OK;
+}
+
 MPP_RET m2vd_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
 {
     MPP_RET ret = MPP_OK;
@@ -413,8 +440,10 @@ MPP_RET m2vd_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
     M2VDParserContext *p = (M2VDParserContext *)c->parse_ctx;
     MppPacket input_packet = p->input_packet;
     RK_U32 out_size = 0, len_in;
+    RK_U32 consume = 0;
     RK_U8 *pos = NULL;
     RK_U8 *buf = NULL;
+    MppBuffer buffer = NULL;
 
 
     buf = pos = mpp_packet_get_pos(pkt);
@@ -428,25 +457,61 @@ MPP_RET m2vd_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
     task->valid = 0;
     len_in = (RK_U32)mpp_packet_get_length(pkt),
     p->eos = mpp_packet_get_eos(pkt);
+    buffer = mpp_packet_get_buffer(pkt);
     // mpp_log("len_in = %d",len_in);
-    if (len_in > p->max_stream_size) {
-        mpp_free(p->bitstream_sw_buf);
-        p->bitstream_sw_buf = NULL;
-        p->bitstream_sw_buf = mpp_malloc(RK_U8, (len_in + 1024));
-        if (NULL == p->bitstream_sw_buf) {
-            mpp_err("m2vd_parser realloc fail");
-            return MPP_ERR_NOMEM;
+
+    if (buffer && buf == mpp_buffer_get_ptr(buffer)) {
+        /*
+         * zero copy mode: one packet is one frame and the stream is already
+         * in MppBuffer so pass the buffer to hal directly
+         */
+        out_size = len_in;
+        consume = out_size;
+        mpp_packet_set_buffer(input_packet, buffer);
+        mpp_packet_set_data(input_packet, buf);
+        mpp_packet_set_size(input_packet, mpp_buffer_get_size(buffer));
+    } else if (p->split) {
+        /*
+         * split mode: input packet is cut into frames on picture start code
+         * and the input packet is kept until it is totally consumed
+         */
+        const RK_U8 *frame = NULL;
+        RK_S32 frame_size = 0;
+
+        mpp_split_set_eos(p->split, p->eos);
+        consume = mpp_split_frame(p->split, &frame, &frame_size, buf, len_in,
+                                  p->pts, mpp_packet_get_dts(pkt));
+        // only the last frame of eos packet carries eos
+        if (consume < len_in)
+            p->eos = 0;
+
+        if (frame_size) {
+            ret = m2vd_parser_check_stream_size(p, frame_size);
+            if (ret)
+                return ret;
+
+            memcpy(p->bitstream_sw_buf, frame, frame_size);
+            p->pts = mpp_split_get_pts(p->split);
+            out_size = frame_size;
         }
-        p->max_stream_size = len_in + 1024;
+        mpp_packet_set_buffer(input_packet, NULL);
+        mpp_packet_set_data(input_packet, p->bitstream_sw_buf);
+        mpp_packet_set_size(input_packet, p->max_stream_size);
+    } else {
+        ret = m2vd_parser_check_stream_size(p, len_in);
+        if (ret)
+            return ret;
+
+        m2vd_parser_split_frame(buf,
+                                len_in,
+                                p->bitstream_sw_buf,
+                                &out_size);
+        consume = out_size;
+        mpp_packet_set_buffer(input_packet, NULL);
+        mpp_packet_set_data(input_packet, p->bitstream_sw_buf);
+        mpp_packet_set_size(input_packet, p->max_stream_size);
     }
-
-    pos += out_size;
-
-    m2vd_parser_split_frame(buf,
-                            len_in,
-                            p->bitstream_sw_buf,
-                            &out_size);
-    pos += out_size;
+    pos += consume;
 
     mpp_packet_set_pos(pkt, pos);
 
@@ -456,13 +521,15 @@ MPP_RET m2vd_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
         return ret;
     }
 
+    // wait for more data to complete the frame
+    if (out_size == 0 && p->split)
+        return ret;
+
     if (M2VD_DBG_SEC_HEADER & m2vd_debug) {
         mpp_log("p->bitstream_sw_buf = 0x%x", p->bitstream_sw_buf);
         mpp_log("out_size = 0x%x", out_size);
     }
 
-    mpp_packet_set_data(input_packet, p->bitstream_sw_buf);
-    mpp_packet_set_size(input_packet, p->max_stream_size);
     mpp_packet_set_length(input_packet, out_size);
 
     task->input_packet = input_packet;
@@ -1321,7 +1388,8 @@ MPP_RET m2vd_parser_parse(void *ctx, HalDecTask *in_task)
 
     p->frame_size = (RK_U32)mpp_packet_get_length(in_task->input_packet);
 
-    mpp_set_bitread_ctx(p->bitread_ctx, p->bitstream_sw_buf, p->frame_size);
+    /* stream may be in parser buffer or in input MppBuffer on zero copy mode */
+    mpp_set_bitread_ctx(p->bitread_ctx, (RK_U8 *)mpp_packet_get_data(in_task->input_packet), p->frame_size);
 
     rev = m2vd_decode_head(p);
 
@@ -33,6 +33,7 @@
 
 #include "mpp_frame.h"
 #include "mpp_packet.h"
+#include "mpp_split.h"
 
 #include "mpp_dec.h"
 #include "m2vd_syntax.h"
@@ -279,6 +280,8 @@ typedef struct M2VDParserContext_t {
 
     MppPacket       input_packet;
     RK_U32       eos;
+    RK_U32       need_split;
+    MppSplit     split;
 
     RK_S32 initFlag;
     RK_S32 decoder_err;
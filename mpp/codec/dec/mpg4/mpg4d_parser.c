@@ -701,12 +701,12 @@ static MPP_RET mpg4d_parse_user_data(Mpg4dParserImpl *p, BitReadCtx_t *gb)
 {
     RK_U8 tmp[256];
     Mpg4Hdr *mp4Hdr = &p->hdr_curr;
-    RK_U32 remain_bit = gb->bytes_left_ * 8 + gb->num_remaining_bits_in_curr_byte_;
+    RK_U32 remain_bit = mpp_get_bits_left(gb);
     RK_S32 i;
 
     memset(tmp, 0, 256);
 
-    for (i = 0; i < 256 && gb->bytes_left_; i++) {
+    for (i = 0; i < 256 && remain_bit >= 8; i++) {
         RK_U32 show_bit = MPP_MIN(remain_bit, 23);
         RK_U32 val;
 
@@ -1271,7 +1271,7 @@ MPP_RET mpp_mpg4_parser_decode(Mpg4dParser ctx, MppPacket pkt)
     mpp_set_bitread_ctx(gb, buf, len);
     p->found_vop = 0;
 
-    while (gb->bytes_left_) {
+    while (mpp_get_bits_left(gb) >= 8) {
         RK_U32 val = 0;
 
         READ_BITS(gb, 8, &val);
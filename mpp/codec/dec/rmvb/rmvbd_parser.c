@@ -167,8 +167,10 @@ MPP_RET rmvbd_parser_deinit(void *ctx)
 
 
     for (k = 0; k < 3; k++) {
-        mpp_free(p->Framehead[k].f);
-        mpp_free(p->rmvbsyn->Framehead[k].f);
+        if (p->Framehead[k].f)
+            mpp_frame_deinit(&p->Framehead[k].f);
+        if (p->rmvbsyn->Framehead[k].f)
+            mpp_frame_deinit(&p->rmvbsyn->Framehead[k].f);
     }
 
     if (p->task_pkt) {
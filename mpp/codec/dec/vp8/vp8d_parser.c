@@ -225,6 +225,7 @@ MPP_RET vp8d_parser_init(void *ctx, ParserCfg *parser_cfg)
     p->packet_slots = parser_cfg->packet_slots;
     p->frame_slots = parser_cfg->frame_slots;
     p->notify_cb = parser_cfg->notify_cb;
+    p->need_split = parser_cfg->need_split;
 
     mpp_buf_slot_setup(p->frame_slots, 15);
 
@@ -240,6 +241,16 @@ MPP_RET vp8d_parser_init(void *ctx, ParserCfg *parser_cfg)
     mpp_packet_init(&p->input_packet, p->bitstream_sw_buf, VP8D_BUF_SIZE_BITMEM);
     p->max_stream_size = VP8D_BUF_SIZE_BITMEM;
 
+    /* IVF stream is split into frames on need_split mode */
+    if (p->need_split) {
+        ret = mpp_split_init(&p->split, MPP_VIDEO_CodingVP8);
+        if (ret) {
+            mpp_err("vp8d init split fail");
+            FUN_T("FUN_OUT");
+            return ret;
+        }
+    }
+
     FUN_T("FUN_OUT");
     return ret;
 }
@@ -258,7 +269,8 @@ void vp8d_unref_frame(VP8DParserContext_t *p, VP8Frame *frame)
     if (!frame->ref_count && frame->slot_index < 0x7f) {
         mpp_buf_slot_clr_flag(p->frame_slots, frame->slot_index, SLOT_CODEC_USE);
         frame->slot_index = 0xff;
-        mpp_free(frame->f);
+        if (frame->f)
+            mpp_frame_deinit(&frame->f);
         mpp_free(frame);
         frame = NULL;
     }
@@ -308,11 +320,21 @@ MPP_RET vp8d_parser_deinit(void *ctx)
         p->bitstream_sw_buf = NULL;
     }
 
+    /* release buffer reference left by zero copy mode */
+    if (NULL != p->input_packet) {
+        mpp_packet_deinit(&p->input_packet);
+    }
+
     if (NULL != p->dxva_ctx) {
         mpp_free(p->dxva_ctx);
         p->dxva_ctx = NULL;
     }
 
+    if (NULL != p->split) {
+        mpp_split_deinit(p->split);
+        p->split = NULL;
+    }
+
     vp8d_unref_allframe(p);
 
     if ( NULL != p) {
@@ -337,6 +359,7 @@ MPP_RET vp8d_parser_reset(void *ctx)
     vp8d_unref_allframe(p);
     p->needKeyFrame = 0;
     p->eos = 0;
+    mpp_split_reset(p->split);
     FUN_T("FUN_OUT");
     return ret;
 }
@@ -399,12 +422,30 @@ MPP_RET vp8d_parser_split_frame(RK_U8 *src, RK_U32 src_size, RK_U8 *dst, RK_U32
 }
 
 
+static MPP_RET vp8d_parser_check_stream_size(VP8DParserContext_t *p, RK_U32 size)
+{
+    if (size > p->max_stream_size) {
+        mpp_free(p->bitstream_sw_buf);
+        p->bitstream_sw_buf = NULL;
+        p->bitstream_sw_buf = mpp_malloc(RK_U8, (size + 1024));
+        if (NULL == p->bitstream_sw_buf) {
+            mpp_err("vp8d_parser realloc fail");
+            return MPP_ERR_NOMEM;
+        }
+        p->max_stream_size = size + 1024;
+    }
+
+    return MPP_OK;
+}
+
 MPP_RET vp8d_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
 {
     MPP_RET ret = MPP_OK;
     RK_U32 out_size = 0, len_in = 0;
+    RK_U32 consume = 0;
     RK_U8 * pos = NULL;
     RK_U8 *buf = NULL;
+    MppBuffer buffer = NULL;
     VP8DContext *c = (VP8DContext *)ctx;
 
     VP8DParserContext_t *p = (VP8DParserContext_t *)c->parse_ctx;
@@ -419,23 +460,61 @@ MPP_RET vp8d_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
 
     len_in = (RK_U32)mpp_packet_get_length(pkt),
     p->eos = mpp_packet_get_eos(pkt);
+    buffer = mpp_packet_get_buffer(pkt);
     // mpp_log("len_in = %d",len_in);
-    if (len_in > p->max_stream_size) {
-        mpp_free(p->bitstream_sw_buf);
-        p->bitstream_sw_buf = NULL;
-        p->bitstream_sw_buf = mpp_malloc(RK_U8, (len_in + 1024));
-        if (NULL == p->bitstream_sw_buf) {
-            mpp_err("vp8d_parser realloc fail");
-            return MPP_ERR_NOMEM;
+
+    if (buffer && buf == mpp_buffer_get_ptr(buffer)) {
+        /*
+         * zero copy mode: one packet is one frame and the stream is already
+         * in MppBuffer so pass the buffer to hal directly
+         */
+        out_size = len_in;
+        consume = out_size;
+        mpp_packet_set_buffer(input_packet, buffer);
+        mpp_packet_set_data(input_packet, buf);
+        mpp_packet_set_size(input_packet, mpp_buffer_get_size(buffer));
+    } else if (p->split) {
+        /*
+         * split mode: frames are cut by IVF frame header and the IVF headers
+         * are dropped, input packet is kept until it is totally consumed
+         */
+        const RK_U8 *frame = NULL;
+        RK_S32 frame_size = 0;
+
+        mpp_split_set_eos(p->split, p->eos);
+        consume = mpp_split_frame(p->split, &frame, &frame_size, buf, len_in,
+                                  p->pts, mpp_packet_get_dts(pkt));
+        // only the last frame of eos packet carries eos
+        if (consume < len_in)
+            p->eos = 0;
+
+        if (frame_size) {
+            ret = vp8d_parser_check_stream_size(p, frame_size);
+            if (ret)
+                return ret;
+
+            memcpy(p->bitstream_sw_buf, frame, frame_size);
+            p->pts = mpp_split_get_pts(p->split);
+            out_size = frame_size;
         }
-        p->max_stream_size = len_in + 1024;
-    }
+        mpp_packet_set_buffer(input_packet, NULL);
+        mpp_packet_set_data(input_packet, p->bitstream_sw_buf);
+        mpp_packet_set_size(input_packet, p->max_stream_size);
+    } else {
+        ret = vp8d_parser_check_stream_size(p, len_in);
+        if (ret)
+            return ret;
 
-    vp8d_parser_split_frame(buf,
-                            len_in,
-                            p->bitstream_sw_buf,
-                            &out_size);
-    pos += out_size;
+        vp8d_parser_split_frame(buf,
+                                len_in,
+                                p->bitstream_sw_buf,
+                                &out_size);
+        consume = out_size;
+        mpp_packet_set_buffer(input_packet, NULL);
+        mpp_packet_set_data(input_packet, p->bitstream_sw_buf);
+        mpp_packet_set_size(input_packet, p->max_stream_size);
+    }
+    pos += consume;
 
     mpp_packet_set_pos(pkt, pos);
 
@@ -444,12 +523,14 @@ MPP_RET vp8d_parser_prepare(void *ctx, MppPacket pkt, HalDecTask *task)
         return ret;
     }
 
+    // wait for more data to complete the frame
+    if (out_size == 0 && p->split)
+        return ret;
+
 
 
     // mpp_log("p->bitstream_sw_buf = 0x%x", p->bitstream_sw_buf);
     // mpp_log("out_size = 0x%x", out_size);
-    mpp_packet_set_data(input_packet, p->bitstream_sw_buf);
-    mpp_packet_set_size(input_packet, p->max_stream_size);
     mpp_packet_set_length(input_packet, out_size);
     p->stream_size = out_size;
     task->input_packet = input_packet;
@@ -1170,9 +1251,11 @@ MPP_RET vp8d_parser_parse(void *ctx, HalDecTask *in_task)
     MPP_RET ret = MPP_OK;
     VP8DContext *c = (VP8DContext *)ctx;
     VP8DParserContext_t *p = (VP8DParserContext_t *)c->parse_ctx;
+    /* stream may be in parser buffer or in input MppBuffer on zero copy mode */
+    RK_U8 *stream = (RK_U8 *)mpp_packet_get_data(in_task->input_packet);
     FUN_T("FUN_IN");
 
-    ret = decoder_frame_header(p, p->bitstream_sw_buf, p->stream_size);
+    ret = decoder_frame_header(p, stream, p->stream_size);
 
     if (MPP_OK != ret) {
         mpp_err("decoder_frame_header err ret %d", ret);
@@ -1180,7 +1263,7 @@ MPP_RET vp8d_parser_parse(void *ctx, HalDecTask *in_task)
         return ret;
     }
 
-    vp8hwdSetPartitionOffsets(p, p->bitstream_sw_buf, p->stream_size);
+    vp8hwdSetPartitionOffsets(p, stream, p->stream_size);
 
     ret = vp8d_alloc_frame(p);
     if (MPP_OK != ret) {
@@ -24,6 +24,7 @@
 #include "mpp_mem.h"
 #include "mpp_dec.h"
 #include "mpp_packet.h"
+#include "mpp_split.h"
 
 #include "vp8d_syntax.h"
 #include "vp8d_data.h"
@@ -177,6 +178,8 @@ typedef struct VP8DParserContext {
     RK_U32          needKeyFrame;
     MppPacket       input_packet;
     RK_U32          eos;
+    RK_U32          need_split;
+    MppSplit        split;
 
     MppBufSlots packet_slots;
     MppBufSlots frame_slots;
@@ -310,13 +310,15 @@ static  RK_S32 vp9_frame_free(VP9Context *s)
         if (s->frames[i].ref) {
             vp9_unref_frame(s, &s->frames[i]);
         }
-        mpp_free(s->frames[i].f);
+        if (s->frames[i].f)
+            mpp_frame_deinit(&s->frames[i].f);
     }
     for (i = 0; i < 8; i++) {
         if (s->refs[i].ref) {
             vp9_unref_frame(s, &s->refs[i]);
         }
-        mpp_free(s->refs[i].f);
+        if (s->refs[i].f)
+            mpp_frame_deinit(&s->refs[i].f);
     }
     return 0;
 }
@@ -1301,36 +1303,65 @@ static void adapt_prob(RK_U8 *p, RK_U32 ct0, RK_U32 ct1,
     *p = p1 + (((p2 - p1) * update_factor + 128) >> 8);
 }
 
+#define COEF_MAX_UPDATE     24
+
+/*
+ * Branch free version of adapt_prob for the coefficient probabilities.
+ * A zero count gives a zero update factor which keeps the probability. The
+ * quotient is computed in double which is exact for any 32 bit operands.
+ */
+static RK_U8 merge_coef_prob(RK_U32 p1, RK_U32 ct0, RK_U32 ct, const RK_U32 *uf_tab)
+{
+    RK_U32 d = ct + (ct == 0);
+    RK_U32 p2 = (RK_U32)((double)((ct0 << 8) + (ct >> 1)) / (double)d);
+    RK_U32 update_factor = uf_tab[MPP_MIN(ct, COEF_MAX_UPDATE)];
+
+    p2 = mpp_clip(p2, 1, 255);
+    return p1 + (((p2 - p1) * update_factor + 128) >> 8);
+}
+
+static void adapt_coef_ctx(RK_U8 *p, const RK_U32 *e, const RK_U32 *c,
+                           RK_S32 num, const RK_U32 *uf_tab)
+{
+    RK_S32 i;
+
+    for (i = 0; i < num; i++, p += 3, e += 2, c += 3) {
+        RK_U32 e0 = e[0], e1 = e[1];
+        RK_U32 c0 = c[0], c1 = c[1], c2 = c[2];
+        RK_U32 p0 = p[0], p1 = p[1], p2 = p[2];
+
+        p[0] = merge_coef_prob(p0, e0, e0 + e1, uf_tab);
+        p[1] = merge_coef_prob(p1, c0, c0 + c1 + c2, uf_tab);
+        p[2] = merge_coef_prob(p2, c1, c1 + c2, uf_tab);
+    }
+}
+
+/* adapt all coefficient probabilities over the flat context arrays */
+static void adapt_coef_probs(RK_U8 *p, const RK_U32 *e, const RK_U32 *c, RK_S32 uf)
+{
+    RK_U32 uf_tab[COEF_MAX_UPDATE + 1];
+    RK_S32 i;
+
+    for (i = 0; i <= COEF_MAX_UPDATE; i++)
+        uf_tab[i] = FASTDIV(uf * i, COEF_MAX_UPDATE);
+
+    // 16 blocks of 6 bands x 6 contexts, dc band only has 3 contexts
+    for (i = 0; i < 4 * 2 * 2; i++, p += 36 * 3, e += 36 * 2, c += 36 * 3) {
+        adapt_coef_ctx(p, e, c, 3, uf_tab);
+        adapt_coef_ctx(p + 6 * 3, e + 6 * 2, c + 6 * 3, 30, uf_tab);
+    }
+}
+
 static void adapt_probs(VP9Context *s)
 {
-    RK_S32 i, j, k, l, m;
+    RK_S32 i, j;
     prob_context *p = &s->prob_ctx[s->framectxid].p;
     RK_S32 uf = (s->keyframe || s->intraonly || !s->last_keyframe) ? 112 : 128;
 
     // coefficients
-    for (i = 0; i < 4; i++)
-        for (j = 0; j < 2; j++)
-            for (k = 0; k < 2; k++)
-                for (l = 0; l < 6; l++)
-                    for (m = 0; m < 6; m++) {
-                        RK_U8 *pp = s->prob_ctx[s->framectxid].coef[i][j][k][l][m];
-                        RK_U32 *e = s->counts.eob[i][j][k][l][m];
-                        RK_U32 *c = s->counts.coef[i][j][k][l][m];
-
-                        if (l == 0 && m >= 3) // dc only has 3 pt
-                            break;
-                        /*  if(i == 0 && j == 0 && k== 1 && l == 0){
-                             mpp_log("e[0] = 0x%x e[1] = 0x%x c[0] = 0x%x c[1] = 0x%x c[2] = 0x%x \n",
-                             e[0],e[1],c[0],c[1],c[2]);
-                             mpp_log("pp[0] = 0x%x pp[1] = 0x%x pp[2] = 0x%x",pp[0],pp[1],pp[2]);
-                          }*/
-                        adapt_prob(&pp[0], e[0], e[1], 24, uf);
-                        adapt_prob(&pp[1], c[0], c[1] + c[2], 24, uf);
-                        adapt_prob(&pp[2], c[1], c[2], 24, uf);
-                        /* if(i == 0 && j == 0 && k== 1 && l == 0){
-                            mpp_log("after pp[0] = 0x%x pp[1] = 0x%x pp[2] = 0x%x",pp[0],pp[1],pp[2]);
-                         }*/
-                    }
+    adapt_coef_probs(&s->prob_ctx[s->framectxid].coef[0][0][0][0][0][0],
+                     &s->counts.eob[0][0][0][0][0][0],
+                     &s->counts.coef[0][0][0][0][0][0], uf);
 #ifdef dump
     fwrite(&s->counts, 1, sizeof(s->counts), vp9_p_fp);
     fflush(vp9_p_fp);
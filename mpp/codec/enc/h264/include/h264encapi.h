@@ -251,6 +251,7 @@ typedef struct {
                               * on the operation of the rate control
                               */
     RK_U32 hrdCpbSize;      /* Size of Coded Picture Buffer in HRD (bits) */
+    RK_U32 frameRateOut;    /* Output frame rate in frames/second */
     RK_U32 gopLen;          /* Length for Group of Pictures, indicates
                               * the distance of two intra pictures,
                               * including first intra [1..150]
@@ -94,6 +94,12 @@ void EncAsicFrameStart(void * inst, regValues_s * val, h264e_syntax *syntax_data
     syntax_data->qp_max = ctx->rateControl.qpMax;
     syntax_data->cp_distance_mbs = val->cpDistanceMbs;
     syntax_data->mb_rc_mode = ctx->rateControl.mbRc;
+    syntax_data->bit_rate   = ctx->rateControl.virtualBuffer.bitRate;
+    syntax_data->frame_rate = ctx->enc_rc_cfg.frameRateOut;
+    if (!syntax_data->frame_rate)
+        syntax_data->frame_rate = ctx->rateControl.outRateNum / MAX(1, ctx->rateControl.outRateDenom);
+    syntax_data->gop        = ctx->intraPicRate;
+    syntax_data->target_bits = (ctx->rateControl.picRc) ? (ctx->rateControl.targetPicSize) : (0);
     if (val->cpTarget != NULL) {
         for (iCount = 0; iCount < 10; ++iCount) {
             syntax_data->cp_target[iCount] = val->cpTarget[iCount];
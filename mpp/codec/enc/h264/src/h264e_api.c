@@ -49,7 +49,11 @@ MPP_RET h264e_init(void *ctx, ControllerCfg *ctrlCfg)
         mpp_err_f("H264EncInit() failed ret %d", ret);
     }
 
-    (void)ctrlCfg;
+    /*
+     * stream size and rate control are updated in H264EncStrmEncodeAfter
+     * so next frame can not be encoded before hardware feedback
+     */
+    ctrlCfg->task_count = 1;
 
     h264e_dbg_func("leave\n");
     return ret;
@@ -340,6 +344,7 @@ MPP_RET h264e_config(void *ctx, RK_S32 cmd, void *param)
             enc_rc_cfg->intraPicRate = 30;
 
         enc_rc_cfg->bitPerSecond = mpp_cfg->bps;
+        enc_rc_cfg->frameRateOut = mpp_cfg->fps_out;
         enc_rc_cfg->gopLen = mpp_cfg->gop;
         enc_rc_cfg->fixedIntraQp = 0;
         enc_rc_cfg->mbQpAdjustment = 0;
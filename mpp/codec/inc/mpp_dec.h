@@ -19,6 +19,7 @@
 
 #include "mpp_parser.h"
 #include "mpp_hal.h"
+#include "mpp_isp.h"
 
 typedef struct MppDec_t MppDec;
 
@@ -32,6 +33,8 @@ struct MppDec_t {
     MppBufSlots         frame_slots;
     MppBufSlots         packet_slots;
     HalTaskGroup        tasks;
+    /* pipeline depth between parser thread and hal thread in task mode */
+    RK_S32              task_count;
 
     // status flag
     RK_U32              reset_flag;
@@ -44,6 +47,12 @@ struct MppDec_t {
     // dec parser thread runtime resource context
     MppPacket           mpp_pkt_in;
     void                *mpp;
+
+    // parser task kept across steps on worker pool
+    void                *parser_task;
+
+    // software isp stage on output frame, setup by MPP_DEC_SET_ISP_CFG before init
+    MppIsp              isp;
 };
 
 typedef struct {
@@ -51,6 +60,10 @@ typedef struct {
     RK_U32              fast_mode;
     RK_U32              need_split;
     RK_U32              internal_pts;
+    /* task mode pipeline depth, 0 for default */
+    RK_S32              task_count;
+    /* isp stage config on output frame, NULL to disable */
+    MppIspConfig        *isp_cfg;
     void                *mpp;
 } MppDecCfg;
 
@@ -63,7 +76,35 @@ extern "C" {
  */
 void *mpp_dec_parser_thread(void *data);
 void *mpp_dec_hal_thread(void *data);
+
+/*
+ * task mode (MJPEG) decoder is a two stage pipeline connected by hal task group
+ *
+ * advanced thread     : get input task, run parser and generate register,
+ *                       then start hardware and send task to hal thread
+ * advanced hal thread : wait hardware done, then return input task and send
+ *                       output frame to output port in input order. It is
+ *                       the only thread returning input task so the input
+ *                       task port keeps one producer.
+ */
 void *mpp_dec_advanced_thread(void *data);
+void *mpp_dec_advanced_hal_thread(void *data);
+
+/*
+ * parser / hal work on shared worker pool. Each step runs one round of the
+ * thread loop and returns zero when it has to wait for next signal.
+ */
+RK_S32 mpp_dec_parser_step(void *data);
+RK_S32 mpp_dec_hal_step(void *data);
+void *mpp_dec_parser_step_done(void *data);
+
+/*
+ * synchronous decode for mpi decode interface. Parser and hal threads are
+ * stopped and the decoding runs on caller thread until the input packet is
+ * consumed or the parser has to wait for user. Output frames are queued to
+ * mpp frame list. Task mode (MJPEG) decodes one image per call.
+ */
+MPP_RET mpp_dec_decode(void *data, MppPacket packet);
 
 /*
  *
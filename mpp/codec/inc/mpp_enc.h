@@ -164,6 +164,13 @@ struct MppEnc_t {
     MppBufSlots         frame_slots;
     MppBufSlots         packet_slots;
     HalTaskGroup        tasks;
+    /*
+     * input and output task queue depth, frames user can queue ahead
+     * hardware is still waited frame by frame in control thread
+     */
+    RK_S32              task_count;
+    /* output stream buffer size of current packet pool */
+    size_t              packet_size;
 
     RK_U32              reset_flag;
     void                *mpp;
@@ -184,11 +191,23 @@ extern "C" {
 
 /*
  * main thread for all encoder. This thread will connect encoder / hal / mpp
+ *
+ * h264e and jpege keep one frame of stream and rate control state which is
+ * updated on hardware feedback, so the frame is encoded, waited and sent to
+ * output port in this thread before next frame is taken.
  */
 void *mpp_enc_control_thread(void *data);
-void *mpp_enc_hal_thread(void *data);
 
-MPP_RET mpp_enc_init(MppEnc **enc, MppCodingType coding);
+/*
+ * synchronous encode for mpi encode interface. Control thread is
+ * stopped and one frame is encoded on caller thread.
+ */
+MPP_RET mpp_enc_encode(void *data, MppFrame frame, MppPacket *packet);
+
+/*
+ * task_count is the input and output task queue depth, 0 for default
+ */
+MPP_RET mpp_enc_init(MppEnc **enc, MppCodingType coding, RK_S32 task_count);
 MPP_RET mpp_enc_deinit(MppEnc *enc);
 MPP_RET mpp_enc_control(MppEnc *enc, MpiCmd cmd, void *param);
 MPP_RET mpp_enc_notify(void *ctx, void *info);
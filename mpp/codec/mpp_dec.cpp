@@ -31,6 +31,8 @@
 
 #include "vpu_api.h"
 
+#define MPP_DEC_MAX_TASK_COUNT      8
+
 typedef union PaserTaskWait_u {
     RK_U32          val;
     struct {
@@ -226,6 +228,13 @@ static RK_U32 reset_dec_task(Mpp *mpp, DecTask *task)
 static void mpp_put_frame(Mpp *mpp, MppFrame frame)
 {
     mpp_list *list = mpp->mFrames;
+    MppDec *dec = mpp->mDec;
+
+    /* isp stage runs here on hal thread before frame is sent to user */
+    if (dec && dec->isp && mpp_frame_get_buffer(frame)) {
+        if (mpp_isp_convert(dec->isp, frame))
+            mpp_frame_set_errinfo(frame, 1);
+    }
 
     list->lock();
     list->add_at_tail(&frame, sizeof(frame));
@@ -254,9 +263,10 @@ static void mpp_dec_push_display(Mpp *mpp)
     MppDec *dec = mpp->mDec;
     MppBufSlots frame_slots = dec->frame_slots;
     mpp->mThreadHal->lock(THREAD_QUE_DISPLAY);
-    while (MPP_OK == mpp_buf_slot_dequeue(frame_slots, &index, QUEUE_DISPLAY)) {
+    while (1) {
         MppFrame frame = NULL;
-        mpp_buf_slot_get_prop(frame_slots, index, SLOT_FRAME, &frame);
+        if (mpp_buf_slot_dequeue_frame(frame_slots, &index, &frame, QUEUE_DISPLAY))
+            break;
         if (!dec->reset_flag) {
             mpp_put_frame(mpp, frame);
         } else {
@@ -265,7 +275,6 @@ static void mpp_dec_push_display(Mpp *mpp)
             if (buffer)
                 mpp_buffer_put(buffer);
         }
-        mpp_buf_slot_clr_flag(frame_slots, index, SLOT_QUEUE_USE);
     }
     mpp->mThreadHal->unlock(THREAD_QUE_DISPLAY);
 }
@@ -403,17 +412,37 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
     task->hal_pkt_idx_in = task_dec->input;
     stream_size = mpp_packet_get_size(task_dec->input_packet);
 
+    /*
+     * When parser pass the input MppBuffer through and the stream starts at
+     * the beginning of the buffer the buffer can be used by hardware directly.
+     */
+    MppBuffer pkt_buf = mpp_packet_get_buffer(task_dec->input_packet);
+    RK_U32 zero_copy = (pkt_buf &&
+                        mpp_packet_get_data(task_dec->input_packet) == mpp_buffer_get_ptr(pkt_buf));
+
     MppBuffer hal_buf_in;
     mpp_buf_slot_get_prop(packet_slots, task->hal_pkt_idx_in, SLOT_BUFFER, &hal_buf_in);
-    if (NULL == hal_buf_in) {
-        mpp_buffer_get(mpp->mPacketGroup, &hal_buf_in, stream_size);
-        if (hal_buf_in) {
-            mpp_buf_slot_set_prop(packet_slots, task->hal_pkt_idx_in, SLOT_BUFFER, hal_buf_in);
-            mpp_buffer_put(hal_buf_in);
-        }
+    if (zero_copy) {
+        if (hal_buf_in != pkt_buf)
+            mpp_buf_slot_set_prop(packet_slots, task->hal_pkt_idx_in, SLOT_BUFFER, pkt_buf);
+
+        hal_buf_in = pkt_buf;
     } else {
-        MppBufferImpl *buf = (MppBufferImpl *)hal_buf_in;
-        mpp_assert(buf->info.size >= stream_size);
+        /* NOTE: buffer left by zero copy task belongs to user and can not be written */
+        if (hal_buf_in &&
+            ((MppBufferImpl *)hal_buf_in)->group_id != ((MppBufferGroupImpl *)mpp->mPacketGroup)->group_id)
+            hal_buf_in = NULL;
+
+        if (NULL == hal_buf_in) {
+            mpp_buffer_get(mpp->mPacketGroup, &hal_buf_in, stream_size);
+            if (hal_buf_in) {
+                mpp_buf_slot_set_prop(packet_slots, task->hal_pkt_idx_in, SLOT_BUFFER, hal_buf_in);
+                mpp_buffer_put(hal_buf_in);
+            }
+        } else {
+            MppBufferImpl *buf = (MppBufferImpl *)hal_buf_in;
+            mpp_assert(buf->info.size >= stream_size);
+        }
     }
 
     task->hal_pkt_buf_in = hal_buf_in;
@@ -425,10 +454,12 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
      * 6. copy prepared stream to hardware buffer
      */
     if (!task->status.dec_pkt_copy_rdy) {
-        MppBufferImpl *buf = (MppBufferImpl *)task->hal_pkt_buf_in;
-        void *src = mpp_packet_get_data(task_dec->input_packet);
-        size_t length = mpp_packet_get_length(task_dec->input_packet);
-        memcpy(buf->info.ptr, src, length);
+        if (!zero_copy) {
+            MppBufferImpl *buf = (MppBufferImpl *)task->hal_pkt_buf_in;
+            void *src = mpp_packet_get_data(task_dec->input_packet);
+            size_t length = mpp_packet_get_length(task_dec->input_packet);
+            memcpy(buf->info.ptr, src, length);
+        }
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
         mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
         task->status.dec_pkt_copy_rdy = 1;
@@ -618,12 +649,25 @@ static MPP_RET try_proc_dec_task(Mpp *mpp, DecTask *task)
 
 
 
+static void dec_parser_exit(Mpp *mpp, DecTask *task)
+{
+    MppBufSlots packet_slots = mpp->mDec->packet_slots;
+
+    if (task && NULL != task->hnd && task->info.dec.valid) {
+        HalDecTask *task_dec = &task->info.dec;
+
+        mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
+        mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
+        mpp_buf_slot_clr_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
+    }
+    mpp_buffer_group_clear(mpp->mPacketGroup);
+}
+
 void *mpp_dec_parser_thread(void *data)
 {
     Mpp *mpp = (Mpp*)data;
     MppThread *parser   = mpp->mThreadCodec;
     MppDec    *dec      = mpp->mDec;
-    MppBufSlots packet_slots = dec->packet_slots;
 
     /*
      * parser thread need to wait at cases below:
@@ -633,7 +677,6 @@ void *mpp_dec_parser_thread(void *data)
      * 3. no buffer on analyzing output task
      */
     DecTask task;
-    HalDecTask  *task_dec = &task.info.dec;
 
     dec_task_init(&task);
 
@@ -659,37 +702,142 @@ void *mpp_dec_parser_thread(void *data)
 
     }
     mpp_log("mpp_dec_parser_thread exit");
-    if (NULL != task.hnd && task_dec->valid) {
-        mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
-        mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
-        mpp_buf_slot_clr_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
-    }
-    mpp_buffer_group_clear(mpp->mPacketGroup);
+    dec_parser_exit(mpp, &task);
     mpp_log("mpp_dec_parser_thread exit ok");
     return NULL;
 }
 
-void *mpp_dec_hal_thread(void *data)
+RK_S32 mpp_dec_parser_step(void *data)
 {
     Mpp *mpp = (Mpp*)data;
-    MppThread *hal      = mpp->mThreadHal;
+    MppDec *dec = mpp->mDec;
+    DecTask *task = (DecTask *)dec->parser_task;
+
+    if (NULL == task) {
+        task = mpp_calloc(DecTask, 1);
+        if (NULL == task) {
+            mpp_err_f("failed to malloc parser task\n");
+            return 0;
+        }
+        dec_task_init(task);
+        dec->parser_task = task;
+    }
+
+    if (dec->reset_flag) {
+        if (reset_dec_task(mpp, task))
+            return 1;
+    }
+
+    try_proc_dec_task(mpp, task);
+
+    /* same wait condition as parser thread: idle until next signal */
+    return (check_task_wait(dec, task)) ? (0) : (1);
+}
+
+void *mpp_dec_parser_step_done(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    MppDec *dec = mpp->mDec;
+    DecTask *task = (DecTask *)dec->parser_task;
+
+    dec_parser_exit(mpp, task);
+    MPP_FREE(dec->parser_task);
+    return NULL;
+}
+
+static void dec_hal_proc(Mpp *mpp, HalTaskHnd task)
+{
     MppDec    *dec      = mpp->mDec;
     HalTaskGroup tasks  = dec->tasks;
     MppBufSlots frame_slots = dec->frame_slots;
     MppBufSlots packet_slots = dec->packet_slots;
+    HalTaskInfo task_info;
+    HalDecTask  *task_dec = &task_info.dec;
+
+    mpp->mTaskGetCount++;
+
+    hal_task_hnd_get_info(task, &task_info);
+    /*
+     * check info change flag
+     * if this is a info change frame, only output the mpp_frame for info change.
+     */
+
+    if (task_dec->flags.info_change) {
+        MppFrame info_frame = NULL;
+        mpp_dec_flush(dec);
+        mpp_dec_push_display(mpp);
+        mpp_buf_slot_get_prop(frame_slots, task_dec->output, SLOT_FRAME, &info_frame);
+        mpp_assert(info_frame);
+        mpp_assert(NULL == mpp_frame_get_buffer(info_frame));
+        mpp_frame_set_info_change(info_frame, 1);
+        mpp_frame_set_errinfo(info_frame, 0);
+        mpp_put_frame(mpp, info_frame);
+
+        hal_task_hnd_set_status(task, TASK_IDLE);
+        mpp->mThreadCodec->signal();
+        return;
+    }
+    /*
+     * check eos task
+     * if this task is invalid then eos flag come we will flush display que
+     * then push eos frame to tell all frame decoded
+     */
+    if (task_dec->flags.eos && !task_dec->valid) {
+        mpp_dec_push_display(mpp);
+        mpp_put_frame_eos(mpp);
+        hal_task_hnd_set_status(task, TASK_IDLE);
+        mpp->mThreadCodec->signal();
+        return;
+    }
+    mpp_hal_hw_wait(dec->hal, &task_info);
+    /*
+     * when hardware decoding is done:
+     * 1. clear decoding flag (mark buffer is ready)
+     * 2. use get_display to get a new frame with buffer
+     * 3. add frame to output list
+     * repeat 2 and 3 until not frame can be output
+     */
+    mpp_buf_slot_clr_flag(packet_slots, task_dec->input,  SLOT_HAL_INPUT);
+
+    // TODO: may have risk here
+    hal_task_hnd_set_status(task, TASK_PROC_DONE);
+    task = NULL;
+    if (dec->parser_fast_mode) {
+        hal_task_get_hnd(tasks, TASK_PROC_DONE, &task);
+        if (task) {
+            hal_task_hnd_set_status(task, TASK_IDLE);
+        }
+    }
+    mpp->mThreadCodec->signal();
+
+    mpp_buf_slot_clr_hal_flag(frame_slots, task_dec->output, task_dec->refer,
+                              MPP_ARRAY_ELEMS(task_dec->refer));
+    if (task_dec->flags.eos) {
+        mpp_dec_flush(dec);
+    }
+    mpp_dec_push_display(mpp);
+    /*
+     * check eos task
+     * if this task is valid then eos flag come we will flush display que
+     * then push eos frame to tell all frame decoded
+     */
+    if (task_dec->flags.eos) {
+        mpp_put_frame_eos(mpp);
+    }
+}
+
+void *mpp_dec_hal_thread(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    MppThread *hal      = mpp->mThreadHal;
+    HalTaskGroup tasks  = mpp->mDec->tasks;
 
     /*
      * hal thread need to wait at cases below:
      * 1. no task slot for work
      */
     HalTaskHnd  task = NULL;
-    HalTaskInfo task_info;
-    HalDecTask  *task_dec = &task_info.dec;
-    RK_S64 cur_deat = 0;
-    RK_U64 dec_no = 0, total_time = 0;
-    RK_S64 p_s, p_e;
 
-    p_s = mpp_time();
     while (MPP_THREAD_RUNNING == hal->get_status()) {
         /*
          * hal thread wait for dxva interface intput firt
@@ -702,88 +850,8 @@ void *mpp_dec_hal_thread(void *data)
         hal->unlock();
 
         if (task) {
-            mpp->mTaskGetCount++;
-
-            hal_task_hnd_get_info(task, &task_info);
-            /*
-             * check info change flag
-             * if this is a info change frame, only output the mpp_frame for info change.
-             */
-
-            if (task_dec->flags.info_change) {
-                MppFrame info_frame = NULL;
-                mpp_dec_flush(dec);
-                mpp_dec_push_display(mpp);
-                mpp_buf_slot_get_prop(frame_slots, task_dec->output, SLOT_FRAME, &info_frame);
-                mpp_assert(info_frame);
-                mpp_assert(NULL == mpp_frame_get_buffer(info_frame));
-                mpp_frame_set_info_change(info_frame, 1);
-                mpp_frame_set_errinfo(info_frame, 0);
-                mpp_put_frame(mpp, info_frame);
-
-                hal_task_hnd_set_status(task, TASK_IDLE);
-                task = NULL;
-                mpp->mThreadCodec->signal();
-                continue;
-            }
-            /*
-             * check eos task
-             * if this task is invalid then eos flag come we will flush display que
-             * then push eos frame to tell all frame decoded
-             */
-            if (task_dec->flags.eos && !task_dec->valid) {
-                mpp_dec_push_display(mpp);
-                mpp_put_frame_eos(mpp);
-                hal_task_hnd_set_status(task, TASK_IDLE);
-                mpp->mThreadCodec->signal();
-                task = NULL;
-                continue;
-            }
-            mpp_hal_hw_wait(dec->hal, &task_info);
-            p_e = mpp_time();
-            cur_deat = (p_e - p_s);
-            total_time += cur_deat;
-            //mpp_log("[Cal_time] dec_no=%lld, time=%d ms, av_time=%lld ms. \n", dec_no, cur_deat, total_time/(dec_no + 1));
-            dec_no++;
-            p_s = p_e;
-            /*
-             * when hardware decoding is done:
-             * 1. clear decoding flag (mark buffer is ready)
-             * 2. use get_display to get a new frame with buffer
-             * 3. add frame to output list
-             * repeat 2 and 3 until not frame can be output
-             */
-            mpp_buf_slot_clr_flag(packet_slots, task_dec->input,  SLOT_HAL_INPUT);
-
-            // TODO: may have risk here
-            hal_task_hnd_set_status(task, TASK_PROC_DONE);
+            dec_hal_proc(mpp, task);
             task = NULL;
-            if (dec->parser_fast_mode) {
-                hal_task_get_hnd(tasks, TASK_PROC_DONE, &task);
-                if (task) {
-                    hal_task_hnd_set_status(task, TASK_IDLE);
-                }
-            }
-            mpp->mThreadCodec->signal();
-
-            mpp_buf_slot_clr_flag(frame_slots, task_dec->output, SLOT_HAL_OUTPUT);
-            for (RK_U32 i = 0; i < MPP_ARRAY_ELEMS(task_dec->refer); i++) {
-                RK_S32 index = task_dec->refer[i];
-                if (index >= 0)
-                    mpp_buf_slot_clr_flag(frame_slots, index, SLOT_HAL_INPUT);
-            }
-            if (task_dec->flags.eos) {
-                mpp_dec_flush(dec);
-            }
-            mpp_dec_push_display(mpp);
-            /*
-             * check eos task
-             * if this task is valid then eos flag come we will flush display que
-             * then push eos frame to tell all frame decoded
-             */
-            if (task_dec->flags.eos) {
-                mpp_put_frame_eos(mpp);
-            }
         }
     }
 
@@ -791,6 +859,18 @@ void *mpp_dec_hal_thread(void *data)
     return NULL;
 }
 
+RK_S32 mpp_dec_hal_step(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    HalTaskHnd task = NULL;
+
+    if (hal_task_get_hnd(mpp->mDec->tasks, TASK_PROCESSING, &task))
+        return 0;
+
+    dec_hal_proc(mpp, task);
+    return 1;
+}
+
 static MPP_RET dec_release_task_in_port(MppPort port)
 {
     MPP_RET ret = MPP_OK;
@@ -823,6 +903,28 @@ static MPP_RET dec_release_task_in_port(MppPort port)
     return ret;
 }
 
+/*
+ * send the input task to hal thread for returning without decoding
+ */
+static void mpp_dec_return_task(Mpp *mpp, HalTaskHnd hnd, MppTask mpp_task)
+{
+    HalTaskInfo task_info;
+    HalDecTask *task_dec = &task_info.dec;
+    MppThread *hal = mpp->mThreadHal;
+
+    hal_task_info_init(&task_info, MPP_CTX_DEC);
+    task_dec->mpp_task = mpp_task;
+    task_dec->packet   = NULL;
+    task_dec->frame    = NULL;
+
+    hal_task_hnd_set_info(hnd, &task_info);
+    hal_task_hnd_set_status(hnd, TASK_PROCESSING);
+
+    hal->lock();
+    hal->signal();
+    hal->unlock();
+}
+
 void *mpp_dec_advanced_thread(void *data)
 {
     Mpp *mpp = (Mpp*)data;
@@ -830,132 +932,488 @@ void *mpp_dec_advanced_thread(void *data)
     MppBufSlots frame_slots = dec->frame_slots;
     MppBufSlots packet_slots = dec->packet_slots;
     MppThread *thd_dec  = mpp->mThreadCodec;
-    DecTask task;   /* decoder task */
-    DecTask *pTask = &task;
-    dec_task_init(pTask);
-    HalDecTask  *task_dec = &pTask->info.dec;
+    MppThread *hal      = mpp->mThreadHal;
+    HalTaskGroup tasks  = dec->tasks;
+    HalTaskHnd hnd = NULL;
+    HalTaskInfo task_info;
+    HalDecTask *task_dec = &task_info.dec;
 
     MppPort input  = mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT);
-    MppPort output = mpp_task_queue_get_port(mpp->mOutputTaskQueue, MPP_PORT_INPUT);
     MppTask mpp_task = NULL;
     MPP_RET ret = MPP_OK;
+    RK_U32 ready = 0;
     MppFrame frame = NULL;
     MppPacket packet = NULL;
 
+    memset(&task_info, 0, sizeof(task_info));
+
     while (MPP_THREAD_RUNNING == thd_dec->get_status()) {
+        /*
+         * parser thread need to wait at cases below:
+         * 1. no idle hal task for pipeline
+         * 2. no input task from user
+         */
         thd_dec->lock();
-        ret = mpp_port_dequeue(input, &mpp_task);
-        if (ret || NULL == mpp_task) {
-            thd_dec->wait();
+        if (MPP_THREAD_RUNNING == thd_dec->get_status()) {
+            if (NULL == hnd)
+                hal_task_get_hnd(tasks, TASK_IDLE, &hnd);
+
+            if (hnd && NULL == mpp_task)
+                mpp_port_dequeue(input, &mpp_task);
+
+            ready = (hnd && mpp_task);
+            if (!ready)
+                thd_dec->wait();
         }
         thd_dec->unlock();
 
-        if (mpp_task != NULL) {
-            mpp_task_meta_get_packet(mpp_task, KEY_INPUT_PACKET, &packet);
-            mpp_task_meta_get_frame (mpp_task, KEY_OUTPUT_FRAME,  &frame);
+        if (!ready)
+            continue;
 
-            if (NULL == packet) {
-                mpp_port_enqueue(input, mpp_task);
-                continue;
-            }
+        mpp_task_meta_get_packet(mpp_task, KEY_INPUT_PACKET, &packet);
+        mpp_task_meta_get_frame (mpp_task, KEY_OUTPUT_FRAME,  &frame);
 
-            if (mpp_packet_get_buffer(packet)) {
-                /*
-                 * if there is available buffer in the input packet do decoding
-                 */
-                MppBuffer input_buffer = mpp_packet_get_buffer(packet);
-                MppBuffer output_buffer = mpp_frame_get_buffer(frame);
-
-                parser_prepare(dec->parser, packet, task_dec);
-
-                /*
-                 * We may find eos in prepare step and there will be no anymore vaild task generated.
-                 * So here we try push eos task to hal, hal will push all frame to display then
-                 * push a eos frame to tell all frame decoded
-                 */
-                if (task_dec->flags.eos && !task_dec->valid) {
-                    mpp_frame_init(&frame);
-                    mpp_frame_set_eos(frame, 1);
-                    goto DEC_OUT;
-                }
-
-                /*
-                 *  look for a unused packet slot index
-                 */
-                if (task_dec->input < 0) {
-                    mpp_buf_slot_get_unused(packet_slots, &task_dec->input);
-                }
-                mpp_buf_slot_set_prop(packet_slots, task_dec->input, SLOT_BUFFER, input_buffer);
-                mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
-                mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
-
-                ret = parser_parse(dec->parser, task_dec);
-                if (ret != MPP_OK) {
-                    mpp_err_f("something wrong with parser_parse!\n");
-                    mpp_buf_slot_clr_flag(packet_slots, task_dec->input,  SLOT_HAL_INPUT);
-                    mpp_frame_init(&frame);
-                    goto DEC_OUT;
-                }
+        if (NULL == packet) {
+            mpp_dec_return_task(mpp, hnd, mpp_task);
+            hnd = NULL;
+            mpp_task = NULL;
+            frame = NULL;
+            continue;
+        }
 
-                if (mpp_buf_slot_is_changed(frame_slots)) {
-                    size_t slot_size = mpp_buf_slot_get_size(frame_slots);
-                    size_t buffer_size = mpp_buffer_get_size(output_buffer);
+        hal_task_info_init(&task_info, MPP_CTX_DEC);
 
-                    if (slot_size == buffer_size) {
-                        mpp_buf_slot_ready(frame_slots);
-                    }
+        if (mpp_packet_get_buffer(packet)) {
+            /*
+             * if there is available buffer in the input packet do decoding
+             */
+            MppBuffer input_buffer = mpp_packet_get_buffer(packet);
+            MppBuffer output_buffer = mpp_frame_get_buffer(frame);
 
-                    mpp_assert(slot_size == buffer_size);
-                }
+            parser_prepare(dec->parser, packet, task_dec);
 
-                mpp_buf_slot_set_prop(frame_slots, task_dec->output, SLOT_BUFFER, output_buffer);
+            /*
+             * We may find eos in prepare step and there will be no anymore vaild task generated.
+             * So here we try push eos task to hal, hal will push all frame to display then
+             * push a eos frame to tell all frame decoded
+             */
+            if (task_dec->flags.eos && !task_dec->valid) {
+                mpp_frame_init(&frame);
+                mpp_frame_set_eos(frame, 1);
+                goto DEC_OUT;
+            }
 
-                // register genertation
-                mpp_hal_reg_gen(dec->hal, &pTask->info);
-                mpp_hal_hw_start(dec->hal, &pTask->info);
-                mpp_hal_hw_wait(dec->hal, &pTask->info);
+            /*
+             *  look for a unused packet slot index
+             */
+            if (task_dec->input < 0) {
+                mpp_buf_slot_get_unused(packet_slots, &task_dec->input);
+            }
+            mpp_buf_slot_set_prop(packet_slots, task_dec->input, SLOT_BUFFER, input_buffer);
+            mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
+            mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
 
+            ret = parser_parse(dec->parser, task_dec);
+            if (ret != MPP_OK) {
+                mpp_err_f("something wrong with parser_parse!\n");
                 mpp_buf_slot_clr_flag(packet_slots, task_dec->input,  SLOT_HAL_INPUT);
-                mpp_buf_slot_clr_flag(frame_slots, task_dec->output, SLOT_HAL_OUTPUT);
-            } else {
-                /*
-                 * else init a empty frame for output
-                 */
-                mpp_log_f("line(%d): Error! Get no buffer from input packet\n", __LINE__);
                 mpp_frame_init(&frame);
+                task_dec->valid = 0;
+                goto DEC_OUT;
             }
 
+            if (mpp_buf_slot_is_changed(frame_slots)) {
+                size_t slot_size = mpp_buf_slot_get_size(frame_slots);
+                size_t buffer_size = mpp_buffer_get_size(output_buffer);
+
+                if (slot_size == buffer_size) {
+                    mpp_buf_slot_ready(frame_slots);
+                }
+
+                mpp_assert(slot_size == buffer_size);
+            }
+
+            mpp_buf_slot_set_prop(frame_slots, task_dec->output, SLOT_BUFFER, output_buffer);
+
+            // register genertation
+            mpp_hal_reg_gen(dec->hal, &task_info);
+            mpp_hal_hw_start(dec->hal, &task_info);
+            task_dec->valid = 1;
+        } else {
             /*
-             * first clear output packet
-             * then enqueue task back to input port
-             * final user will release the mpp_frame they had input
+             * else init a empty frame for output
              */
-        DEC_OUT:
-            mpp_task_meta_set_packet(mpp_task, KEY_INPUT_PACKET, packet);
-            mpp_port_enqueue(input, mpp_task);
-            mpp_task = NULL;
+            mpp_log_f("line(%d): Error! Get no buffer from input packet\n", __LINE__);
+            mpp_frame_init(&frame);
+        }
 
-            // send finished task to output port
-            mpp_port_dequeue(output, &mpp_task);
-            mpp_task_meta_set_frame(mpp_task, KEY_OUTPUT_FRAME, frame);
+        /*
+         * hardware is running now, send the task to hal thread for waiting
+         * and go on with the next input task
+         */
+    DEC_OUT:
+        task_dec->mpp_task = mpp_task;
+        task_dec->packet   = packet;
+        task_dec->frame    = frame;
 
-            // setup output task here
-            mpp_port_enqueue(output, mpp_task);
-            mpp_task = NULL;
-            packet = NULL;
-            frame = NULL;
+        hal_task_hnd_set_info(hnd, &task_info);
+        hal_task_hnd_set_status(hnd, TASK_PROCESSING);
+
+        hal->lock();
+        hal->signal();
+        hal->unlock();
+
+        hnd = NULL;
+        mpp_task = NULL;
+        packet = NULL;
+        frame = NULL;
+    }
+
+    /*
+     * return the input task which is not processed yet
+     * input task is only dequeued with an idle hal task so hnd is valid here
+     */
+    if (mpp_task)
+        mpp_dec_return_task(mpp, hnd, mpp_task);
+
+    return NULL;
+}
+
+static void mpp_dec_put_task_output(Mpp *mpp, HalDecTask *task_dec)
+{
+    MppThread *hal = mpp->mThreadHal;
+    MppPort input  = mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT);
+    MppPort output = mpp_task_queue_get_port(mpp->mOutputTaskQueue, MPP_PORT_INPUT);
+    MppTask mpp_task = NULL;
+
+    /*
+     * task without packet only returns the input task to user.
+     * hal thread is the only producer of input task port so parser thread
+     * hands the input task to here instead of enqueuing it by itself.
+     */
+    if (NULL == task_dec->packet) {
+        mpp_port_enqueue(input, task_dec->mpp_task);
+        return ;
+    }
+
+    /*
+     * first return input task with its packet
+     * then send frame to output port, wait user to return output task
+     */
+    mpp_task_meta_set_packet(task_dec->mpp_task, KEY_INPUT_PACKET, task_dec->packet);
+    mpp_port_enqueue(input, task_dec->mpp_task);
+
+    hal->lock();
+    while (mpp_port_dequeue(output, &mpp_task) || NULL == mpp_task) {
+        if (MPP_THREAD_RUNNING != hal->get_status())
+            break;
+        hal->wait();
+    }
+    hal->unlock();
+
+    if (NULL == mpp_task)
+        return ;
+
+    mpp_task_meta_set_frame(mpp_task, KEY_OUTPUT_FRAME, task_dec->frame);
+    mpp_port_enqueue(output, mpp_task);
+}
+
+void *mpp_dec_advanced_hal_thread(void *data)
+{
+    Mpp *mpp = (Mpp*)data;
+    MppDec *dec      = mpp->mDec;
+    MppBufSlots frame_slots = dec->frame_slots;
+    MppBufSlots packet_slots = dec->packet_slots;
+    MppThread *hal      = mpp->mThreadHal;
+    MppThread *thd_dec  = mpp->mThreadCodec;
+    HalTaskGroup tasks  = dec->tasks;
+    HalTaskHnd hnd = NULL;
+    HalTaskInfo task_info;
+    HalDecTask *task_dec = &task_info.dec;
+
+    memset(&task_info, 0, sizeof(task_info));
+
+    /*
+     * NOTE: hal thread is stopped after parser thread so the task started
+     * by parser thread will always be finished here before thread exit.
+     * Hal task group list is in fifo order so output keeps input order.
+     */
+    while (1) {
+        hal->lock();
+        if (hal_task_get_hnd(tasks, TASK_PROCESSING, &hnd)) {
+            if (MPP_THREAD_RUNNING != hal->get_status()) {
+                hal->unlock();
+                break;
+            }
+            hal->wait();
+        }
+        hal->unlock();
+
+        if (NULL == hnd)
+            continue;
+
+        hal_task_hnd_get_info(hnd, &task_info);
 
-            hal_task_info_init(&pTask->info, MPP_CTX_DEC);
+        if (task_dec->valid) {
+            mpp_hal_hw_wait(dec->hal, &task_info);
+
+            mpp_buf_slot_clr_flag(packet_slots, task_dec->input,  SLOT_HAL_INPUT);
+            mpp_buf_slot_clr_flag(frame_slots, task_dec->output, SLOT_HAL_OUTPUT);
         }
+
+        /*
+         * release the hal task to parser thread before output
+         */
+        hal_task_hnd_set_status(hnd, TASK_IDLE);
+        hnd = NULL;
+
+        thd_dec->lock();
+        thd_dec->signal();
+        thd_dec->unlock();
+
+        mpp_dec_put_task_output(mpp, task_dec);
     }
 
     // clear remain task in output port
-    dec_release_task_in_port(input);
+    dec_release_task_in_port(mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT));
     dec_release_task_in_port(mpp->mOutputPort);
 
     return NULL;
 }
 
+/*
+ * reference user packet data without copy for synchronous decode
+ */
+static MppPacket dec_packet_ref(MppPacket src)
+{
+    MppPacket packet = NULL;
+
+    if (mpp_packet_init(&packet, mpp_packet_get_data(src), mpp_packet_get_size(src)))
+        return NULL;
+
+    mpp_packet_set_pos(packet, mpp_packet_get_pos(src));
+    mpp_packet_set_length(packet, mpp_packet_get_length(src));
+    mpp_packet_set_pts(packet, mpp_packet_get_pts(src));
+    mpp_packet_set_dts(packet, mpp_packet_get_dts(src));
+    mpp_packet_set_flag(packet, mpp_packet_get_flag(src) & (~MPP_PACKET_FLAG_INTERNAL));
+    mpp_packet_set_buffer(packet, mpp_packet_get_buffer(src));
+
+    return packet;
+}
+
+static MPP_RET dec_decode_normal(Mpp *mpp, MppPacket packet)
+{
+    MppDec *dec = mpp->mDec;
+    MppPacket pkt = NULL;
+    RK_S32 work = 0;
+
+    {
+        AutoMutex autoLock(mpp->mPackets->mutex());
+
+        if (NULL == dec->mpp_pkt_in && 0 == mpp->mPackets->list_size()) {
+            pkt = dec_packet_ref(packet);
+            if (NULL == pkt)
+                return MPP_ERR_MALLOC;
+
+            dec->mpp_pkt_in = pkt;
+        } else {
+            /* previous stream is still waiting for user, queue after it */
+            MppPacket copy = NULL;
+
+            if (mpp_packet_copy_init(&copy, packet))
+                return MPP_ERR_MALLOC;
+
+            mpp->mPackets->add_at_tail(&copy, sizeof(copy));
+        }
+        mpp->mPacketPutCount++;
+    }
+    mpp_packet_set_length(packet, 0);
+
+    /*
+     * run hal step first so that the parser always finds the previous task
+     * done. Stop when both of them have to wait for next input or for the
+     * buffer held by user.
+     */
+    do {
+        work  = mpp_dec_hal_step(mpp);
+        work |= mpp_dec_parser_step(mpp);
+    } while (work);
+
+    /* user packet is not consumed, keep the remaining stream by copy */
+    if (pkt && dec->mpp_pkt_in == pkt) {
+        MppPacket copy = NULL;
+        size_t offset = (char *)mpp_packet_get_pos(pkt) - (char *)mpp_packet_get_data(pkt);
+
+        if (mpp_packet_copy_init(&copy, pkt)) {
+            mpp_err_f("failed to keep stream of blocked packet\n");
+        } else {
+            mpp_packet_set_pos(copy, (char *)mpp_packet_get_data(copy) + offset);
+            mpp_packet_set_length(copy, mpp_packet_get_length(pkt));
+        }
+
+        mpp_packet_deinit(&pkt);
+        dec->mpp_pkt_in = copy;
+    }
+
+    return MPP_OK;
+}
+
+/*
+ * decode one image from packet. parser consumes the image from packet and
+ * keeps the remaining stream in packet for next image in split mode.
+ */
+static MPP_RET dec_decode_task_one(Mpp *mpp, MppPacket packet)
+{
+    MppDec *dec = mpp->mDec;
+    MppBufSlots frame_slots = dec->frame_slots;
+    MppBufSlots packet_slots = dec->packet_slots;
+    HalTaskInfo task_info;
+    HalDecTask *task_dec = &task_info.dec;
+    MppPacket stream = NULL;
+    MppBuffer output_buffer = NULL;
+    MppFrame frame = NULL;
+    MPP_RET ret = MPP_OK;
+    void *start = mpp_packet_get_pos(packet);
+    size_t length = mpp_packet_get_length(packet);
+    size_t consume = 0;
+
+    hal_task_info_init(&task_info, MPP_CTX_DEC);
+
+    parser_prepare(dec->parser, packet, task_dec);
+
+    /* set_pos in parser counts length from packet size, keep it by ourselves */
+    consume = (char *)mpp_packet_get_pos(packet) - (char *)start;
+    mpp_packet_set_length(packet, (consume < length) ? (length - consume) : (0));
+
+    if (!task_dec->valid) {
+        if (task_dec->flags.eos) {
+            mpp_frame_init(&frame);
+            mpp_frame_set_eos(frame, 1);
+        }
+        goto DEC_OUT;
+    }
+
+    if (task_dec->input < 0)
+        mpp_buf_slot_get_unused(packet_slots, &task_dec->input);
+
+    /*
+     * hardware reads the image from the start of stream buffer. Use the
+     * input buffer when the whole packet is the image, otherwise copy the
+     * image cut by parser to a new buffer.
+     */
+    if (mpp_packet_get_buffer(packet) && consume == length &&
+        start == mpp_buffer_get_ptr(mpp_packet_get_buffer(packet))) {
+        stream = packet;
+    } else {
+        MppPacket image = task_dec->input_packet;
+        size_t size = mpp_packet_get_length(image);
+        MppBuffer buffer = NULL;
+
+        if (NULL == mpp->mPacketGroup)
+            mpp_buffer_group_get_internal(&mpp->mPacketGroup, MPP_BUFFER_TYPE_ION);
+
+        mpp_buffer_get(mpp->mPacketGroup, &buffer, size);
+        if (NULL == buffer) {
+            mpp_err_f("failed to get stream buffer size %d\n", size);
+            ret = MPP_ERR_NOMEM;
+            goto DEC_OUT;
+        }
+
+        mpp_buffer_write(buffer, 0, mpp_packet_get_data(image), size);
+        mpp_packet_init_with_buffer(&stream, buffer);
+        mpp_packet_set_length(stream, size);
+        mpp_buffer_put(buffer);
+    }
+
+    mpp_buf_slot_set_prop(packet_slots, task_dec->input, SLOT_BUFFER, mpp_packet_get_buffer(stream));
+    mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_CODEC_READY);
+    mpp_buf_slot_set_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
+
+    ret = parser_parse(dec->parser, task_dec);
+    if (ret) {
+        mpp_err_f("something wrong with parser_parse!\n");
+        mpp_buf_slot_clr_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
+        mpp_frame_init(&frame);
+        mpp_frame_set_errinfo(frame, 1);
+        goto DEC_OUT;
+    }
+
+    /* output buffer always matches slot size, no info change to user */
+    if (mpp_buf_slot_is_changed(frame_slots))
+        mpp_buf_slot_ready(frame_slots);
+
+    if (NULL == mpp->mFrameGroup) {
+        mpp_log("mpp_dec use internal frame buffer group\n");
+        mpp_buffer_group_get_internal(&mpp->mFrameGroup, MPP_BUFFER_TYPE_ION);
+    }
+
+    mpp_buffer_get(mpp->mFrameGroup, &output_buffer, mpp_buf_slot_get_size(frame_slots));
+    if (NULL == output_buffer) {
+        mpp_err_f("failed to get frame buffer\n");
+        mpp_buf_slot_clr_flag(packet_slots, task_dec->input, SLOT_HAL_INPUT);
+        mpp_buf_slot_clr_flag(frame_slots, task_dec->output, SLOT_HAL_OUTPUT);
+        ret = MPP_ERR_NOMEM;
+        goto DEC_OUT;
+    }
+
+    mpp_buf_slot_set_prop(frame_slots, task_dec->output, SLOT_BUFFER, output_buffer);
+
+    mpp_hal_reg_gen(dec->hal, &task_info);
+    mpp_hal_hw_start(dec->hal, &task_info);
+    mpp_hal_hw_wait(dec->hal, &task_info);
+
+    /* output frame holds the extra reference from mpp_buffer_get */
+    mpp_buf_slot_get_prop(frame_slots, task_dec->output, SLOT_FRAME, &frame);
+
+    mpp_buf_slot_clr_flag(packet_slots, task_dec->input,  SLOT_HAL_INPUT);
+    mpp_buf_slot_clr_flag(frame_slots, task_dec->output, SLOT_HAL_OUTPUT);
+
+DEC_OUT:
+    if (stream && stream != packet)
+        mpp_packet_deinit(&stream);
+
+    if (frame)
+        mpp_put_frame(mpp, frame);
+
+    return ret;
+}
+
+/*
+ * in split mode one packet may carry several images, decode them all and
+ * the incomplete image at the end is kept by parser for next packet
+ */
+static MPP_RET dec_decode_task_mode(Mpp *mpp, MppPacket packet)
+{
+    MPP_RET ret = MPP_OK;
+
+    do {
+        size_t length = mpp_packet_get_length(packet);
+        MPP_RET err = dec_decode_task_one(mpp, packet);
+
+        /* broken image is returned as error frame, go on with next image */
+        if (err)
+            ret = err;
+
+        /* stop when parser can not consume any more stream */
+        if (mpp_packet_get_length(packet) == length)
+            break;
+    } while (mpp_packet_get_length(packet));
+
+    mpp_packet_set_length(packet, 0);
+
+    return ret;
+}
+
+MPP_RET mpp_dec_decode(void *data, MppPacket packet)
+{
+    Mpp *mpp = (Mpp*)data;
+
+    if (mpp->mDec->coding == MPP_VIDEO_CodingMJPEG)
+        return dec_decode_task_mode(mpp, packet);
+
+    return dec_decode_normal(mpp, packet);
+}
+
 MPP_RET mpp_dec_init(MppDec **dec, MppDecCfg *cfg)
 {
     MPP_RET ret;
@@ -982,7 +1440,15 @@ MPP_RET mpp_dec_init(MppDec **dec, MppDecCfg *cfg)
     }
 
     coding = cfg->coding;
-    hal_task_count = (cfg->fast_mode) ? (3) : (2);
+    /*
+     * task mode decoder runs one hal task per task in flight and keeps the
+     * original one by one behavior by default
+     */
+    if (coding == MPP_VIDEO_CodingMJPEG) {
+        hal_task_count = (cfg->task_count > 0) ? (cfg->task_count) : (1);
+        hal_task_count = MPP_MIN(hal_task_count, MPP_DEC_MAX_TASK_COUNT);
+    } else
+        hal_task_count = (cfg->fast_mode) ? (3) : (2);
 
     do {
         ret = mpp_buf_slot_init(&frame_slots);
@@ -1041,6 +1507,7 @@ MPP_RET mpp_dec_init(MppDec **dec, MppDecCfg *cfg)
         p->parser = parser;
         p->hal    = hal;
         p->tasks  = hal_cfg.tasks;
+        p->task_count = hal_task_count;
         p->frame_slots  = frame_slots;
         p->packet_slots = packet_slots;
 
@@ -1048,6 +1515,21 @@ MPP_RET mpp_dec_init(MppDec **dec, MppDecCfg *cfg)
         p->parser_need_split    = cfg->need_split;
         p->parser_fast_mode     = cfg->fast_mode;
         p->parser_internal_pts  = cfg->internal_pts;
+
+        if (cfg->isp_cfg) {
+            ret = mpp_isp_init(&p->isp);
+            if (ret) {
+                mpp_err_f("could not init isp\n");
+                break;
+            }
+
+            ret = mpp_isp_control(p->isp, MPP_ISP_SET_CFG, cfg->isp_cfg);
+            if (ret) {
+                mpp_err_f("invalid isp config\n");
+                break;
+            }
+        }
+
         *dec = p;
         return MPP_OK;
     } while (0);
@@ -1083,6 +1565,16 @@ MPP_RET mpp_dec_deinit(MppDec *dec)
         dec->packet_slots = NULL;
     }
 
+    if (dec->mpp_pkt_in) {
+        mpp_packet_deinit(&dec->mpp_pkt_in);
+        dec->mpp_pkt_in = NULL;
+    }
+
+    if (dec->isp) {
+        mpp_isp_deinit(dec->isp);
+        dec->isp = NULL;
+    }
+
     mpp_free(dec);
     return MPP_OK;
 }
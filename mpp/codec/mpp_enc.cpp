@@ -28,10 +28,9 @@
 #include "mpp_packet_impl.h"
 #include "hal_h264e_api.h"
 
-static void reset_hal_enc_task(HalEncTask *task)
-{
-    memset(task, 0, sizeof(*task));
-}
+#define MPP_ENC_DEFAULT_TASK_COUNT  2
+
+#define MPP_ENC_PACKET_MAX_COUNT    16
 
 static MPP_RET release_task_in_port(MppPort port)
 {
@@ -68,6 +67,141 @@ static MPP_RET release_task_in_port(MppPort port)
     return ret;
 }
 
+static void mpp_enc_put_output(Mpp *mpp, HalEncTask *enc_task)
+{
+    MppThread *thd_enc = mpp->mThreadCodec;
+    MppPort input  = mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT);
+    MppPort output = mpp_task_queue_get_port(mpp->mOutputTaskQueue, MPP_PORT_INPUT);
+    MppPacket packet = enc_task->packet;
+    MppTask mpp_task = NULL;
+
+    if (mpp_frame_get_eos(enc_task->frame))
+        mpp_packet_set_eos(packet);
+
+    /*
+     * first clear output packet
+     * then enqueue task back to input port
+     * final user will release the mpp_frame they had input
+     */
+    mpp_task_meta_set_frame(enc_task->mpp_task, KEY_INPUT_FRAME, enc_task->frame);
+    mpp_port_enqueue(input, enc_task->mpp_task);
+
+    // send finished task to output port, wait user to return output task
+    thd_enc->lock();
+    while (mpp_port_dequeue(output, &mpp_task) || NULL == mpp_task) {
+        if (MPP_THREAD_RUNNING != thd_enc->get_status())
+            break;
+        thd_enc->wait();
+    }
+    thd_enc->unlock();
+
+    if (NULL == mpp_task) {
+        mpp_packet_deinit(&packet);
+        return ;
+    }
+
+    mpp_task_meta_set_packet(mpp_task, KEY_OUTPUT_PACKET, packet);
+
+    {
+        RK_S32 is_intra = enc_task->is_intra;
+        RK_U32 flag = mpp_packet_get_flag(packet);
+
+        mpp_task_meta_set_s32(mpp_task, KEY_OUTPUT_INTRA, is_intra);
+        if (is_intra) {
+            mpp_packet_set_flag(packet, flag | MPP_PACKET_FLAG_INTRA);
+        }
+    }
+
+    // setup output task here
+    mpp_port_enqueue(output, mpp_task);
+}
+
+/*
+ * Output stream buffer size is the worst case size width * height so that
+ * large intra frame is never truncated by hardware.
+ */
+static size_t mpp_enc_get_packet_size(MppEncConfig *cfg)
+{
+    return MPP_ALIGN(cfg->width * cfg->height, SZ_4K);
+}
+
+/*
+ * Output stream buffers are kept in packet group and recycled when user
+ * releases the packet. Buffers for encoder and output port plus one for user
+ * are pre-allocated when the config changes so that there is no allocation
+ * in the loop. The group is not limited, when user holds more packets new
+ * buffer is allocated instead of blocking encoder, and undersized buffers
+ * left from previous config are released on miss.
+ */
+static void mpp_enc_setup_packet_pool(Mpp *mpp, size_t size)
+{
+    MppEnc *enc = mpp->mEnc;
+    MppBufferGroup group = mpp->mPacketGroup;
+    RK_S32 count = enc->task_count * 2 + 1;
+    MppBuffer buffers[MPP_ENC_PACKET_MAX_COUNT];
+    RK_S32 i;
+
+    count = MPP_MIN(count, MPP_ENC_PACKET_MAX_COUNT);
+
+    mpp_buffer_group_trim_config(group, MPP_BUFFER_TRIM_ON_MISS);
+
+    for (i = 0; i < count; i++) {
+        buffers[i] = NULL;
+        if (mpp_buffer_get(group, &buffers[i], size))
+            break;
+    }
+
+    mpp_dbg(MPP_DBG_BUFFER, "packet pool size %d count %d ready %d\n", (RK_S32)size, count, i);
+
+    while (i--)
+        mpp_buffer_put(buffers[i]);
+
+    enc->packet_size = size;
+}
+
+static MppPacket mpp_enc_get_packet(Mpp *mpp)
+{
+    MppEnc *enc = mpp->mEnc;
+    size_t size = mpp_enc_get_packet_size(&enc->mpp_cfg);
+    MppPacket packet = NULL;
+    MppBuffer buffer = NULL;
+
+    if (size != enc->packet_size)
+        mpp_enc_setup_packet_pool(mpp, size);
+
+    if (mpp_buffer_get(mpp->mPacketGroup, &buffer, size))
+        return NULL;
+
+    mpp_packet_init_with_buffer(&packet, buffer);
+    mpp_buffer_put(buffer);
+
+    return packet;
+}
+
+/*
+ * encode one frame into packet. Controller and hal keep one frame of stream,
+ * rate control and register state, so hardware is waited before return.
+ */
+static void mpp_enc_encode_frame(MppEnc *enc, HalTaskInfo *task_info,
+                                 MppFrame frame, MppPacket packet)
+{
+    HalEncTask *enc_task = &task_info->enc;
+    RK_U32 outputStreamSize = 0;
+
+    mpp_packet_set_pts(packet, mpp_frame_get_pts(frame));
+
+    enc_task->input  = mpp_frame_get_buffer(frame);
+    enc_task->output = mpp_packet_get_buffer(packet);
+    controller_encode(enc->controller, enc_task);
+
+    mpp_hal_reg_gen(enc->hal, task_info);
+    mpp_hal_hw_start(enc->hal, task_info);
+    mpp_hal_hw_wait(enc->hal, task_info);
+
+    controller_config(enc->controller, GET_OUTPUT_STREAM_SIZE, (void*)&outputStreamSize);
+    mpp_packet_set_length(packet, outputStreamSize);
+}
+
 void *mpp_enc_control_thread(void *data)
 {
     Mpp *mpp = (Mpp*)data;
@@ -76,106 +210,101 @@ void *mpp_enc_control_thread(void *data)
     HalTaskInfo task_info;
     HalEncTask *enc_task = &task_info.enc;
     MppPort input  = mpp_task_queue_get_port(mpp->mInputTaskQueue,  MPP_PORT_OUTPUT);
-    MppPort output = mpp_task_queue_get_port(mpp->mOutputTaskQueue, MPP_PORT_INPUT);
     MppTask mpp_task = NULL;
-    MPP_RET ret = MPP_OK;
+    RK_U32 ready = 0;
     MppFrame frame = NULL;
     MppPacket packet = NULL;
+    RK_U32 own_packet = 0;
     MppBuffer mv_info = NULL;
 
     memset(&task_info, 0, sizeof(HalTaskInfo));
 
     while (MPP_THREAD_RUNNING == thd_enc->get_status()) {
-        thd_enc->lock();
-        ret = mpp_port_dequeue(input, &mpp_task);
-        if (ret || NULL == mpp_task) {
-            thd_enc->wait();
-        }
-        thd_enc->unlock();
-
-        if (mpp_task != NULL) {
-            mpp_task_meta_get_frame (mpp_task, KEY_INPUT_FRAME,  &frame);
-            mpp_task_meta_get_packet(mpp_task, KEY_OUTPUT_PACKET, &packet);
-            mpp_task_meta_get_buffer(mpp_task, KEY_MOTION_INFO, &mv_info);
+        RK_U32 new_task = 0;
 
-            if (NULL == frame) {
-                mpp_port_enqueue(input, mpp_task);
-                continue;
-            }
+        /*
+         * output buffer is taken out of thread lock because packet group
+         * listener locks this thread with group lock held
+         */
+        if (mpp_task && frame && mpp_frame_get_buffer(frame) && NULL == packet) {
+            packet = mpp_enc_get_packet(mpp);
+            own_packet = (packet != NULL);
+        }
 
-            reset_hal_enc_task(enc_task);
-
-            if (mpp_frame_get_buffer(frame)) {
-                /*
-                 * if there is available buffer in the input frame do encoding
-                 */
-                if (NULL == packet) {
-                    RK_U32 width  = enc->mpp_cfg.width;
-                    RK_U32 height = enc->mpp_cfg.height;
-                    RK_U32 size = width * height;
-                    MppBuffer buffer = NULL;
-
-                    mpp_buffer_get(mpp->mPacketGroup, &buffer, size);
-                    mpp_log("create buffer size %d fd %d\n", size, mpp_buffer_get_fd(buffer));
-                    mpp_packet_init_with_buffer(&packet, buffer);
-                    mpp_buffer_put(buffer);
+        /*
+         * control thread need to wait at cases below:
+         * 1. no input task from user
+         * 2. failed to get output buffer, wait for user to release packet
+         */
+        thd_enc->lock();
+        if (MPP_THREAD_RUNNING == thd_enc->get_status()) {
+            if (NULL == mpp_task) {
+                mpp_port_dequeue(input, &mpp_task);
+                if (mpp_task) {
+                    mpp_task_meta_get_frame (mpp_task, KEY_INPUT_FRAME,  &frame);
+                    mpp_task_meta_get_packet(mpp_task, KEY_OUTPUT_PACKET, &packet);
+                    mpp_task_meta_get_buffer(mpp_task, KEY_MOTION_INFO, &mv_info);
+                    new_task = 1;
                 }
-                mpp_assert(packet);
+            }
 
-                mpp_packet_set_pts(packet, mpp_frame_get_pts(frame));
+            ready = mpp_task && (packet || NULL == frame || NULL == mpp_frame_get_buffer(frame));
 
-                enc_task->input  = mpp_frame_get_buffer(frame);
-                enc_task->output = mpp_packet_get_buffer(packet);
-                enc_task->mv_info = mv_info;
-                controller_encode(mpp->mEnc->controller, enc_task);
+            /* new input task goes back to get output buffer first */
+            if (!ready && !new_task)
+                thd_enc->wait();
+        }
+        thd_enc->unlock();
 
-                mpp_hal_reg_gen((mpp->mEnc->hal), &task_info);
-                mpp_hal_hw_start((mpp->mEnc->hal), &task_info);
-                mpp_hal_hw_wait((mpp->mEnc->hal), &task_info);
+        if (!ready)
+            continue;
 
-                RK_U32 outputStreamSize = 0;
-                controller_config(mpp->mEnc->controller, GET_OUTPUT_STREAM_SIZE, (void*)&outputStreamSize);
+        if (NULL == frame) {
+            mpp_port_enqueue(input, mpp_task);
+            mpp_task = NULL;
+            packet = NULL;
+            own_packet = 0;
+            continue;
+        }
 
-                mpp_packet_set_length(packet, outputStreamSize);
-            } else {
-                /*
-                 * else init a empty packet for output
-                 */
-                mpp_packet_new(&packet);
-            }
+        hal_task_info_init(&task_info, MPP_CTX_ENC);
 
-            if (mpp_frame_get_eos(frame))
-                mpp_packet_set_eos(packet);
+        if (mpp_frame_get_buffer(frame)) {
+            /*
+             * if there is available buffer in the input frame do encoding
+             */
+            mpp_assert(packet);
 
+            enc_task->mv_info = mv_info;
+            mpp_enc_encode_frame(enc, &task_info, frame, packet);
+        } else {
             /*
-             * first clear output packet
-             * then enqueue task back to input port
-             * final user will release the mpp_frame they had input
+             * else init a empty packet for output
              */
-            mpp_task_meta_set_frame(mpp_task, KEY_INPUT_FRAME, frame);
-            mpp_port_enqueue(input, mpp_task);
-            mpp_task = NULL;
+            mpp_packet_new(&packet);
+        }
 
-            // send finished task to output port
-            mpp_port_dequeue(output, &mpp_task);
-            mpp_task_meta_set_packet(mpp_task, KEY_OUTPUT_PACKET, packet);
+        enc_task->mpp_task = mpp_task;
+        enc_task->frame    = frame;
+        enc_task->packet   = packet;
 
-            {
-                RK_S32 is_intra = enc_task->is_intra;
-                RK_U32 flag = mpp_packet_get_flag(packet);
+        mpp_enc_put_output(mpp, enc_task);
 
-                mpp_task_meta_set_s32(mpp_task, KEY_OUTPUT_INTRA, is_intra);
-                if (is_intra) {
-                    mpp_packet_set_flag(packet, flag | MPP_PACKET_FLAG_INTRA);
-                }
-            }
+        mpp_task = NULL;
+        packet = NULL;
+        own_packet = 0;
+        frame = NULL;
+    }
 
-            // setup output task here
-            mpp_port_enqueue(output, mpp_task);
-            mpp_task = NULL;
-            packet = NULL;
-            frame = NULL;
-        }
+    /* return the input task which is waiting for output buffer */
+    if (mpp_task) {
+        if (own_packet)
+            mpp_packet_deinit(&packet);
+        else if (packet)
+            mpp_task_meta_set_packet(mpp_task, KEY_OUTPUT_PACKET, packet);
+
+        mpp_task_meta_set_frame(mpp_task, KEY_INPUT_FRAME, frame);
+        mpp_port_enqueue(input, mpp_task);
     }
 
     // clear remain task in output port
@@ -185,70 +314,41 @@ void *mpp_enc_control_thread(void *data)
     return NULL;
 }
 
-void *mpp_enc_hal_thread(void *data)
+MPP_RET mpp_enc_encode(void *data, MppFrame frame, MppPacket *packet)
 {
     Mpp *mpp = (Mpp*)data;
-    MppThread *hal      = mpp->mThreadHal;
-    mpp_list *frames    = mpp->mFrames;
-    mpp_list *tasks     = mpp->mTasks;
-
-    while (MPP_THREAD_RUNNING == hal->get_status()) {
-        /*
-         * hal thread wait for dxva interface intput firt
-         */
-        hal->lock();
-        if (0 == tasks->list_size())
-            hal->wait();
-        hal->unlock();
-
-        // get_config
-        // register genertation
-        if (tasks->list_size()) {
-            HalDecTask *task;
-            tasks->lock();
-            tasks->del_at_head(&task, sizeof(task));
-            mpp->mTaskGetCount++;
-            tasks->unlock();
-
-            // hal->mpp_hal_reg_gen(current);
+    MppEnc *enc = mpp->mEnc;
+    HalTaskInfo task_info;
+    HalEncTask *enc_task = &task_info.enc;
+    MppPacket pkt = NULL;
 
-            /*
-             * wait previous register set done
-             */
-            // hal->mpp_hal_hw_wait(previous);
+    *packet = NULL;
 
-            /*
-             * send current register set to hardware
-             */
-            // hal->mpp_hal_hw_start(current);
+    hal_task_info_init(&task_info, MPP_CTX_ENC);
 
-            /*
-             * mark previous buffer is complete
-             */
-            // change dpb slot status
-            // signal()
-            // mark frame in output queue
-            // wait up output thread to get a output frame
-
-            // for test
-            MppBuffer buffer;
-            mpp_buffer_get(mpp->mFrameGroup, &buffer, SZ_1M);
-
-            MppFrame frame;
-            mpp_frame_init(&frame);
-            mpp_frame_set_buffer(frame, buffer);
-            frames->lock();
-            frames->add_at_tail(&frame, sizeof(frame));
-            mpp->mFramePutCount++;
-            frames->signal();
-            frames->unlock();
+    if (mpp_frame_get_buffer(frame)) {
+        pkt = mpp_enc_get_packet(mpp);
+        if (NULL == pkt) {
+            mpp_err_f("failed to get stream buffer\n");
+            return MPP_ERR_MALLOC;
         }
+
+        mpp_enc_encode_frame(enc, &task_info, frame, pkt);
+
+        if (enc_task->is_intra)
+            mpp_packet_set_flag(pkt, mpp_packet_get_flag(pkt) | MPP_PACKET_FLAG_INTRA);
+    } else {
+        mpp_packet_new(&pkt);
     }
 
-    return NULL;
+    if (mpp_frame_get_eos(frame))
+        mpp_packet_set_eos(pkt);
+
+    *packet = pkt;
+    return MPP_OK;
 }
 
-MPP_RET mpp_enc_init(MppEnc **enc, MppCodingType coding)
+MPP_RET mpp_enc_init(MppEnc **enc, MppCodingType coding, RK_S32 task_count)
 {
     MPP_RET ret;
     MppBufSlots frame_slots = NULL;
@@ -256,7 +356,6 @@ MPP_RET mpp_enc_init(MppEnc **enc, MppCodingType coding)
     Controller controller = NULL;
     MppHal hal = NULL;
     MppEnc *p = NULL;
-    RK_S32 task_count = 2;
     IOInterruptCB cb = {NULL, NULL};
 
     if (NULL == enc) {
@@ -285,6 +384,9 @@ MPP_RET mpp_enc_init(MppEnc **enc, MppCodingType coding)
             break;
         }
 
+        if (task_count <= 0)
+            task_count = MPP_ENC_DEFAULT_TASK_COUNT;
+
         mpp_buf_slot_setup(packet_slots, task_count);
         cb.callBack = mpp_enc_notify;
         cb.opaque = p;
@@ -300,6 +402,13 @@ MPP_RET mpp_enc_init(MppEnc **enc, MppCodingType coding)
             mpp_err_f("could not init controller\n");
             break;
         }
+        /*
+         * controller may lower the hal task count when it can not encode
+         * next frame before the feedback of previous frame
+         */
+        if (controller_cfg.task_count <= 0 || controller_cfg.task_count > task_count)
+            controller_cfg.task_count = task_count;
+
         cb.callBack = hal_enc_callback;
         cb.opaque = controller;
         // then init hal with task count from controller
@@ -311,7 +420,7 @@ MPP_RET mpp_enc_init(MppEnc **enc, MppCodingType coding)
             frame_slots,
             packet_slots,
             NULL,
-            1/*controller_cfg.task_count*/,  // TODO
+            controller_cfg.task_count,
             0,
             cb,
         };
@@ -326,6 +435,7 @@ MPP_RET mpp_enc_init(MppEnc **enc, MppCodingType coding)
         p->controller   = controller;
         p->hal          = hal;
         p->tasks        = hal_cfg.tasks;
+        p->task_count   = task_count;
         p->frame_slots  = frame_slots;
         p->packet_slots = packet_slots;
         p->mpp_cfg.size = sizeof(p->mpp_cfg);
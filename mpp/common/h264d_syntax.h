@@ -413,6 +413,10 @@ typedef struct _DXVA_PicParams_H264_MVC {
     RK_U8   RefPicLayerIdList[16];
     RK_U8   scaleing_list_enable_flag;
     RK_U16  UsedForInTerviewflags;
+    //!< parameter set id and version for hal packet cache
+    RK_U16  seq_parameter_set_id;
+    RK_U16  pic_parameter_set_id;
+    RK_U32  spspps_version;
 
     ////!< for fpga test
     //USHORT seq_parameter_set_id;
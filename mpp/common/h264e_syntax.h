@@ -45,6 +45,10 @@ typedef struct h264e_syntax_t {
     RK_S32 cp_target[10];
     RK_S32 target_error[7];
     RK_S32 delta_qp[7];
+    RK_S32 bit_rate;        /* target bit rate, bits per second */
+    RK_S32 frame_rate;      /* output frame rate, frames per second */
+    RK_S32 gop;             /* intra frame interval */
+    RK_S32 target_bits;     /* frame target bits from frame rc, 0 - no frame rc */
 
 
     RK_U32 output_strm_limit_size;      // outputStrmSize
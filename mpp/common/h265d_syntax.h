@@ -161,6 +161,7 @@ typedef struct _DXVA_PicParams_HEVC {
     UINT32 pps_id;
     UINT32 sps_id;
     UCHAR scaling_list_data_present_flag;
+    UINT32 ps_version;      /* parameter set version for hal packet cache */
 } DXVA_PicParams_HEVC, *LPDXVA_PicParams_HEVC;
 
 /* HEVC Quantizatiuon Matrix structure */
@@ -63,7 +63,7 @@ MPP_RET hal_task_group_init(HalTaskGroup *group, MppCtxType type, RK_S32 count)
             mpp_err_f("malloc group failed\n");
             break;
         }
-        lock = new Mutex();
+        lock = new Mutex(MPP_MUTEX_ADAPTIVE);
         if (NULL == lock) {
             mpp_err_f("new lock failed\n");
             break;;
@@ -133,6 +133,16 @@ typedef struct HalDecTask_t {
 
     // current task reference slot index, -1 for unused
     RK_S32          refer[MAX_DEC_REF_NUM];
+
+    /*
+     * task mode resource carried from parser thread to hal thread
+     * mpp_task : task dequeued from input port, returned when hardware is done
+     * packet   : input packet to be returned with mpp_task
+     * frame    : output frame to be sent to output port
+     */
+    MppTask         mpp_task;
+    MppPacket       packet;
+    MppFrame        frame;
 } HalDecTask;
 
 typedef struct HalEncTask_t {
@@ -154,6 +164,15 @@ typedef struct HalEncTask_t {
 
     HalEncTaskFlag  flags;
 
+    /*
+     * mpp side resource carried from control thread to hal thread
+     * mpp_task : task dequeued from input port, returned when hardware is done
+     * frame    : input frame to be returned with mpp_task
+     * packet   : output packet to be sent to output port
+     */
+    MppTask         mpp_task;
+    MppFrame        frame;
+    MppPacket       packet;
 } HalEncTask;
 
 
@@ -145,6 +145,31 @@ static void rkv_write_pps_to_fifo(H264dHalCtx_t *p_hal, FifoCtx_t *pkt)
     FunctionOut(p_hal->logctx.parr[RUN_HAL]);
 }
 
+/*!
+***********************************************************************
+* \brief
+*    check packet key, return 1 when the parameter sets are unchanged
+***********************************************************************
+*/
+static RK_U32 rkv_check_pkt_key(H264dRkvPktKey_t *key, DXVA_PicParams_H264_MVC *pp, RK_U32 mbaff)
+{
+    if (key->valid
+        && key->version  == pp->spspps_version
+        && key->sps_id   == pp->seq_parameter_set_id
+        && key->pps_id   == pp->pic_parameter_set_id
+        && key->layer_id == pp->curr_layer_id
+        && key->mbaff    == mbaff) {
+        return 1;
+    }
+    key->valid    = 1;
+    key->version  = pp->spspps_version;
+    key->sps_id   = pp->seq_parameter_set_id;
+    key->pps_id   = pp->pic_parameter_set_id;
+    key->layer_id = pp->curr_layer_id;
+    key->mbaff    = mbaff;
+
+    return 0;
+}
 
 /*!
 ***********************************************************************
@@ -160,6 +185,8 @@ void rkv_reset_fifo_packet(H264dRkvPkt_t *pkt)
         fifo_packet_reset(&pkt->rps);
         fifo_packet_reset(&pkt->scanlist);
         fifo_packet_reset(&pkt->reg);
+        pkt->spspps_key.valid = 0;
+        pkt->scanlist_key.valid = 0;
     }
 }
 
@@ -177,6 +204,7 @@ void rkv_free_fifo_packet(H264dRkvPkt_t *pkt)
         MPP_FREE(pkt->rps.pbuf);
         MPP_FREE(pkt->scanlist.pbuf);
         MPP_FREE(pkt->reg.pbuf);
+        MPP_FREE(pkt->spspps_tbl);
     }
 }
 /*!
@@ -201,6 +229,12 @@ MPP_RET rkv_alloc_fifo_packet(H264dLogCtx_t *logctx, H264dRkvPkt_t *pkts)
     FUN_CHECK(ret = fifo_packet_alloc(&pkts->rps,      H264dRPS_HEADER, rps_size));
     FUN_CHECK(ret = fifo_packet_alloc(&pkts->scanlist, H264dSCL_HEADER, sclst_size));
     FUN_CHECK(ret = fifo_packet_alloc(&pkts->reg,      H264dREG_HEADER, regs_size));
+    pkts->spspps_tbl = mpp_calloc(RK_U8, RKV_SPSPPS_SIZE);
+    MEM_CHECK(ret, pkts->spspps_tbl);
+    pkts->spspps_key.valid = 0;
+    pkts->scanlist_key.valid = 0;
+    pkts->spspps_update = 1;
+    pkts->scanlist_update = 0;
 
     //!< set logctx
     pkts->spspps.logctx   = logctx->parr[LOG_WRITE_SPSPPS];
@@ -241,12 +275,24 @@ void rkv_prepare_spspps_packet(void *hal, FifoCtx_t *pkt)
     RK_S32 i = 0;
     RK_S32 is_long_term = 0, voidx = 0;
     H264dHalCtx_t *p_hal = (H264dHalCtx_t *)hal;
+    H264dRkvPkt_t *pkts = (H264dRkvPkt_t *)p_hal->pkts;
 
     FunctionIn(p_hal->logctx.parr[RUN_HAL]);
-    fifo_packet_reset(pkt);
-    LogInfo(pkt->logctx, "------------------ Frame SPS_PPS begin ------------------------");
-    rkv_write_sps_to_fifo(p_hal, pkt);
-    rkv_write_pps_to_fifo(p_hal, pkt);
+    if (rkv_check_pkt_key(&pkts->spspps_key, p_hal->pp, p_hal->pp->MbaffFrameFlag)) {
+        //!< sps and pps unchanged, restart after the packed pps
+        pkt->index  = pkts->spspps_index;
+        pkt->bitpos = pkts->spspps_bitpos;
+        pkt->bvalue = pkts->spspps_bvalue;
+        pkt->pbuf[pkt->index] = pkt->bvalue;
+    } else {
+        fifo_packet_reset(pkt);
+        LogInfo(pkt->logctx, "------------------ Frame SPS_PPS begin ------------------------");
+        rkv_write_sps_to_fifo(p_hal, pkt);
+        rkv_write_pps_to_fifo(p_hal, pkt);
+        pkts->spspps_index  = pkt->index;
+        pkts->spspps_bitpos = pkt->bitpos;
+        pkts->spspps_bvalue = pkt->bvalue;
+    }
 
     for (i = 0; i < 16; i++) {
         is_long_term = (p_hal->pp->RefFrameList[i].bPicEntry != 0xff) ? p_hal->pp->RefFrameList[i].AssociatedFlag : 0;
@@ -258,6 +304,13 @@ void rkv_prepare_spspps_packet(void *hal, FifoCtx_t *pkt)
     }
     fifo_align_bits(pkt, 64);
     fifo_fwrite_data(pkt);  //!< "PPSH" header 32 bit
+    //!< all 256 table entries carry the same packet
+    if (memcmp(pkts->spspps_tbl, pkt->pbuf, RKV_SPSPPS_ENTRY_SIZE)) {
+        for (i = 0; i < 256; i++) {
+            memcpy(pkts->spspps_tbl + RKV_SPSPPS_ENTRY_SIZE * i, pkt->pbuf, RKV_SPSPPS_ENTRY_SIZE);
+        }
+        pkts->spspps_update = 1;
+    }
     FunctionOut(p_hal->logctx.parr[RUN_HAL]);
 }
 /*!
@@ -336,8 +389,11 @@ void rkv_prepare_scanlist_packet(void *hal, FifoCtx_t *pkt)
 {
     RK_S32 i = 0;
     H264dHalCtx_t *p_hal = (H264dHalCtx_t *)hal;
+    H264dRkvPkt_t *pkts = (H264dRkvPkt_t *)p_hal->pkts;
+
     FunctionIn(p_hal->logctx.parr[RUN_HAL]);
-    if (p_hal->pp->scaleing_list_enable_flag) {
+    if (p_hal->pp->scaleing_list_enable_flag
+        && !rkv_check_pkt_key(&pkts->scanlist_key, p_hal->pp, 0)) {
         fifo_packet_reset(pkt);
         LogInfo(pkt->logctx, "------------------ Scanlist begin ------------------------");
         for (i = 0; i < 6; ++i) { //!< 4x4, 6 lists
@@ -347,6 +403,7 @@ void rkv_prepare_scanlist_packet(void *hal, FifoCtx_t *pkt)
             fifo_write_bytes(pkt, p_hal->qm->bScalingLists8x8[i], H264ScalingList8x8Length);
         }
         fifo_fwrite_data(pkt); //!< "SCLS" header 32 bit
+        pkts->scanlist_update = 1;
     }
     FunctionOut(p_hal->logctx.parr[RUN_HAL]);
 }
@@ -31,11 +31,34 @@
 #define RKV_RPS_SIZE              (128 + 128)         /* bytes */
 #define RKV_SCALING_LIST_SIZE     (6*16+2*64 + 128)   /* bytes */
 #define RKV_ERROR_INFO_SIZE       (256*144*4)         /* bytes */
+#define RKV_SPSPPS_ENTRY_SIZE     (32)                /* bytes */
+
+//!< parameter sets a packed packet is built from
+typedef struct h264d_rkv_pkt_key_t {
+    RK_U32      valid;
+    RK_U32      version;
+    RK_U16      sps_id;
+    RK_U16      pps_id;
+    RK_U16      layer_id;
+    RK_U16      mbaff;
+} H264dRkvPktKey_t;
+
 typedef struct h264d_rkv_packet_t {
     FifoCtx_t   spspps;
     FifoCtx_t   rps;
     FifoCtx_t   scanlist;
     FifoCtx_t   reg;
+    //!< sps and pps part of spspps packet is reused until the key changes
+    H264dRkvPktKey_t spspps_key;
+    RK_U32      spspps_index;
+    RK_U32      spspps_bitpos;
+    RK_U64      spspps_bvalue;
+    //!< pps table of 256 entries in cabac buffer, rewritten on entry change
+    RK_U8      *spspps_tbl;
+    RK_U32      spspps_update;
+    //!< scanlist packet is reused until the key changes
+    H264dRkvPktKey_t scanlist_key;
+    RK_U32      scanlist_update;
 } H264dRkvPkt_t;
 
 
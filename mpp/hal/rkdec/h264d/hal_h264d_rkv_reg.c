@@ -319,7 +319,6 @@ __FAILED:
 //extern "C"
 MPP_RET rkv_h264d_gen_regs(void *hal, HalTaskInfo *task)
 {
-    RK_U32 i = 0;
     RK_U32 hw_base = 0;
     RK_U32 strm_offset = 0;
     MPP_RET ret = MPP_ERR_UNKNOW;
@@ -340,8 +339,9 @@ MPP_RET rkv_h264d_gen_regs(void *hal, HalTaskInfo *task)
     hw_base = mpp_buffer_get_fd(p_hal->cabac_buf);
     //!< copy datas
     strm_offset = RKV_CABAC_TAB_SIZE;
-    for (i = 0; i < 256; i++)   {
-        mpp_buffer_write(p_hal->cabac_buf, (strm_offset + 32 * i), (void *)pkts->spspps.pbuf, RKV_SPSPPS_SIZE);
+    if (pkts->spspps_update) {
+        mpp_buffer_write(p_hal->cabac_buf, strm_offset, (void *)pkts->spspps_tbl, RKV_SPSPPS_SIZE);
+        pkts->spspps_update = 0;
     }
     p_regs->swreg42_pps_base.sw_pps_base = hw_base + (strm_offset << 10);
     strm_offset += RKV_SPSPPS_SIZE;
@@ -350,7 +350,10 @@ MPP_RET rkv_h264d_gen_regs(void *hal, HalTaskInfo *task)
     p_regs->swreg43_rps_base.sw_rps_base = hw_base + (strm_offset << 10);
 
     strm_offset += RKV_RPS_SIZE;
-    mpp_buffer_write(p_hal->cabac_buf, strm_offset, (void *)pkts->scanlist.pbuf, RKV_SCALING_LIST_SIZE);
+    if (pkts->scanlist_update) {
+        mpp_buffer_write(p_hal->cabac_buf, strm_offset, (void *)pkts->scanlist.pbuf, RKV_SCALING_LIST_SIZE);
+        pkts->scanlist_update = 0;
+    }
 
     strm_offset += RKV_SCALING_LIST_SIZE;
     p_regs->swreg75_h264_errorinfo_base.sw_errorinfo_base = hw_base + (strm_offset << 10);
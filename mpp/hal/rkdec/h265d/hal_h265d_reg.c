@@ -50,12 +50,21 @@ FILE *fp = NULL;
 
 #define MAX_GEN_REG 3
 RK_U32 h265h_debug = 0;
+/* parameter sets the pps and scaling list packet in a buffer are built from */
+typedef struct h265d_pps_key {
+    RK_U32    valid;
+    RK_U32    version;
+    RK_U32    vps_id;
+    RK_U32    sps_id;
+    RK_U32    pps_id;
+} h265d_pps_key_t;
 typedef struct h265d_reg_buf {
     RK_S32    use_flag;
     MppBuffer scaling_list_data;
     MppBuffer pps_data;
     MppBuffer rps_data;
     void*     hw_regs;
+    h265d_pps_key_t pps_key;
 } h265d_reg_buf_t;
 typedef struct h265d_reg_context {
     RK_S32 vpu_socket;
@@ -73,6 +82,8 @@ typedef struct h265d_reg_context {
     RK_U32 fast_mode_err_found;
     void *scaling_rk;
     void *scaling_qm;
+    h265d_pps_key_t pps_key;
+    h265d_pps_key_t *cur_pps_key;
 } h265d_reg_context_t;
 
 typedef struct ScalingList {
@@ -303,6 +314,7 @@ MPP_RET hal_h265d_alloc_res(void *hal)
                 mpp_err("h265d rps_data get buffer failed\n");
                 return ret;
             }
+            reg_cxt->g_buf[i].pps_key.valid = 0;
         }
     } else {
         reg_cxt->hw_regs = mpp_calloc_size(void, sizeof(H265d_REGS_t));
@@ -323,7 +335,8 @@ MPP_RET hal_h265d_alloc_res(void *hal)
             mpp_err("h265d rps_data get buffer failed\n");
             return ret;
         }
-
+        reg_cxt->pps_key.valid = 0;
+        reg_cxt->cur_pps_key = &reg_cxt->pps_key;
     }
     return MPP_OK;
 }
@@ -1093,19 +1106,28 @@ RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
     RK_S32 fifo_len = 10;
     RK_S32 i, j;
     RK_U32 addr;
-    RK_U64 *pps_packet = NULL;
+    RK_U64 pps_packet[10 + 1];
     RK_U32 log2_min_cb_size;
     RK_S32 width, height;
     h265d_reg_context_t *reg_cxt = ( h265d_reg_context_t *)hal;
     h265d_dxva2_picture_context_t *dxva_cxt = (h265d_dxva2_picture_context_t*)dxva;
+    h265d_pps_key_t *key = NULL;
     BitputCtx_t bp;
-    pps_packet = mpp_calloc(RK_U64, fifo_len + 1);
 
     if (NULL == reg_cxt || dxva_cxt == NULL) {
 
         mpp_err("%s:%s:%d reg_cxt or dxva_cxt is NULL", __FILE__, __FUNCTION__, __LINE__);
         return MPP_ERR_NULL_PTR;
     }
+
+    /* packets in current buffer are kept until the parameter sets change */
+    key = reg_cxt->cur_pps_key;
+    if (key->valid && key->version == dxva_cxt->pp.ps_version &&
+        key->vps_id == dxva_cxt->pp.vps_id &&
+        key->sps_id == dxva_cxt->pp.sps_id &&
+        key->pps_id == dxva_cxt->pp.pps_id) {
+        return 0;
+    }
 #ifdef RKPLATFORM
     void *pps_ptr = mpp_buffer_get_ptr(reg_cxt->pps_data);
     if (NULL == pps_ptr) {
@@ -1118,7 +1140,7 @@ RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
 #endif
 
 
-    for (i = 0; i < 10; i++) pps_packet[i] = 0;
+    memset(pps_packet, 0, sizeof(pps_packet));
 
     mpp_set_bitput_ctx(&bp, pps_packet, fifo_len);
 
@@ -1314,9 +1336,11 @@ RK_S32 hal_h265d_output_pps_packet(void *hal, void *dxva)
     fflush(fp);
 #endif
 #endif
-    if (pps_packet != NULL) {
-        mpp_free(pps_packet);
-    }
+    key->valid = 1;
+    key->version = dxva_cxt->pp.ps_version;
+    key->vps_id = dxva_cxt->pp.vps_id;
+    key->sps_id = dxva_cxt->pp.sps_id;
+    key->pps_id = dxva_cxt->pp.pps_id;
     return 0;
 }
 
@@ -1350,6 +1374,7 @@ MPP_RET hal_h265d_gen_regs(void *hal,  HalTaskInfo *syn)
                 reg_cxt->scaling_list_data = reg_cxt->g_buf[i].scaling_list_data;
                 reg_cxt->pps_data = reg_cxt->g_buf[i].pps_data;
                 reg_cxt->hw_regs = reg_cxt->g_buf[i].hw_regs;
+                reg_cxt->cur_pps_key = &reg_cxt->g_buf[i].pps_key;
                 reg_cxt->g_buf[i].use_flag = 1;
                 break;
             }
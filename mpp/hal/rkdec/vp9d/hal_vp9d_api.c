@@ -246,17 +246,65 @@ MPP_RET hal_vp9d_deinit(void *hal)
     return ret = MPP_OK;
 }
 
+/*
+ * probability packet writer
+ * Every probability is one byte and the packet only has byte fields and
+ * 128 bit alignments, so it is written with bulk copies straight into the
+ * probe buffer which is cleared before packing.
+ */
+typedef struct vp9_prob_writer {
+    RK_U8  *buf;
+    RK_U32 pos;
+    RK_U32 size;
+} vp9_prob_writer_t;
+
+static void vp9_prob_put(vp9_prob_writer_t *w, const void *src, RK_U32 len)
+{
+    len = MPP_MIN(len, w->size - w->pos);
+    memcpy(w->buf + w->pos, src, len);
+    w->pos += len;
+}
+
+static void vp9_prob_skip(vp9_prob_writer_t *w, RK_U32 len)
+{
+    w->pos = MPP_MIN(w->pos + len, w->size);
+}
+
+static void vp9_prob_align(vp9_prob_writer_t *w)
+{
+    w->pos = MPP_MIN(MPP_ALIGN(w->pos, 16), w->size);
+}
+
+/* 27 byte groups, each group is aligned to 128 bit */
+static void vp9_prob_put_group(vp9_prob_writer_t *w, const RK_U8 *src, RK_U32 len)
+{
+    while (len >= 27) {
+        vp9_prob_put(w, src, 27);
+        vp9_prob_align(w);
+        src += 27;
+        len -= 27;
+    }
+    vp9_prob_put(w, src, len);
+}
+
+/* UNCONSTRAINED_NODES probs of COEF_BANDS x COEFF_CONTEXTS with stride 11 */
+static void vp9_prob_put_coef(vp9_prob_writer_t *w, const RK_U8 *coef)
+{
+    RK_S32 i, j;
+
+    for (i = 0; i < COEF_BANDS * COEFF_CONTEXTS / 9; i++) {
+        for (j = 0; j < 9; j++, coef += 11)
+            vp9_prob_put(w, coef, UNCONSTRAINED_NODES);
+        vp9_prob_align(w);
+    }
+}
+
 MPP_RET hal_vp9d_output_probe(void *hal, void *dxva)
 {
-    RK_S32 i, j, k, m, n;
-    RK_S32 fifo_len = 304;
-    RK_U64 *probe_packet = NULL;
-    BitputCtx_t bp;
+    RK_S32 i, j;
+    vp9_prob_writer_t w;
     DXVA_PicParams_VP9 *pic_param = (DXVA_PicParams_VP9*)dxva;
     RK_S32 intraFlag = (!pic_param->frame_type || pic_param->intra_only);
-    vp9_prob partition_probs[PARTITION_CONTEXTS][PARTITION_TYPES - 1];
-    vp9_prob uv_mode_prob[INTRA_MODES][INTRA_MODES - 1];
-#ifdef RKPLATFORM
     hal_vp9_context_t *reg_cxt = (hal_vp9_context_t*)hal;
     void *probe_ptr = mpp_buffer_get_ptr(reg_cxt->probe_base);
     if (NULL == probe_ptr) {
@@ -265,239 +313,113 @@ MPP_RET hal_vp9d_output_probe(void *hal, void *dxva)
         return MPP_ERR_NOMEM;
     }
     memset(probe_ptr, 0, 304 * 8);
-#else
-    (void)hal;
-#endif
 
-    if (intraFlag) {
-        memcpy(partition_probs, vp9_kf_partition_probs, sizeof(partition_probs));
-        memcpy(uv_mode_prob, vp9_kf_uv_mode_prob, sizeof(uv_mode_prob));
-    } else {
-        memcpy(partition_probs, pic_param->prob.partition, sizeof(partition_probs));
-        memcpy(uv_mode_prob, pic_param->prob.uv_mode, sizeof(uv_mode_prob));
-    }
+    w.buf = (RK_U8 *)probe_ptr;
+    w.pos = 0;
+    w.size = 304 * 8;
 
-    probe_packet = mpp_calloc(RK_U64, fifo_len + 1);
-    mpp_set_bitput_ctx(&bp, probe_packet, fifo_len);
     //sb info  5 x 128 bit
-    for (i = 0; i < PARTITION_CONTEXTS; i++) //kf_partition_prob
-        for (j = 0; j < PARTITION_TYPES - 1; j++)
-            mpp_put_bits(&bp, partition_probs[i][j], 8); //48
-
-    for (i = 0; i < PREDICTION_PROBS; i++) //Segment_id_pred_prob //3
-        mpp_put_bits(&bp, pic_param->stVP9Segments.pred_probs[i], 8);
-
-    for (i = 0; i < SEG_TREE_PROBS; i++) //Segment_id_probs
-        mpp_put_bits(&bp, pic_param->stVP9Segments.tree_probs[i], 8); //7
-
-    for (i = 0; i < SKIP_CONTEXTS; i++) //Skip_flag_probs //3
-        mpp_put_bits(&bp, pic_param->prob.skip[i], 8);
-
-    for (i = 0; i < TX_SIZE_CONTEXTS; i++) //Tx_size_probs //6
-        for (j = 0; j < TX_SIZES - 1; j++)
-            mpp_put_bits(&bp, pic_param->prob.tx32p[i][j], 8);
-
-    for (i = 0; i < TX_SIZE_CONTEXTS; i++) //Tx_size_probs //4
-        for (j = 0; j < TX_SIZES - 2; j++)
-            mpp_put_bits(&bp, pic_param->prob.tx16p[i][j], 8);
-
-    for (i = 0; i < TX_SIZE_CONTEXTS; i++) //Tx_size_probs //2
-        mpp_put_bits(&bp, pic_param->prob.tx8p[i], 8);
-
-    for (i = 0; i < INTRA_INTER_CONTEXTS; i++) //Tx_size_probs //4
-        mpp_put_bits(&bp, pic_param->prob.intra[i], 8);
+    if (intraFlag) //kf_partition_prob
+        vp9_prob_put(&w, vp9_kf_partition_probs, PARTITION_CONTEXTS * (PARTITION_TYPES - 1));
+    else
+        vp9_prob_put(&w, pic_param->prob.partition, PARTITION_CONTEXTS * (PARTITION_TYPES - 1));
+
+    vp9_prob_put(&w, pic_param->stVP9Segments.pred_probs, PREDICTION_PROBS); //Segment_id_pred_prob
+    vp9_prob_put(&w, pic_param->stVP9Segments.tree_probs, SEG_TREE_PROBS); //Segment_id_probs
+    vp9_prob_put(&w, pic_param->prob.skip, SKIP_CONTEXTS); //Skip_flag_probs
+    vp9_prob_put(&w, pic_param->prob.tx32p, TX_SIZE_CONTEXTS * (TX_SIZES - 1)); //Tx_size_probs
+    vp9_prob_put(&w, pic_param->prob.tx16p, TX_SIZE_CONTEXTS * (TX_SIZES - 2));
+    vp9_prob_put(&w, pic_param->prob.tx8p, TX_SIZE_CONTEXTS);
+    vp9_prob_put(&w, pic_param->prob.intra, INTRA_INTER_CONTEXTS);
+    vp9_prob_align(&w);
 
-    mpp_put_align(&bp, 128, 0);
     if (intraFlag) { //intra probs
         //intra only //149 x 128 bit ,aligned to 152 x 128 bit
         //coeff releated prob   64 x 128 bit
         for (i = 0; i < TX_SIZES; i++)
-            for (j = 0; j < PLANE_TYPES; j++) {
-                RK_S32 byte_count = 0;
-                for (k = 0; k < COEF_BANDS; k++) {
-                    for (m = 0; m < COEFF_CONTEXTS; m++)
-                        for (n = 0; n < UNCONSTRAINED_NODES; n++) {
-                            mpp_put_bits(&bp, pic_param->prob.coef[i][j][0][k][m][n], 8);
-
-                            byte_count++;
-                            if (byte_count == 27) {
-                                mpp_put_align(&bp, 128, 0);
-                                byte_count = 0;
-                            }
-                        }
-                }
-                mpp_put_align(&bp, 128, 0);
-            }
+            for (j = 0; j < PLANE_TYPES; j++)
+                vp9_prob_put_coef(&w, pic_param->prob.coef[i][j][0][0][0]);
 
         //intra mode prob  80 x 128 bit
         for (i = 0; i < INTRA_MODES; i++) { //vp9_kf_y_mode_prob
-            RK_S32 byte_count = 0;
-            for (j = 0; j < INTRA_MODES; j++)
-                for (k = 0; k < INTRA_MODES - 1; k++) {
-                    mpp_put_bits(&bp, vp9_kf_y_mode_prob[i][j][k], 8);
-                    byte_count++;
-                    if (byte_count == 27) {
-                        byte_count = 0;
-                        mpp_put_align(&bp, 128, 0);
-                    }
-
-                }
+            vp9_prob_put_group(&w, vp9_kf_y_mode_prob[i][0], INTRA_MODES * (INTRA_MODES - 1));
             if (i < 4) {
-                for (m = 0; m < (i < 3 ? 23 : 21); m++)
-                    mpp_put_bits(&bp, ((vp9_prob *)(&vp9_kf_uv_mode_prob[0][0]))[i * 23 + m], 8);
-                for (; m < 23; m++)
-                    mpp_put_bits(&bp, 0, 8);
+                RK_U32 len = (i < 3 ? 23 : 21);
+
+                vp9_prob_put(&w, ((vp9_prob *)(&vp9_kf_uv_mode_prob[0][0])) + i * 23, len);
+                vp9_prob_skip(&w, 23 - len);
             } else {
-                for (m = 0; m < 23; m++)
-                    mpp_put_bits(&bp, 0, 8);
+                vp9_prob_skip(&w, 23);
             }
-            mpp_put_align(&bp, 128, 0);
+            vp9_prob_align(&w);
         }
         //align to 152 x 128 bit
         for (i = 0; i < INTER_PROB_SIZE_ALIGN_TO_128 - INTRA_PROB_SIZE_ALIGN_TO_128; i++) { //aligned to 153 x 256 bit
-            mpp_put_bits(&bp, 0, 8);
-            mpp_put_align(&bp, 128, 0);
+            vp9_prob_skip(&w, 1);
+            vp9_prob_align(&w);
         }
     } else {
         //inter probs
         //151 x 128 bit ,aligned to 152 x 128 bit
         //inter only
+        const vp9_prob *uv_mode_prob = &pic_param->prob.uv_mode[0][0];
 
         //intra_y_mode & inter_block info   6 x 128 bit
-        for (i = 0; i < BLOCK_SIZE_GROUPS; i++) //intra_y_mode
-            for (j = 0; j < INTRA_MODES - 1; j++)
-                mpp_put_bits(&bp, pic_param->prob.y_mode[i][j], 8);
-
-        for (i = 0; i < COMP_INTER_CONTEXTS; i++) //reference_mode prob
-            mpp_put_bits(&bp, pic_param->prob.comp[i], 8);
-
-        for (i = 0; i < REF_CONTEXTS; i++) //comp ref bit
-            mpp_put_bits(&bp, pic_param->prob.comp_ref[i], 8);
-
-        for (i = 0; i < REF_CONTEXTS; i++) //single ref bit
-            for (j = 0; j < 2; j++)
-                mpp_put_bits(&bp, pic_param->prob.single_ref[i][j], 8);
-
-        for (i = 0; i < INTER_MODE_CONTEXTS; i++) //mv mode bit
-            for (j = 0; j < INTER_MODES - 1; j++)
-                mpp_put_bits(&bp, pic_param->prob.mv_mode[i][j], 8);
-
-
-        for (i = 0; i < SWITCHABLE_FILTER_CONTEXTS; i++) //comp ref bit
-            for (j = 0; j < SWITCHABLE_FILTERS - 1; j++)
-                mpp_put_bits(&bp, pic_param->prob.filter[i][j], 8);
-
-        mpp_put_align(&bp, 128, 0);
+        vp9_prob_put(&w, pic_param->prob.y_mode, BLOCK_SIZE_GROUPS * (INTRA_MODES - 1)); //intra_y_mode
+        vp9_prob_put(&w, pic_param->prob.comp, COMP_INTER_CONTEXTS); //reference_mode prob
+        vp9_prob_put(&w, pic_param->prob.comp_ref, REF_CONTEXTS); //comp ref bit
+        vp9_prob_put(&w, pic_param->prob.single_ref, REF_CONTEXTS * 2); //single ref bit
+        vp9_prob_put(&w, pic_param->prob.mv_mode, INTER_MODE_CONTEXTS * (INTER_MODES - 1)); //mv mode bit
+        vp9_prob_put(&w, pic_param->prob.filter, SWITCHABLE_FILTER_CONTEXTS * (SWITCHABLE_FILTERS - 1));
+        vp9_prob_align(&w);
 
         //128 x 128bit
         //coeff releated
         for (i = 0; i < TX_SIZES; i++)
-            for (j = 0; j < PLANE_TYPES; j++) {
-                RK_S32 byte_count = 0;
-                for (k = 0; k < COEF_BANDS; k++) {
-                    for (m = 0; m < COEFF_CONTEXTS; m++)
-                        for (n = 0; n < UNCONSTRAINED_NODES; n++) {
-                            mpp_put_bits(&bp, pic_param->prob.coef[i][j][0][k][m][n], 8);
-                            byte_count++;
-                            if (byte_count == 27) {
-                                mpp_put_align(&bp, 128, 0);
-                                byte_count = 0;
-                            }
-                        }
-                }
-                mpp_put_align(&bp, 128, 0);
-            }
+            for (j = 0; j < PLANE_TYPES; j++)
+                vp9_prob_put_coef(&w, pic_param->prob.coef[i][j][0][0][0]);
         for (i = 0; i < TX_SIZES; i++)
-            for (j = 0; j < PLANE_TYPES; j++) {
-                RK_S32 byte_count = 0;
-                for (k = 0; k < COEF_BANDS; k++) {
-                    for (m = 0; m < COEFF_CONTEXTS; m++) {
-                        for (n = 0; n < UNCONSTRAINED_NODES; n++) {
-                            mpp_put_bits(&bp, pic_param->prob.coef[i][j][1][k][m][n], 8);
-                            byte_count++;
-                            if (byte_count == 27) {
-                                mpp_put_align(&bp, 128, 0);
-                                byte_count = 0;
-                            }
-                        }
-
-                    }
-                }
-                mpp_put_align(&bp, 128, 0);
-            }
+            for (j = 0; j < PLANE_TYPES; j++)
+                vp9_prob_put_coef(&w, pic_param->prob.coef[i][j][1][0][0]);
 
         //intra uv mode 6 x 128
-        for (i = 0; i < 3; i++) //intra_uv_mode
-            for (j = 0; j < INTRA_MODES - 1; j++)
-                mpp_put_bits(&bp, uv_mode_prob[i][j], 8);
-        mpp_put_align(&bp, 128, 0);
-
-        for (; i < 6; i++) //intra_uv_mode
-            for (j = 0; j < INTRA_MODES - 1; j++)
-                mpp_put_bits(&bp, uv_mode_prob[i][j], 8);
-        mpp_put_align(&bp, 128, 0);
-
-        for (; i < 9; i++) //intra_uv_mode
-            for (j = 0; j < INTRA_MODES - 1; j++)
-                mpp_put_bits(&bp, uv_mode_prob[i][j], 8);
-        mpp_put_align(&bp, 128, 0);
-        for (; i < INTRA_MODES; i++) //intra_uv_mode
-            for (j = 0; j < INTRA_MODES - 1; j++)
-                mpp_put_bits(&bp, uv_mode_prob[i][j], 8);
-
-        mpp_put_align(&bp, 128, 0);
-        mpp_put_bits(&bp, 0, 8);
-        mpp_put_align(&bp, 128, 0);
-
-        //mv releated 6 x 128
-        for (i = 0; i < MV_JOINTS - 1; i++) //mv_joint_type
-            mpp_put_bits(&bp, pic_param->prob.mv_joint[i], 8);
-
-        for (i = 0; i < 2; i++) { //sign bit
-            mpp_put_bits(&bp, pic_param->prob.mv_comp[i].sign, 8);
-        }
-        for (i = 0; i < 2; i++) { //classes bit
-            for (j = 0; j < MV_CLASSES - 1; j++)
-                mpp_put_bits(&bp, pic_param->prob.mv_comp[i].classes[j], 8);
-        }
-        for (i = 0; i < 2; i++) { //classe0 bit
-            mpp_put_bits(&bp, pic_param->prob.mv_comp[i].class0, 8);
+        for (i = 0; i < 3; i++) { //intra_uv_mode
+            vp9_prob_put(&w, uv_mode_prob + i * 3 * (INTRA_MODES - 1), 3 * (INTRA_MODES - 1));
+            vp9_prob_align(&w);
         }
-        for (i = 0; i < 2; i++) { // bits
-            for (j = 0; j < MV_OFFSET_BITS; j++)
-                mpp_put_bits(&bp, pic_param->prob.mv_comp[i].bits[j], 8);
-        }
-        for (i = 0; i < 2; i++) { //class0_fp bit
-            for (j = 0; j < CLASS0_SIZE; j++)
-                for (k = 0; k < MV_FP_SIZE - 1; k++)
-                    mpp_put_bits(&bp, pic_param->prob.mv_comp[i].class0_fp[j][k], 8);
-        }
-        for (i = 0; i < 2; i++) { //comp ref bit
-            for (j = 0; j < MV_FP_SIZE - 1; j++)
-                mpp_put_bits(&bp, pic_param->prob.mv_comp[i].fp[j], 8);
-        }
-        for (i = 0; i < 2; i++) { //class0_hp bit
+        vp9_prob_put(&w, uv_mode_prob + 9 * (INTRA_MODES - 1), INTRA_MODES - 1);
+        vp9_prob_align(&w);
+        vp9_prob_skip(&w, 1);
+        vp9_prob_align(&w);
 
-            mpp_put_bits(&bp, pic_param->prob.mv_comp[i].class0_hp, 8);
-        }
-        for (i = 0; i < 2; i++) { //hp bit
-            mpp_put_bits(&bp, pic_param->prob.mv_comp[i].hp, 8);
-        }
-        mpp_put_align(&bp, 128, 0);
+        //mv releated 6 x 128
+        vp9_prob_put(&w, pic_param->prob.mv_joint, MV_JOINTS - 1); //mv_joint_type
+        for (i = 0; i < 2; i++) //sign bit
+            vp9_prob_put(&w, &pic_param->prob.mv_comp[i].sign, 1);
+        for (i = 0; i < 2; i++) //classes bit
+            vp9_prob_put(&w, pic_param->prob.mv_comp[i].classes, MV_CLASSES - 1);
+        for (i = 0; i < 2; i++) //classe0 bit
+            vp9_prob_put(&w, &pic_param->prob.mv_comp[i].class0, 1);
+        for (i = 0; i < 2; i++) // bits
+            vp9_prob_put(&w, pic_param->prob.mv_comp[i].bits, MV_OFFSET_BITS);
+        for (i = 0; i < 2; i++) //class0_fp bit
+            vp9_prob_put(&w, pic_param->prob.mv_comp[i].class0_fp, CLASS0_SIZE * (MV_FP_SIZE - 1));
+        for (i = 0; i < 2; i++) //comp ref bit
+            vp9_prob_put(&w, pic_param->prob.mv_comp[i].fp, MV_FP_SIZE - 1);
+        for (i = 0; i < 2; i++) //class0_hp bit
+            vp9_prob_put(&w, &pic_param->prob.mv_comp[i].class0_hp, 1);
+        for (i = 0; i < 2; i++) //hp bit
+            vp9_prob_put(&w, &pic_param->prob.mv_comp[i].hp, 1);
+        vp9_prob_align(&w);
     }
-#ifdef RKPLATFORM
-    memcpy(probe_ptr, probe_packet, 304 * 8);
-#endif
 #ifdef dump
     if (intraFlag) {
-        fwrite(probe_packet, 1, 302 * 8, vp9_fp);
+        fwrite(probe_ptr, 1, 302 * 8, vp9_fp);
     } else {
-        fwrite(probe_packet, 1, 304 * 8, vp9_fp);
+        fwrite(probe_ptr, 1, 304 * 8, vp9_fp);
     }
     fflush(vp9_fp);
 #endif
-    if (probe_packet != NULL)
-        mpp_free(probe_packet);
 
     return 0;
 }
@@ -390,6 +390,7 @@ typedef struct h264e_hal_context_t {
     h264e_hal_param                 param;
     RK_U32                          enc_mode;
     void                            *dump_files;
+    void                            *rc_ctx;
 
     void                            *param_buf;
     MppPacket                       packeted_param;
@@ -30,17 +30,6 @@
 
 #define RKVENC_DUMP_INFO                0
 
-#define RKVENC_FRAME_TYPE_AUTO          0x0000  /* Let x264 choose the right type */
-#define RKVENC_FRAME_TYPE_IDR           0x0001
-#define RKVENC_FRAME_TYPE_I             0x0002
-#define RKVENC_FRAME_TYPE_P             0x0003
-#define RKVENC_FRAME_TYPE_BREF          0x0004  /* Non-disposable B-frame */
-#define RKVENC_FRAME_TYPE_B             0x0005
-#define RKVENC_FRAME_TYPE_KEYFRAME      0x0006  /* IDR or I depending on b_open_gop option */
-#define RKVENC_IS_TYPE_I(x) ((x)==RKVENC_FRAME_TYPE_I || (x)==RKVENC_FRAME_TYPE_IDR)
-#define RKVENC_IS_TYPE_B(x) ((x)==RKVENC_FRAME_TYPE_B || (x)==RKVENC_FRAME_TYPE_BREF)
-#define RKVENC_IS_DISPOSABLE(type) ( type == RKVENC_FRAME_TYPE_B )
-
 #define H264E_IOC_MAGIC                       'l'
 #define H264E_IOC_CUSTOM_BASE                 0x1000
 #define H264E_IOC_SET_OSD_PLT                 _IOW(H264E_IOC_MAGIC, H264E_IOC_CUSTOM_BASE+1, MppEncOSDPlt)
@@ -2720,11 +2709,13 @@ MPP_RET hal_h264e_rkv_init(void *hal, MppHalCfg *cfg)
     ctx->extra_info     = mpp_calloc(h264e_hal_rkv_extra_info, 1);
     ctx->dpb_ctx        = mpp_calloc(h264e_hal_rkv_dpb_ctx, 1);
     ctx->dump_files     = mpp_calloc(h264e_hal_rkv_dump_files, 1);
+    ctx->rc_ctx         = mpp_calloc(h264e_hal_rkv_rc_ctx, 1);
     ctx->param_buf      = mpp_calloc_size(void,  H264E_EXTRA_INFO_BUF_SIZE);
     mpp_packet_init(&ctx->packeted_param, ctx->param_buf, H264E_EXTRA_INFO_BUF_SIZE);
     hal_h264e_rkv_open_dump_files(ctx->dump_files);
     hal_h264e_rkv_init_extra_info(ctx->extra_info);
     hal_h264e_rkv_reference_init(ctx->dpb_ctx, &ctx->param);
+    hal_h264e_rkv_rc_init(ctx->rc_ctx);
 
     ctx->int_cb = cfg->hal_int_cb;
     ctx->frame_cnt = 0;
@@ -2772,6 +2763,7 @@ MPP_RET hal_h264e_rkv_deinit(void *hal)
     MPP_FREE(ctx->ioctl_input);
     MPP_FREE(ctx->ioctl_output);
     MPP_FREE(ctx->param_buf);
+    MPP_FREE(ctx->rc_ctx);
 
     if (ctx->buffers) {
         hal_h264e_rkv_free_buffers(ctx);
@@ -2865,103 +2857,248 @@ static MPP_RET hal_h264e_rkv_validate_syntax(h264e_syntax *syn, h264e_hal_rkv_cs
     return MPP_OK;
 }
 
+static const RK_S32 rkv_rc_err_level[RKV_H264E_RC_ERR_LEVELS] = {
+    -192, -144, -96, -16, 16, 96, 144, 192, 256,
+};
+
+static const RK_S32 rkv_rc_qp_adjust[RKV_H264E_RC_ERR_LEVELS] = {
+    -4, -3, -2, -1, 0, 1, 2, 3, 4,
+};
+
+void hal_h264e_rkv_rc_init(h264e_hal_rkv_rc_ctx *rc)
+{
+    RK_S32 k = 0;
+
+    memset(rc, 0, sizeof(*rc));
+    for (k = 0; k < 2; k++) {
+        rc->err_scale[k] = 256;
+        rc->qp_range[k] = 4;
+        rc->next_qp[k] = -1;
+    }
+    rc->ip_ratio = 4 * 256;
+}
+
+static RK_S32 hal_h264e_rkv_rc_derive_target(h264e_hal_rkv_rc_ctx *rc, h264e_hal_rkv_rc_task *task,
+                                             h264e_syntax *syn, RK_S32 intra)
+{
+    RK_S64 fps = (syn->frame_rate > 0) ? (syn->frame_rate) : (30);
+    RK_S64 gop = syn->gop;
+    RK_S64 bit_rate = syn->bit_rate;
+    RK_S64 window = (gop > 1) ? (gop) : (fps);
+    RK_S64 frame_bits = 0;
+    RK_S64 base = 0;
+    RK_S64 target = 0;
+
+    /* no bit rate config, 8Mbps for 1080p */
+    if (bit_rate <= 0)
+        bit_rate = (RK_S64)syn->pic_luma_width * syn->pic_luma_height * 4;
+
+    frame_bits = bit_rate / fps;
+    if (gop > 1) {
+        /* one intra frame and (gop - 1) inter frames share the gop budget */
+        base = frame_bits * gop * 256 / ((gop - 1) * 256 + rc->ip_ratio);
+        if (intra)
+            base = base * rc->ip_ratio / 256;
+    } else {
+        base = frame_bits;
+    }
+
+    base = MPP_MAX(base, 1);
+    task->base = (RK_S32)base;
+
+    /* pay back the drift of previous frames in one gop */
+    target = base - rc->bits_drift / window;
+    target = H264E_HAL_CLIP3(target, base / 2, base * 2);
+
+    return (RK_S32)target;
+}
+
+void hal_h264e_rkv_rc_gen_regs(h264e_hal_rkv_rc_ctx *rc, h264e_rkv_reg_set *regs, h264e_syntax *syn)
+{
+    RK_S32 mb_w = (syn->pic_luma_width + 15) / 16;
+    RK_S32 mb_h = (syn->pic_luma_height + 15) / 16;
+    RK_S32 mbs = MPP_MAX(mb_w * mb_h, 1);
+    RK_S32 intra = RKVENC_IS_TYPE_I(syn->frame_coding_type);
+    RK_S32 derived = (syn->target_bits <= 0);
+    RK_S32 qp_min = regs->swreg54.rc_min_qp;
+    RK_S32 qp_max = regs->swreg54.rc_max_qp;
+    RK_S32 pic_qp = syn->qp;
+    RK_S32 target = 0;
+    RK_S32 bits_err[RKV_H264E_RC_ERR_LEVELS];
+    RK_S32 qp_adj[RKV_H264E_RC_ERR_LEVELS];
+    RK_S32 k = 0;
+    h264e_hal_rkv_rc_task *task = NULL;
+
+    /* qp_max equal to qp_min is a valid fixed qp */
+    if (qp_max < qp_min)
+        qp_max = 51;
+
+    /* drop the oldest frame when feedback is lost */
+    if (rc->task_wr - rc->task_rd >= RKV_H264E_RC_TASK_NUM) {
+        h264e_hal_log_err("rc task queue full, drop frame without feedback");
+        rc->task_rd++;
+    }
+    task = &rc->task[rc->task_wr & (RKV_H264E_RC_TASK_NUM - 1)];
+    memset(task, 0, sizeof(*task));
+
+    if (derived) {
+        target = hal_h264e_rkv_rc_derive_target(rc, task, syn, intra);
+        if (rc->next_qp[intra] >= 0)
+            pic_qp = rc->next_qp[intra];
+        else if (rc->next_qp[!intra] >= 0)
+            pic_qp = rc->next_qp[!intra] + ((intra) ? (-3) : (3));
+    } else {
+        target = syn->target_bits;
+    }
+    pic_qp = H264E_HAL_CLIP3(pic_qp, qp_min, qp_max);
+
+    /*
+     * bits error thresholds are fractions (level / 1024) of the frame
+     * target scaled by the feedback of last frames, in units of 16 bits
+     */
+    for (k = 0; k < RKV_H264E_RC_ERR_LEVELS; k++) {
+        RK_S64 err = (RK_S64)rkv_rc_err_level[k] * target / 1024 * rc->err_scale[intra] / 256;
+        bits_err[k] = (RK_S32)H264E_HAL_CLIP3(err >> 4, -32768, 32767);
+        /* qp adjust steps span the qp clip range */
+        qp_adj[k] = rkv_rc_qp_adjust[k] * rc->qp_range[intra] / 4;
+    }
+
+    regs->swreg10.pic_qp        = pic_qp;
+    regs->swreg46.rc_ctu_num    = mb_w;
+
+    regs->swreg47.bits_error0   = bits_err[0];
+    regs->swreg47.bits_error1   = bits_err[1];
+    regs->swreg48.bits_error2   = bits_err[2];
+    regs->swreg48.bits_error3   = bits_err[3];
+    regs->swreg49.bits_error4   = bits_err[4];
+    regs->swreg49.bits_error5   = bits_err[5];
+    regs->swreg50.bits_error6   = bits_err[6];
+    regs->swreg50.bits_error7   = bits_err[7];
+    regs->swreg51.bits_error8   = bits_err[8];
+
+    regs->swreg52.qp_adjuest0   = qp_adj[0];
+    regs->swreg52.qp_adjuest1   = qp_adj[1];
+    regs->swreg52.qp_adjuest2   = qp_adj[2];
+    regs->swreg52.qp_adjuest3   = qp_adj[3];
+    regs->swreg52.qp_adjuest4   = qp_adj[4];
+    regs->swreg52.qp_adjuest5   = qp_adj[5];
+    regs->swreg53.qp_adjuest6   = qp_adj[6];
+    regs->swreg53.qp_adjuest7   = qp_adj[7];
+    regs->swreg53.qp_adjuest8   = qp_adj[8];
+
+    regs->swreg54.rc_qp_range   = rc->qp_range[intra];
+    regs->swreg55.ctu_ebits     = H264E_HAL_CLIP3(target / mbs, 1, 0xfffff); //target bits of one mb
+
+    task->intra     = intra;
+    task->target    = target;
+    task->derived   = derived;
+    task->qp        = pic_qp;
+    task->mbs       = mbs;
+    rc->task_wr++;
+
+    h264e_hal_log_detail("rc %s target %d qp %d range %d scale %d",
+                         (intra) ? ("I") : ("P"), target, pic_qp,
+                         rc->qp_range[intra], rc->err_scale[intra]);
+}
+
+/* qp delta to reach target bits, bits halve every 6 qp */
+static RK_S32 hal_h264e_rkv_rc_qp_delta(RK_S64 bits, RK_S64 target)
+{
+    RK_S64 ratio = bits * 256 / MPP_MAX(target, 1);
+    RK_S32 delta = 0;
+
+    while (ratio > 287 && delta < 6) {
+        ratio = ratio * 228 / 256;
+        delta++;
+    }
+    while (ratio < 228 && delta > -6) {
+        ratio = ratio * 287 / 256;
+        delta--;
+    }
+
+    return delta;
+}
+
+void hal_h264e_rkv_rc_update(h264e_hal_rkv_rc_ctx *rc, RK_U32 strm_size, RK_U32 qp_sum)
+{
+    h264e_hal_rkv_rc_task *task = NULL;
+    RK_S32 intra = 0;
+    RK_S64 bits = (RK_S64)strm_size * 8;
+    RK_S64 target = 0;
+    RK_S64 dev = 0;
+    RK_S32 avg_qp = 0;
+
+    if (rc->task_rd == rc->task_wr)
+        return;
+
+    task = &rc->task[rc->task_rd & (RKV_H264E_RC_TASK_NUM - 1)];
+    rc->task_rd++;
+
+    intra = task->intra;
+    target = MPP_MAX(task->target, 1);
+    /* no stream size from hardware, keep the rc state */
+    if (!strm_size)
+        return;
+
+    /* tighten mb rc when missing the target, relax it when close enough */
+    dev = ((bits > target) ? (bits - target) : (target - bits)) * 100 / target;
+    if (dev > 10) {
+        rc->err_scale[intra] = MPP_MAX(rc->err_scale[intra] * 3 / 4, 64);
+        rc->qp_range[intra] = MPP_MIN(rc->qp_range[intra] + 1, 8);
+    } else if (dev < 3) {
+        rc->err_scale[intra] = MPP_MIN(rc->err_scale[intra] * 5 / 4, 256);
+        rc->qp_range[intra] = MPP_MAX(rc->qp_range[intra] - 1, 2);
+    }
+
+    avg_qp = (qp_sum) ? ((RK_S32)((qp_sum + task->mbs / 2) / task->mbs)) : (task->qp);
+    rc->next_qp[intra] = H264E_HAL_CLIP3(avg_qp + hal_h264e_rkv_rc_qp_delta(bits, target), 0, 51);
+
+    if (intra && rc->last_bits[0] > 0) {
+        RK_S64 ratio = bits * 256 / rc->last_bits[0];
+
+        ratio = H264E_HAL_CLIP3(ratio, 256, 16 * 256);
+        rc->ip_ratio = (RK_S32)((rc->ip_ratio * 3 + ratio) / 4);
+    }
+    rc->last_bits[intra] = (RK_S32)bits;
+
+    if (task->derived)
+        rc->bits_drift += bits - task->base;
+
+    h264e_hal_log_detail("rc %s real %lld target %lld avg_qp %d drift %lld",
+                         (intra) ? ("I") : ("P"), bits, target, avg_qp, rc->bits_drift);
+}
+
 MPP_RET hal_h264e_rkv_set_rc_regs(h264e_hal_context *ctx, h264e_rkv_reg_set *regs, h264e_syntax *syn,
                                   h264e_hal_rkv_coveragetest_cfg *test)
 {
-    if (test && test->mbrc) {
-        RK_U32 num_mbs_oneframe = (syn->pic_luma_width + 15) / 16 * ((syn->pic_luma_height + 15) / 16);
-        RK_U32 frame_target_bitrate = (syn->pic_luma_width * syn->pic_luma_height / 1920 / 1080) * 10000000 / 8; //Bytes
-        RK_U32 frame_target_size = frame_target_bitrate / syn->keyframe_max_interval;
-        RK_U32 mb_target_size = frame_target_size / num_mbs_oneframe;
-        RK_U32 aq_strength          = 2;
+    RK_U32 aq_strength = 2;
 
+    regs->swreg10.pic_qp        = syn->qp; //if CQP, pic_qp=qp constant.
+    regs->swreg46.rc_en         = syn->mb_rc_mode; //TODO: multi slices
+    regs->swreg46.rc_mode       = syn->mb_rc_mode; //0:frame/slice rc; 1:mbrc
+    regs->swreg54.rc_qp_range   = 4; //sw_rc_clip_qp_range;
+    regs->swreg54.rc_max_qp     = syn->qp_max;
+    regs->swreg54.rc_min_qp     = syn->qp_min;
+
+    if (test && test->mbrc) {
         h264e_hal_log_detail("---- test-mbrc ----");
-        regs->swreg10.pic_qp        = syn->qp;//syn->swreg10.pic_qp; //if CQP, pic_qp=qp constant.
-        regs->swreg46.rc_en         = 1;
-        regs->swreg46.rc_mode       = 1; //0:frame/slice rc; 1:mbrc
+        regs->swreg46.rc_en     = 1;
+        regs->swreg46.rc_mode   = 1;
+        regs->swreg54.rc_max_qp = 40;
+        regs->swreg54.rc_min_qp = 20;
+    }
+
+    if (regs->swreg46.rc_mode) { //mb rc mode open
         regs->swreg46.aqmode_en     = 1;
         regs->swreg46.aq_strg       = (RK_U32)(aq_strength * 1.0397 * 256);
         regs->swreg46.Reserved      = 0x0;
-        regs->swreg46.rc_ctu_num    = (syn->pic_luma_width + 15) / 16;
-
-        regs->swreg47.bits_error0    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * -192; //sw_bits_error[0];
-        regs->swreg47.bits_error1    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * -144; //sw_bits_error[1];
-        regs->swreg48.bits_error2    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * -96; //sw_bits_error[2];
-        regs->swreg48.bits_error3    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * -16; //sw_bits_error[3];
-        regs->swreg49.bits_error4    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 16; //sw_bits_error[4];
-        regs->swreg49.bits_error5    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 96; //sw_bits_error[5];
-        regs->swreg50.bits_error6    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 144; //sw_bits_error[6];
-        regs->swreg50.bits_error7    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 192; //sw_bits_error[7];
-        regs->swreg51.bits_error8    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 256; //sw_bits_error[8];
-
-        regs->swreg52.qp_adjuest0    = -4; //sw_qp_adjuest[0];
-        regs->swreg52.qp_adjuest1    = -3; //sw_qp_adjuest[1];
-        regs->swreg52.qp_adjuest2    = -2; //sw_qp_adjuest[2];
-        regs->swreg52.qp_adjuest3    = -1; //sw_qp_adjuest[3];
-        regs->swreg52.qp_adjuest4    =  0; //sw_qp_adjuest[4];
-        regs->swreg52.qp_adjuest5    =  1; //sw_qp_adjuest[5];
-        regs->swreg53.qp_adjuest6    =  2; //sw_qp_adjuest[6];
-        regs->swreg53.qp_adjuest7    =  3; //sw_qp_adjuest[7];
-        regs->swreg53.qp_adjuest8    =  4; //sw_qp_adjuest[8];
-
-        regs->swreg54.rc_qp_mod      = 2; //sw_quality_flag;
-        regs->swreg54.rc_fact0       = 8; //sw_quality_factor_0;
-        regs->swreg54.rc_fact1       = 8; //sw_quality_factor_1;
-        regs->swreg54.Reserved       = 0x0;
-        regs->swreg54.rc_qp_range    = 4; //sw_rc_clip_qp_range;
-        regs->swreg54.rc_max_qp      = 40;
-        regs->swreg54.rc_min_qp      = 20;
-
-        regs->swreg55.ctu_ebits    = mb_target_size; //sw_ctu_target_bits;
-    } else {
-        h264e_hal_rkv_extra_info *extra_info = (h264e_hal_rkv_extra_info *)ctx->extra_info;
-        h264e_control_extra_info_cfg *extra_info_cfg = &extra_info->sei.extra_info_cfg;
-        RK_U32 num_mbs_oneframe = (syn->pic_luma_width + 15) / 16 * ((syn->pic_luma_height + 15) / 16);
-        RK_U32 frame_target_bitrate = (syn->pic_luma_width * syn->pic_luma_height / 1920 / 1080) * 8000000 / 8; //Bytes
-        RK_U32 frame_target_size = frame_target_bitrate / extra_info_cfg->keyframe_max_interval;
-        RK_U32 mb_target_size = frame_target_size / num_mbs_oneframe;
-        RK_U32 aq_strength          = 2;
-
-        regs->swreg10.pic_qp        = syn->qp;//syn->swreg10.pic_qp; //if CQP, pic_qp=qp constant.
-        regs->swreg46.rc_en         = syn->mb_rc_mode; //TODO: multi slices
-        regs->swreg46.rc_mode       = syn->mb_rc_mode; //0:frame/slice rc; 1:mbrc
-        regs->swreg54.rc_qp_range    = 4; //sw_rc_clip_qp_range;
-        regs->swreg54.rc_max_qp      = syn->qp_max;
-        regs->swreg54.rc_min_qp      = syn->qp_min;
-        if (regs->swreg46.rc_mode) { //mb rc mode open
-            regs->swreg46.aqmode_en     = 1;
-            regs->swreg46.aq_strg       = (RK_U32)(aq_strength * 1.0397 * 256);
-            regs->swreg46.Reserved      = 0x0;
-            regs->swreg46.rc_ctu_num    = (syn->pic_luma_width + 15) / 16;
-
-            regs->swreg47.bits_error0    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * -192; //sw_bits_error[0];
-            regs->swreg47.bits_error1    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * -144; //sw_bits_error[1];
-            regs->swreg48.bits_error2    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * -96; //sw_bits_error[2];
-            regs->swreg48.bits_error3    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * -16; //sw_bits_error[3];
-            regs->swreg49.bits_error4    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 16; //sw_bits_error[4];
-            regs->swreg49.bits_error5    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 96; //sw_bits_error[5];
-            regs->swreg50.bits_error6    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 144; //sw_bits_error[6];
-            regs->swreg50.bits_error7    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 192; //sw_bits_error[7];
-            regs->swreg51.bits_error8    = ((mb_target_size >> 4) * num_mbs_oneframe / 2) * 256; //sw_bits_error[8];
-
-            regs->swreg52.qp_adjuest0    = -4; //sw_qp_adjuest[0];
-            regs->swreg52.qp_adjuest1    = -3; //sw_qp_adjuest[1];
-            regs->swreg52.qp_adjuest2    = -2; //sw_qp_adjuest[2];
-            regs->swreg52.qp_adjuest3    = -1; //sw_qp_adjuest[3];
-            regs->swreg52.qp_adjuest4    =  0; //sw_qp_adjuest[4];
-            regs->swreg52.qp_adjuest5    =  1; //sw_qp_adjuest[5];
-            regs->swreg53.qp_adjuest6    =  2; //sw_qp_adjuest[6];
-            regs->swreg53.qp_adjuest7    =  3; //sw_qp_adjuest[7];
-            regs->swreg53.qp_adjuest8    =  4; //sw_qp_adjuest[8];
-
-            regs->swreg54.rc_qp_mod      = 2; //sw_quality_flag;
-            regs->swreg54.rc_fact0       = 8; //sw_quality_factor_0;
-            regs->swreg54.rc_fact1       = 8; //sw_quality_factor_1;
-
-            regs->swreg55.ctu_ebits      = mb_target_size; //syn->swreg55.ctu_ebits;
-
-            (void)test;
-        }
+
+        regs->swreg54.rc_qp_mod     = 2; //sw_quality_flag;
+        regs->swreg54.rc_fact0      = 8; //sw_quality_factor_0;
+        regs->swreg54.rc_fact1      = 8; //sw_quality_factor_1;
+        regs->swreg54.Reserved      = 0x0;
+
+        hal_h264e_rkv_rc_gen_regs((h264e_hal_rkv_rc_ctx *)ctx->rc_ctx, regs, syn);
     }
 
     return MPP_OK;
@@ -3676,8 +3813,9 @@ MPP_RET hal_h264e_rkv_start(void *hal, HalTaskInfo *task)
     return ret;
 }
 
-static MPP_RET hal_h264e_rkv_set_feedback(h264e_feedback *fb, h264e_rkv_ioctl_output *out)
+static MPP_RET hal_h264e_rkv_set_feedback(h264e_hal_context *ctx, h264e_feedback *fb, h264e_rkv_ioctl_output *out)
 {
+    h264e_hal_rkv_rc_ctx *rc = (h264e_hal_rkv_rc_ctx *)ctx->rc_ctx;
     RK_U32 k = 0;
     h264e_rkv_ioctl_output_elem *elem = NULL;
     h264e_hal_debug_enter();
@@ -3685,6 +3823,7 @@ static MPP_RET hal_h264e_rkv_set_feedback(h264e_feedback *fb, h264e_rkv_ioctl_ou
         elem = &out->elem[k];
         fb->qp_sum = elem->swreg71.qp_sum;
         fb->out_strm_size = elem->swreg69.bs_lgth;
+        hal_h264e_rkv_rc_update(rc, fb->out_strm_size, fb->qp_sum);
 
         fb->hw_status = 0;
         h264e_hal_log_detail("hw_status: 0x%08x", elem->hw_status);
@@ -3792,10 +3931,9 @@ MPP_RET hal_h264e_rkv_wait(void *hal, HalTaskInfo *task)
     (void)cmd;
 #endif
 
-    if (int_cb.callBack) {
-        hal_h264e_rkv_set_feedback(fb, reg_out);
+    hal_h264e_rkv_set_feedback(ctx, fb, reg_out);
+    if (int_cb.callBack)
         int_cb.callBack(int_cb.opaque, fb);
-    }
 
     hal_h264e_rkv_dump_mpp_reg_out(ctx);
     hal_h264e_rkv_dump_mpp_feedback(ctx);
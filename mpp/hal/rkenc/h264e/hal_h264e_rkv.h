@@ -20,6 +20,19 @@
 #include "mpp_buffer.h"
 #include "mpp_hal.h"
 #include "hal_task.h"
+#include "h264e_syntax.h"
+
+#define RKVENC_FRAME_TYPE_AUTO          0x0000  /* Let x264 choose the right type */
+#define RKVENC_FRAME_TYPE_IDR           0x0001
+#define RKVENC_FRAME_TYPE_I             0x0002
+#define RKVENC_FRAME_TYPE_P             0x0003
+#define RKVENC_FRAME_TYPE_BREF          0x0004  /* Non-disposable B-frame */
+#define RKVENC_FRAME_TYPE_B             0x0005
+#define RKVENC_FRAME_TYPE_KEYFRAME      0x0006  /* IDR or I depending on b_open_gop option */
+#define RKVENC_IS_TYPE_I(x) ((x)==RKVENC_FRAME_TYPE_I || (x)==RKVENC_FRAME_TYPE_IDR)
+#define RKVENC_IS_TYPE_B(x) ((x)==RKVENC_FRAME_TYPE_B || (x)==RKVENC_FRAME_TYPE_BREF)
+#define RKVENC_IS_DISPOSABLE(type) ( type == RKVENC_FRAME_TYPE_B )
+
 /*
 enc_mode
     0: N/A
@@ -317,6 +330,48 @@ typedef struct h264e_hal_rkv_dpb_ctx_t {
     RK_S32 i_long_term_reference_flag;
 } h264e_hal_rkv_dpb_ctx;
 
+/*
+ * mb rc state of rkv encoder
+ *
+ * The frame target comes from the frame rc in codec through syntax
+ * target_bits. Without frame rc the target is derived from bit_rate,
+ * frame_rate and gop with the learned intra / inter size ratio, and the
+ * frame qp follows the feedback of the last frame with the same type.
+ * The feedback of each frame also tunes the bits error thresholds and qp
+ * clip range of hardware mb rc for that frame type.
+ */
+#define RKV_H264E_RC_ERR_LEVELS         9
+/* max frames in hardware waiting for feedback, must be power of 2 */
+#define RKV_H264E_RC_TASK_NUM           4
+
+/* rc state of one frame sent to hardware and waiting for feedback */
+typedef struct h264e_hal_rkv_rc_task_t {
+    RK_S32  intra;
+    RK_S32  target;             /* frame target bits */
+    RK_S32  derived;            /* target derived in hal, not from codec */
+    RK_S32  base;               /* derived target before drift compensation */
+    RK_S32  qp;
+    RK_S32  mbs;
+} h264e_hal_rkv_rc_task;
+
+typedef struct h264e_hal_rkv_rc_ctx_t {
+    /*
+     * frames are queued in register generation order and the feedback is
+     * returned by hardware in the same order
+     */
+    h264e_hal_rkv_rc_task task[RKV_H264E_RC_TASK_NUM];
+    RK_U32  task_wr;
+    RK_U32  task_rd;
+
+    /* index 0 - inter frame, 1 - intra frame */
+    RK_S32  err_scale[2];       /* Q8 scale of bits error thresholds */
+    RK_S32  qp_range[2];        /* hardware qp clip range around pic_qp */
+    RK_S32  next_qp[2];         /* pic_qp for derived target, -1 - no feedback */
+    RK_S32  last_bits[2];
+    RK_S32  ip_ratio;           /* Q8 intra / inter frame bits ratio */
+    RK_S64  bits_drift;         /* real bits - budget of derived targets */
+} h264e_hal_rkv_rc_ctx;
+
 typedef struct h264e_hal_rkv_dbg_info_t {
     struct {
         RK_U32    lkt_num : 8;
@@ -1575,4 +1630,8 @@ MPP_RET hal_h264e_rkv_reset   (void *hal);
 MPP_RET hal_h264e_rkv_flush   (void *hal);
 MPP_RET hal_h264e_rkv_control (void *hal, RK_S32 cmd_type, void *param);
 
+void hal_h264e_rkv_rc_init    (h264e_hal_rkv_rc_ctx *rc);
+void hal_h264e_rkv_rc_gen_regs(h264e_hal_rkv_rc_ctx *rc, h264e_rkv_reg_set *regs, h264e_syntax *syn);
+void hal_h264e_rkv_rc_update  (h264e_hal_rkv_rc_ctx *rc, RK_U32 strm_size, RK_U32 qp_sum);
+
 #endif
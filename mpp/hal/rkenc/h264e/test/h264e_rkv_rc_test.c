@@ -0,0 +1,403 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "h264e_rkv_rc_test"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+
+#include "hal_h264e.h"
+#include "hal_h264e_rkv.h"
+#include "H264RateControl.h"
+#include "H264Slice.h"
+
+/*
+ * offline replay of rkv h264 encoder rate control
+ *
+ * Each frame goes through the codec frame rc (H264BeforePicRc), the hal mb
+ * rc register derivation and a simple model of the hardware mb rc. The model
+ * codes one mb row at a time with bits = complexity * 2 ^ ((26 - qp) / 6) and
+ * moves the row qp by the qp_adjuest of the accumulated bits error level.
+ * The frame size and qp sum are fed back to both hal and codec rc.
+ *
+ * The frame complexity comes from a trace file with one value per line or
+ * from a built-in synthetic sequence with scene cuts.
+ */
+
+#define RC_TEST_MAX_FRAMES          3000
+#define RC_TEST_BITS_PER_MB         40      /* inter mb bits at qp 26 with complexity 1.0 */
+#define RC_TEST_INTRA_FACTOR        4
+#define RC_TEST_MAX_ERROR           5       /* percent */
+
+typedef struct {
+    RK_S32  width;
+    RK_S32  height;
+    RK_S32  bps;
+    RK_S32  fps;
+    RK_S32  gop;
+    RK_S32  frames;
+    RK_S32  hal_only;   /* no frame rc in codec, target derived in hal */
+} RcTestCfg;
+
+typedef struct {
+    RK_S64  total_bits;
+    RK_S32  frames;
+    double  frame_err;  /* sum of |real - target| / target */
+} RcTestResult;
+
+static const RcTestCfg rc_test_cfgs[] = {
+    { 1280,  720, 2000000, 30, 30, 600, 0, },
+    {  720,  480,  800000, 25, 50, 500, 0, },
+    { 1920, 1080, 8000000, 30, 60, 600, 0, },
+    { 1280,  720, 2000000, 30, 30, 600, 1, },
+    { 1920, 1080, 4000000, 25, 25, 500, 1, },
+};
+
+static RK_S32 rc_test_verbose = 0;
+static float rc_test_cplx[RC_TEST_MAX_FRAMES];
+static RK_S32 rc_test_cplx_cnt = 0;
+
+static RK_U32 rc_test_rand(RK_U32 *seed)
+{
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 16) & 0x7fff;
+}
+
+static void rc_test_gen_cplx(RK_S32 frames)
+{
+    RK_U32 seed = 1;
+    float scene = 1.0f;
+    RK_S32 i;
+
+    for (i = 0; i < frames && i < RC_TEST_MAX_FRAMES; i++) {
+        /* scene cut every 90 - 210 frames */
+        if (i && (rc_test_rand(&seed) % 150) == 0)
+            scene = 0.4f + (rc_test_rand(&seed) % 160) / 100.0f;
+
+        rc_test_cplx[i] = scene * (0.9f + (rc_test_rand(&seed) % 20) / 100.0f)
+                          * (1.0f + 0.2f * sinf(i / 40.0f));
+    }
+    rc_test_cplx_cnt = i;
+}
+
+static MPP_RET rc_test_read_cplx(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    float val;
+
+    if (!fp) {
+        mpp_err("failed to open trace %s\n", path);
+        return MPP_NOK;
+    }
+
+    rc_test_cplx_cnt = 0;
+    while (rc_test_cplx_cnt < RC_TEST_MAX_FRAMES && fscanf(fp, "%f", &val) == 1)
+        rc_test_cplx[rc_test_cplx_cnt++] = (val > 0) ? (val) : (0.01f);
+
+    fclose(fp);
+    return (rc_test_cplx_cnt) ? (MPP_OK) : (MPP_NOK);
+}
+
+static void rc_test_init_codec_rc(h264RateControl_s *rc, const RcTestCfg *cfg)
+{
+    RK_S32 mb_w = (cfg->width + 15) / 16;
+    RK_S32 mb_h = (cfg->height + 15) / 16;
+    h264VirtualBuffer_s *vb = &rc->virtualBuffer;
+
+    memset(rc, 0, sizeof(*rc));
+    rc->outRateNum = cfg->fps;
+    rc->outRateDenom = 1;
+    rc->mbPerPic = mb_w * mb_h;
+    rc->mbRows = mb_h;
+
+    vb->bitRate = cfg->bps;
+    vb->unitsInTic = 1;
+    vb->timeScale = cfg->fps;
+    vb->bufferSize = cfg->bps;
+
+    /* codec mb rc forces frame rc on */
+    rc->hrd = ENCHW_NO;
+    rc->picRc = (cfg->hal_only) ? (ENCHW_NO) : (ENCHW_YES);
+    rc->mbRc = rc->picRc;
+    rc->picSkip = ENCHW_NO;
+
+    /* initial qp from bit rate */
+    rc->qpHdr = -1;
+    rc->fixedQp = 26;
+    rc->qpMin = 18;
+    rc->qpMax = 51;
+    rc->frameCoded = ENCHW_YES;
+    rc->sliceTypeCur = ISLICE;
+    rc->sliceTypePrev = PSLICE;
+    rc->gopLen = cfg->gop;
+    rc->intraQpDelta = -3;
+    rc->fixedIntraQp = 0;
+
+    H264InitRc(rc);
+}
+
+static RK_S32 rc_test_sign_ext(RK_U32 val, RK_U32 bits)
+{
+    RK_U32 sign = 1 << (bits - 1);
+
+    return (RK_S32)((val ^ sign) - sign);
+}
+
+/* hardware mb rc model, returns frame bits */
+static RK_S64 rc_test_encode(h264e_rkv_reg_set *regs, RK_S32 mb_w, RK_S32 mb_h,
+                             float cplx, RK_S32 intra, RK_U32 *qp_sum)
+{
+    RK_U32 bits_err_reg[RKV_H264E_RC_ERR_LEVELS] = {
+        regs->swreg47.bits_error0, regs->swreg47.bits_error1,
+        regs->swreg48.bits_error2, regs->swreg48.bits_error3,
+        regs->swreg49.bits_error4, regs->swreg49.bits_error5,
+        regs->swreg50.bits_error6, regs->swreg50.bits_error7,
+        regs->swreg51.bits_error8,
+    };
+    RK_U32 qp_adj_reg[RKV_H264E_RC_ERR_LEVELS] = {
+        regs->swreg52.qp_adjuest0, regs->swreg52.qp_adjuest1,
+        regs->swreg52.qp_adjuest2, regs->swreg52.qp_adjuest3,
+        regs->swreg52.qp_adjuest4, regs->swreg52.qp_adjuest5,
+        regs->swreg53.qp_adjuest6, regs->swreg53.qp_adjuest7,
+        regs->swreg53.qp_adjuest8,
+    };
+    RK_S32 bits_err[RKV_H264E_RC_ERR_LEVELS];
+    RK_S32 qp_adj[RKV_H264E_RC_ERR_LEVELS];
+    RK_S32 pic_qp = regs->swreg10.pic_qp;
+    RK_S32 range = regs->swreg54.rc_qp_range;
+    RK_S32 qp_min = MPP_MAX(pic_qp - range, (RK_S32)regs->swreg54.rc_min_qp);
+    RK_S32 qp_max = MPP_MIN(pic_qp + range, (RK_S32)regs->swreg54.rc_max_qp);
+    RK_S32 mb_rc = regs->swreg46.rc_en && regs->swreg46.rc_mode;
+    RK_S64 mb_target = regs->swreg55.ctu_ebits;
+    RK_S64 bits = 0;
+    RK_S32 qp = pic_qp;
+    RK_S32 row, k;
+
+    /* bits error and qp adjust registers are two's complement */
+    for (k = 0; k < RKV_H264E_RC_ERR_LEVELS; k++) {
+        bits_err[k] = rc_test_sign_ext(bits_err_reg[k], 16);
+        qp_adj[k] = rc_test_sign_ext(qp_adj_reg[k], 5);
+    }
+
+    *qp_sum = 0;
+    for (row = 0; row < mb_h; row++) {
+        /* content varies from top to bottom of the picture */
+        float row_cplx = cplx * (1.0f + 0.5f * sinf(row * 6.2832f / mb_h));
+        double row_bits = RC_TEST_BITS_PER_MB * mb_w * row_cplx *
+                          pow(2.0, (26 - qp) / 6.0);
+
+        if (intra)
+            row_bits *= RC_TEST_INTRA_FACTOR;
+
+        bits += (RK_S64)row_bits;
+        *qp_sum += qp * mb_w;
+
+        if (mb_rc) {
+            /* error is compared in units of 16 bits */
+            RK_S64 err = (bits - mb_target * mb_w * (row + 1)) >> 4;
+
+            for (k = 0; k < RKV_H264E_RC_ERR_LEVELS - 1; k++)
+                if (err < bits_err[k])
+                    break;
+
+            qp = H264E_HAL_CLIP3(pic_qp + qp_adj[k], qp_min, qp_max);
+        }
+    }
+
+    return bits;
+}
+
+static MPP_RET rc_test_run(const RcTestCfg *cfg, RcTestResult *res)
+{
+    RK_S32 mb_w = (cfg->width + 15) / 16;
+    RK_S32 mb_h = (cfg->height + 15) / 16;
+    h264RateControl_s *rc = mpp_calloc(h264RateControl_s, 1);
+    h264e_hal_rkv_rc_ctx *hal_rc = mpp_calloc(h264e_hal_rkv_rc_ctx, 1);
+    h264e_rkv_reg_set *regs = mpp_calloc(h264e_rkv_reg_set, 1);
+    h264e_syntax syn;
+    RK_S32 frames = MPP_MIN(cfg->frames, rc_test_cplx_cnt);
+    RK_S32 i;
+
+    if (!rc || !hal_rc || !regs) {
+        mpp_err("failed to malloc rc context\n");
+        MPP_FREE(rc);
+        MPP_FREE(hal_rc);
+        MPP_FREE(regs);
+        return MPP_ERR_MALLOC;
+    }
+
+    rc_test_init_codec_rc(rc, cfg);
+    hal_h264e_rkv_rc_init(hal_rc);
+    memset(res, 0, sizeof(*res));
+
+    for (i = 0; i < frames; i++) {
+        RK_S32 intra = (i % cfg->gop) == 0;
+        RK_U32 qp_sum = 0;
+        RK_S64 bits = 0;
+        RK_S32 target = 0;
+
+        H264BeforePicRc(rc, 1, (intra) ? (ISLICE) : (PSLICE));
+
+        memset(&syn, 0, sizeof(syn));
+        syn.pic_luma_width      = cfg->width;
+        syn.pic_luma_height     = cfg->height;
+        syn.frame_coding_type   = (i == 0) ? (RKVENC_FRAME_TYPE_IDR) :
+                                  (intra) ? (RKVENC_FRAME_TYPE_I) : (RKVENC_FRAME_TYPE_P);
+        syn.qp                  = rc->qpHdr;
+        syn.qp_min              = rc->qpMin;
+        syn.qp_max              = rc->qpMax;
+        syn.mb_rc_mode          = 1;
+        syn.bit_rate            = cfg->bps;
+        syn.frame_rate          = cfg->fps;
+        syn.gop                 = cfg->gop;
+        syn.target_bits         = (rc->picRc) ? (rc->targetPicSize) : (0);
+
+        memset(regs, 0, sizeof(*regs));
+        regs->swreg46.rc_en     = 1;
+        regs->swreg46.rc_mode   = 1;
+        regs->swreg54.rc_min_qp = syn.qp_min;
+        regs->swreg54.rc_max_qp = syn.qp_max;
+        hal_h264e_rkv_rc_gen_regs(hal_rc, regs, &syn);
+        target = hal_rc->task[(hal_rc->task_wr - 1) & (RKV_H264E_RC_TASK_NUM - 1)].target;
+
+        bits = rc_test_encode(regs, mb_w, mb_h, rc_test_cplx[i], intra, &qp_sum);
+
+        hal_h264e_rkv_rc_update(hal_rc, (RK_U32)((bits + 7) / 8), qp_sum);
+        H264AfterPicRc(rc, (RK_U32)(bits / 6), (RK_U32)((bits + 7) / 8), qp_sum);
+
+        res->total_bits += (bits + 7) / 8 * 8;
+        res->frame_err += fabs((double)(bits - target)) / MPP_MAX(target, 1);
+        res->frames++;
+
+        if (rc_test_verbose)
+            mpp_log("frame %4d %s cplx %.2f qp %2d target %8d real %8lld\n",
+                    i, (intra) ? ("I") : ("P"), rc_test_cplx[i],
+                    regs->swreg10.pic_qp, target, bits);
+    }
+
+    MPP_FREE(rc);
+    MPP_FREE(hal_rc);
+    MPP_FREE(regs);
+    return MPP_OK;
+}
+
+static void rc_test_help(void)
+{
+    mpp_log("usage: h264e_rkv_rc_test [options]\n");
+    mpp_log("  -i trace     frame complexity trace, one value per line\n");
+    mpp_log("  -w width     picture width\n");
+    mpp_log("  -h height    picture height\n");
+    mpp_log("  -b bps       target bit rate\n");
+    mpp_log("  -f fps       frame rate\n");
+    mpp_log("  -g gop       intra frame interval\n");
+    mpp_log("  -n frames    frame count\n");
+    mpp_log("  -s           no codec frame rc, target derived in hal\n");
+    mpp_log("  -v           log each frame and hal rc detail\n");
+    mpp_log("without -w / -h / -b the built-in config list is replayed\n");
+}
+
+int main(int argc, char **argv)
+{
+    RcTestCfg user = { 1280, 720, 0, 30, 30, RC_TEST_MAX_FRAMES, 0, };
+    const RcTestCfg *cfgs = rc_test_cfgs;
+    RK_S32 cfg_cnt = MPP_ARRAY_ELEMS(rc_test_cfgs);
+    const char *trace = NULL;
+    RK_S32 failed = 0;
+    RK_S32 i;
+
+    for (i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = (i + 1 < argc) ? (argv[i + 1]) : (NULL);
+
+        if (!strcmp(opt, "-s")) {
+            user.hal_only = 1;
+            continue;
+        }
+        if (!strcmp(opt, "-v")) {
+            rc_test_verbose = 1;
+            h264e_hal_log_mode |= H264E_HAL_LOG_DETAIL;
+            continue;
+        }
+        if (opt[0] != '-' || !opt[1] || opt[2] || !val) {
+            rc_test_help();
+            return -1;
+        }
+
+        switch (opt[1]) {
+        case 'i' : trace = val; break;
+        case 'w' : user.width = atoi(val); break;
+        case 'h' : user.height = atoi(val); break;
+        case 'b' : user.bps = atoi(val); break;
+        case 'f' : user.fps = atoi(val); break;
+        case 'g' : user.gop = atoi(val); break;
+        case 'n' : user.frames = atoi(val); break;
+        default : {
+            rc_test_help();
+            return -1;
+        } break;
+        }
+        i++;
+    }
+
+    if (user.bps > 0) {
+        if (user.width <= 0 || user.height <= 0 || user.fps <= 0 ||
+            user.gop < 1 || user.gop > 150 || user.frames <= 0) {
+            rc_test_help();
+            return -1;
+        }
+        cfgs = &user;
+        cfg_cnt = 1;
+    }
+
+    if (trace) {
+        if (rc_test_read_cplx(trace))
+            return -1;
+    } else
+        rc_test_gen_cplx(RC_TEST_MAX_FRAMES);
+
+    for (i = 0; i < cfg_cnt; i++) {
+        const RcTestCfg *cfg = &cfgs[i];
+        RcTestResult res;
+        double real_bps = 0;
+        double err = 0;
+
+        if (rc_test_run(cfg, &res) || !res.frames) {
+            failed++;
+            continue;
+        }
+
+        real_bps = (double)res.total_bits * cfg->fps / res.frames;
+        err = (real_bps - cfg->bps) * 100 / cfg->bps;
+
+        mpp_log("%4dx%-4d fps %2d gop %3d %s target %8d real %8.0f error %+5.2f%% frame error %5.2f%%\n",
+                cfg->width, cfg->height, cfg->fps, cfg->gop,
+                (cfg->hal_only) ? ("hal") : ("mpp"), cfg->bps, real_bps, err,
+                res.frame_err * 100 / res.frames);
+
+        if (fabs(err) > RC_TEST_MAX_ERROR)
+            failed++;
+    }
+
+    mpp_log("h264e rkv rc test %s\n", (failed) ? ("failed") : ("success"));
+
+    return (failed) ? (-1) : (0);
+}
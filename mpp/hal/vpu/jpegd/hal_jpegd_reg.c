@@ -1875,6 +1875,7 @@ MPP_RET hal_jpegd_init(void *hal, MppHalCfg *cfg)
 {
     FUN_TEST("Enter");
     MPP_RET ret = MPP_OK;
+    RK_S32 i;
     JpegHalContext *JpegHalCtx = (JpegHalContext *)hal;
     if (NULL == JpegHalCtx) {
         JpegHalCtx = (JpegHalContext *)mpp_calloc(JpegHalContext, 1);
@@ -1926,11 +1927,22 @@ MPP_RET hal_jpegd_init(void *hal, MppHalCfg *cfg)
         return ret;
     }
 
-    ret = mpp_buffer_get(JpegHalCtx->group, &JpegHalCtx->pTableBase, JPEGDEC_BASELINE_TABLE_SIZE);
-    if (MPP_OK != ret) {
-        JPEGD_ERROR_LOG("get buffer failed\n");
-        return ret;
+    JpegHalCtx->table_count = (cfg->task_count > 0) ? (cfg->task_count) : (1);
+    JpegHalCtx->table_idx = 0;
+    JpegHalCtx->table_bufs = mpp_calloc(MppBuffer, JpegHalCtx->table_count);
+    if (NULL == JpegHalCtx->table_bufs) {
+        JPEGD_ERROR_LOG("no memory!");
+        return MPP_ERR_NOMEM;
+    }
+
+    for (i = 0; i < JpegHalCtx->table_count; i++) {
+        ret = mpp_buffer_get(JpegHalCtx->group, &JpegHalCtx->table_bufs[i], JPEGDEC_BASELINE_TABLE_SIZE);
+        if (MPP_OK != ret) {
+            JPEGD_ERROR_LOG("get buffer failed\n");
+            return ret;
+        }
     }
+    JpegHalCtx->pTableBase = JpegHalCtx->table_bufs[0];
 
     JpegHalCtx->output_fmt = MPP_FMT_YUV420SP;
     JpegHalCtx->set_output_fmt_flag = 0;
@@ -1964,12 +1976,21 @@ MPP_RET hal_jpegd_deinit(void *hal)
         }
     }
 
-    if (JpegHalCtx->pTableBase) {
-        ret = mpp_buffer_put(JpegHalCtx->pTableBase);
-        if (MPP_OK != ret) {
-            JPEGD_ERROR_LOG("put buffer failed\n");
-            return ret;
+    if (JpegHalCtx->table_bufs) {
+        RK_S32 i;
+
+        for (i = 0; i < JpegHalCtx->table_count; i++) {
+            if (JpegHalCtx->table_bufs[i]) {
+                ret = mpp_buffer_put(JpegHalCtx->table_bufs[i]);
+                if (MPP_OK != ret) {
+                    JPEGD_ERROR_LOG("put buffer failed\n");
+                    return ret;
+                }
+            }
         }
+        mpp_free(JpegHalCtx->table_bufs);
+        JpegHalCtx->table_bufs = NULL;
+        JpegHalCtx->pTableBase = NULL;
     }
 
     if (JpegHalCtx->group) {
@@ -2011,7 +2032,9 @@ MPP_RET hal_jpegd_gen_regs(void *hal,  HalTaskInfo *syn)
         jpegd_set_output_format(JpegHalCtx, pSyntax);
 
 #ifdef RKPLATFORM
-        if (JpegHalCtx->set_output_fmt_flag && (JpegHalCtx->vpu_socket > 0)) {
+        /* reopen socket for pp once, there may be task in flight later */
+        if (JpegHalCtx->set_output_fmt_flag && !JpegHalCtx->pp_socket_ready &&
+            (JpegHalCtx->vpu_socket > 0)) {
             VPUClientRelease(JpegHalCtx->vpu_socket);
             JpegHalCtx->vpu_socket = 0;
 
@@ -2022,6 +2045,7 @@ MPP_RET hal_jpegd_gen_regs(void *hal,  HalTaskInfo *syn)
             } else {
                 JPEGD_VERBOSE_LOG("get vpu_socket(%d), success. \n", JpegHalCtx->vpu_socket);
             }
+            JpegHalCtx->pp_socket_ready = 1;
         }
 
         mpp_buf_slot_get_prop(JpegHalCtx->packet_slots, syn->dec.input, SLOT_BUFFER, &streambuf);
@@ -2035,6 +2059,10 @@ MPP_RET hal_jpegd_gen_regs(void *hal,  HalTaskInfo *syn)
 
         ret = jpegd_set_post_processor(JpegHalCtx, pSyntax);
 
+        /* previous tasks may still be reading their tables */
+        JpegHalCtx->pTableBase = JpegHalCtx->table_bufs[JpegHalCtx->table_idx];
+        JpegHalCtx->table_idx = (JpegHalCtx->table_idx + 1) % JpegHalCtx->table_count;
+
         ret = jpegd_gen_regs(JpegHalCtx, pSyntax);
 
         if (JpegHalCtx->hal_debug_enable && JpegHalCtx->frame_count < 3) {
@@ -711,6 +711,14 @@ typedef struct JpegHalContext {
     MppBufferGroup group;
     MppBuffer frame_buf;
     MppBuffer pTableBase;
+    /*
+     * hardware reads table buffer until the task is done, so each task in
+     * flight has its own one and pTableBase points to the one in use
+     */
+    MppBuffer *table_bufs;
+    RK_S32 table_count;
+    RK_S32 table_idx;
+    RK_U32 pp_socket_ready;
 
     MppFrameFormat output_fmt;
     RK_U32 set_output_fmt_flag;
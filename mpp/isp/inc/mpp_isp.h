@@ -0,0 +1,65 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ISP_H__
+#define __MPP_ISP_H__
+
+#include "rk_mpi.h"
+
+/*
+ * software isp for yuv to rgb conversion with crop and scaling
+ *
+ * Each output row is produced in tiles of ISP_TILE_WIDTH pixels. For one tile
+ * the source rows are filtered vertically into line buffers covering only
+ * the source span of the tile, then filtered horizontally, converted to rgb
+ * and packed to the destination. Source is read once per output row and
+ * the working set of a tile stays in L1 cache.
+ */
+typedef void* MppIsp;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_isp_init(MppIsp *isp);
+MPP_RET mpp_isp_deinit(MppIsp isp);
+MPP_RET mpp_isp_control(MppIsp isp, MpiCmd cmd, void *param);
+
+/*
+ * convert src frame to dst frame with dst frame buffer. rgb format and
+ * non-zero width / height / hor_stride of dst frame override isp config.
+ * The final output info is written back to dst frame.
+ */
+MPP_RET mpp_isp_process(MppIsp isp, MppFrame dst, MppFrame src);
+
+/*
+ * convert frame in place: the output is written to a buffer from isp
+ * internal buffer group and replaces the frame buffer and format info.
+ * Other frame info like pts / eos / errinfo is kept.
+ */
+MPP_RET mpp_isp_convert(MppIsp isp, MppFrame frame);
+
+/*
+ * thread for MPP_CTX_ISP context. It takes frames from mpp frame list, then
+ * converts and puts them to mpp isp frame list.
+ */
+void *mpp_isp_thread(void *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_ISP_H__*/
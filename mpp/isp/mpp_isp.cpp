@@ -0,0 +1,859 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define  MODULE_TAG "mpp_isp"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_env.h"
+#include "mpp_common.h"
+
+#include "mpp.h"
+#include "mpp_isp.h"
+
+#define ISP_DBG_FUNCTION            (0x00000001)
+#define ISP_DBG_INFO                (0x00000002)
+
+#define isp_dbg(flag, fmt, ...)     _mpp_dbg(mpp_isp_debug, flag, fmt, ## __VA_ARGS__)
+#define isp_dbg_f(flag, fmt, ...)   _mpp_dbg_f(mpp_isp_debug, flag, fmt, ## __VA_ARGS__)
+
+#define isp_dbg_func(fmt, ...)      isp_dbg_f(ISP_DBG_FUNCTION, fmt, ## __VA_ARGS__)
+#define isp_dbg_info(fmt, ...)      isp_dbg(ISP_DBG_INFO, fmt, ## __VA_ARGS__)
+
+/* output pixels per tile, line buffers of one tile stay in L1 cache */
+#define ISP_TILE_WIDTH              256
+/* line buffer padding for the bilinear tap read beyond one sample plane */
+#define ISP_LINE_PADDING            16
+/* converted frames waiting for user in MPP_CTX_ISP context */
+#define ISP_OUTPUT_MAX_COUNT        4
+
+#define ISP_CLIP8(v)                ((v) < 0 ? 0 : ((v) > 255 ? 255 : (v)))
+
+static RK_U32 mpp_isp_debug = 0;
+
+/*
+ * source position of one output sample on one direction
+ *
+ * bilinear : pos and pos + 1 are blended, coef is weight of pos + 1 in Q8
+ * area     : samples in [pos, end) are averaged, coef is 1 / (end - pos) in Q16
+ */
+typedef struct IspMap_t {
+    RK_S32          pos;
+    RK_S32          end;
+    RK_S32          coef;
+} IspMap;
+
+typedef struct IspPlane_t {
+    RK_U8           *ptr;
+    RK_S32          stride;
+    /* 1 for planar, 2 for interleaved chroma */
+    RK_S32          step;
+    RK_S32          width;
+    RK_S32          height;
+} IspPlane;
+
+/* yuv to rgb matrix in Q14 */
+typedef struct IspCsc_t {
+    RK_S32          y;
+    RK_S32          y_off;
+    RK_S32          rv;
+    RK_S32          gu;
+    RK_S32          gv;
+    RK_S32          bu;
+} IspCsc;
+
+/* [bt709][full range] */
+static const IspCsc isp_csc[2][2] = {
+    {
+        { 19071, 16, 26149, 6406, 13320, 33063, },  /* BT.601 limited range */
+        { 16384,  0, 22970, 5638, 11700, 29032, },  /* BT.601 full range */
+    },
+    {
+        { 19071, 16, 29374, 3490,  8735, 34603, },  /* BT.709 limited range */
+        { 16384,  0, 25802, 3069,  7670, 30402, },  /* BT.709 full range */
+    },
+};
+
+/* frame parameter resolved from config, source frame and destination frame */
+typedef struct IspJob_t {
+    IspPlane        plane[3];
+    /* chroma subsampling shift */
+    RK_S32          shift_x;
+    RK_S32          shift_y;
+
+    RK_S32          crop_x;
+    RK_S32          crop_y;
+    RK_S32          crop_w;
+    RK_S32          crop_h;
+
+    RK_S32          width;
+    RK_S32          height;
+    RK_S32          hor_stride;
+    MppFrameFormat  format;
+    RK_S32          bpp;
+    RK_S32          scale_mode;
+
+    const IspCsc    *csc;
+} IspJob;
+
+typedef struct MppIspImpl_t {
+    Mutex           *lock;
+    MppIspConfig    cfg;
+    MppBufferGroup  group;
+
+    IspJob          job;
+
+    /* maps of luma and chroma on x and y direction */
+    IspMap          *map_x[2];
+    IspMap          *map_y[2];
+    RK_S32          map_x_size;
+    RK_S32          map_y_size;
+
+    /* vertical filtered line of y / u / v and area accumulator */
+    RK_U8           *line[3];
+    RK_U32          *acc;
+    RK_S32          line_size;
+} MppIspImpl;
+
+static RK_S32 isp_get_bpp(MppFrameFormat fmt)
+{
+    switch (fmt) {
+    case MPP_FMT_RGB565 :
+    case MPP_FMT_BGR565 : {
+        return 2;
+    } break;
+    case MPP_FMT_RGB888 :
+    case MPP_FMT_BGR888 : {
+        return 3;
+    } break;
+    case MPP_FMT_ARGB8888 :
+    case MPP_FMT_ABGR8888 : {
+        return 4;
+    } break;
+    default : {
+    } break;
+    }
+    return 0;
+}
+
+static MPP_RET isp_check_config(MppIspConfig *cfg)
+{
+    if (cfg->crop_x < 0 || cfg->crop_y < 0 ||
+        cfg->crop_w < 0 || cfg->crop_h < 0 ||
+        cfg->width < 0 || cfg->height < 0 || cfg->hor_stride < 0) {
+        mpp_err_f("invalid crop [%d %d %d %d] size %dx%d stride %d\n",
+                  cfg->crop_x, cfg->crop_y, cfg->crop_w, cfg->crop_h,
+                  cfg->width, cfg->height, cfg->hor_stride);
+        return MPP_ERR_VALUE;
+    }
+    if (!isp_get_bpp((MppFrameFormat)cfg->format)) {
+        mpp_err_f("unsupported output format %x\n", cfg->format);
+        return MPP_ERR_VALUE;
+    }
+    if (cfg->scale_mode < 0 || cfg->scale_mode >= MPP_ISP_SCALE_BUTT) {
+        mpp_err_f("invalid scale mode %d\n", cfg->scale_mode);
+        return MPP_ERR_VALUE;
+    }
+    return MPP_OK;
+}
+
+static MPP_RET isp_setup_planes(IspJob *job, MppFrame src)
+{
+    MppFrameFormat fmt = mpp_frame_get_fmt(src);
+    MppBuffer buffer = mpp_frame_get_buffer(src);
+    RK_S32 width  = mpp_frame_get_width(src);
+    RK_S32 height = mpp_frame_get_height(src);
+    RK_S32 hor_stride = mpp_frame_get_hor_stride(src);
+    RK_S32 ver_stride = mpp_frame_get_ver_stride(src);
+    RK_S32 luma_size = hor_stride * ver_stride;
+    RK_S32 chroma_size = 0;
+    RK_U8 *ptr = NULL;
+    IspPlane *y = &job->plane[0];
+    IspPlane *u = &job->plane[1];
+    IspPlane *v = &job->plane[2];
+
+    if (NULL == buffer) {
+        mpp_err_f("found NULL buffer in source frame\n");
+        return MPP_ERR_NULL_PTR;
+    }
+    if (width <= 0 || height <= 0 || hor_stride < width || ver_stride < height) {
+        mpp_err_f("invalid source size %dx%d stride %dx%d\n",
+                  width, height, hor_stride, ver_stride);
+        return MPP_ERR_VALUE;
+    }
+
+    switch (fmt) {
+    case MPP_FMT_YUV420SP :
+    case MPP_FMT_YUV420SP_VU :
+    case MPP_FMT_YUV420P : {
+        job->shift_y = 1;
+    } break;
+    case MPP_FMT_YUV422SP :
+    case MPP_FMT_YUV422SP_VU :
+    case MPP_FMT_YUV422P : {
+        job->shift_y = 0;
+    } break;
+    default : {
+        mpp_err_f("unsupported source format %x\n", fmt);
+        return MPP_NOK;
+    } break;
+    }
+    job->shift_x = 1;
+
+    chroma_size = luma_size >> job->shift_y;
+    if (mpp_buffer_get_size(buffer) < (size_t)(luma_size + chroma_size)) {
+        mpp_err_f("source buffer size %d is less than %d\n",
+                  (RK_S32)mpp_buffer_get_size(buffer), luma_size + chroma_size);
+        return MPP_ERR_VALUE;
+    }
+
+    ptr = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    y->ptr      = ptr;
+    y->stride   = hor_stride;
+    y->step     = 1;
+    y->width    = width;
+    y->height   = height;
+
+    u->width    = (width + 1) >> job->shift_x;
+    u->height   = (height + job->shift_y) >> job->shift_y;
+    if (fmt == MPP_FMT_YUV420P || fmt == MPP_FMT_YUV422P) {
+        u->ptr      = ptr + luma_size;
+        u->stride   = hor_stride >> 1;
+        u->step     = 1;
+        v->ptr      = u->ptr + (chroma_size >> 1);
+    } else {
+        RK_S32 swap = (fmt == MPP_FMT_YUV420SP_VU || fmt == MPP_FMT_YUV422SP_VU);
+
+        u->ptr      = ptr + luma_size + swap;
+        u->stride   = hor_stride;
+        u->step     = 2;
+        v->ptr      = ptr + luma_size + !swap;
+    }
+    v->stride   = u->stride;
+    v->step     = u->step;
+    v->width    = u->width;
+    v->height   = u->height;
+
+    job->csc = &isp_csc[mpp_frame_get_colorspace(src) == MPP_FRAME_SPC_BT709]
+               [mpp_frame_get_color_range(src) == MPP_FRAME_RANGE_JPEG];
+    return MPP_OK;
+}
+
+/*
+ * resolve crop / output size / format from config, source frame and the
+ * optional destination frame
+ */
+static MPP_RET isp_setup_job(MppIspImpl *p, MppFrame dst, MppFrame src)
+{
+    MppIspConfig *cfg = &p->cfg;
+    IspJob *job = &p->job;
+    MPP_RET ret = isp_setup_planes(job, src);
+    RK_S32 src_w = job->plane[0].width;
+    RK_S32 src_h = job->plane[0].height;
+
+    if (ret)
+        return ret;
+
+    job->crop_x = cfg->crop_x;
+    job->crop_y = cfg->crop_y;
+    job->crop_w = cfg->crop_w ? cfg->crop_w : src_w - cfg->crop_x;
+    job->crop_h = cfg->crop_h ? cfg->crop_h : src_h - cfg->crop_y;
+    if (job->crop_w <= 0 || job->crop_h <= 0 ||
+        job->crop_x + job->crop_w > src_w ||
+        job->crop_y + job->crop_h > src_h) {
+        mpp_err_f("crop [%d %d %d %d] is out of source %dx%d\n",
+                  cfg->crop_x, cfg->crop_y, cfg->crop_w, cfg->crop_h,
+                  src_w, src_h);
+        return MPP_ERR_VALUE;
+    }
+
+    job->width  = cfg->width  ? cfg->width  : job->crop_w;
+    job->height = cfg->height ? cfg->height : job->crop_h;
+    job->hor_stride = cfg->hor_stride;
+    job->format = (MppFrameFormat)cfg->format;
+    job->scale_mode = cfg->scale_mode;
+
+    if (dst) {
+        MppFrameFormat fmt = mpp_frame_get_fmt(dst);
+
+        if ((fmt & MPP_FRAME_FMT_MASK) == MPP_FRAME_FMT_RGB)
+            job->format = fmt;
+        if (mpp_frame_get_width(dst))
+            job->width = mpp_frame_get_width(dst);
+        if (mpp_frame_get_height(dst))
+            job->height = mpp_frame_get_height(dst);
+        if (mpp_frame_get_hor_stride(dst))
+            job->hor_stride = mpp_frame_get_hor_stride(dst);
+    }
+
+    job->bpp = isp_get_bpp(job->format);
+    if (!job->bpp) {
+        mpp_err_f("unsupported output format %x\n", job->format);
+        return MPP_NOK;
+    }
+    if (!job->hor_stride)
+        job->hor_stride = MPP_ALIGN(job->width * job->bpp, 16);
+    if (job->hor_stride < job->width * job->bpp) {
+        mpp_err_f("output stride %d is less than width %d\n",
+                  job->hor_stride, job->width);
+        return MPP_ERR_VALUE;
+    }
+
+    isp_dbg_info("crop [%d %d %d %d] -> %dx%d fmt %x stride %d mode %d\n",
+                 job->crop_x, job->crop_y, job->crop_w, job->crop_h,
+                 job->width, job->height, job->format, job->hor_stride,
+                 job->scale_mode);
+    return MPP_OK;
+}
+
+/*
+ * map n output samples to source rectangle [off, off + len) on a plane of
+ * size samples. off and len are in Q16 so that chroma rectangle of an odd
+ * luma crop keeps its exact position.
+ */
+static void isp_build_map(IspMap *map, RK_S32 n, RK_S64 off, RK_S64 len,
+                          RK_S32 size, RK_S32 mode)
+{
+    RK_S32 i;
+
+    for (i = 0; i < n; i++) {
+        IspMap *m = &map[i];
+
+        if (mode == MPP_ISP_SCALE_BILINEAR) {
+            RK_S64 s = off + ((2 * i + 1) * len) / (2 * n) - 32768;
+
+            s = MPP_MIN(MPP_MAX(s, 0), ((RK_S64)size - 1) << 16);
+            m->pos  = (RK_S32)(s >> 16);
+            m->coef = (RK_S32)(s >> 8) & 0xff;
+            if (m->pos >= size - 1) {
+                m->pos  = MPP_MAX(size - 2, 0);
+                m->coef = (size > 1) ? 256 : 0;
+            }
+            m->end  = MPP_MIN(m->pos + 2, size);
+        } else {
+            RK_S32 cnt;
+
+            m->pos  = (RK_S32)((off + i * len / n) >> 16);
+            m->end  = (RK_S32)((off + (i + 1) * len / n) >> 16);
+            m->pos  = MPP_MIN(m->pos, size - 1);
+            m->end  = MPP_MIN(MPP_MAX(m->end, m->pos + 1), size);
+            cnt     = m->end - m->pos;
+            m->coef = (65536 + cnt / 2) / cnt;
+        }
+    }
+}
+
+static MPP_RET isp_setup_maps(MppIspImpl *p)
+{
+    IspJob *job = &p->job;
+    RK_S32 line_size = job->plane[0].width + ISP_LINE_PADDING;
+    RK_S32 i;
+
+    if (p->map_x_size < job->width) {
+        for (i = 0; i < 2; i++) {
+            p->map_x[i] = mpp_realloc(p->map_x[i], IspMap, job->width);
+            if (NULL == p->map_x[i])
+                break;
+        }
+        p->map_x_size = (i == 2) ? job->width : 0;
+    }
+    if (p->map_y_size < job->height) {
+        for (i = 0; i < 2; i++) {
+            p->map_y[i] = mpp_realloc(p->map_y[i], IspMap, job->height);
+            if (NULL == p->map_y[i])
+                break;
+        }
+        p->map_y_size = (i == 2) ? job->height : 0;
+    }
+    if (p->line_size < line_size) {
+        for (i = 0; i < 3; i++) {
+            MPP_FREE(p->line[i]);
+            p->line[i] = mpp_calloc(RK_U8, line_size);
+        }
+        MPP_FREE(p->acc);
+        p->acc = mpp_calloc(RK_U32, line_size);
+        p->line_size = line_size;
+        if (!p->line[0] || !p->line[1] || !p->line[2] || !p->acc)
+            p->line_size = 0;
+    }
+    if (!p->map_x_size || !p->map_y_size || !p->line_size) {
+        mpp_err_f("failed to malloc isp line buffer\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    isp_build_map(p->map_x[0], job->width,
+                  (RK_S64)job->crop_x << 16, (RK_S64)job->crop_w << 16,
+                  job->plane[0].width, job->scale_mode);
+    isp_build_map(p->map_y[0], job->height,
+                  (RK_S64)job->crop_y << 16, (RK_S64)job->crop_h << 16,
+                  job->plane[0].height, job->scale_mode);
+    isp_build_map(p->map_x[1], job->width,
+                  (RK_S64)job->crop_x << (16 - job->shift_x),
+                  (RK_S64)job->crop_w << (16 - job->shift_x),
+                  job->plane[1].width, job->scale_mode);
+    isp_build_map(p->map_y[1], job->height,
+                  (RK_S64)job->crop_y << (16 - job->shift_y),
+                  (RK_S64)job->crop_h << (16 - job->shift_y),
+                  job->plane[1].height, job->scale_mode);
+    return MPP_OK;
+}
+
+/*
+ * vertical filter of n samples from base on plane to line buffer. Returns
+ * the source row directly when there is nothing to filter.
+ */
+static const RK_U8 *isp_filter_ver(const IspPlane *plane, const IspMap *m,
+                                   RK_S32 mode, RK_S32 base, RK_S32 n,
+                                   RK_U8 *line, RK_U32 *acc)
+{
+    const RK_S32 step = plane->step;
+    const RK_U8 *src = plane->ptr + m->pos * plane->stride + base * step;
+    RK_S32 i;
+
+    if (mode == MPP_ISP_SCALE_BILINEAR) {
+        const RK_U8 *src1 = (m->end - m->pos > 1) ? src + plane->stride : src;
+        const RK_S32 f1 = m->coef;
+        const RK_S32 f0 = 256 - f1;
+
+        if (!f1) {
+            if (step == 1)
+                return src;
+
+            for (i = 0; i < n; i++)
+                line[i] = src[i * step];
+        } else {
+            for (i = 0; i < n; i++)
+                line[i] = (src[i * step] * f0 + src1[i * step] * f1 + 128) >> 8;
+        }
+    } else {
+        const RK_U32 coef = m->coef;
+        RK_S32 row;
+
+        for (i = 0; i < n; i++)
+            acc[i] = src[i * step];
+
+        for (row = m->pos + 1; row < m->end; row++) {
+            src += plane->stride;
+            for (i = 0; i < n; i++)
+                acc[i] += src[i * step];
+        }
+
+        for (i = 0; i < n; i++)
+            line[i] = (acc[i] * coef + 32768) >> 16;
+    }
+    return line;
+}
+
+/* horizontal filter of n output samples, line starts at source sample base */
+static void isp_filter_hor(RK_U8 *dst, const RK_U8 *line, const IspMap *map,
+                           RK_S32 mode, RK_S32 base, RK_S32 n)
+{
+    RK_S32 i;
+
+    if (mode == MPP_ISP_SCALE_BILINEAR) {
+        for (i = 0; i < n; i++) {
+            const RK_U8 *s = line + map[i].pos - base;
+            const RK_S32 f1 = map[i].coef;
+
+            /* single sample plane has no next sample to blend */
+            const RK_S32 next = map[i].end - map[i].pos - 1;
+
+            dst[i] = (s[0] * (256 - f1) + s[next] * f1 + 128) >> 8;
+        }
+    } else {
+        for (i = 0; i < n; i++) {
+            const RK_U8 *s = line + map[i].pos - base;
+            const RK_S32 cnt = map[i].end - map[i].pos;
+            RK_U32 sum = 0;
+            RK_S32 k;
+
+            for (k = 0; k < cnt; k++)
+                sum += s[k];
+
+            dst[i] = (sum * map[i].coef + 32768) >> 16;
+        }
+    }
+}
+
+/* yuv to rgb of n pixels packed to dst */
+static void isp_pack_rgb(RK_U8 *dst, const RK_U8 *y, const RK_U8 *u,
+                         const RK_U8 *v, RK_S32 n, MppFrameFormat fmt,
+                         const IspCsc *csc)
+{
+    const RK_S32 cy = csc->y;
+    const RK_S32 yoff = csc->y_off;
+    const RK_S32 rv = csc->rv;
+    const RK_S32 gu = csc->gu;
+    const RK_S32 gv = csc->gv;
+    const RK_S32 bu = csc->bu;
+    const RK_S32 swap = (fmt == MPP_FMT_BGR565 || fmt == MPP_FMT_BGR888 ||
+                         fmt == MPP_FMT_ABGR8888);
+    RK_S32 i;
+
+    switch (fmt) {
+    case MPP_FMT_RGB565 :
+    case MPP_FMT_BGR565 : {
+        RK_U16 *d = (RK_U16 *)dst;
+
+        for (i = 0; i < n; i++) {
+            RK_S32 l = (y[i] - yoff) * cy + 8192;
+            RK_S32 cb = u[i] - 128;
+            RK_S32 cr = v[i] - 128;
+            RK_S32 r = (l + rv * cr) >> 14;
+            RK_S32 g = (l - gu * cb - gv * cr) >> 14;
+            RK_S32 b = (l + bu * cb) >> 14;
+            RK_S32 hi, lo;
+
+            r = ISP_CLIP8(r);
+            g = ISP_CLIP8(g);
+            b = ISP_CLIP8(b);
+            hi = swap ? b : r;
+            lo = swap ? r : b;
+            d[i] = (RK_U16)(((hi >> 3) << 11) | ((g >> 2) << 5) | (lo >> 3));
+        }
+    } break;
+    case MPP_FMT_RGB888 :
+    case MPP_FMT_BGR888 : {
+        RK_U8 *d = dst;
+
+        for (i = 0; i < n; i++, d += 3) {
+            RK_S32 l = (y[i] - yoff) * cy + 8192;
+            RK_S32 cb = u[i] - 128;
+            RK_S32 cr = v[i] - 128;
+            RK_S32 r = (l + rv * cr) >> 14;
+            RK_S32 g = (l - gu * cb - gv * cr) >> 14;
+            RK_S32 b = (l + bu * cb) >> 14;
+
+            r = ISP_CLIP8(r);
+            g = ISP_CLIP8(g);
+            b = ISP_CLIP8(b);
+            d[0] = (RK_U8)(swap ? b : r);
+            d[1] = (RK_U8)g;
+            d[2] = (RK_U8)(swap ? r : b);
+        }
+    } break;
+    case MPP_FMT_ARGB8888 :
+    case MPP_FMT_ABGR8888 : {
+        RK_U32 *d = (RK_U32 *)dst;
+
+        for (i = 0; i < n; i++) {
+            RK_S32 l = (y[i] - yoff) * cy + 8192;
+            RK_S32 cb = u[i] - 128;
+            RK_S32 cr = v[i] - 128;
+            RK_S32 r = (l + rv * cr) >> 14;
+            RK_S32 g = (l - gu * cb - gv * cr) >> 14;
+            RK_S32 b = (l + bu * cb) >> 14;
+            RK_U32 hi, lo;
+
+            r = ISP_CLIP8(r);
+            g = ISP_CLIP8(g);
+            b = ISP_CLIP8(b);
+            hi = swap ? b : r;
+            lo = swap ? r : b;
+            d[i] = 0xff000000 | (hi << 16) | ((RK_U32)g << 8) | lo;
+        }
+    } break;
+    default : {
+    } break;
+    }
+}
+
+/* one tile of output row: vertical filter, horizontal filter, then pack */
+static void isp_run_tile(MppIspImpl *p, RK_S32 y, RK_S32 x0, RK_S32 n, RK_U8 *dst)
+{
+    IspJob *job = &p->job;
+    RK_U8 out[3][ISP_TILE_WIDTH];
+    const RK_U8 *pix[3];
+    RK_S32 i;
+
+    for (i = 0; i < 3; i++) {
+        const RK_S32 c = (i > 0);
+        const IspMap *mx = p->map_x[c] + x0;
+        const IspMap *my = p->map_y[c] + y;
+        const RK_S32 base = mx[0].pos;
+        const RK_S32 span = mx[n - 1].end - base;
+        const RK_U8 *line = isp_filter_ver(&job->plane[i], my, job->scale_mode,
+                                           base, span, p->line[i], p->acc);
+
+        /* luma without horizontal scaling is used as filtered */
+        if (!c && job->scale_mode == MPP_ISP_SCALE_BILINEAR &&
+            job->width == job->crop_w) {
+            pix[i] = line + (job->crop_x + x0 - base);
+            continue;
+        }
+
+        isp_filter_hor(out[i], line, mx, job->scale_mode, base, n);
+        pix[i] = out[i];
+    }
+
+    isp_pack_rgb(dst, pix[0], pix[1], pix[2], n, job->format, job->csc);
+}
+
+static MPP_RET isp_run(MppIspImpl *p, MppBuffer buffer)
+{
+    IspJob *job = &p->job;
+    RK_U8 *dst = (RK_U8 *)mpp_buffer_get_ptr(buffer);
+    RK_S32 y, x;
+    MPP_RET ret;
+
+    if (mpp_buffer_get_size(buffer) < (size_t)(job->hor_stride * job->height)) {
+        mpp_err_f("output buffer size %d is less than %d\n",
+                  (RK_S32)mpp_buffer_get_size(buffer), job->hor_stride * job->height);
+        return MPP_ERR_VALUE;
+    }
+
+    ret = isp_setup_maps(p);
+    if (ret)
+        return ret;
+
+    for (y = 0; y < job->height; y++, dst += job->hor_stride) {
+        for (x = 0; x < job->width; x += ISP_TILE_WIDTH) {
+            RK_S32 n = MPP_MIN(ISP_TILE_WIDTH, job->width - x);
+
+            isp_run_tile(p, y, x, n, dst + x * job->bpp);
+        }
+    }
+    return MPP_OK;
+}
+
+static void isp_setup_frame(MppFrame frame, IspJob *job)
+{
+    mpp_frame_set_fmt(frame, job->format);
+    mpp_frame_set_width(frame, job->width);
+    mpp_frame_set_height(frame, job->height);
+    mpp_frame_set_hor_stride(frame, job->hor_stride);
+    mpp_frame_set_ver_stride(frame, job->height);
+}
+
+MPP_RET mpp_isp_init(MppIsp *isp)
+{
+    MppIspImpl *p = NULL;
+
+    if (NULL == isp) {
+        mpp_err_f("found NULL input isp\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    *isp = NULL;
+    mpp_env_get_u32("mpp_isp_debug", &mpp_isp_debug, 0);
+
+    p = mpp_calloc(MppIspImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    if (mpp_buffer_group_get_internal(&p->group, MPP_BUFFER_TYPE_ION)) {
+        mpp_err_f("failed to get buffer group\n");
+        mpp_free(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    p->lock = new Mutex();
+    p->cfg.format = MPP_FMT_ARGB8888;
+    p->cfg.scale_mode = MPP_ISP_SCALE_BILINEAR;
+
+    *isp = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_isp_deinit(MppIsp isp)
+{
+    MppIspImpl *p = (MppIspImpl *)isp;
+    RK_S32 i;
+
+    if (NULL == p) {
+        mpp_err_f("found NULL input isp\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    for (i = 0; i < 2; i++) {
+        MPP_FREE(p->map_x[i]);
+        MPP_FREE(p->map_y[i]);
+    }
+    for (i = 0; i < 3; i++)
+        MPP_FREE(p->line[i]);
+    MPP_FREE(p->acc);
+
+    if (p->group) {
+        mpp_buffer_group_put(p->group);
+        p->group = NULL;
+    }
+    delete p->lock;
+    mpp_free(p);
+    return MPP_OK;
+}
+
+MPP_RET mpp_isp_control(MppIsp isp, MpiCmd cmd, void *param)
+{
+    MppIspImpl *p = (MppIspImpl *)isp;
+    MPP_RET ret = MPP_OK;
+
+    if (NULL == p || NULL == param) {
+        mpp_err_f("found NULL input isp %p param %p\n", p, param);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    AutoMutex autoLock(p->lock);
+
+    switch (cmd) {
+    case MPP_ISP_SET_CFG : {
+        MppIspConfig *cfg = (MppIspConfig *)param;
+
+        ret = isp_check_config(cfg);
+        if (MPP_OK == ret)
+            p->cfg = *cfg;
+    } break;
+    case MPP_ISP_GET_CFG : {
+        *(MppIspConfig *)param = p->cfg;
+    } break;
+    default : {
+        mpp_err_f("unsupported cmd %x\n", cmd);
+        ret = MPP_NOK;
+    } break;
+    }
+    return ret;
+}
+
+MPP_RET mpp_isp_process(MppIsp isp, MppFrame dst, MppFrame src)
+{
+    MppIspImpl *p = (MppIspImpl *)isp;
+    MppBuffer buffer = NULL;
+    MPP_RET ret;
+
+    if (NULL == p || NULL == dst || NULL == src) {
+        mpp_err_f("found NULL input isp %p dst %p src %p\n", p, dst, src);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    buffer = mpp_frame_get_buffer(dst);
+    if (NULL == buffer) {
+        mpp_err_f("found NULL buffer in output frame\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    isp_dbg_func("enter dst %p src %p\n", dst, src);
+
+    AutoMutex autoLock(p->lock);
+
+    ret = isp_setup_job(p, dst, src);
+    if (MPP_OK == ret)
+        ret = isp_run(p, buffer);
+    if (MPP_OK == ret)
+        isp_setup_frame(dst, &p->job);
+
+    isp_dbg_func("leave ret %d\n", ret);
+    return ret;
+}
+
+MPP_RET mpp_isp_convert(MppIsp isp, MppFrame frame)
+{
+    MppIspImpl *p = (MppIspImpl *)isp;
+    MppBuffer buffer = NULL;
+    MPP_RET ret;
+
+    if (NULL == p || NULL == frame) {
+        mpp_err_f("found NULL input isp %p frame %p\n", p, frame);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    isp_dbg_func("enter frame %p\n", frame);
+
+    AutoMutex autoLock(p->lock);
+
+    ret = isp_setup_job(p, NULL, frame);
+    if (ret)
+        return ret;
+
+    ret = mpp_buffer_get(p->group, &buffer, p->job.hor_stride * p->job.height);
+    if (ret) {
+        mpp_err_f("failed to get output buffer\n");
+        return ret;
+    }
+
+    ret = isp_run(p, buffer);
+    if (MPP_OK == ret) {
+        /* frame takes the output buffer and releases the source one */
+        mpp_frame_set_buffer(frame, buffer);
+        isp_setup_frame(frame, &p->job);
+    }
+    mpp_buffer_put(buffer);
+
+    isp_dbg_func("leave ret %d\n", ret);
+    return ret;
+}
+
+void *mpp_isp_thread(void *data)
+{
+    Mpp *mpp = (Mpp *)data;
+    MppThread *thd = mpp->mThreadCodec;
+    mpp_list *input = mpp->mFrames;
+    mpp_list *output = mpp->mIspFrames;
+
+    while (MPP_THREAD_RUNNING == thd->get_status()) {
+        MppFrame frame = NULL;
+
+        /*
+         * isp thread need to wait at cases below:
+         * 1. no input frame from user
+         * 2. user still holds too many converted frames
+         */
+        thd->lock();
+        if (MPP_THREAD_RUNNING == thd->get_status()) {
+            RK_S32 pending = 0;
+
+            output->lock();
+            pending = output->list_size();
+            output->unlock();
+
+            if (pending < ISP_OUTPUT_MAX_COUNT) {
+                input->lock();
+                if (input->list_size())
+                    input->del_at_head(&frame, sizeof(frame));
+                input->unlock();
+            }
+
+            if (NULL == frame)
+                thd->wait();
+        }
+        thd->unlock();
+
+        if (NULL == frame)
+            continue;
+
+        /* reset flushes both lists, hold it until the frame is sent out */
+        thd->lock(THREAD_RESET);
+        if (mpp_frame_get_buffer(frame)) {
+            MPP_RET ret = mpp_isp_convert(mpp->mIsp, frame);
+
+            if (ret) {
+                mpp_err("isp convert failed ret %d\n", ret);
+                mpp_frame_set_errinfo(frame, 1);
+            }
+        }
+
+        output->lock();
+        output->add_at_tail(&frame, sizeof(frame));
+        mpp->mFramePutCount++;
+        output->signal();
+        output->unlock();
+        thd->unlock(THREAD_RESET);
+    }
+
+    return NULL;
+}
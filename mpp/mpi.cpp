@@ -72,6 +72,7 @@ static MppCodingTypeInfo support_list[] = {
 #if HAVE_JPEGE
     {   MPP_CTX_ENC,    MPP_VIDEO_CodingMJPEG,  "enc",  "jpeg",         },
 #endif
+    {   MPP_CTX_ISP,    MPP_VIDEO_CodingUnused, "isp",  "yuv to rgb",   },
 };
 
 #define check_mpp_ctx(ctx)  _check_mpp_ctx(ctx, __FUNCTION__)
@@ -101,7 +102,8 @@ static MPP_RET mpi_decode(MppCtx ctx, MppPacket packet, MppFrame *frame)
             ret = MPP_ERR_NULL_PTR;
             break;
         }
-        // TODO: do decode here
+
+        ret = p->ctx->decode(packet, frame);
     } while (0);
 
     mpi_dbg_func("leave ret %d\n", ret);
@@ -173,7 +175,7 @@ static MPP_RET mpi_encode(MppCtx ctx, MppFrame frame, MppPacket *packet)
             break;
         }
 
-        // TODO: do encode here
+        ret = p->ctx->encode(frame, packet);
     } while (0);
 
     mpi_dbg_func("leave ret %d\n", ret);
@@ -230,21 +232,47 @@ static MPP_RET mpi_encode_get_packet(MppCtx ctx, MppPacket *packet)
 
 static MPP_RET mpi_isp(MppCtx ctx, MppFrame dst, MppFrame src)
 {
-    MPP_RET ret = MPP_OK;
+    MPP_RET ret = MPP_NOK;
+    MpiImpl *p = (MpiImpl *)ctx;
+
     mpi_dbg_func("enter ctx %p dst %p src %p\n", ctx, dst, src);
+    do {
+        ret = check_mpp_ctx(p);
+        if (ret)
+            break;
 
-    // TODO: do isp process here
+        if (NULL == dst || NULL == src) {
+            mpp_err_f("found NULL input dst %p src %p\n", dst, src);
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        ret = p->ctx->isp(dst, src);
+    } while (0);
 
     mpi_dbg_func("leave ret %d\n", ret);
-    return MPP_OK;
+    return ret;
 }
 
 static MPP_RET mpi_isp_put_frame(MppCtx ctx, MppFrame frame)
 {
-    MPP_RET ret = MPP_OK;
+    MPP_RET ret = MPP_NOK;
+    MpiImpl *p = (MpiImpl *)ctx;
+
     mpi_dbg_func("enter ctx %p frame %p\n", ctx, frame);
+    do {
+        ret = check_mpp_ctx(p);
+        if (ret)
+            break;
+
+        if (NULL == frame) {
+            mpp_err_f("found NULL input frame\n");
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
 
-    // TODO: do isp put frame process here
+        ret = p->ctx->isp_put_frame(frame);
+    } while (0);
 
     mpi_dbg_func("leave ret %d\n", ret);
     return ret;
@@ -252,10 +280,23 @@ static MPP_RET mpi_isp_put_frame(MppCtx ctx, MppFrame frame)
 
 static MPP_RET mpi_isp_get_frame(MppCtx ctx, MppFrame *frame)
 {
-    MPP_RET ret = MPP_OK;
+    MPP_RET ret = MPP_NOK;
+    MpiImpl *p = (MpiImpl *)ctx;
+
     mpi_dbg_func("enter ctx %p frame %p\n", ctx, frame);
+    do {
+        ret = check_mpp_ctx(p);
+        if (ret)
+            break;
 
-    // TODO: do isp get frame process here
+        if (NULL == frame) {
+            mpp_err_f("found NULL input frame\n");
+            ret = MPP_ERR_NULL_PTR;
+            break;
+        }
+
+        ret = p->ctx->isp_get_frame(frame);
+    } while (0);
 
     mpi_dbg_func("leave ret %d\n", ret);
     return ret;
@@ -16,6 +16,8 @@
 
 #define  MODULE_TAG "mpp"
 
+#include <string.h>
+
 #include "mpp_log.h"
 #include "mpp_mem.h"
 #include "mpp_env.h"
@@ -37,6 +39,7 @@ Mpp::Mpp()
     : mPackets(NULL),
       mFrames(NULL),
       mTasks(NULL),
+      mIspFrames(NULL),
       mPacketPutCount(0),
       mPacketGetCount(0),
       mFramePutCount(0),
@@ -54,19 +57,28 @@ Mpp::Mpp()
       mThreadHal(NULL),
       mDec(NULL),
       mEnc(NULL),
+      mIsp(NULL),
       mType(MPP_CTX_BUTT),
       mCoding(MPP_VIDEO_CodingUnused),
       mInitDone(0),
       mPacketBlock(0),
-      mInputBlock(0),
-      mOutputBlock(0),
+      mInputTimeout(MPP_POLL_NON_BLOCK),
+      mOutputTimeout(MPP_POLL_NON_BLOCK),
       mMultiFrame(0),
       mInputTask(NULL),
       mStatus(0),
+      mSyncMode(0),
+      mAsyncUsed(0),
+      mWorkerMode(0),
+      mWorker(NULL),
       mParserFastMode(0),
       mParserNeedSplit(0),
-      mParserInternalPts(0)
+      mParserInternalPts(0),
+      mDecTaskCount(0),
+      mDecIspEnable(0),
+      mEncTaskCount(0)
 {
+    memset(&mDecIspCfg, 0, sizeof(mDecIspCfg));
 }
 
 MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
@@ -89,14 +101,27 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
             mParserFastMode,
             mParserNeedSplit,
             mParserInternalPts,
+            mDecTaskCount,
+            (mDecIspEnable) ? (&mDecIspCfg) : (NULL),
             this,
         };
         mpp_dec_init(&mDec, &cfg);
+        if (NULL == mDec)
+            break;
+
+        /* env mpp_dec_worker enables worker pool for all decoders */
+        if (!mWorkerMode)
+            mpp_env_get_u32("mpp_dec_worker", &mWorkerMode, 0);
 
         if (mCoding != MPP_VIDEO_CodingMJPEG) {
             mThreadCodec = new MppThread(mpp_dec_parser_thread, this, "mpp_dec_parser");
             mThreadHal  = new MppThread(mpp_dec_hal_thread, this, "mpp_dec_hal");
 
+            if (mWorkerMode && MPP_OK == mpp_worker_get(&mWorker)) {
+                mThreadCodec->set_worker(mWorker, mpp_dec_parser_step, mpp_dec_parser_step_done);
+                mThreadHal->set_worker(mWorker, mpp_dec_hal_step);
+            }
+
             mpp_buffer_group_get_internal(&mPacketGroup, MPP_BUFFER_TYPE_ION);
             mpp_buffer_group_limit_config(mPacketGroup, 0, 3);
 
@@ -106,11 +131,12 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
             mpp_task_queue_setup(mOutputTaskQueue, 4);
         } else {
             mThreadCodec = new MppThread(mpp_dec_advanced_thread, this, "mpp_dec_parser");
+            mThreadHal  = new MppThread(mpp_dec_advanced_hal_thread, this, "mpp_dec_hal");
 
             mpp_task_queue_init(&mInputTaskQueue);
             mpp_task_queue_init(&mOutputTaskQueue);
-            mpp_task_queue_setup(mInputTaskQueue, 1);
-            mpp_task_queue_setup(mOutputTaskQueue, 1);
+            mpp_task_queue_setup(mInputTaskQueue, mDec->task_count);
+            mpp_task_queue_setup(mOutputTaskQueue, mDec->task_count);
         }
     } break;
     case MPP_CTX_ENC : {
@@ -118,32 +144,51 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mPackets    = new mpp_list((node_destructor)mpp_packet_deinit);
         mTasks      = new mpp_list((node_destructor)NULL);
 
-        mpp_enc_init(&mEnc, coding);
+        mpp_enc_init(&mEnc, coding, mEncTaskCount);
+        if (NULL == mEnc)
+            break;
+
         mThreadCodec = new MppThread(mpp_enc_control_thread, this, "mpp_enc_ctrl");
-        //mThreadHal  = new MppThread(mpp_enc_hal_thread, this, "mpp_enc_hal");
 
         mpp_buffer_group_get_internal(&mPacketGroup, MPP_BUFFER_TYPE_ION);
         mpp_buffer_group_get_internal(&mFrameGroup, MPP_BUFFER_TYPE_ION);
 
+        /* wake up control thread when user releases output packet */
+        mpp_buffer_group_set_listener((MppBufferGroupImpl *)mPacketGroup, (void *)mThreadCodec);
+
+        /* user can queue task_count frames ahead of encoder */
         mpp_task_queue_init(&mInputTaskQueue);
         mpp_task_queue_init(&mOutputTaskQueue);
-        mpp_task_queue_setup(mInputTaskQueue, 1);
-        mpp_task_queue_setup(mOutputTaskQueue, 1);
+        mpp_task_queue_setup(mInputTaskQueue, mEnc->task_count);
+        mpp_task_queue_setup(mOutputTaskQueue, mEnc->task_count);
+    } break;
+    case MPP_CTX_ISP : {
+        mFrames     = new mpp_list((node_destructor)mpp_frame_deinit);
+        mIspFrames  = new mpp_list((node_destructor)mpp_frame_deinit);
+
+        mpp_isp_init(&mIsp);
+        if (NULL == mIsp)
+            break;
+
+        mThreadCodec = new MppThread(mpp_isp_thread, this, "mpp_isp");
     } break;
     default : {
         mpp_err("Mpp error type %d\n", mType);
     } break;
     }
 
-    mInputPort  = mpp_task_queue_get_port(mInputTaskQueue,  MPP_PORT_INPUT);
-    mOutputPort = mpp_task_queue_get_port(mOutputTaskQueue, MPP_PORT_OUTPUT);
+    if (mInputTaskQueue && mOutputTaskQueue) {
+        mInputPort  = mpp_task_queue_get_port(mInputTaskQueue,  MPP_PORT_INPUT);
+        mOutputPort = mpp_task_queue_get_port(mOutputTaskQueue, MPP_PORT_OUTPUT);
+    }
 
     if (mCoding == MPP_VIDEO_CodingMJPEG &&
         mFrames && mPackets &&
         (mDec) &&
-        mThreadCodec/* &&
+        mThreadCodec && mThreadHal/* &&
         mPacketGroup*/) {
         mThreadCodec->start();
+        mThreadHal->start();
         mInitDone = 1;
     } else if (mFrames && mPackets &&
                (mDec) &&
@@ -154,10 +199,14 @@ MPP_RET Mpp::init(MppCtxType type, MppCodingType coding)
         mInitDone = 1;
     } else if (mFrames && mPackets &&
                (mEnc) &&
-               mThreadCodec/* && mThreadHal */ &&
+               mThreadCodec &&
                mPacketGroup) {
         mThreadCodec->start();
-        //mThreadHal->start();  // TODO
+        mInitDone = 1;
+    } else if (mFrames && mIspFrames &&
+               (mIsp) &&
+               mThreadCodec) {
+        mThreadCodec->start();
         mInitDone = 1;
     } else {
         mpp_err("error found on mpp initialization\n");
@@ -178,12 +227,18 @@ void Mpp::clear()
     // MUST: release listener here
     if (mFrameGroup)
         mpp_buffer_group_set_listener((MppBufferGroupImpl *)mFrameGroup, NULL);
+    if (mType == MPP_CTX_ENC && mPacketGroup)
+        mpp_buffer_group_set_listener((MppBufferGroupImpl *)mPacketGroup, NULL);
 
     if (mThreadCodec)
         mThreadCodec->stop();
     if (mThreadHal)
         mThreadHal->stop();
 
+    /* release the parser task kept by synchronous decode steps */
+    if (mSyncMode && mDec && mCoding != MPP_VIDEO_CodingMJPEG)
+        mpp_dec_parser_step_done(this);
+
     if (mThreadCodec) {
         delete mThreadCodec;
         mThreadCodec = NULL;
@@ -192,6 +247,10 @@ void Mpp::clear()
         delete mThreadHal;
         mThreadHal = NULL;
     }
+    if (mWorker) {
+        mpp_worker_put(mWorker);
+        mWorker = NULL;
+    }
 
     if (mInputTaskQueue) {
         mpp_task_queue_deinit(mInputTaskQueue);
@@ -214,6 +273,14 @@ void Mpp::clear()
             mEnc = NULL;
         }
     }
+    if (mIspFrames) {
+        delete mIspFrames;
+        mIspFrames = NULL;
+    }
+    if (mIsp) {
+        mpp_isp_deinit(mIsp);
+        mIsp = NULL;
+    }
     if (mPackets) {
         delete mPackets;
         mPackets = NULL;
@@ -238,9 +305,11 @@ void Mpp::clear()
 
 MPP_RET Mpp::put_packet(MppPacket packet)
 {
-    if (!mInitDone)
+    if (!mInitDone || mSyncMode)
         return MPP_NOK;
 
+    mAsyncUsed = 1;
+
     AutoMutex autoLock(mPackets->mutex());
     RK_U32 eos = mpp_packet_get_eos(packet);
 
@@ -263,7 +332,7 @@ MPP_RET Mpp::put_packet(MppPacket packet)
 
 MPP_RET Mpp::get_frame(MppFrame *frame)
 {
-    if (!mInitDone)
+    if (!mInitDone || mSyncMode)
         return MPP_NOK;
 
     AutoMutex autoLock(mFrames->mutex());
@@ -271,9 +340,10 @@ MPP_RET Mpp::get_frame(MppFrame *frame)
 
     if (0 == mFrames->list_size()) {
         mThreadCodec->signal();
-        if (mOutputBlock)
+        if (mOutputTimeout < 0)
             mFrames->wait();
-        msleep(1);
+        else if (mOutputTimeout)
+            mFrames->wait(mOutputTimeout);
     }
 
     if (mFrames->list_size()) {
@@ -307,17 +377,17 @@ MPP_RET Mpp::put_frame(MppFrame frame)
 
     do {
         if (NULL == task) {
-            ret = dequeue(MPP_PORT_INPUT, &task);
+            ret = poll(MPP_PORT_INPUT, mInputTimeout);
             if (ret) {
-                mpp_log_f("failed to dequeue from input port ret %d\n", ret);
+                mpp_dbg_f(MPP_DBG_FRAME, "poll on input port timeout %lld ret %d\n", mInputTimeout, ret);
                 break;
             }
-        }
 
-        /* FIXME: use wait to do block wait */
-        if (mInputBlock && NULL == task) {
-            msleep(2);
-            continue;
+            ret = dequeue(MPP_PORT_INPUT, &task);
+            if (ret || NULL == task) {
+                mpp_log_f("failed to dequeue from input port ret %d\n", ret);
+                break;
+            }
         }
 
         mpp_assert(task);
@@ -334,9 +404,14 @@ MPP_RET Mpp::put_frame(MppFrame frame)
             break;
         }
 
-        if (mInputBlock) {
-            while (MPP_NOK == mpp_port_can_dequeue(mInputPort)) {
-                msleep(2);
+        task = NULL;
+
+        if (mInputTimeout) {
+            /* wait until the task is processed and returned to input port */
+            ret = poll(MPP_PORT_INPUT, mInputTimeout);
+            if (ret) {
+                mpp_dbg_f(MPP_DBG_FRAME, "poll on input port timeout %lld ret %d\n", mInputTimeout, ret);
+                break;
             }
 
             ret = dequeue(MPP_PORT_INPUT, &task);
@@ -369,27 +444,23 @@ MPP_RET Mpp::get_packet(MppPacket *packet)
     MPP_RET ret = MPP_OK;
     MppTask task = NULL;
 
+    *packet = NULL;
+
     do {
-        if (NULL == task) {
-            ret = dequeue(MPP_PORT_OUTPUT, &task);
-            if (ret) {
-                mpp_log_f("failed to dequeue from output port ret %d\n", ret);
-                break;
-            }
+        ret = poll(MPP_PORT_OUTPUT, mOutputTimeout);
+        if (ret) {
+            /* empty output port on non-block mode is not an error */
+            if (MPP_POLL_NON_BLOCK == mOutputTimeout)
+                ret = MPP_OK;
+            break;
         }
 
-        /* FIXME: use wait to do block wait */
-        if (NULL == task) {
-            if (mOutputBlock) {
-                msleep(2);
-                continue;
-            } else {
-                break;
-            }
+        ret = dequeue(MPP_PORT_OUTPUT, &task);
+        if (ret || NULL == task) {
+            mpp_log_f("failed to dequeue from output port ret %d\n", ret);
+            break;
         }
 
-        mpp_assert(task);
-
         ret = mpp_task_meta_get_packet(task, KEY_OUTPUT_PACKET, packet);
         if (ret) {
             mpp_log_f("failed to get output packet from task ret %d\n", ret);
@@ -405,65 +476,248 @@ MPP_RET Mpp::get_packet(MppPacket *packet)
         if (ret) {
             mpp_log_f("failed to enqueue task to output port ret %d\n", ret);
         }
+    } while (0);
 
-        break;
-    } while (1);
+    return ret;
+}
+
+MPP_RET Mpp::start_sync()
+{
+    if (mSyncMode)
+        return MPP_OK;
+
+    if (mAsyncUsed) {
+        mpp_err("can not switch to synchronous mode after async interface is used\n");
+        return MPP_NOK;
+    }
+
+    /* threads are idle without input, stop them and run their steps here */
+    mThreadCodec->stop();
+    if (mThreadHal)
+        mThreadHal->stop();
+    mSyncMode = 1;
+
+    return MPP_OK;
+}
+
+MPP_RET Mpp::decode(MppPacket packet, MppFrame *frame)
+{
+    if (!mInitDone || mType != MPP_CTX_DEC)
+        return MPP_NOK;
+
+    MPP_RET ret = start_sync();
+    if (ret)
+        return ret;
+
+    *frame = NULL;
+
+    ret = mpp_dec_decode(this, packet);
+
+    /* frames left in list are returned on the following calls */
+    AutoMutex autoLock(mFrames->mutex());
+    if (mFrames->list_size()) {
+        MppFrame first = NULL;
+
+        mFrames->del_at_head(&first, sizeof(first));
+        mFrameGetCount++;
+
+        if (mMultiFrame) {
+            MppFrame prev = first;
+            MppFrame next = NULL;
+            while (mFrames->list_size()) {
+                mFrames->del_at_head(&next, sizeof(next));
+                mFrameGetCount++;
+                mpp_frame_set_next(prev, next);
+                prev = next;
+            }
+        }
+        *frame = first;
+    }
 
     return ret;
 }
 
+MPP_RET Mpp::encode(MppFrame frame, MppPacket *packet)
+{
+    if (!mInitDone || mType != MPP_CTX_ENC)
+        return MPP_NOK;
+
+    MPP_RET ret = start_sync();
+    if (ret)
+        return ret;
+
+    return mpp_enc_encode(this, frame, packet);
+}
+
+MPP_RET Mpp::isp(MppFrame dst, MppFrame src)
+{
+    if (!mInitDone || mType != MPP_CTX_ISP)
+        return MPP_NOK;
+
+    return mpp_isp_process(mIsp, dst, src);
+}
+
+MPP_RET Mpp::isp_put_frame(MppFrame frame)
+{
+    if (!mInitDone || mType != MPP_CTX_ISP)
+        return MPP_NOK;
+
+    {
+        AutoMutex autoLock(mFrames->mutex());
+
+        if (mFrames->list_size() >= 4 && !mpp_frame_get_eos(frame))
+            return MPP_NOK;
+
+        MppBuffer buffer = mpp_frame_get_buffer(frame);
+        MppFrame frm = NULL;
+
+        if (MPP_OK != mpp_frame_init(&frm))
+            return MPP_NOK;
+
+        /* isp holds the source buffer until the frame is converted */
+        mpp_frame_copy(frm, frame);
+        if (buffer)
+            mpp_buffer_inc_ref(buffer);
+
+        mFrames->add_at_tail(&frm, sizeof(frm));
+    }
+
+    /*
+     * isp thread takes the list lock under its thread lock so the list lock
+     * must be released before signaling the thread
+     */
+    mThreadCodec->lock();
+    mThreadCodec->signal();
+    mThreadCodec->unlock();
+    return MPP_OK;
+}
+
+MPP_RET Mpp::isp_get_frame(MppFrame *frame)
+{
+    if (!mInitDone || mType != MPP_CTX_ISP)
+        return MPP_NOK;
+
+    MppFrame frm = NULL;
+
+    {
+        AutoMutex autoLock(mIspFrames->mutex());
+
+        if (0 == mIspFrames->list_size()) {
+            if (mOutputTimeout < 0)
+                mIspFrames->wait();
+            else if (mOutputTimeout)
+                mIspFrames->wait(mOutputTimeout);
+        }
+
+        if (mIspFrames->list_size()) {
+            mIspFrames->del_at_head(&frm, sizeof(frm));
+            mFrameGetCount++;
+        }
+    }
+
+    /* isp thread may wait for user to take the converted frames */
+    if (frm) {
+        mThreadCodec->lock();
+        mThreadCodec->signal();
+        mThreadCodec->unlock();
+    }
+
+    *frame = frm;
+    return MPP_OK;
+}
+
+MPP_RET Mpp::poll(MppPortType type, RK_S64 timeout)
+{
+    if (!mInitDone || mSyncMode)
+        return MPP_NOK;
+
+    /*
+     * NOTE: do not hold port lock here, otherwise the enqueue from other
+     * thread will be blocked and poll will never return
+     */
+    MppPort port = (type == MPP_PORT_INPUT) ? (mInputPort) :
+                   (type == MPP_PORT_OUTPUT) ? (mOutputPort) : (NULL);
+
+    if (NULL == port)
+        return MPP_NOK;
+
+    return mpp_port_poll(port, timeout);
+}
+
 MPP_RET Mpp::dequeue(MppPortType type, MppTask *task)
 {
-    if (!mInitDone)
+    if (!mInitDone || mSyncMode)
         return MPP_NOK;
 
+    mAsyncUsed = 1;
+
     MPP_RET ret = MPP_NOK;
-    AutoMutex autoLock(mPortLock);
     MppTaskQueue port = NULL;
+    Mutex *lock = NULL;
     switch (type) {
     case MPP_PORT_INPUT : {
         port = mInputPort;
+        lock = &mInputPortLock;
     } break;
     case MPP_PORT_OUTPUT : {
         port = mOutputPort;
+        lock = &mOutputPortLock;
     } break;
     default : {
     } break;
     }
 
-    if (port)
+    if (port) {
+        AutoMutex autoLock(lock);
         ret = mpp_port_dequeue(port, task);
+    }
 
     return ret;
 }
 
 MPP_RET Mpp::enqueue(MppPortType type, MppTask task)
 {
-    if (!mInitDone)
+    if (!mInitDone || mSyncMode)
         return MPP_NOK;
 
     MPP_RET ret = MPP_NOK;
-    AutoMutex autoLock(mPortLock);
     MppTaskQueue port = NULL;
+    Mutex *lock = NULL;
     switch (type) {
     case MPP_PORT_INPUT : {
         port = mInputPort;
+        lock = &mInputPortLock;
     } break;
     case MPP_PORT_OUTPUT : {
         port = mOutputPort;
+        lock = &mOutputPortLock;
     } break;
     default : {
     } break;
     }
 
     if (port) {
-        mThreadCodec->lock();
+        AutoMutex autoLock(lock);
         ret = mpp_port_enqueue(port, task);
-        if (MPP_OK == ret) {
-            // if enqueue success wait up thread
-            mThreadCodec->signal();
-        }
+    }
+
+    if (MPP_OK == ret) {
+        /*
+         * if enqueue success wait up thread
+         * codec thread checks the port under its own lock before waiting so
+         * taking the thread lock around signal is enough to avoid lost wakeup
+         */
+        mThreadCodec->lock();
+        mThreadCodec->signal();
         mThreadCodec->unlock();
+
+        /* task mode decoder hal thread waits for output task returned by user */
+        if (type == MPP_PORT_OUTPUT && mThreadHal &&
+            mType == MPP_CTX_DEC && mCoding == MPP_VIDEO_CodingMJPEG) {
+            mThreadHal->lock();
+            mThreadHal->signal();
+            mThreadHal->unlock();
+        }
     }
 
     return ret;
@@ -493,7 +747,7 @@ MPP_RET Mpp::control(MpiCmd cmd, MppParam param)
             ret = control_dec(cmd, param);
         } break;
         case CMD_CTX_ID_ENC : {
-            mpp_assert(mType == MPP_CTX_ENC);
+            mpp_assert(mType == MPP_CTX_ENC || mType == MPP_CTX_BUTT);
             mpp_assert(cmd > MPP_ENC_CMD_BASE);
             mpp_assert(cmd < MPP_ENC_CMD_END);
 
@@ -528,6 +782,23 @@ MPP_RET Mpp::reset()
 
     MppPacket pkt = NULL;
 
+    if (mType == MPP_CTX_ISP) {
+        /* wait for the frame under conversion then drop all frames */
+        mThreadCodec->lock(THREAD_RESET);
+        mFrames->lock();
+        mFrames->flush();
+        mFrames->unlock();
+        mIspFrames->lock();
+        mIspFrames->flush();
+        mIspFrames->unlock();
+        mThreadCodec->unlock(THREAD_RESET);
+
+        mThreadCodec->lock();
+        mThreadCodec->signal();
+        mThreadCodec->unlock();
+        return MPP_OK;
+    }
+
     /*
      * On mp4 case extra data of sps/pps will be put at the beginning
      * If these packet was reset before they are send to decoder then
@@ -546,29 +817,50 @@ MPP_RET Mpp::reset()
     mFrames->flush();
     mFrames->unlock();
 
-    mThreadCodec->lock(THREAD_RESET);
-
-    if (mType == MPP_CTX_DEC) {
-        mpp_dec_reset(mDec);
+    if (mSyncMode) {
+        /* no codec thread to wait for, parser step does the reset here */
+        if (mType == MPP_CTX_DEC) {
+            mpp_dec_reset(mDec);
 
-        if (mDec->coding != MPP_VIDEO_CodingMJPEG) {
-            mThreadCodec->lock();
-            mThreadCodec->signal();
-            mThreadCodec->unlock();
-            mThreadCodec->wait(THREAD_RESET);
+            if (mDec->coding != MPP_VIDEO_CodingMJPEG)
+                mpp_dec_parser_step(this);
+        } else {
+            mpp_enc_reset(mEnc);
         }
     } else {
-        mpp_enc_reset(mEnc);
+        mThreadCodec->lock(THREAD_RESET);
+
+        if (mType == MPP_CTX_DEC) {
+            mpp_dec_reset(mDec);
+
+            if (mDec->coding != MPP_VIDEO_CodingMJPEG) {
+                mThreadCodec->lock();
+                mThreadCodec->signal();
+                mThreadCodec->unlock();
+                mThreadCodec->wait(THREAD_RESET);
+            }
+        } else {
+            mpp_enc_reset(mEnc);
+        }
+        mThreadCodec->unlock(THREAD_RESET);
     }
-    mThreadCodec->unlock(THREAD_RESET);
 
     if (pkt != NULL) {
         RK_U32 flags = mpp_packet_get_flag(pkt);
 
         if (flags & MPP_PACKET_FLAG_EXTRA_DATA) {
-            put_packet(pkt);
+            if (mSyncMode) {
+                /* decoded with the next packet */
+                mPackets->lock();
+                mPackets->add_at_tail(&pkt, sizeof(pkt));
+                mPackets->unlock();
+                pkt = NULL;
+            } else {
+                put_packet(pkt);
+            }
         }
-        mpp_packet_deinit(&pkt);
+        if (pkt)
+            mpp_packet_deinit(&pkt);
         pkt = NULL;
     }
 
@@ -583,11 +875,27 @@ MPP_RET Mpp::control_mpp(MpiCmd cmd, MppParam param)
     switch (cmd) {
     case MPP_SET_INPUT_BLOCK: {
         RK_U32 block = *((RK_U32 *)param);
-        mInputBlock = block;
+        mInputTimeout = (block) ? (MPP_POLL_BLOCK) : (MPP_POLL_NON_BLOCK);
     } break;
     case MPP_SET_OUTPUT_BLOCK: {
         RK_U32 block = *((RK_U32 *)param);
-        mOutputBlock = block;
+        mOutputTimeout = (block) ? (MPP_POLL_BLOCK) : (MPP_POLL_NON_BLOCK);
+    } break;
+    case MPP_SET_INPUT_TIMEOUT: {
+        RK_S64 timeout = *((RK_S64 *)param);
+        mInputTimeout = (timeout < 0) ? ((RK_S64)MPP_POLL_BLOCK) : (timeout);
+    } break;
+    case MPP_SET_OUTPUT_TIMEOUT: {
+        RK_S64 timeout = *((RK_S64 *)param);
+        mOutputTimeout = (timeout < 0) ? ((RK_S64)MPP_POLL_BLOCK) : (timeout);
+    } break;
+    case MPP_SET_WORKER_MODE: {
+        if (mInitDone) {
+            mpp_err("worker mode must be set before init\n");
+            ret = MPP_NOK;
+            break;
+        }
+        mWorkerMode = *((RK_U32 *)param);
     } break;
     default : {
         ret = MPP_NOK;
@@ -656,6 +964,14 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
         mParserFastMode = flag;
         ret = MPP_OK;
     } break;
+    case MPP_DEC_SET_TASK_COUNT: {
+        if (mInitDone) {
+            mpp_err("decoder task count should be set before init\n");
+            break;
+        }
+        mDecTaskCount = *((RK_S32 *)param);
+        ret = MPP_OK;
+    } break;
     case MPP_DEC_GET_STREAM_COUNT: {
         AutoMutex autoLock(mPackets->mutex());
         *((RK_S32 *)param) = mPackets->list_size();
@@ -667,6 +983,19 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
     case MPP_DEC_SET_OUTPUT_FORMAT: {
         ret = mpp_dec_control(mDec, cmd, param);
     } break;
+    case MPP_DEC_SET_ISP_CFG: {
+        /* isp stage runs on hal thread so it is fixed after init */
+        if (mInitDone) {
+            mpp_err("decoder isp config should be set before init\n");
+            break;
+        }
+        if (param) {
+            mDecIspCfg = *((MppIspConfig *)param);
+            mDecIspEnable = 1;
+        } else
+            mDecIspEnable = 0;
+        ret = MPP_OK;
+    } break;
     default : {
     } break;
     }
@@ -675,19 +1004,28 @@ MPP_RET Mpp::control_dec(MpiCmd cmd, MppParam param)
 
 MPP_RET Mpp::control_enc(MpiCmd cmd, MppParam param)
 {
+    if (MPP_ENC_SET_TASK_COUNT == cmd) {
+        if (mInitDone) {
+            mpp_err("encoder task count should be set before init\n");
+            return MPP_NOK;
+        }
+        mEncTaskCount = *((RK_S32 *)param);
+        return MPP_OK;
+    }
+
     mpp_assert(mEnc);
     return mpp_enc_control(mEnc, cmd, param);
 }
 
 MPP_RET Mpp::control_isp(MpiCmd cmd, MppParam param)
 {
-    MPP_RET ret = MPP_NOK;
-
     mpp_assert(cmd > MPP_ISP_CMD_BASE);
     mpp_assert(cmd < MPP_ISP_CMD_END);
 
-    (void)cmd;
-    (void)param;
-    return ret;
+    if (NULL == mIsp) {
+        mpp_err("isp control %x should be called after init\n", cmd);
+        return MPP_NOK;
+    }
+    return mpp_isp_control(mIsp, cmd, param);
 }
 
@@ -20,6 +20,7 @@
 #include "mpp_list.h"
 #include "mpp_dec.h"
 #include "mpp_enc.h"
+#include "mpp_isp.h"
 #include "mpp_task.h"
 
 #define MPP_DBG_FUNCTION                (0x00000001)
@@ -71,6 +72,16 @@ public:
     MPP_RET put_frame(MppFrame frame);
     MPP_RET get_packet(MppPacket *packet);
 
+    /* synchronous interface, can not be mixed with the async ones above */
+    MPP_RET decode(MppPacket packet, MppFrame *frame);
+    MPP_RET encode(MppFrame frame, MppPacket *packet);
+
+    /* isp interface for MPP_CTX_ISP context */
+    MPP_RET isp(MppFrame dst, MppFrame src);
+    MPP_RET isp_put_frame(MppFrame frame);
+    MPP_RET isp_get_frame(MppFrame *frame);
+
+    MPP_RET poll(MppPortType type, RK_S64 timeout);
     MPP_RET dequeue(MppPortType type, MppTask *task);
     MPP_RET enqueue(MppPortType type, MppTask task);
 
@@ -80,6 +91,8 @@ public:
     mpp_list        *mPackets;
     mpp_list        *mFrames;
     mpp_list        *mTasks;
+    /* converted frames of isp context, mFrames is its input */
+    mpp_list        *mIspFrames;
 
     /* counters for debug */
     RK_U32          mPacketPutCount;
@@ -101,8 +114,11 @@ public:
 
     /*
      * Mpp task queue for advance task mode
+     * task port is single producer single consumer on each side so user
+     * access to each port is serialized by its own port lock
      */
-    Mutex           mPortLock;
+    Mutex           mInputPortLock;
+    Mutex           mOutputPortLock;
     MppPort         mInputPort;
     MppPort         mOutputPort;
 
@@ -123,17 +139,20 @@ public:
 
     MppDec          *mDec;
     MppEnc          *mEnc;
+    MppIsp          mIsp;
 
 private:
     void clear();
+    MPP_RET start_sync();
 
     MppCtxType      mType;
     MppCodingType   mCoding;
 
     RK_U32          mInitDone;
     RK_U32          mPacketBlock;
-    RK_U32          mInputBlock;
-    RK_U32          mOutputBlock;
+    /* MPP_POLL_BLOCK / MPP_POLL_NON_BLOCK or timeout in millisecond */
+    RK_S64          mInputTimeout;
+    RK_S64          mOutputTimeout;
     RK_U32          mMultiFrame;
 
     // task for put_frame / put_packet
@@ -141,14 +160,29 @@ private:
 
     RK_U32          mStatus;
 
+    /*
+     * first decode / encode call stops the codec and hal threads and runs
+     * them on caller thread. It is refused once async interface is used.
+     */
+    RK_U32          mSyncMode;
+    RK_U32          mAsyncUsed;
+
+    /* run parser / hal on process-wide worker pool instead of own threads */
+    RK_U32          mWorkerMode;
+    MppWorker       mWorker;
+
     /* decoder paramter before init */
     RK_U32          mParserFastMode;
     RK_U32          mParserNeedSplit;
     RK_U32          mParserInternalPts;     /* for MPEG2/MPEG4 */
+    RK_S32          mDecTaskCount;          /* for task mode (MJPEG) */
+    MppIspConfig    mDecIspCfg;             /* isp stage on output frame */
+    RK_U32          mDecIspEnable;
 
     /* encoder paramter before init */
     MppEncConfig    mControlCfg;
     RK_U32          mControlCfgReady;
+    RK_S32          mEncTaskCount;
 
     MPP_RET control_mpp(MpiCmd cmd, MppParam param);
     MPP_RET control_osal(MpiCmd cmd, MppParam param);
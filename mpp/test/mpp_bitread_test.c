@@ -0,0 +1,517 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_bitread_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_bitread.h"
+
+#define BITREAD_TEST_STREAM_SIZE    4096
+#define BITREAD_TEST_OP_COUNT       2000
+#define BITREAD_TEST_ROUND          200
+#define BITREAD_TEST_BENCH_LOOP     200000
+
+/*
+ * reference reader: the byte by byte reader which mpp_bitread used before
+ */
+typedef struct RefBitRead_t {
+    RK_U8   *data;
+    RK_U32  bytes_left;
+    RK_U32  curr_byte;
+    RK_S32  bits_left;
+    RK_U32  prev_two_bytes;
+    RK_S32  used_bits;
+    RK_S32  detect;
+} RefBitRead;
+
+static void ref_init(RefBitRead *ctx, RK_U8 *data, RK_S32 size, RK_S32 detect)
+{
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->data = data;
+    ctx->bytes_left = size;
+    ctx->prev_two_bytes = 0xffff;
+    ctx->detect = detect;
+}
+
+static MPP_RET ref_update_byte(RefBitRead *ctx)
+{
+    if (ctx->bytes_left < 1)
+        return MPP_NOK;
+
+    if (ctx->detect && *ctx->data == 0x03 && (ctx->prev_two_bytes & 0xffff) == 0) {
+        ctx->data++;
+        ctx->bytes_left--;
+        ctx->prev_two_bytes = 0xffff;
+        if (ctx->bytes_left < 1)
+            return MPP_NOK;
+    }
+
+    ctx->curr_byte = *ctx->data++;
+    ctx->bytes_left--;
+    ctx->bits_left = 8;
+    ctx->prev_two_bytes = (ctx->prev_two_bytes << 8) | ctx->curr_byte;
+    return MPP_OK;
+}
+
+static MPP_RET ref_read_bits(RefBitRead *ctx, RK_S32 num_bits, RK_U32 *out)
+{
+    RK_U64 val = 0;
+    RK_S32 bits = num_bits;
+
+    while (bits) {
+        RK_S32 take;
+
+        if (!ctx->bits_left && ref_update_byte(ctx))
+            return MPP_NOK;
+
+        take = MPP_MIN(bits, ctx->bits_left);
+        val = (val << take) |
+              ((ctx->curr_byte >> (ctx->bits_left - take)) & ((1 << take) - 1));
+        ctx->bits_left -= take;
+        bits -= take;
+    }
+
+    ctx->used_bits += num_bits;
+    *out = (RK_U32)val;
+    return MPP_OK;
+}
+
+static MPP_RET ref_read_ue(RefBitRead *ctx, RK_U32 *val)
+{
+    RK_S32 zeros = -1;
+    RK_U32 bit = 0;
+    RK_U32 rest = 0;
+
+    do {
+        if (ref_read_bits(ctx, 1, &bit))
+            return MPP_NOK;
+        zeros++;
+    } while (!bit);
+
+    if (zeros > 31)
+        return MPP_NOK;
+
+    if (zeros && ref_read_bits(ctx, zeros, &rest))
+        return MPP_NOK;
+
+    *val = (RK_U32)((1ULL << zeros) - 1) + rest;
+    return MPP_OK;
+}
+
+/*
+ * bit writer with emulation prevention for stream generation
+ */
+typedef struct BitWrite_t {
+    RK_U8   *buf;
+    RK_S32  size;
+    RK_S32  pos;
+    RK_U32  byte;
+    RK_S32  bits;
+    RK_S32  zeros;
+    RK_S32  ep_count;
+} BitWrite;
+
+static void bw_put_byte(BitWrite *bw, RK_U32 byte)
+{
+    if (bw->zeros >= 2 && byte <= 3) {
+        bw->buf[bw->pos++] = 0x03;
+        bw->zeros = 0;
+        bw->ep_count++;
+    }
+    bw->buf[bw->pos++] = byte;
+    bw->zeros = (byte) ? (0) : (bw->zeros + 1);
+}
+
+static void bw_put_bits(BitWrite *bw, RK_U32 val, RK_S32 num_bits)
+{
+    while (num_bits--) {
+        bw->byte = (bw->byte << 1) | ((val >> num_bits) & 1);
+        if (++bw->bits == 8) {
+            bw_put_byte(bw, bw->byte);
+            bw->byte = 0;
+            bw->bits = 0;
+        }
+    }
+}
+
+static void bw_put_ue(BitWrite *bw, RK_U32 val)
+{
+    RK_U64 code = (RK_U64)val + 1;
+    RK_S32 len = 0;
+
+    while ((code >> len) > 1)
+        len++;
+
+    bw_put_bits(bw, 0, len);
+    bw_put_bits(bw, 1, 1);
+    if (len)
+        bw_put_bits(bw, (RK_U32)code, len);
+}
+
+static void bw_put_se(BitWrite *bw, RK_S32 val)
+{
+    bw_put_ue(bw, (val > 0) ? (val * 2 - 1) : (-val * 2));
+}
+
+static void bw_flush(BitWrite *bw)
+{
+    // rbsp trailing bits
+    bw_put_bits(bw, 1, 1);
+    while (bw->bits)
+        bw_put_bits(bw, 0, 1);
+}
+
+typedef enum BitReadTestOp_e {
+    OP_READ_BITS,
+    OP_READ_LONG,
+    OP_SHOW_BITS,
+    OP_SKIP_BITS,
+    OP_SKIP_LONG,
+    OP_READ_UE,
+    OP_READ_SE,
+    OP_BUTT,
+} BitReadTestOp;
+
+typedef struct BitReadTestItem_t {
+    BitReadTestOp   op;
+    RK_S32          bits;
+    RK_U32          val;
+} BitReadTestItem;
+
+/*
+ * generate random syntax elements with plenty of zero bytes so that a lot of
+ * emulation prevention bytes are inserted into the stream
+ */
+static RK_S32 gen_stream(BitWrite *bw, BitReadTestItem *items, RK_S32 count)
+{
+    RK_S32 i;
+
+    for (i = 0; i < count; i++) {
+        BitReadTestItem *item = &items[i];
+
+        item->op = (BitReadTestOp)(rand() % OP_BUTT);
+        item->bits = rand() % 31 + 1;
+        item->val = (rand() & 3) ? (0u) : ((RK_U32)rand() & ((1u << item->bits) - 1));
+
+        switch (item->op) {
+        case OP_READ_LONG : {
+            item->bits = 32;
+            item->val = (rand() & 1) ? (0) : ((RK_U32)rand() << 1);
+        } /* fall through */
+        case OP_READ_BITS :
+        case OP_SKIP_BITS : {
+            bw_put_bits(bw, item->val, item->bits);
+        } break;
+        case OP_SHOW_BITS : {
+            // show then read the same bits
+            bw_put_bits(bw, item->val, item->bits);
+        } break;
+        case OP_SKIP_LONG : {
+            // 32 bits like start code or more bits like user data
+            RK_S32 bits = item->bits = (rand() & 1) ? (32) : (33 + rand() % 64);
+
+            while (bits > 0) {
+                RK_S32 len = MPP_MIN(bits, 32);
+
+                bw_put_bits(bw, (rand() & 1) ? (0) : ((RK_U32)rand() << 1), len);
+                bits -= len;
+            }
+            item->val = 0;
+        } break;
+        case OP_READ_UE : {
+            item->val = (rand() & 1) ? ((RK_U32)rand() % 8) : ((RK_U32)rand() & 0xffff);
+            bw_put_ue(bw, item->val);
+        } break;
+        case OP_READ_SE : {
+            RK_S32 v = rand() % 2000 - 1000;
+            item->val = (RK_U32)v;
+            bw_put_se(bw, v);
+        } break;
+        default : {
+        } break;
+        }
+
+        if (bw->pos + 16 >= bw->size) {
+            i++;
+            break;
+        }
+    }
+    bw_flush(bw);
+    return i;
+}
+
+static MPP_RET check_stream(RK_U8 *buf, RK_S32 size, BitReadTestItem *items, RK_S32 count)
+{
+    BitReadCtx_t ctx;
+    BitReadCtx_t *bitctx = &ctx;
+    RK_S32 i;
+
+    mpp_set_bitread_ctx(bitctx, buf, size);
+    mpp_set_pre_detection(bitctx);
+
+    for (i = 0; i < count; i++) {
+        BitReadTestItem *item = &items[i];
+        RK_U32 val = 0;
+        MPP_RET ret = MPP_NOK;
+
+        switch (item->op) {
+        case OP_READ_BITS : {
+            ret = mpp_read_bits(bitctx, item->bits, (RK_S32 *)&val);
+        } break;
+        case OP_READ_LONG : {
+            ret = mpp_read_longbits(bitctx, item->bits, &val);
+        } break;
+        case OP_SHOW_BITS : {
+            RK_U32 show = 0;
+            ret = mpp_show_bits(bitctx, item->bits, (RK_S32 *)&show);
+            ret |= mpp_read_bits(bitctx, item->bits, (RK_S32 *)&val);
+            if (show != val)
+                ret = MPP_NOK;
+        } break;
+        case OP_SKIP_BITS : {
+            ret = mpp_skip_bits(bitctx, item->bits);
+            val = item->val;
+        } break;
+        case OP_SKIP_LONG : {
+            ret = mpp_skip_bits(bitctx, item->bits);
+        } break;
+        case OP_READ_UE : {
+            ret = mpp_read_ue(bitctx, &val);
+        } break;
+        case OP_READ_SE : {
+            ret = mpp_read_se(bitctx, (RK_S32 *)&val);
+        } break;
+        default : {
+        } break;
+        }
+
+        if (ret || val != item->val) {
+            mpp_err("mpp_bitread_test mismatch at item %d op %d bits %d val %x expect %x\n",
+                    i, item->op, item->bits, val, item->val);
+            return MPP_NOK;
+        }
+    }
+
+    if (mpp_has_more_rbsp_data(bitctx)) {
+        mpp_err("mpp_bitread_test found %d bits rbsp data at the end\n",
+                mpp_get_bits_left(bitctx));
+        return MPP_NOK;
+    }
+
+    return MPP_OK;
+}
+
+/*
+ * typical h.264 1080p high profile sps / pps / slice header syntax
+ */
+static void gen_headers(BitWrite *bw)
+{
+    RK_S32 i;
+
+    // sps
+    bw_put_bits(bw, 100, 8);    // profile_idc
+    bw_put_bits(bw, 0, 8);      // constraint flags
+    bw_put_bits(bw, 40, 8);     // level_idc
+    bw_put_ue(bw, 0);           // seq_parameter_set_id
+    bw_put_ue(bw, 1);           // chroma_format_idc
+    bw_put_ue(bw, 0);           // bit_depth_luma_minus8
+    bw_put_ue(bw, 0);           // bit_depth_chroma_minus8
+    bw_put_bits(bw, 0, 2);      // qpprime_y_zero / seq_scaling_matrix_present
+    bw_put_ue(bw, 0);           // log2_max_frame_num_minus4
+    bw_put_ue(bw, 0);           // pic_order_cnt_type
+    bw_put_ue(bw, 2);           // log2_max_pic_order_cnt_lsb_minus4
+    bw_put_ue(bw, 4);           // max_num_ref_frames
+    bw_put_bits(bw, 0, 1);      // gaps_in_frame_num_allowed
+    bw_put_ue(bw, 119);         // pic_width_in_mbs_minus1
+    bw_put_ue(bw, 67);          // pic_height_in_map_units_minus1
+    bw_put_bits(bw, 3, 2);      // frame_mbs_only / direct_8x8_inference
+    bw_put_bits(bw, 1, 1);      // frame_cropping_flag
+    bw_put_ue(bw, 0);
+    bw_put_ue(bw, 0);
+    bw_put_ue(bw, 0);
+    bw_put_ue(bw, 4);
+    bw_put_bits(bw, 0, 1);      // vui_parameters_present
+
+    // pps
+    bw_put_ue(bw, 0);           // pic_parameter_set_id
+    bw_put_ue(bw, 0);           // seq_parameter_set_id
+    bw_put_bits(bw, 1, 1);      // entropy_coding_mode
+    bw_put_bits(bw, 0, 1);      // bottom_field_pic_order_in_frame_present
+    bw_put_ue(bw, 0);           // num_slice_groups_minus1
+    bw_put_ue(bw, 2);           // num_ref_idx_l0_default_active_minus1
+    bw_put_ue(bw, 0);           // num_ref_idx_l1_default_active_minus1
+    bw_put_bits(bw, 2, 3);      // weighted_pred / weighted_bipred_idc
+    bw_put_se(bw, -3);          // pic_init_qp_minus26
+    bw_put_se(bw, 0);           // pic_init_qs_minus26
+    bw_put_se(bw, -2);          // chroma_qp_index_offset
+    bw_put_bits(bw, 5, 3);      // deblocking / constrained_intra / redundant_pic_cnt
+    bw_put_bits(bw, 1, 1);      // transform_8x8_mode
+    bw_put_bits(bw, 0, 1);      // pic_scaling_matrix_present
+    bw_put_se(bw, -2);          // second_chroma_qp_index_offset
+
+    // slice headers of a gop
+    for (i = 0; i < 8; i++) {
+        bw_put_ue(bw, 0);       // first_mb_in_slice
+        bw_put_ue(bw, (i) ? (5) : (7));  // slice_type
+        bw_put_ue(bw, 0);       // pic_parameter_set_id
+        bw_put_bits(bw, i, 4);  // frame_num
+        bw_put_bits(bw, i * 2, 6);  // pic_order_cnt_lsb
+        if (i) {
+            bw_put_bits(bw, 0, 1);  // num_ref_idx_active_override
+            bw_put_bits(bw, 0, 1);  // ref_pic_list_modification_flag_l0
+            bw_put_bits(bw, 0, 1);  // adaptive_ref_pic_marking_mode
+            bw_put_ue(bw, 0);       // cabac_init_idc
+        } else {
+            bw_put_bits(bw, 0, 2);  // no_output_of_prior_pics / long_term_reference
+        }
+        bw_put_se(bw, (i) ? (2) : (-4));  // slice_qp_delta
+        bw_put_ue(bw, 0);       // disable_deblocking_filter_idc
+        bw_put_se(bw, 0);       // slice_alpha_c0_offset_div2
+        bw_put_se(bw, 0);       // slice_beta_offset_div2
+        bw_put_bits(bw, 0, 16); // zero bytes to trigger emulation prevention
+    }
+    bw_flush(bw);
+}
+
+static RK_S32 parse_headers_new(RK_U8 *buf, RK_S32 size)
+{
+    BitReadCtx_t ctx;
+    BitReadCtx_t *bitctx = &ctx;
+    RK_U32 val = 0;
+    RK_S32 sum = 0;
+
+    mpp_set_bitread_ctx(bitctx, buf, size);
+    mpp_set_pre_detection(bitctx);
+
+    while (mpp_get_bits_left(bitctx) > 32) {
+        if (mpp_read_ue(bitctx, &val))
+            break;
+        sum += val;
+        if (mpp_read_bits(bitctx, 3, (RK_S32 *)&val))
+            break;
+        sum += val;
+    }
+
+    return sum;
+}
+
+static RK_S32 parse_headers_ref(RK_U8 *buf, RK_S32 size)
+{
+    RefBitRead ctx;
+    RK_U32 val = 0;
+    RK_S32 sum = 0;
+
+    ref_init(&ctx, buf, size, 1);
+
+    while (ctx.bytes_left * 8 + ctx.bits_left > 32) {
+        if (ref_read_ue(&ctx, &val))
+            break;
+        sum += val;
+        if (ref_read_bits(&ctx, 3, &val))
+            break;
+        sum += val;
+    }
+
+    return sum;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    RK_U8 *buf = NULL;
+    BitReadTestItem *items = NULL;
+    BitWrite bw;
+    RK_S32 round;
+    RK_S32 ep_total = 0;
+    RK_S32 i;
+
+    mpp_log("mpp_bitread_test start\n");
+
+    buf = malloc(BITREAD_TEST_STREAM_SIZE);
+    items = malloc(sizeof(*items) * BITREAD_TEST_OP_COUNT);
+    if (NULL == buf || NULL == items) {
+        mpp_err("mpp_bitread_test malloc failed\n");
+        goto MPP_TEST_FAILED;
+    }
+
+    srand(0x1234);
+
+    for (round = 0; round < BITREAD_TEST_ROUND; round++) {
+        RK_S32 count;
+
+        memset(&bw, 0, sizeof(bw));
+        bw.buf = buf;
+        bw.size = BITREAD_TEST_STREAM_SIZE;
+
+        count = gen_stream(&bw, items, BITREAD_TEST_OP_COUNT);
+        ep_total += bw.ep_count;
+
+        if (check_stream(buf, bw.pos, items, count)) {
+            mpp_err("mpp_bitread_test check failed at round %d\n", round);
+            goto MPP_TEST_FAILED;
+        }
+    }
+
+    mpp_log("mpp_bitread_test check %d streams with %d emulation prevention bytes ok\n",
+            BITREAD_TEST_ROUND, ep_total);
+
+    {
+        RK_S64 time_start, time_new, time_ref;
+        RK_S32 sum_new = 0, sum_ref = 0;
+
+        memset(&bw, 0, sizeof(bw));
+        bw.buf = buf;
+        bw.size = BITREAD_TEST_STREAM_SIZE;
+        gen_headers(&bw);
+
+        mpp_debug |= MPP_DBG_TIMING;
+
+        time_start = mpp_time();
+        for (i = 0; i < BITREAD_TEST_BENCH_LOOP; i++)
+            sum_new += parse_headers_new(buf, bw.pos);
+        time_new = mpp_time() - time_start;
+
+        time_start = mpp_time();
+        for (i = 0; i < BITREAD_TEST_BENCH_LOOP; i++)
+            sum_ref += parse_headers_ref(buf, bw.pos);
+        time_ref = mpp_time() - time_start;
+
+        mpp_debug &= ~MPP_DBG_TIMING;
+
+        if (sum_new != sum_ref) {
+            mpp_err("mpp_bitread_test header parse mismatch %d vs %d\n", sum_new, sum_ref);
+            goto MPP_TEST_FAILED;
+        }
+
+        mpp_log("mpp_bitread_test parse %d bytes headers %d times\n",
+                bw.pos, BITREAD_TEST_BENCH_LOOP);
+        mpp_log("mpp_bitread_test cache reader %lld us byte reader %lld us\n",
+                time_new, time_ref);
+    }
+
+    ret = MPP_OK;
+
+MPP_TEST_FAILED:
+    free(items);
+    free(buf);
+
+    mpp_log("mpp_bitread_test %s\n", (ret) ? ("failed") : ("success"));
+    return ret;
+}
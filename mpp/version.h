@@ -17,11 +17,11 @@
 #ifndef __VERSION_H__
 #define __VERSION_H__
 
-#define	MPP_VERSION             "-1"
-#define	MPP_AUTHOR              ""
-#define	MPP_DATE                ""
-#define	MPP_ONE_LINE            ""
-#define	MPP_VER_NUM             ""
+#define	MPP_VERSION             "a2b0918945f7f35243fc576f4482649c18751d96"
+#define	MPP_AUTHOR              "agent"
+#define	MPP_DATE                "Sat Oct 17 23:39:24 2026 +0000"
+#define	MPP_ONE_LINE            "a2b0918 author: agent [user-025] Derive rkv h264 encoder mb rc registers from bitrate config and feedback"
+#define	MPP_VER_NUM             "-1"
 
 #endif /*__VERSION_H__*/
 
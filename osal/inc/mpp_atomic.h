@@ -0,0 +1,72 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_ATOMIC_H__
+#define __MPP_ATOMIC_H__
+
+#include "rk_type.h"
+
+/*
+ * atomic operation for lock free data structure
+ *
+ * MPP_ATOMIC_LOAD      - load with acquire order
+ * MPP_ATOMIC_STORE     - store with release order
+ * MPP_ATOMIC_ADD_FETCH - add and return new value, full barrier
+ * MPP_ATOMIC_SUB_FETCH - sub and return new value, full barrier
+ * MPP_ATOMIC_CAS       - compare and swap, return non-zero on success
+ * MPP_ATOMIC_FENCE     - full memory barrier
+ * MPP_ATOMIC_FENCE_ACQ - loads before it are not reordered with later loads and stores
+ * MPP_ATOMIC_FENCE_REL - stores after it are not reordered with earlier loads and stores
+ *
+ * MPP_ATOMIC_LOAD_PTR  - load pointer with acquire order
+ * MPP_ATOMIC_STORE_PTR - store pointer with release order
+ *
+ * NOTE: only 32bit integer and pointer are supported for portability
+ */
+#if defined(_MSC_VER)
+
+#include <windows.h>
+
+#define MPP_ATOMIC_LOAD(ptr)            (MemoryBarrier(), *(volatile RK_S32 *)(ptr))
+#define MPP_ATOMIC_STORE(ptr, val)      do { MemoryBarrier(); *(volatile RK_S32 *)(ptr) = (val); } while (0)
+#define MPP_ATOMIC_ADD_FETCH(ptr, val)  (InterlockedExchangeAdd((volatile LONG *)(ptr), (val)) + (val))
+#define MPP_ATOMIC_SUB_FETCH(ptr, val)  (InterlockedExchangeAdd((volatile LONG *)(ptr), -(val)) - (val))
+#define MPP_ATOMIC_CAS(ptr, old, val)   \
+    (InterlockedCompareExchange((volatile LONG *)(ptr), (val), (old)) == (LONG)(old))
+#define MPP_ATOMIC_FENCE()              MemoryBarrier()
+#define MPP_ATOMIC_FENCE_ACQ()          MemoryBarrier()
+#define MPP_ATOMIC_FENCE_REL()          MemoryBarrier()
+#define MPP_ATOMIC_LOAD_PTR(ptr)        \
+    InterlockedCompareExchangePointer((PVOID volatile *)(ptr), NULL, NULL)
+#define MPP_ATOMIC_STORE_PTR(ptr, val)  \
+    InterlockedExchangePointer((PVOID volatile *)(ptr), (PVOID)(val))
+
+#else
+
+#define MPP_ATOMIC_LOAD(ptr)            __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define MPP_ATOMIC_STORE(ptr, val)      __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#define MPP_ATOMIC_ADD_FETCH(ptr, val)  __atomic_add_fetch(ptr, val, __ATOMIC_SEQ_CST)
+#define MPP_ATOMIC_SUB_FETCH(ptr, val)  __atomic_sub_fetch(ptr, val, __ATOMIC_SEQ_CST)
+#define MPP_ATOMIC_CAS(ptr, old, val)   __sync_bool_compare_and_swap(ptr, old, val)
+#define MPP_ATOMIC_FENCE()              __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define MPP_ATOMIC_FENCE_ACQ()          __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define MPP_ATOMIC_FENCE_REL()          __atomic_thread_fence(__ATOMIC_RELEASE)
+#define MPP_ATOMIC_LOAD_PTR(ptr)        __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define MPP_ATOMIC_STORE_PTR(ptr, val)  __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+
+#endif
+
+#endif /*__MPP_ATOMIC_H__*/
@@ -71,6 +71,37 @@ MPP_RET mpp_mem_get_snapshot(MppMemSnapshot *hnd);
 MPP_RET mpp_mem_put_snapshot(MppMemSnapshot *hnd);
 MPP_RET mpp_mem_squash_snapshot(MppMemSnapshot hnd0, MppMemSnapshot hnd1);
 
+/*
+ * mpp fixed size memory pool for frequently created small object
+ *
+ * Objects returned by pool are zeroed. Put object will return it to pool free
+ * list instead of system, so after warm-up there is no more malloc / free.
+ * Pool statistics can be get by mpp_mem_pool_get_info or shown by
+ * mpp_show_mem_pool_status.
+ */
+typedef void* MppMemPool;
+
+typedef struct MppMemPoolInfo_t {
+    const char          *tag;
+    size_t              size;
+    /* object count allocated from system */
+    RK_U32              malloc_count;
+    /* object count on using and in free list */
+    RK_U32              used_count;
+    RK_U32              unused_count;
+    /* total get call count */
+    RK_U64              get_count;
+} MppMemPoolInfo;
+
+#define mpp_mem_pool_init(size) mpp_mem_pool_init_f(MODULE_TAG, size)
+
+MppMemPool mpp_mem_pool_init_f(const char *tag, size_t size);
+void mpp_mem_pool_deinit(MppMemPool pool);
+void *mpp_mem_pool_get(MppMemPool pool);
+void mpp_mem_pool_put(MppMemPool pool, void *p);
+MPP_RET mpp_mem_pool_get_info(MppMemPool pool, MppMemPoolInfo *info);
+void mpp_show_mem_pool_status();
+
 #ifdef __cplusplus
 }
 #endif
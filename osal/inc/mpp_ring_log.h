@@ -0,0 +1,62 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_RING_LOG_H__
+#define __MPP_RING_LOG_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+/*
+ * fixed capacity operation history
+ *
+ * Entries of fixed size are written into a preallocated ring. Adding an entry
+ * takes no lock and does no allocation so the history can be left enabled.
+ * When the ring is full the oldest entry is overwritten. Each entry is stamped
+ * with a sequence number, monotonic time in us (tick resolution on linux) and
+ * the writer thread id.
+ *
+ * mpp_ring_log_init  - count is rounded up to power of 2
+ * mpp_ring_log_add   - copy entry_size bytes from entry, safe from any thread
+ * mpp_ring_log_dump  - call func on the entries in the ring from the oldest.
+ *                      Entries being overwritten during dump are skipped.
+ * mpp_ring_log_reset - drop all entries, must not run with mpp_ring_log_add
+ */
+typedef void* MppRingLog;
+
+typedef struct MppRingLogInfo_t {
+    RK_U32      seq;
+    RK_S32      tid;
+    RK_S64      time;
+} MppRingLogInfo;
+
+typedef void (*MppRingLogFunc)(void *ctx, MppRingLogInfo *info, void *entry);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_ring_log_init(MppRingLog *log, RK_S32 entry_size, RK_S32 count);
+MPP_RET mpp_ring_log_deinit(MppRingLog log);
+void    mpp_ring_log_add(MppRingLog log, const void *entry);
+MPP_RET mpp_ring_log_dump(MppRingLog log, MppRingLogFunc func, void *ctx);
+MPP_RET mpp_ring_log_reset(MppRingLog log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_RING_LOG_H__*/
@@ -44,6 +44,7 @@ int pthread_setname_np(pthread_t thread, const char *name);
 #include <unistd.h>
 #include <semaphore.h>
 #include <pthread.h>
+#include <time.h>
 
 #ifndef PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP
 #define PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP PTHREAD_RECURSIVE_MUTEX_INITIALIZER
@@ -65,17 +66,43 @@ typedef enum {
 #ifdef __cplusplus
 
 #include "mpp_log.h"
+#include "mpp_atomic.h"
+#include "mpp_worker.h"
 
 class Mutex;
 class Condition;
 
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define MPP_CPU_RELAX()     __asm__ __volatile__("pause" ::: "memory")
+#elif defined(__GNUC__) && (defined(__arm__) || defined(__aarch64__))
+#define MPP_CPU_RELAX()     __asm__ __volatile__("yield" ::: "memory")
+#else
+#define MPP_CPU_RELAX()     do {} while (0)
+#endif
+
+#define MPP_MUTEX_SPIN_COUNT    100
+
+/*
+ * Mutex is non-recursive.
+ *
+ * MPP_MUTEX_NORMAL   - plain mutex, fastest when uncontended
+ * MPP_MUTEX_ADAPTIVE - spin with trylock for a short while on contention
+ *                      before sleeping in kernel. For the locks shared by
+ *                      parser / hal / user threads which are only held for a
+ *                      few instructions. No spin on single core system.
+ */
+typedef enum MppMutexType_e {
+    MPP_MUTEX_NORMAL,
+    MPP_MUTEX_ADAPTIVE,
+} MppMutexType;
+
 /*
  * for shorter type name and function name
  */
 class Mutex
 {
 public:
-    Mutex();
+    Mutex(MppMutexType type = MPP_MUTEX_NORMAL);
     ~Mutex();
 
     void lock();
@@ -96,16 +123,28 @@ private:
     friend class Condition;
 
     pthread_mutex_t mMutex;
+    RK_S32          mSpin;
 
     Mutex(const Mutex &);
     Mutex &operator = (const Mutex&);
 };
 
-inline Mutex::Mutex()
+static inline RK_S32 mpp_mutex_spin_count()
+{
+#if defined(_WIN32)
+    static RK_S32 spin = MPP_MUTEX_SPIN_COUNT;
+#else
+    static RK_S32 spin = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? (MPP_MUTEX_SPIN_COUNT) : (0);
+#endif
+    return spin;
+}
+
+inline Mutex::Mutex(MppMutexType type)
+    : mSpin((MPP_MUTEX_ADAPTIVE == type) ? mpp_mutex_spin_count() : 0)
 {
     pthread_mutexattr_t attr;
     pthread_mutexattr_init(&attr);
-    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_NORMAL);
     pthread_mutex_init(&mMutex, &attr);
     pthread_mutexattr_destroy(&attr);
 }
@@ -115,6 +154,13 @@ inline Mutex::~Mutex()
 }
 inline void Mutex::lock()
 {
+    RK_S32 spin = mSpin;
+
+    while (spin-- > 0) {
+        if (!pthread_mutex_trylock(&mMutex))
+            return;
+        MPP_CPU_RELAX();
+    }
     pthread_mutex_lock(&mMutex);
 }
 inline void Mutex::unlock()
@@ -131,6 +177,10 @@ typedef Mutex::Autolock AutoMutex;
 
 /*
  * for shorter type name and function name
+ *
+ * Condition counts its waiters and signal / broadcast return without calling
+ * into pthread when nobody is waiting. On bionic every pthread_cond_signal is
+ * a futex wake syscall even without waiter.
  */
 class Condition
 {
@@ -139,14 +189,18 @@ public:
     Condition(int type);
     ~Condition();
     void wait(Mutex& mutex);
-    void timedwait(Mutex& mutex, RK_S64 timeout);
+    /* timeout in millisecond, return 0 on signaled and ETIMEDOUT on timeout */
+    RK_S32 timedwait(Mutex& mutex, RK_S64 timeout);
     void signal();
+    void broadcast();
 
 private:
-    pthread_cond_t mCond;
+    pthread_cond_t  mCond;
+    RK_S32          mWaiters;
 };
 
 inline Condition::Condition()
+    : mWaiters(0)
 {
     pthread_cond_init(&mCond, NULL);
 }
@@ -156,18 +210,42 @@ inline Condition::~Condition()
 }
 inline void Condition::wait(Mutex& mutex)
 {
+    MPP_ATOMIC_ADD_FETCH(&mWaiters, 1);
     pthread_cond_wait(&mCond, &mutex.mMutex);
+    MPP_ATOMIC_SUB_FETCH(&mWaiters, 1);
 }
-inline void Condition::timedwait(Mutex& mutex, RK_S64 timeout)
+inline RK_S32 Condition::timedwait(Mutex& mutex, RK_S64 timeout)
 {
-    struct timespec time;
-    time.tv_sec  = (time_t)(timeout >> 32);
-    time.tv_nsec = (long)timeout;
-    pthread_cond_timedwait(&mCond, &mutex.mMutex, &time);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    ts.tv_sec  += (time_t)(timeout / 1000);
+    ts.tv_nsec += (long)((timeout % 1000) * 1000000);
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec  += 1;
+        ts.tv_nsec -= 1000000000;
+    }
+
+    MPP_ATOMIC_ADD_FETCH(&mWaiters, 1);
+    RK_S32 ret = pthread_cond_timedwait(&mCond, &mutex.mMutex, &ts);
+    MPP_ATOMIC_SUB_FETCH(&mWaiters, 1);
+    return ret;
 }
+/*
+ * The waiter count is raised under the mutex before waiting so a signaler
+ * holding the mutex always sees it. A signaler without the mutex has the same
+ * guarantee as with a bare pthread_cond_signal, which does not wake a waiter
+ * that has not entered wait yet.
+ */
 inline void Condition::signal()
 {
-    pthread_cond_signal(&mCond);
+    if (MPP_ATOMIC_LOAD(&mWaiters))
+        pthread_cond_signal(&mCond);
+}
+inline void Condition::broadcast()
+{
+    if (MPP_ATOMIC_LOAD(&mWaiters))
+        pthread_cond_broadcast(&mCond);
 }
 
 class MppMutexCond
@@ -204,6 +282,13 @@ public:
     MppThreadStatus get_status();
     void set_status(MppThreadStatus status);
 
+    /*
+     * run on shared worker pool instead of a dedicated thread, call before start
+     * step is called on worker each time THREAD_WORK is signaled and done is
+     * called by stop after the last step has finished
+     */
+    void set_worker(MppWorker worker, MppWorkerFunc step, MppThreadFunc done = NULL);
+
     void start();
     void stop();
 
@@ -225,6 +310,8 @@ public:
     void signal(MppThreadSignal id = THREAD_WORK) {
         mpp_assert(id < THREAD_SIGNAL_BUTT);
         mMutexCond[id].signal();
+        if (mWorker && THREAD_WORK == id)
+            signal_job();
     }
 
 private:
@@ -236,6 +323,15 @@ private:
     char            mName[THREAD_NAME_LEN];
     void            *mContext;
 
+    MppWorker       mWorker;
+    /* mJob is attached and detached under mJobLock for signal from any thread */
+    Mutex           mJobLock;
+    MppWorkerJob    mJob;
+    MppWorkerFunc   mStep;
+    MppThreadFunc   mDone;
+
+    void signal_job();
+
     MppThread();
     MppThread(const MppThread &);
     MppThread &operator=(const MppThread &);
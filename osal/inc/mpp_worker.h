@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __MPP_WORKER_H__
+#define __MPP_WORKER_H__
+
+#include "rk_type.h"
+#include "mpp_err.h"
+
+/*
+ * process-wide worker pool
+ *
+ * A fixed number of worker threads shared by all mpp instances in the process.
+ * Work is submitted as jobs. A job is a step function with its context which
+ * is run on a worker each time the job is signaled. Each worker has its own job
+ * queue and steals jobs from the other workers when its queue is empty.
+ *
+ * A job is never run on two workers at the same time and a signal arriving
+ * while the job is running makes it run once more, so one job behaves like a
+ * dedicated thread looping on its step function and waiting for signal.
+ *
+ * step function return value:
+ * 0        - no more work, wait for next signal
+ * non-zero - more work to do, run again without signal
+ *
+ * environment:
+ * mpp_worker_num - worker thread count, default is online cpu count (min 2)
+ * mpp_worker_pin - pin worker i to cpu (i % cpu count) when non-zero (linux only)
+ *
+ * mpp_worker_get / put - get and put the shared pool with reference count.
+ *                        The pool is created on first get and destroyed on
+ *                        last put.
+ * mpp_worker_job_deinit - wait for the job leaving worker and free it
+ */
+typedef void* MppWorker;
+typedef void* MppWorkerJob;
+typedef RK_S32 (*MppWorkerFunc)(void *ctx);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+MPP_RET mpp_worker_get(MppWorker *worker);
+MPP_RET mpp_worker_put(MppWorker worker);
+
+MPP_RET mpp_worker_job_init(MppWorkerJob *job, MppWorker worker,
+                            MppWorkerFunc func, void *ctx);
+MPP_RET mpp_worker_job_deinit(MppWorkerJob job);
+MPP_RET mpp_worker_job_signal(MppWorkerJob job);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*__MPP_WORKER_H__*/
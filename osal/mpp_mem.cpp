@@ -298,3 +298,212 @@ MPP_RET mpp_mem_squash_snapshot(MppMemSnapshot hnd0, MppMemSnapshot hnd1)
     return MPP_OK;
 }
 
+typedef struct MppMemPoolImpl_t {
+    const char          *tag;
+    size_t              size;
+    pthread_mutex_t     lock;
+
+    struct list_head    list_pool;
+    struct list_head    list_unused;
+
+    RK_U32              malloc_count;
+    RK_U32              used_count;
+    RK_U32              unused_count;
+    RK_U64              get_count;
+} MppMemPoolImpl;
+
+/* object header, object data is after the header with default align */
+typedef struct MppMemPoolNode_t {
+    struct list_head    list;
+    MppMemPoolImpl      *pool;
+} MppMemPoolNode;
+
+#define MEM_POOL_NODE_SIZE      MPP_ALIGN(sizeof(MppMemPoolNode), RK_OSAL_MEM_ALIGN)
+#define MEM_POOL_NODE_TO_PTR(n) ((void *)((RK_U8 *)(n) + MEM_POOL_NODE_SIZE))
+#define MEM_POOL_PTR_TO_NODE(p) ((MppMemPoolNode *)((RK_U8 *)(p) - MEM_POOL_NODE_SIZE))
+
+/*
+ * pool service records all pools for status dump. On exit only the free list
+ * memory is released, pool itself is kept for object put after service exit.
+ */
+class MppMemPoolService
+{
+private:
+    MppMemPoolService();
+    ~MppMemPoolService();
+    MppMemPoolService(const MppMemPoolService &);
+    MppMemPoolService &operator=(const MppMemPoolService &);
+
+public:
+    static MppMemPoolService *get_instance() {
+        static MppMemPoolService instance;
+        return &instance;
+    }
+
+    pthread_mutex_t     mLock;
+    struct list_head    mListPool;
+};
+
+static void mem_pool_trim(MppMemPoolImpl *pool)
+{
+    while (!list_empty(&pool->list_unused)) {
+        MppMemPoolNode *node = list_entry(pool->list_unused.next, MppMemPoolNode, list);
+        list_del_init(&node->list);
+        pool->unused_count--;
+        pool->malloc_count--;
+        mpp_free(node);
+    }
+}
+
+MppMemPoolService::MppMemPoolService()
+{
+    pthread_mutex_init(&mLock, NULL);
+    INIT_LIST_HEAD(&mListPool);
+}
+
+MppMemPoolService::~MppMemPoolService()
+{
+    MppMemPoolImpl *pos, *n;
+
+    pthread_mutex_lock(&mLock);
+    list_for_each_entry_safe(pos, n, &mListPool, MppMemPoolImpl, list_pool) {
+        pthread_mutex_lock(&pos->lock);
+        mem_pool_trim(pos);
+        pthread_mutex_unlock(&pos->lock);
+    }
+    pthread_mutex_unlock(&mLock);
+}
+
+MppMemPool mpp_mem_pool_init_f(const char *tag, size_t size)
+{
+    MppMemPoolService *service = MppMemPoolService::get_instance();
+    MppMemPoolImpl *pool = mpp_calloc(MppMemPoolImpl, 1);
+
+    if (NULL == pool) {
+        mpp_err_f("failed to malloc pool for %s size %d\n", tag, size);
+        return NULL;
+    }
+
+    pool->tag  = tag;
+    pool->size = size;
+    pthread_mutex_init(&pool->lock, NULL);
+    INIT_LIST_HEAD(&pool->list_pool);
+    INIT_LIST_HEAD(&pool->list_unused);
+
+    pthread_mutex_lock(&service->mLock);
+    list_add_tail(&pool->list_pool, &service->mListPool);
+    pthread_mutex_unlock(&service->mLock);
+
+    return pool;
+}
+
+void mpp_mem_pool_deinit(MppMemPool pool)
+{
+    MppMemPoolService *service = MppMemPoolService::get_instance();
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+
+    if (NULL == impl)
+        return;
+
+    pthread_mutex_lock(&service->mLock);
+    list_del_init(&impl->list_pool);
+    pthread_mutex_unlock(&service->mLock);
+
+    mem_pool_trim(impl);
+
+    if (impl->used_count)
+        mpp_err_f("pool %s deinit with %d object not released\n",
+                  impl->tag, impl->used_count);
+
+    pthread_mutex_destroy(&impl->lock);
+    mpp_free(impl);
+}
+
+void *mpp_mem_pool_get(MppMemPool pool)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolNode *node = NULL;
+
+    pthread_mutex_lock(&impl->lock);
+
+    impl->get_count++;
+    if (!list_empty(&impl->list_unused)) {
+        node = list_entry(impl->list_unused.next, MppMemPoolNode, list);
+        list_del_init(&node->list);
+        impl->unused_count--;
+    } else {
+        // object is zeroed on put so only the new one needs calloc
+        node = (MppMemPoolNode *)mpp_osal_calloc(impl->tag, MEM_POOL_NODE_SIZE + impl->size);
+        if (NULL == node) {
+            mpp_err_f("pool %s failed to malloc size %d\n", impl->tag, impl->size);
+            pthread_mutex_unlock(&impl->lock);
+            return NULL;
+        }
+        INIT_LIST_HEAD(&node->list);
+        node->pool = impl;
+        impl->malloc_count++;
+    }
+    impl->used_count++;
+
+    pthread_mutex_unlock(&impl->lock);
+
+    return MEM_POOL_NODE_TO_PTR(node);
+}
+
+void mpp_mem_pool_put(MppMemPool pool, void *p)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+    MppMemPoolNode *node = MEM_POOL_PTR_TO_NODE(p);
+
+    if (node->pool != impl) {
+        mpp_err_f("pool %s found invalid object %p\n", impl->tag, p);
+        return;
+    }
+
+    // clear on put so any stale user of the object will fail on name check
+    memset(p, 0, impl->size);
+
+    pthread_mutex_lock(&impl->lock);
+    list_add(&node->list, &impl->list_unused);
+    impl->used_count--;
+    impl->unused_count++;
+    pthread_mutex_unlock(&impl->lock);
+}
+
+MPP_RET mpp_mem_pool_get_info(MppMemPool pool, MppMemPoolInfo *info)
+{
+    MppMemPoolImpl *impl = (MppMemPoolImpl *)pool;
+
+    if (NULL == impl || NULL == info) {
+        mpp_err_f("invalid input pool %p info %p\n", pool, info);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    pthread_mutex_lock(&impl->lock);
+    info->tag           = impl->tag;
+    info->size          = impl->size;
+    info->malloc_count  = impl->malloc_count;
+    info->used_count    = impl->used_count;
+    info->unused_count  = impl->unused_count;
+    info->get_count     = impl->get_count;
+    pthread_mutex_unlock(&impl->lock);
+
+    return MPP_OK;
+}
+
+void mpp_show_mem_pool_status()
+{
+    MppMemPoolService *service = MppMemPoolService::get_instance();
+    MppMemPoolImpl *pos, *n;
+
+    pthread_mutex_lock(&service->mLock);
+    list_for_each_entry_safe(pos, n, &service->mListPool, MppMemPoolImpl, list_pool) {
+        MppMemPoolInfo info;
+
+        mpp_mem_pool_get_info(pos, &info);
+        mpp_log("mem pool %-16s size %-5d malloc %-5d used %-5d unused %-5d get %llu\n",
+                info.tag, info.size, info.malloc_count, info.used_count,
+                info.unused_count, info.get_count);
+    }
+    pthread_mutex_unlock(&service->mLock);
+}
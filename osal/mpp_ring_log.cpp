@@ -0,0 +1,213 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ring_log"
+
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <sys/types.h>
+#include <sys/timeb.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_common.h"
+#include "mpp_atomic.h"
+#include "mpp_ring_log.h"
+
+/*
+ * entry layout: MppRingLogInfo followed by entry_size bytes of user data
+ *
+ * seq of entry with position pos is (pos + 1) when the write is done and 0
+ * while it is being written, so the reader can detect overwritten entries.
+ */
+typedef struct MppRingLogImpl_t {
+    RK_U32      pos;
+    RK_U32      count;
+    RK_S32      entry_size;
+    RK_S32      stride;
+    RK_U8       *buf;
+} MppRingLogImpl;
+
+static RK_S32 ring_log_tid()
+{
+#if defined(_WIN32)
+    return (RK_S32)GetCurrentThreadId();
+#elif defined(__linux__)
+    static __thread RK_S32 tid = 0;
+
+    if (!tid)
+        tid = (RK_S32)syscall(SYS_gettid);
+    return tid;
+#else
+    return (RK_S32)(intptr_t)pthread_self();
+#endif
+}
+
+/*
+ * do not use mpp_time here for it only works with timing debug
+ * coarse clock is used when available for it is much cheaper and the entry
+ * order is given by seq
+ */
+static RK_S64 ring_log_time()
+{
+#if defined(_WIN32)
+    struct timeb tb;
+    ftime(&tb);
+    return ((RK_S64)tb.time * 1000 + (RK_S64)tb.millitm) * 1000;
+#else
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC_COARSE)
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (RK_S64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+MPP_RET mpp_ring_log_init(MppRingLog *log, RK_S32 entry_size, RK_S32 count)
+{
+    MppRingLogImpl *p = NULL;
+    RK_U32 size = 1;
+
+    if (NULL == log || entry_size <= 0 || count <= 0) {
+        mpp_err_f("found invalid input log %p entry_size %d count %d\n",
+                  log, entry_size, count);
+        return MPP_ERR_VALUE;
+    }
+
+    *log = NULL;
+
+    while (size < (RK_U32)count)
+        size <<= 1;
+
+    p = mpp_calloc(MppRingLogImpl, 1);
+    if (NULL == p) {
+        mpp_err_f("failed to malloc context\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    p->count = size;
+    p->entry_size = entry_size;
+    p->stride = MPP_ALIGN(sizeof(MppRingLogInfo) + entry_size, 8);
+    p->buf = mpp_calloc(RK_U8, p->stride * size);
+    if (NULL == p->buf) {
+        mpp_err_f("failed to malloc %d entries\n", size);
+        mpp_free(p);
+        return MPP_ERR_MALLOC;
+    }
+
+    *log = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_ring_log_deinit(MppRingLog log)
+{
+    MppRingLogImpl *p = (MppRingLogImpl *)log;
+
+    if (NULL == p) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    mpp_free(p->buf);
+    mpp_free(p);
+    return MPP_OK;
+}
+
+void mpp_ring_log_add(MppRingLog log, const void *entry)
+{
+    MppRingLogImpl *p = (MppRingLogImpl *)log;
+
+    if (NULL == p || NULL == entry)
+        return;
+
+    RK_U32 pos = MPP_ATOMIC_ADD_FETCH(&p->pos, 1) - 1;
+    MppRingLogInfo *info = (MppRingLogInfo *)(p->buf + (pos & (p->count - 1)) * p->stride);
+
+    /* mark entry invalid before the content is changed */
+    MPP_ATOMIC_STORE(&info->seq, 0);
+    MPP_ATOMIC_FENCE_REL();
+
+    info->tid = ring_log_tid();
+    info->time = ring_log_time();
+    memcpy(info + 1, entry, p->entry_size);
+
+    MPP_ATOMIC_STORE(&info->seq, pos + 1);
+}
+
+MPP_RET mpp_ring_log_dump(MppRingLog log, MppRingLogFunc func, void *ctx)
+{
+    MppRingLogImpl *p = (MppRingLogImpl *)log;
+
+    if (NULL == p || NULL == func) {
+        mpp_err_f("found invalid input log %p func %p\n", log, func);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    RK_U8 *tmp = mpp_malloc(RK_U8, p->stride);
+    if (NULL == tmp) {
+        mpp_err_f("failed to malloc dump buffer\n");
+        return MPP_ERR_MALLOC;
+    }
+
+    RK_U32 end = MPP_ATOMIC_LOAD(&p->pos);
+    RK_U32 start = (end > p->count) ? (end - p->count) : (0);
+    MppRingLogInfo *copy = (MppRingLogInfo *)tmp;
+
+    for (RK_U32 pos = start; pos != end; pos++) {
+        MppRingLogInfo *info = (MppRingLogInfo *)(p->buf + (pos & (p->count - 1)) * p->stride);
+        RK_U32 seq = MPP_ATOMIC_LOAD(&info->seq);
+
+        if (seq != pos + 1)
+            continue;
+
+        memcpy(tmp, info, p->stride);
+        MPP_ATOMIC_FENCE_ACQ();
+
+        /* overwritten by writer during copy */
+        if (MPP_ATOMIC_LOAD(&info->seq) != seq)
+            continue;
+
+        func(ctx, copy, copy + 1);
+    }
+
+    mpp_free(tmp);
+    return MPP_OK;
+}
+
+MPP_RET mpp_ring_log_reset(MppRingLog log)
+{
+    MppRingLogImpl *p = (MppRingLogImpl *)log;
+
+    if (NULL == p) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    MPP_ATOMIC_STORE(&p->pos, 0);
+    return MPP_OK;
+}
@@ -31,7 +31,11 @@ static RK_U32 thread_debug = 0;
 MppThread::MppThread(MppThreadFunc func, void *ctx, const char *name)
     : mStatus(MPP_THREAD_UNINITED),
       mFunction(func),
-      mContext(ctx)
+      mContext(ctx),
+      mWorker(NULL),
+      mJob(NULL),
+      mStep(NULL),
+      mDone(NULL)
 {
     if (name)
         strncpy(mName, name, sizeof(mName));
@@ -48,9 +52,35 @@ void MppThread::set_status(MppThreadStatus status)
     mStatus = status;
 }
 
+void MppThread::set_worker(MppWorker worker, MppWorkerFunc step, MppThreadFunc done)
+{
+    mpp_assert(MPP_THREAD_UNINITED == mStatus);
+    mWorker = worker;
+    mStep = step;
+    mDone = done;
+}
+
 void MppThread::start()
 {
     pthread_attr_t attr;
+
+    if (mWorker) {
+        MppWorkerJob job = NULL;
+
+        if (MPP_THREAD_UNINITED == mStatus &&
+            MPP_OK == mpp_worker_job_init(&job, mWorker, mStep, mContext)) {
+            mStatus = MPP_THREAD_RUNNING;
+            thread_dbg(MPP_THREAD_DBG_FUNCTION, "thread %s %p context %p run on worker\n",
+                       mName, mStep, mContext);
+
+            mJobLock.lock();
+            mJob = job;
+            mJobLock.unlock();
+            mpp_worker_job_signal(job);
+        }
+        return;
+    }
+
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
 
@@ -74,6 +104,27 @@ void MppThread::start()
 
 void MppThread::stop()
 {
+    if (mWorker && MPP_THREAD_UNINITED != mStatus) {
+        MppWorkerJob job = NULL;
+
+        lock();
+        mStatus = MPP_THREAD_STOPPING;
+        unlock();
+
+        /* detach the job first so that no signal can reach it after release */
+        mJobLock.lock();
+        job = mJob;
+        mJob = NULL;
+        mJobLock.unlock();
+
+        mpp_worker_job_deinit(job);
+        if (mDone)
+            mDone(mContext);
+
+        mStatus = MPP_THREAD_UNINITED;
+        return;
+    }
+
     if (MPP_THREAD_UNINITED != mStatus) {
         lock();
         mStatus = MPP_THREAD_STOPPING;
@@ -89,6 +140,14 @@ void MppThread::stop()
     }
 }
 
+void MppThread::signal_job()
+{
+    AutoMutex autoLock(mJobLock);
+
+    if (mJob)
+        mpp_worker_job_signal(mJob);
+}
+
 #if defined(_WIN32) && !defined(__MINGW32CE__)
 //
 // Usage: SetThreadName ((DWORD)-1, "MainThread");
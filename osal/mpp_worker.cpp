@@ -0,0 +1,414 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_worker"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "mpp_log.h"
+#include "mpp_env.h"
+#include "mpp_list.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+#include "mpp_worker.h"
+
+#define MPP_WORKER_DBG_FUNCTION     (0x00000001)
+#define MPP_WORKER_DBG_JOB          (0x00000002)
+
+#define MAX_WORKER_NUM              16
+
+#define worker_dbg(flag, fmt, ...)  _mpp_dbg(mpp_worker_debug, flag, fmt, ## __VA_ARGS__)
+
+typedef enum MppWorkerJobStatus_e {
+    JOB_IDLE,
+    JOB_QUEUED,
+    JOB_RUNNING,
+} MppWorkerJobStatus;
+
+struct MppWorkerPool_t;
+
+/*
+ * job status is protected by job lock
+ * lock order: job lock -> worker queue lock -> pool lock
+ */
+typedef struct MppWorkerJobImpl_t {
+    struct list_head        list;
+    struct MppWorkerPool_t  *pool;
+    MppWorkerFunc           func;
+    void                    *ctx;
+
+    Mutex                   lock;
+    Condition               cond;
+    MppWorkerJobStatus      status;
+    RK_U32                  pending;
+    RK_U32                  stopping;
+    /* queue of the worker which runs the job last time */
+    RK_S32                  home;
+} MppWorkerJobImpl;
+
+typedef struct MppWorkerThread_t {
+    struct MppWorkerPool_t  *pool;
+    RK_S32                  idx;
+    MppThread               *thd;
+
+    Mutex                   lock;
+    struct list_head        jobs;
+} MppWorkerThread;
+
+typedef struct MppWorkerPool_t {
+    RK_S32                  ref_count;
+    RK_S32                  count;
+    RK_S32                  cpus;
+    RK_U32                  pin;
+
+    /* pool lock for worker sleep and wakeup */
+    Mutex                   lock;
+    Condition               cond;
+    RK_U32                  running;
+    RK_S32                  queued;
+    RK_S32                  sleeping;
+    RK_S32                  next_home;
+
+    MppWorkerThread         workers[MAX_WORKER_NUM];
+} MppWorkerPool;
+
+static RK_U32 mpp_worker_debug = 0;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static MppWorkerPool *pool_shared = NULL;
+
+static RK_S32 worker_get_cpu_count()
+{
+#if defined(_WIN32)
+    return 2;
+#else
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cpus > 0) ? (RK_S32)cpus : 1;
+#endif
+}
+
+static void worker_pin_cpu(MppWorkerThread *p)
+{
+#if defined(__linux__)
+    MppWorkerPool *pool = p->pool;
+    cpu_set_t mask;
+
+    if (!pool->pin)
+        return;
+
+    CPU_ZERO(&mask);
+    CPU_SET(p->idx % pool->cpus, &mask);
+    if (sched_setaffinity(0, sizeof(mask), &mask))
+        mpp_err("worker %d pin to cpu %d failed\n", p->idx, p->idx % pool->cpus);
+#else
+    (void)p;
+#endif
+}
+
+static void worker_enqueue(MppWorkerPool *pool, MppWorkerJobImpl *job)
+{
+    MppWorkerThread *w = &pool->workers[job->home];
+
+    w->lock.lock();
+    list_add_tail(&job->list, &w->jobs);
+    w->lock.unlock();
+
+    pool->lock.lock();
+    pool->queued++;
+    if (pool->sleeping)
+        pool->cond.signal();
+    pool->lock.unlock();
+}
+
+/* take job from own queue first then steal from the other workers */
+static MppWorkerJobImpl *worker_dequeue(MppWorkerThread *p)
+{
+    MppWorkerPool *pool = p->pool;
+    MppWorkerJobImpl *job = NULL;
+    RK_S32 i;
+
+    for (i = 0; i < pool->count && NULL == job; i++) {
+        MppWorkerThread *w = &pool->workers[(p->idx + i) % pool->count];
+
+        w->lock.lock();
+        if (!list_empty(&w->jobs)) {
+            job = list_entry(w->jobs.next, MppWorkerJobImpl, list);
+            list_del_init(&job->list);
+        }
+        w->lock.unlock();
+
+        if (job && i)
+            worker_dbg(MPP_WORKER_DBG_JOB, "worker %d steal job %p from worker %d\n",
+                       p->idx, job, w->idx);
+    }
+
+    if (job) {
+        pool->lock.lock();
+        pool->queued--;
+        pool->lock.unlock();
+    }
+
+    return job;
+}
+
+static void worker_run_job(MppWorkerThread *p, MppWorkerJobImpl *job)
+{
+    MppWorkerPool *pool = p->pool;
+    RK_S32 again;
+
+    job->lock.lock();
+    if (job->stopping) {
+        job->status = JOB_IDLE;
+        job->cond.broadcast();
+        job->lock.unlock();
+        return;
+    }
+    job->status = JOB_RUNNING;
+    job->pending = 0;
+    job->home = p->idx;
+    job->lock.unlock();
+
+    again = job->func(job->ctx);
+
+    job->lock.lock();
+    if (job->stopping) {
+        job->status = JOB_IDLE;
+        job->cond.broadcast();
+    } else if (again || job->pending) {
+        job->status = JOB_QUEUED;
+        worker_enqueue(pool, job);
+    } else {
+        job->status = JOB_IDLE;
+    }
+    job->lock.unlock();
+}
+
+static void *worker_thread(void *data)
+{
+    MppWorkerThread *p = (MppWorkerThread *)data;
+    MppWorkerPool *pool = p->pool;
+
+    worker_pin_cpu(p);
+
+    while (1) {
+        MppWorkerJobImpl *job = worker_dequeue(p);
+
+        if (job) {
+            worker_run_job(p, job);
+            continue;
+        }
+
+        pool->lock.lock();
+        if (!pool->running) {
+            pool->lock.unlock();
+            break;
+        }
+        if (pool->queued <= 0) {
+            pool->sleeping++;
+            pool->cond.wait(pool->lock);
+            pool->sleeping--;
+        }
+        pool->lock.unlock();
+    }
+
+    return NULL;
+}
+
+static MppWorkerPool *worker_pool_create()
+{
+    MppWorkerPool *pool = new MppWorkerPool;
+    RK_U32 count = 0;
+    RK_S32 i;
+
+    mpp_env_get_u32("mpp_worker_debug", &mpp_worker_debug, 0);
+    mpp_env_get_u32("mpp_worker_num", &count, 0);
+    mpp_env_get_u32("mpp_worker_pin", &pool->pin, 0);
+
+    pool->cpus = worker_get_cpu_count();
+    if (!count)
+        count = MPP_MAX(pool->cpus, 2);
+    if (count > MAX_WORKER_NUM)
+        count = MAX_WORKER_NUM;
+
+    pool->ref_count = 0;
+    pool->count = count;
+    pool->running = 1;
+    pool->queued = 0;
+    pool->sleeping = 0;
+    pool->next_home = 0;
+
+    for (i = 0; i < pool->count; i++) {
+        MppWorkerThread *w = &pool->workers[i];
+        char name[THREAD_NAME_LEN];
+
+        snprintf(name, sizeof(name), "mpp_worker%u", (RK_U32)i % MAX_WORKER_NUM);
+        w->pool = pool;
+        w->idx = i;
+        w->thd = new MppThread(worker_thread, w, name);
+        INIT_LIST_HEAD(&w->jobs);
+    }
+
+    for (i = 0; i < pool->count; i++)
+        pool->workers[i].thd->start();
+
+    worker_dbg(MPP_WORKER_DBG_FUNCTION, "pool %p create with %d workers pin %d\n",
+               pool, pool->count, pool->pin);
+
+    return pool;
+}
+
+static void worker_pool_destroy(MppWorkerPool *pool)
+{
+    RK_S32 i;
+
+    pool->lock.lock();
+    pool->running = 0;
+    pool->cond.broadcast();
+    pool->lock.unlock();
+
+    for (i = 0; i < pool->count; i++) {
+        MppWorkerThread *w = &pool->workers[i];
+
+        w->thd->stop();
+        delete w->thd;
+        w->thd = NULL;
+        mpp_assert(list_empty(&w->jobs));
+    }
+
+    worker_dbg(MPP_WORKER_DBG_FUNCTION, "pool %p destroy\n", pool);
+
+    delete pool;
+}
+
+MPP_RET mpp_worker_get(MppWorker *worker)
+{
+    if (NULL == worker) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    if (NULL == pool_shared)
+        pool_shared = worker_pool_create();
+
+    pool_shared->ref_count++;
+    *worker = pool_shared;
+    pthread_mutex_unlock(&pool_lock);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_worker_put(MppWorker worker)
+{
+    MppWorkerPool *pool = (MppWorkerPool *)worker;
+
+    if (NULL == pool) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    mpp_assert(pool == pool_shared);
+    pool->ref_count--;
+    if (pool->ref_count <= 0) {
+        worker_pool_destroy(pool);
+        pool_shared = NULL;
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    return MPP_OK;
+}
+
+MPP_RET mpp_worker_job_init(MppWorkerJob *job, MppWorker worker,
+                            MppWorkerFunc func, void *ctx)
+{
+    MppWorkerPool *pool = (MppWorkerPool *)worker;
+    MppWorkerJobImpl *p = NULL;
+
+    if (NULL == job || NULL == pool || NULL == func) {
+        mpp_err_f("found invalid input job %p worker %p func %p\n", job, worker, func);
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p = new MppWorkerJobImpl;
+    INIT_LIST_HEAD(&p->list);
+    p->pool = pool;
+    p->func = func;
+    p->ctx = ctx;
+    p->status = JOB_IDLE;
+    p->pending = 0;
+    p->stopping = 0;
+
+    /* spread new jobs on worker queues */
+    pool->lock.lock();
+    p->home = pool->next_home;
+    pool->next_home = (pool->next_home + 1) % pool->count;
+    pool->lock.unlock();
+
+    worker_dbg(MPP_WORKER_DBG_FUNCTION, "job %p init on worker %d\n", p, p->home);
+
+    *job = p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_worker_job_deinit(MppWorkerJob job)
+{
+    MppWorkerJobImpl *p = (MppWorkerJobImpl *)job;
+
+    if (NULL == p) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p->lock.lock();
+    p->stopping = 1;
+    while (JOB_IDLE != p->status)
+        p->cond.wait(p->lock);
+    p->lock.unlock();
+
+    worker_dbg(MPP_WORKER_DBG_FUNCTION, "job %p deinit\n", p);
+
+    delete p;
+    return MPP_OK;
+}
+
+MPP_RET mpp_worker_job_signal(MppWorkerJob job)
+{
+    MppWorkerJobImpl *p = (MppWorkerJobImpl *)job;
+
+    if (NULL == p) {
+        mpp_err_f("found NULL input\n");
+        return MPP_ERR_NULL_PTR;
+    }
+
+    p->lock.lock();
+    if (!p->stopping) {
+        if (JOB_IDLE == p->status) {
+            p->status = JOB_QUEUED;
+            worker_enqueue(p->pool, p);
+        } else if (JOB_RUNNING == p->status) {
+            p->pending = 1;
+        }
+    }
+    p->lock.unlock();
+
+    return MPP_OK;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_lock_test"
+
+#include <errno.h>
+
+#include "mpp_log.h"
+#include "mpp_thread.h"
+
+/*
+ * lock micro benchmark
+ *
+ * compare osal Mutex / Condition with the recursive pthread mutex and plain
+ * pthread condition which were used before. Adaptive mutex only spins on
+ * multi-core system.
+ */
+#define LOCK_LOOP_COUNT         1000000
+#define CONTEND_LOOP_COUNT      200000
+#define CONTEND_THREAD_COUNT    2
+
+/* mpp_time only works with timing debug so use own clock here */
+static RK_S64 lock_test_time()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (RK_S64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+typedef struct LockTestCtx_t {
+    Mutex           *mutex;
+    pthread_mutex_t *pmutex;
+    RK_S32          loop;
+    RK_S32          count;
+} LockTestCtx;
+
+static void *lock_test_mutex_thread(void *arg)
+{
+    LockTestCtx *ctx = (LockTestCtx *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < ctx->loop; i++) {
+        ctx->mutex->lock();
+        ctx->count++;
+        ctx->mutex->unlock();
+    }
+    return NULL;
+}
+
+static void *lock_test_pmutex_thread(void *arg)
+{
+    LockTestCtx *ctx = (LockTestCtx *)arg;
+    RK_S32 i;
+
+    for (i = 0; i < ctx->loop; i++) {
+        pthread_mutex_lock(ctx->pmutex);
+        ctx->count++;
+        pthread_mutex_unlock(ctx->pmutex);
+    }
+    return NULL;
+}
+
+static RK_S64 lock_test_contend(LockTestCtx *ctx, void *(*func)(void *))
+{
+    pthread_t thds[CONTEND_THREAD_COUNT];
+    RK_S64 time_start = lock_test_time();
+    RK_S32 i;
+
+    for (i = 0; i < CONTEND_THREAD_COUNT; i++)
+        pthread_create(&thds[i], NULL, func, ctx);
+
+    for (i = 0; i < CONTEND_THREAD_COUNT; i++)
+        pthread_join(thds[i], NULL);
+
+    return lock_test_time() - time_start;
+}
+
+static void lock_test_log(const char *name, RK_S64 time, RK_S32 count)
+{
+    mpp_log("%-32s %8.2f ns/op\n", name, (double)time / count);
+}
+
+int main()
+{
+    Mutex mutex;
+    Mutex mutex_adaptive(MPP_MUTEX_ADAPTIVE);
+    Condition cond;
+    pthread_mutex_t pmutex;
+    pthread_mutexattr_t attr;
+    pthread_cond_t pcond;
+    LockTestCtx ctx;
+    RK_S64 time_start;
+    RK_S32 ret = 0;
+    RK_S32 i;
+
+    mpp_log("mpp lock test start\n");
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&pmutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_cond_init(&pcond, NULL);
+
+    /* uncontended lock / unlock */
+    time_start = lock_test_time();
+    for (i = 0; i < LOCK_LOOP_COUNT; i++) {
+        pthread_mutex_lock(&pmutex);
+        pthread_mutex_unlock(&pmutex);
+    }
+    lock_test_log("recursive pthread mutex", lock_test_time() - time_start, LOCK_LOOP_COUNT);
+
+    time_start = lock_test_time();
+    for (i = 0; i < LOCK_LOOP_COUNT; i++) {
+        mutex.lock();
+        mutex.unlock();
+    }
+    lock_test_log("Mutex", lock_test_time() - time_start, LOCK_LOOP_COUNT);
+
+    time_start = lock_test_time();
+    for (i = 0; i < LOCK_LOOP_COUNT; i++) {
+        mutex_adaptive.lock();
+        mutex_adaptive.unlock();
+    }
+    lock_test_log("Mutex adaptive", lock_test_time() - time_start, LOCK_LOOP_COUNT);
+
+    /* contended lock / unlock */
+    ctx.mutex = &mutex;
+    ctx.pmutex = &pmutex;
+    ctx.loop = CONTEND_LOOP_COUNT;
+
+    ctx.count = 0;
+    lock_test_log("recursive pthread mutex contend",
+                  lock_test_contend(&ctx, lock_test_pmutex_thread),
+                  CONTEND_LOOP_COUNT * CONTEND_THREAD_COUNT);
+    if (ctx.count != CONTEND_LOOP_COUNT * CONTEND_THREAD_COUNT) {
+        mpp_err("recursive pthread mutex count %d mismatch\n", ctx.count);
+        ret = -1;
+    }
+
+    ctx.count = 0;
+    lock_test_log("Mutex contend",
+                  lock_test_contend(&ctx, lock_test_mutex_thread),
+                  CONTEND_LOOP_COUNT * CONTEND_THREAD_COUNT);
+    if (ctx.count != CONTEND_LOOP_COUNT * CONTEND_THREAD_COUNT) {
+        mpp_err("Mutex count %d mismatch\n", ctx.count);
+        ret = -1;
+    }
+
+    ctx.mutex = &mutex_adaptive;
+    ctx.count = 0;
+    lock_test_log("Mutex adaptive contend",
+                  lock_test_contend(&ctx, lock_test_mutex_thread),
+                  CONTEND_LOOP_COUNT * CONTEND_THREAD_COUNT);
+    if (ctx.count != CONTEND_LOOP_COUNT * CONTEND_THREAD_COUNT) {
+        mpp_err("Mutex adaptive count %d mismatch\n", ctx.count);
+        ret = -1;
+    }
+
+    /* signal without waiter */
+    time_start = lock_test_time();
+    for (i = 0; i < LOCK_LOOP_COUNT; i++)
+        pthread_cond_signal(&pcond);
+    lock_test_log("pthread cond signal no waiter", lock_test_time() - time_start, LOCK_LOOP_COUNT);
+
+    time_start = lock_test_time();
+    for (i = 0; i < LOCK_LOOP_COUNT; i++)
+        cond.signal();
+    lock_test_log("Condition signal no waiter", lock_test_time() - time_start, LOCK_LOOP_COUNT);
+
+    /* timed wait still returns on timeout */
+    mutex.lock();
+    if (ETIMEDOUT != cond.timedwait(mutex, 1)) {
+        mpp_err("Condition timedwait without signal not timeout\n");
+        ret = -1;
+    }
+    mutex.unlock();
+
+    pthread_cond_destroy(&pcond);
+    pthread_mutex_destroy(&pmutex);
+
+    mpp_log("mpp lock test %s\n", ret ? "failed" : "success");
+    return ret;
+}
@@ -22,6 +22,8 @@
 
 // TODO: need to add pressure test case and parameter scan case
 
+#define MPP_MEM_TEST_POOL_COUNT     16
+
 int main()
 {
     void *tmp = NULL;
@@ -42,6 +44,34 @@ int main()
         }
     }
     mpp_free(tmp);
+
+    {
+        MppMemPool pool = mpp_mem_pool_init(sizeof(RK_S64) * 4);
+        MppMemPoolInfo info;
+        void *objs[MPP_MEM_TEST_POOL_COUNT];
+        RK_S32 loop, i;
+
+        /* after first loop all the object should be reused from pool */
+        for (loop = 0; loop < 4; loop++) {
+            for (i = 0; i < MPP_MEM_TEST_POOL_COUNT; i++)
+                objs[i] = mpp_mem_pool_get(pool);
+
+            for (i = 0; i < MPP_MEM_TEST_POOL_COUNT; i++)
+                mpp_mem_pool_put(pool, objs[i]);
+        }
+
+        mpp_mem_pool_get_info(pool, &info);
+        mpp_show_mem_pool_status();
+        mpp_mem_pool_deinit(pool);
+
+        if (info.malloc_count != MPP_MEM_TEST_POOL_COUNT || info.used_count) {
+            mpp_log("mpp_mem_test pool failed malloc %d used %d\n",
+                    info.malloc_count, info.used_count);
+            return -1;
+        }
+        mpp_log("mpp_mem_test pool success\n");
+    }
+
     mpp_log("mpp_mem_test done\n");
 
     return 0;
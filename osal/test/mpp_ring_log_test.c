@@ -0,0 +1,156 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_ring_log_test"
+
+#include <time.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "mpp_log.h"
+#include "mpp_ring_log.h"
+
+#define RING_LOG_COUNT      1000
+#define RING_THREAD_COUNT   4
+#define RING_LOOP_COUNT     100000
+
+typedef struct RingTestEntry_t {
+    RK_S32      thread;
+    RK_S32      count;
+    RK_S32      check;
+} RingTestEntry;
+
+typedef struct RingTestCtx_t {
+    MppRingLog  log;
+    RK_S32      thread;
+} RingTestCtx;
+
+typedef struct RingDumpCtx_t {
+    RK_S32      count;
+    RK_S32      error;
+    RK_U32      last_seq;
+    RK_S32      last[RING_THREAD_COUNT];
+} RingDumpCtx;
+
+static RK_S64 ring_test_time()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (RK_S64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void *ring_test_thread(void *arg)
+{
+    RingTestCtx *ctx = (RingTestCtx *)arg;
+    RingTestEntry entry;
+    RK_S32 i;
+
+    for (i = 0; i < RING_LOOP_COUNT; i++) {
+        entry.thread = ctx->thread;
+        entry.count = i;
+        entry.check = ~i;
+        mpp_ring_log_add(ctx->log, &entry);
+    }
+    return NULL;
+}
+
+/* entries must be complete and in order for each thread */
+static void ring_test_dump(void *ctx, MppRingLogInfo *info, void *data)
+{
+    RingDumpCtx *p = (RingDumpCtx *)ctx;
+    RingTestEntry *entry = (RingTestEntry *)data;
+
+    if (entry->check != ~entry->count ||
+        entry->thread < 0 || entry->thread >= RING_THREAD_COUNT ||
+        (p->count && info->seq <= p->last_seq) ||
+        entry->count <= p->last[entry->thread]) {
+        p->error++;
+        return;
+    }
+
+    p->last[entry->thread] = entry->count;
+    p->last_seq = info->seq;
+    p->count++;
+}
+
+int main()
+{
+    MppRingLog log = NULL;
+    RingTestCtx ctx[RING_THREAD_COUNT];
+    pthread_t thds[RING_THREAD_COUNT];
+    RingDumpCtx dump;
+    RingTestEntry entry;
+    RK_S64 time_start;
+    RK_S32 ret = 0;
+    RK_S32 i;
+
+    mpp_log("mpp ring log test start\n");
+
+    if (mpp_ring_log_init(&log, sizeof(RingTestEntry), RING_LOG_COUNT)) {
+        mpp_err("mpp ring log init failed\n");
+        return -1;
+    }
+
+    /* single thread cost */
+    time_start = ring_test_time();
+    for (i = 0; i < RING_LOOP_COUNT; i++) {
+        entry.thread = 0;
+        entry.count = i;
+        entry.check = ~i;
+        mpp_ring_log_add(log, &entry);
+    }
+    mpp_log("ring log add %.2f ns/op\n",
+            (double)(ring_test_time() - time_start) / RING_LOOP_COUNT);
+
+    /* concurrent writers with overwrite */
+    mpp_ring_log_reset(log);
+    for (i = 0; i < RING_THREAD_COUNT; i++) {
+        ctx[i].log = log;
+        ctx[i].thread = i;
+        pthread_create(&thds[i], NULL, ring_test_thread, &ctx[i]);
+    }
+    for (i = 0; i < RING_THREAD_COUNT; i++)
+        pthread_join(thds[i], NULL);
+
+    memset(&dump, 0, sizeof(dump));
+    for (i = 0; i < RING_THREAD_COUNT; i++)
+        dump.last[i] = -1;
+
+    mpp_ring_log_dump(log, ring_test_dump, &dump);
+
+    /* capacity is rounded up to power of 2 */
+    if (dump.error || dump.count != 1024 ||
+        dump.last_seq != RING_THREAD_COUNT * RING_LOOP_COUNT) {
+        mpp_err("ring log dump error %d count %d last seq %u\n",
+                dump.error, dump.count, dump.last_seq);
+        ret = -1;
+    }
+
+    /* reset drops all entries */
+    mpp_ring_log_reset(log);
+    memset(&dump, 0, sizeof(dump));
+    mpp_ring_log_dump(log, ring_test_dump, &dump);
+    if (dump.count) {
+        mpp_err("ring log dump %d entries after reset\n", dump.count);
+        ret = -1;
+    }
+
+    mpp_ring_log_deinit(log);
+
+    mpp_log("mpp ring log test %s\n", ret ? "failed" : "success");
+    return ret;
+}
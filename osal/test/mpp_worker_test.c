@@ -0,0 +1,132 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_worker_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_atomic.h"
+#include "mpp_worker.h"
+
+#define MAX_JOB_NUM         8
+#define JOB_STEP_COUNT      1000
+#define JOB_SIGNAL_COUNT    200
+
+typedef struct WorkerTestCtx_t {
+    RK_S32  running;
+    RK_S32  steps;
+    RK_S32  target;
+    RK_S32  error;
+} WorkerTestCtx;
+
+/*
+ * each step checks no other worker is running the same job and asks to run
+ * again until the target step count is reached
+ */
+static RK_S32 worker_test_step(void *ctx)
+{
+    WorkerTestCtx *p = (WorkerTestCtx *)ctx;
+    RK_S32 steps;
+
+    if (MPP_ATOMIC_ADD_FETCH(&p->running, 1) != 1)
+        MPP_ATOMIC_ADD_FETCH(&p->error, 1);
+
+    steps = MPP_ATOMIC_ADD_FETCH(&p->steps, 1);
+
+    MPP_ATOMIC_SUB_FETCH(&p->running, 1);
+
+    return steps < MPP_ATOMIC_LOAD(&p->target);
+}
+
+static RK_S32 worker_test_wait(WorkerTestCtx *ctx, RK_S32 count, RK_S32 target)
+{
+    RK_S32 i;
+    RK_S32 retry = 2000;
+
+    while (retry--) {
+        for (i = 0; i < count; i++) {
+            if (MPP_ATOMIC_LOAD(&ctx[i].steps) < target)
+                break;
+        }
+        if (i == count)
+            return 0;
+        msleep(1);
+    }
+    return -1;
+}
+
+int main()
+{
+    MppWorker worker = NULL;
+    MppWorkerJob jobs[MAX_JOB_NUM];
+    WorkerTestCtx ctx[MAX_JOB_NUM];
+    RK_S32 ret = 0;
+    RK_S32 i, j;
+
+    mpp_log("mpp worker test start\n");
+
+    memset(ctx, 0, sizeof(ctx));
+
+    if (mpp_worker_get(&worker)) {
+        mpp_err("mpp worker get failed\n");
+        return -1;
+    }
+
+    for (i = 0; i < MAX_JOB_NUM; i++) {
+        ctx[i].target = JOB_STEP_COUNT;
+        mpp_worker_job_init(&jobs[i], worker, worker_test_step, &ctx[i]);
+    }
+
+    /* one signal runs each job until it stops asking for another step */
+    for (i = 0; i < MAX_JOB_NUM; i++)
+        mpp_worker_job_signal(jobs[i]);
+
+    if (worker_test_wait(ctx, MAX_JOB_NUM, JOB_STEP_COUNT)) {
+        mpp_err("mpp worker test timeout on step again\n");
+        ret = -1;
+    }
+
+    /* signals on busy job must not be lost */
+    for (i = 0; i < MAX_JOB_NUM; i++)
+        MPP_ATOMIC_STORE(&ctx[i].target, 0);
+
+    for (j = 0; j < JOB_SIGNAL_COUNT; j++) {
+        for (i = 0; i < MAX_JOB_NUM; i++)
+            mpp_worker_job_signal(jobs[i]);
+    }
+
+    if (worker_test_wait(ctx, MAX_JOB_NUM, JOB_STEP_COUNT + 1)) {
+        mpp_err("mpp worker test timeout on signal\n");
+        ret = -1;
+    }
+
+    for (i = 0; i < MAX_JOB_NUM; i++) {
+        mpp_worker_job_deinit(jobs[i]);
+        if (ctx[i].error) {
+            mpp_err("job %d run on two workers at the same time %d times\n",
+                    i, ctx[i].error);
+            ret = -1;
+        }
+        mpp_log("job %d steps %d\n", i, ctx[i].steps);
+    }
+
+    mpp_worker_put(worker);
+
+    mpp_log("mpp worker test %s\n", ret ? "failed" : "success");
+    return ret;
+}
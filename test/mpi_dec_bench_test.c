@@ -0,0 +1,950 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(_WIN32)
+#include "vld.h"
+#endif
+
+#define MODULE_TAG "mpi_dec_bench_test"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#include "rk_mpi.h"
+
+#include "mpp_log.h"
+#include "mpp_mem.h"
+#include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+#include "mpp_thread.h"
+
+#include "utils.h"
+
+/*
+ * multi-instance decoder throughput benchmark
+ *
+ * Each instance decodes one memory mapped input file in its own thread as
+ * fast as the decoder accepts data. Instances are assigned to the input files
+ * in turn so different codecs can run at the same time.
+ *
+ * MJPEG uses the task api with one jpeg per task and up to -c tasks in flight
+ * (MPP_DEC_SET_TASK_COUNT), checking that frames come back in input order.
+ * The other codecs use decode_put_packet / decode_get_frame in split mode with
+ * the put time as packet pts, so frame latency is get time minus frame pts.
+ *
+ * Without RKPLATFORM the hal does not touch hardware, so the benchmark
+ * measures the parser / mpp pipeline overhead on any linux machine.
+ */
+#define MAX_FILE_NAME_LENGTH        256
+#define BENCH_MAX_INPUT             8
+#define BENCH_MAX_INSTANCE          64
+#define BENCH_PACKET_SIZE           (SZ_4K)
+#define BENCH_MAX_TASK_COUNT        8
+/* no frame for this long after eos packet ends the instance */
+#define BENCH_EOS_TIMEOUT_MS        1000
+
+/* mpp_buffer_debug bits: default operation history and lock statistic */
+#define BENCH_BUF_DBG_OPS_HISTORY   (0x00000004)
+#define BENCH_BUF_DBG_LOCK_STAT     (0x00000020)
+
+typedef struct {
+    char            name[MAX_FILE_NAME_LENGTH];
+    MppCodingType   type;
+
+    RK_U8           *data;
+    size_t          size;
+
+    /* jpeg position for MJPEG task mode */
+    size_t          *jpeg_pos;
+    size_t          *jpeg_len;
+    RK_S32          jpeg_count;
+} MpiDecBenchInput;
+
+typedef struct {
+    RK_S32          idx;
+    MpiDecBenchInput *input;
+    RK_U32          loop;
+    size_t          packet_size;
+    RK_U32          worker;
+    RK_S32          task_count;
+    RK_U32          sync;
+    RK_U32          width;
+    RK_U32          height;
+
+    MppCtx          ctx;
+    MppApi          *mpi;
+    pthread_t       thd;
+
+    /* result */
+    RK_S32          ret;
+    RK_U32          eos_timeout;
+    RK_S64          time_start;
+    RK_S64          time_end;
+    RK_S32          frame_count;
+    RK_S32          error_count;
+    RK_S64          *latency;
+    RK_S32          latency_count;
+    RK_S32          latency_size;
+} MpiDecBenchInst;
+
+typedef struct {
+    MpiDecBenchInput inputs[BENCH_MAX_INPUT];
+    RK_S32          input_count;
+    RK_S32          instance;
+    RK_U32          loop;
+    size_t          packet_size;
+    RK_U32          worker;
+    RK_S32          task_count;
+    RK_U32          sync;
+    RK_U32          width;
+    RK_U32          height;
+    RK_U32          debug;
+} MpiDecBenchCmd;
+
+static OptionInfo mpi_dec_bench_cmd[] = {
+    {"i",               "input_file",           "input bitstream file, can be set multiple times"},
+    {"t",               "type",                 "coding type of the input file(s) after it, default H.264"},
+    {"n",               "instance",             "decoder instance count, default 1"},
+    {"l",               "loop",                 "decode the input file loop times per instance, default 1"},
+    {"s",               "packet_size",          "packet size for split mode, default 4096"},
+    {"p",               "worker",               "use shared worker pool for decoder threads"},
+    {"c",               "task_count",           "MJPEG tasks in flight per instance, default 1"},
+    {"y",               "sync",                 "use synchronous mpi decode on instance thread"},
+    {"w",               "width",                "max width for MJPEG output buffer"},
+    {"h",               "height",               "max height for MJPEG output buffer"},
+    {"d",               "debug",                "debug flag"},
+};
+
+/* mpp_time only works with timing debug so use own clock here */
+static RK_S64 bench_time_us()
+{
+#if defined(_WIN32)
+    return (RK_S64)GetTickCount() * 1000;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (RK_S64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static RK_S64 bench_cpu_us()
+{
+#if defined(_WIN32)
+    return 0;
+#else
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (RK_S64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+static void bench_idle()
+{
+#if defined(_WIN32)
+    Sleep(0);
+#else
+    usleep(100);
+#endif
+}
+
+static MPP_RET bench_input_open(MpiDecBenchInput *input)
+{
+#if defined(_WIN32)
+    FILE *fp = fopen(input->name, "rb");
+
+    if (NULL == fp) {
+        mpp_err("failed to open input file %s\n", input->name);
+        return MPP_NOK;
+    }
+
+    fseek(fp, 0L, SEEK_END);
+    input->size = ftell(fp);
+    rewind(fp);
+
+    input->data = mpp_malloc(RK_U8, input->size);
+    if (input->data)
+        fread(input->data, 1, input->size, fp);
+    fclose(fp);
+#else
+    struct stat st;
+    int fd = open(input->name, O_RDONLY);
+
+    if (fd < 0) {
+        mpp_err("failed to open input file %s\n", input->name);
+        return MPP_NOK;
+    }
+
+    if (fstat(fd, &st) || st.st_size <= 0) {
+        mpp_err("invalid input file %s\n", input->name);
+        close(fd);
+        return MPP_NOK;
+    }
+
+    input->size = st.st_size;
+    input->data = (RK_U8 *)mmap(NULL, input->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == input->data)
+        input->data = NULL;
+#endif
+
+    if (NULL == input->data) {
+        mpp_err("failed to map input file %s\n", input->name);
+        return MPP_NOK;
+    }
+
+    if (input->type == MPP_VIDEO_CodingMJPEG) {
+        /* one jpeg is from SOI to the next EOI */
+        RK_U8 *p = input->data;
+        size_t size = input->size;
+        size_t start = 0;
+        RK_S32 in_jpeg = 0;
+        size_t i;
+
+        for (i = 0; i + 1 < size; i++) {
+            if (p[i] != 0xff)
+                continue;
+
+            if (!in_jpeg && p[i + 1] == 0xd8) {
+                start = i;
+                in_jpeg = 1;
+            } else if (in_jpeg && p[i + 1] == 0xd9) {
+                if (!(input->jpeg_count & 15)) {
+                    input->jpeg_pos = mpp_realloc(input->jpeg_pos, size_t, input->jpeg_count + 16);
+                    input->jpeg_len = mpp_realloc(input->jpeg_len, size_t, input->jpeg_count + 16);
+                    if (NULL == input->jpeg_pos || NULL == input->jpeg_len)
+                        return MPP_ERR_MALLOC;
+                }
+                input->jpeg_pos[input->jpeg_count] = start;
+                input->jpeg_len[input->jpeg_count] = i + 2 - start;
+                input->jpeg_count++;
+                in_jpeg = 0;
+            }
+        }
+
+        if (!input->jpeg_count) {
+            mpp_err("no jpeg found in %s\n", input->name);
+            return MPP_NOK;
+        }
+    }
+
+    mpp_log("input %s type %d size %d\n", input->name, input->type, input->size);
+    return MPP_OK;
+}
+
+static void bench_input_close(MpiDecBenchInput *input)
+{
+    if (input->data) {
+#if defined(_WIN32)
+        mpp_free(input->data);
+#else
+        munmap(input->data, input->size);
+#endif
+        input->data = NULL;
+    }
+
+    MPP_FREE(input->jpeg_pos);
+    MPP_FREE(input->jpeg_len);
+}
+
+static void bench_add_latency(MpiDecBenchInst *inst, RK_S64 latency)
+{
+    if (inst->latency_count >= inst->latency_size) {
+        RK_S32 size = inst->latency_size ? inst->latency_size * 2 : 1024;
+
+        inst->latency = mpp_realloc(inst->latency, RK_S64, size);
+        if (NULL == inst->latency) {
+            inst->latency_size = inst->latency_count = 0;
+            return;
+        }
+        inst->latency_size = size;
+    }
+
+    inst->latency[inst->latency_count++] = latency;
+}
+
+static MPP_RET bench_decode_simple(MpiDecBenchInst *inst)
+{
+    MpiDecBenchInput *input = inst->input;
+    MppCtx ctx  = inst->ctx;
+    MppApi *mpi = inst->mpi;
+    MppPacket packet = NULL;
+    size_t pos = 0;
+    RK_U32 loop = 0;
+    RK_U32 pkt_eos = 0;
+    RK_S64 idle_start = 0;
+    MPP_RET ret = MPP_OK;
+
+    while (1) {
+        MppFrame frame = NULL;
+
+        /* keep input queue full */
+        if (!pkt_eos) {
+            if (NULL == packet) {
+                size_t len = MPP_MIN(input->size - pos, inst->packet_size);
+
+                mpp_packet_init(&packet, input->data + pos, len);
+                mpp_packet_set_pts(packet, bench_time_us());
+                if (pos + len >= input->size && loop + 1 >= inst->loop)
+                    mpp_packet_set_eos(packet);
+            }
+
+            if (MPP_OK == mpi->decode_put_packet(ctx, packet)) {
+                pkt_eos = mpp_packet_get_eos(packet);
+                pos += inst->packet_size;
+                if (pos >= input->size) {
+                    pos = 0;
+                    loop++;
+                }
+
+                mpp_packet_deinit(&packet);
+                packet = NULL;
+                continue;
+            }
+        }
+
+        /* input is full or done, wait for frame with output timeout */
+        ret = mpi->decode_get_frame(ctx, &frame);
+        if (ret) {
+            mpp_err("instance %d decode_get_frame failed ret %d\n", inst->idx, ret);
+            break;
+        }
+
+        if (NULL == frame) {
+            if (pkt_eos) {
+                RK_S64 now = bench_time_us();
+
+                if (!idle_start)
+                    idle_start = now;
+                else if (now - idle_start > BENCH_EOS_TIMEOUT_MS * 1000) {
+                    inst->eos_timeout = 1;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        idle_start = 0;
+
+        if (mpp_frame_get_info_change(frame)) {
+            mpi->control(ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
+        } else {
+            RK_U32 eos = mpp_frame_get_eos(frame);
+            RK_S64 pts = mpp_frame_get_pts(frame);
+
+            /* eos frame may be an empty frame without buffer */
+            if (mpp_frame_get_buffer(frame) || !eos) {
+                RK_S64 now = bench_time_us();
+
+                if (mpp_frame_get_errinfo(frame) || mpp_frame_get_discard(frame))
+                    inst->error_count++;
+
+                if (pts > 0 && pts <= now)
+                    bench_add_latency(inst, now - pts);
+
+                inst->frame_count++;
+                inst->time_end = now;
+            }
+
+            if (eos) {
+                mpp_frame_deinit(&frame);
+                break;
+            }
+        }
+        mpp_frame_deinit(&frame);
+    }
+
+    if (packet)
+        mpp_packet_deinit(&packet);
+
+    return ret;
+}
+
+/*
+ * keep up to task_count jpeg in flight, each one with its own packet and
+ * frame buffer. Output must come back in input order.
+ */
+static MPP_RET bench_decode_task(MpiDecBenchInst *inst)
+{
+    MpiDecBenchInput *input = inst->input;
+    MppCtx ctx  = inst->ctx;
+    MppApi *mpi = inst->mpi;
+    RK_S32 count = inst->task_count;
+    MppBufferGroup frm_grp = NULL;
+    MppBufferGroup pkt_grp = NULL;
+    MppBuffer frm_buf[BENCH_MAX_TASK_COUNT];
+    MppBuffer pkt_buf[BENCH_MAX_TASK_COUNT];
+    MppPacket packets[BENCH_MAX_TASK_COUNT];
+    MppFrame frames[BENCH_MAX_TASK_COUNT];
+    RK_S64 starts[BENCH_MAX_TASK_COUNT];
+    size_t max_len = 0;
+    size_t frm_size;
+    RK_U32 width  = inst->width  ? inst->width  : 1920;
+    RK_U32 height = inst->height ? inst->height : 1088;
+    RK_S32 total = input->jpeg_count * inst->loop;
+    RK_S32 sent = 0;
+    RK_S32 done = 0;
+    RK_S32 i;
+    MPP_RET ret = MPP_NOK;
+
+    memset(frm_buf, 0, sizeof(frm_buf));
+    memset(pkt_buf, 0, sizeof(pkt_buf));
+    memset(packets, 0, sizeof(packets));
+    memset(frames, 0, sizeof(frames));
+
+    for (i = 0; i < input->jpeg_count; i++)
+        max_len = MPP_MAX(max_len, input->jpeg_len[i]);
+
+    /* yuv422 at most */
+    frm_size = MPP_ALIGN(width, 16) * MPP_ALIGN(height, 16) * 2;
+
+    do {
+        if (mpp_buffer_group_get_internal(&frm_grp, MPP_BUFFER_TYPE_ION) ||
+            mpp_buffer_group_get_internal(&pkt_grp, MPP_BUFFER_TYPE_ION)) {
+            mpp_err("instance %d failed to get buffer group\n", inst->idx);
+            break;
+        }
+
+        for (i = 0; i < count; i++) {
+            if (mpp_buffer_get(frm_grp, &frm_buf[i], frm_size) ||
+                mpp_buffer_get(pkt_grp, &pkt_buf[i], max_len))
+                break;
+
+            mpp_packet_init_with_buffer(&packets[i], pkt_buf[i]);
+            mpp_frame_init(&frames[i]);
+            mpp_frame_set_buffer(frames[i], frm_buf[i]);
+        }
+
+        if (i < count) {
+            mpp_err("instance %d failed to get buffer\n", inst->idx);
+            break;
+        }
+
+        ret = MPP_OK;
+    } while (0);
+
+    while (!ret && done < total) {
+        MppTask task = NULL;
+
+        /* fill the pipeline */
+        while (sent < total && sent - done < count) {
+            RK_S32 idx = sent % count;
+            RK_S32 jpeg = sent % input->jpeg_count;
+            MppPacket packet = packets[idx];
+
+            task = NULL;
+            ret = mpi->dequeue(ctx, MPP_PORT_INPUT, &task);
+            if (ret || NULL == task)
+                break;
+
+            mpp_buffer_write(pkt_buf[idx], 0, input->data + input->jpeg_pos[jpeg],
+                             input->jpeg_len[jpeg]);
+            mpp_packet_set_pos(packet, mpp_buffer_get_ptr(pkt_buf[idx]));
+            mpp_packet_set_length(packet, input->jpeg_len[jpeg]);
+            if (sent + 1 == total)
+                mpp_packet_set_eos(packet);
+
+            mpp_task_meta_set_packet(task, KEY_INPUT_PACKET, packet);
+            mpp_task_meta_set_frame(task, KEY_OUTPUT_FRAME, frames[idx]);
+
+            starts[idx] = bench_time_us();
+            ret = mpi->enqueue(ctx, MPP_PORT_INPUT, task);
+            if (ret)
+                break;
+
+            sent++;
+        }
+
+        if (ret)
+            break;
+
+        /* collect output in input order */
+        task = NULL;
+        ret = mpi->dequeue(ctx, MPP_PORT_OUTPUT, &task);
+        if (ret)
+            break;
+
+        if (NULL == task) {
+            bench_idle();
+            continue;
+        }
+
+        {
+            RK_S32 idx = done % count;
+            MppFrame frame_out = NULL;
+            RK_S64 now = bench_time_us();
+
+            mpp_task_meta_get_frame(task, KEY_OUTPUT_FRAME, &frame_out);
+            if (frame_out != frames[idx]) {
+                mpp_err("instance %d task %d output out of order\n", inst->idx, done);
+                inst->error_count++;
+            } else if (mpp_frame_get_errinfo(frame_out)) {
+                inst->error_count++;
+            }
+
+            bench_add_latency(inst, now - starts[idx]);
+            inst->frame_count++;
+            inst->time_end = now;
+            done++;
+        }
+
+        ret = mpi->enqueue(ctx, MPP_PORT_OUTPUT, task);
+    }
+
+    if (ret)
+        mpp_err("instance %d task decode failed ret %d\n", inst->idx, ret);
+
+    for (i = 0; i < count; i++) {
+        if (packets[i])
+            mpp_packet_deinit(&packets[i]);
+        if (frames[i])
+            mpp_frame_deinit(&frames[i]);
+        if (pkt_buf[i])
+            mpp_buffer_put(pkt_buf[i]);
+        if (frm_buf[i])
+            mpp_buffer_put(frm_buf[i]);
+    }
+    if (pkt_grp)
+        mpp_buffer_group_put(pkt_grp);
+    if (frm_grp)
+        mpp_buffer_group_put(frm_grp);
+
+    return ret;
+}
+
+/*
+ * one packet in and the ready frame out in each mpi->decode call. MJPEG
+ * sends one jpeg per packet and the other codecs split by packet size.
+ * Empty packets drain the frames left after the eos packet.
+ */
+static MPP_RET bench_decode_sync(MpiDecBenchInst *inst)
+{
+    MpiDecBenchInput *input = inst->input;
+    MppCtx ctx  = inst->ctx;
+    MppApi *mpi = inst->mpi;
+    RK_U32 is_jpeg = (input->type == MPP_VIDEO_CodingMJPEG);
+    RK_S32 count = (is_jpeg) ? (input->jpeg_count) :
+                   (RK_S32)((input->size + inst->packet_size - 1) / inst->packet_size);
+    RK_S32 total = count * inst->loop;
+    RK_S32 sent = 0;
+    RK_S64 idle_start = 0;
+    MPP_RET ret = MPP_OK;
+
+    while (1) {
+        MppPacket packet = NULL;
+        MppFrame frame = NULL;
+
+        if (sent < total) {
+            RK_S32 idx = sent % count;
+            size_t pos = (is_jpeg) ? (input->jpeg_pos[idx]) : (idx * inst->packet_size);
+            size_t len = (is_jpeg) ? (input->jpeg_len[idx]) :
+                         (MPP_MIN(input->size - pos, inst->packet_size));
+
+            mpp_packet_init(&packet, input->data + pos, len);
+            if (++sent == total)
+                mpp_packet_set_eos(packet);
+        } else {
+            mpp_packet_init(&packet, NULL, 0);
+        }
+        mpp_packet_set_pts(packet, bench_time_us());
+
+        ret = mpi->decode(ctx, packet, &frame);
+        mpp_packet_deinit(&packet);
+        if (ret) {
+            mpp_err("instance %d decode failed ret %d\n", inst->idx, ret);
+            break;
+        }
+
+        if (NULL == frame) {
+            if (sent == total) {
+                RK_S64 now = bench_time_us();
+
+                if (!idle_start)
+                    idle_start = now;
+                else if (now - idle_start > BENCH_EOS_TIMEOUT_MS * 1000) {
+                    inst->eos_timeout = 1;
+                    break;
+                }
+            }
+            continue;
+        }
+
+        idle_start = 0;
+
+        if (mpp_frame_get_info_change(frame)) {
+            mpi->control(ctx, MPP_DEC_SET_INFO_CHANGE_READY, NULL);
+        } else {
+            RK_U32 eos = mpp_frame_get_eos(frame);
+
+            if (mpp_frame_get_buffer(frame) || !eos) {
+                RK_S64 now = bench_time_us();
+                RK_S64 pts = mpp_frame_get_pts(frame);
+
+                if (mpp_frame_get_errinfo(frame) || mpp_frame_get_discard(frame))
+                    inst->error_count++;
+
+                if (pts > 0 && pts <= now)
+                    bench_add_latency(inst, now - pts);
+
+                inst->frame_count++;
+                inst->time_end = now;
+            }
+
+            if (eos) {
+                mpp_frame_deinit(&frame);
+                break;
+            }
+        }
+        mpp_frame_deinit(&frame);
+    }
+
+    return ret;
+}
+
+static void *bench_thread(void *arg)
+{
+    MpiDecBenchInst *inst = (MpiDecBenchInst *)arg;
+    MppCodingType type = inst->input->type;
+    RK_U32 need_split = 1;
+    RK_S64 timeout = 1;
+    MPP_RET ret;
+
+    do {
+        ret = mpp_create(&inst->ctx, &inst->mpi);
+        if (ret) {
+            mpp_err("instance %d mpp_create failed\n", inst->idx);
+            break;
+        }
+
+        if (type == MPP_VIDEO_CodingMJPEG) {
+            inst->mpi->control(inst->ctx, MPP_DEC_SET_TASK_COUNT, &inst->task_count);
+        } else {
+            // NOTE: decoder split mode need to be set before init
+            inst->mpi->control(inst->ctx, MPP_DEC_SET_PARSER_SPLIT_MODE, &need_split);
+            /* wait frame in get_frame instead of polling */
+            inst->mpi->control(inst->ctx, MPP_SET_OUTPUT_TIMEOUT, &timeout);
+            if (inst->worker)
+                inst->mpi->control(inst->ctx, MPP_SET_WORKER_MODE, &inst->worker);
+        }
+
+        ret = mpp_init(inst->ctx, MPP_CTX_DEC, type);
+        if (ret) {
+            mpp_err("instance %d mpp_init failed\n", inst->idx);
+            break;
+        }
+
+        inst->time_start = bench_time_us();
+        inst->time_end = inst->time_start;
+
+        if (inst->sync)
+            ret = bench_decode_sync(inst);
+        else if (type == MPP_VIDEO_CodingMJPEG)
+            ret = bench_decode_task(inst);
+        else
+            ret = bench_decode_simple(inst);
+    } while (0);
+
+    if (inst->ctx) {
+        mpp_destroy(inst->ctx);
+        inst->ctx = NULL;
+    }
+
+    inst->ret = ret;
+    return NULL;
+}
+
+static int bench_cmp_s64(const void *a, const void *b)
+{
+    RK_S64 va = *(const RK_S64 *)a;
+    RK_S64 vb = *(const RK_S64 *)b;
+
+    return (va > vb) - (va < vb);
+}
+
+static void bench_report(MpiDecBenchInst *insts, RK_S32 count, RK_S64 time, RK_S64 cpu)
+{
+    MppBufferLockStat stat;
+    RK_S32 total = 0;
+    RK_S32 i;
+
+    mpp_log("inst type      frames    fps   p50 ms   p99 ms  errors\n");
+
+    for (i = 0; i < count; i++) {
+        MpiDecBenchInst *inst = &insts[i];
+        RK_S64 duration = inst->time_end - inst->time_start;
+        float fps = duration > 0 ? inst->frame_count * 1000000.0 / duration : 0;
+        float p50 = 0;
+        float p99 = 0;
+
+        if (inst->latency_count) {
+            RK_S32 n = inst->latency_count;
+
+            qsort(inst->latency, n, sizeof(RK_S64), bench_cmp_s64);
+            p50 = inst->latency[(n - 1) * 50 / 100] / 1000.0;
+            p99 = inst->latency[(n - 1) * 99 / 100] / 1000.0;
+        }
+
+        mpp_log("%4d %8x %7d %7.1f %8.2f %8.2f %7d%s%s\n", i, inst->input->type,
+                inst->frame_count, fps, p50, p99, inst->error_count,
+                inst->eos_timeout ? " eos timeout" : "",
+                inst->ret ? " failed" : "");
+        total += inst->frame_count;
+    }
+
+    mpp_log("total frames %d time %.1f ms fps %.1f\n", total, time / 1000.0,
+            time > 0 ? total * 1000000.0 / time : 0);
+    if (total && cpu)
+        mpp_log("cpu time %.1f ms %.1f us per frame\n", cpu / 1000.0, (float)cpu / total);
+
+    if (!mpp_buffer_lock_stat(&stat))
+        mpp_log("buffer lock %u contended %u (%.2f%%)\n",
+                stat.lock_count, stat.contend_count,
+                stat.lock_count ? stat.contend_count * 100.0 / stat.lock_count : 0);
+}
+
+static RK_S32 mpi_dec_bench(MpiDecBenchCmd *cmd)
+{
+    MpiDecBenchInst *insts = NULL;
+    RK_S64 time_start;
+    RK_S64 cpu_start;
+    RK_S32 ret = MPP_NOK;
+    RK_S32 i;
+
+    for (i = 0; i < cmd->input_count; i++) {
+        if (bench_input_open(&cmd->inputs[i]))
+            goto BENCH_OUT;
+    }
+
+    insts = mpp_calloc(MpiDecBenchInst, cmd->instance);
+    if (NULL == insts) {
+        mpp_err("failed to malloc instances\n");
+        goto BENCH_OUT;
+    }
+
+    for (i = 0; i < cmd->instance; i++) {
+        MpiDecBenchInst *inst = &insts[i];
+
+        inst->idx = i;
+        inst->input = &cmd->inputs[i % cmd->input_count];
+        inst->loop = cmd->loop;
+        inst->packet_size = cmd->packet_size;
+        inst->worker = cmd->worker;
+        inst->task_count = cmd->task_count;
+        inst->sync = cmd->sync;
+        inst->width = cmd->width;
+        inst->height = cmd->height;
+    }
+
+    time_start = bench_time_us();
+    cpu_start = bench_cpu_us();
+
+    for (i = 0; i < cmd->instance; i++)
+        pthread_create(&insts[i].thd, NULL, bench_thread, &insts[i]);
+
+    ret = MPP_OK;
+    for (i = 0; i < cmd->instance; i++) {
+        pthread_join(insts[i].thd, NULL);
+        if (insts[i].ret)
+            ret = insts[i].ret;
+    }
+
+    bench_report(insts, cmd->instance, bench_time_us() - time_start,
+                 bench_cpu_us() - cpu_start);
+
+BENCH_OUT:
+    if (insts) {
+        for (i = 0; i < cmd->instance; i++)
+            MPP_FREE(insts[i].latency);
+        mpp_free(insts);
+    }
+
+    for (i = 0; i < cmd->input_count; i++)
+        bench_input_close(&cmd->inputs[i]);
+
+    return ret;
+}
+
+static void mpi_dec_bench_help()
+{
+    mpp_log("usage: mpi_dec_bench_test [options]\n");
+    show_options(mpi_dec_bench_cmd);
+    mpp_show_support_format();
+}
+
+static RK_S32 mpi_dec_bench_parse_options(int argc, char **argv, MpiDecBenchCmd *cmd)
+{
+    const char *opt;
+    const char *next;
+    RK_S32 optindex = 1;
+    MppCodingType type = MPP_VIDEO_CodingAVC;
+    RK_S32 err = MPP_NOK;
+
+    if ((argc < 2) || (cmd == NULL))
+        return 1;
+
+    while (optindex < argc) {
+        opt  = (const char*)argv[optindex++];
+        next = (const char*)argv[optindex];
+
+        if (opt[0] != '-' || opt[1] == '\0')
+            goto PARSE_OPINIONS_OUT;
+
+        opt++;
+
+        /* options without value */
+        if (*opt == 'p') {
+            cmd->worker = 1;
+            continue;
+        }
+        if (*opt == 'y') {
+            cmd->sync = 1;
+            continue;
+        }
+
+        if ((*opt == 'h') && !strncmp(opt, "help", 4)) {
+            err = 1;
+            goto PARSE_OPINIONS_OUT;
+        }
+
+        if (!next) {
+            mpp_err("option -%s needs a value\n", opt);
+            goto PARSE_OPINIONS_OUT;
+        }
+
+        switch (*opt) {
+        case 'i': {
+            MpiDecBenchInput *input;
+
+            if (cmd->input_count >= BENCH_MAX_INPUT) {
+                mpp_err("too many input files\n");
+                goto PARSE_OPINIONS_OUT;
+            }
+            input = &cmd->inputs[cmd->input_count++];
+            strncpy(input->name, next, MAX_FILE_NAME_LENGTH - 1);
+            input->type = type;
+        } break;
+        case 't': {
+            type = (MppCodingType)atoi(next);
+            if (mpp_check_support_format(MPP_CTX_DEC, type)) {
+                mpp_err("invalid input coding type\n");
+                goto PARSE_OPINIONS_OUT;
+            }
+            /* type after -i applies to that file */
+            if (cmd->input_count)
+                cmd->inputs[cmd->input_count - 1].type = type;
+        } break;
+        case 'n': {
+            cmd->instance = atoi(next);
+        } break;
+        case 'l': {
+            cmd->loop = atoi(next);
+        } break;
+        case 's': {
+            cmd->packet_size = atoi(next);
+        } break;
+        case 'c': {
+            cmd->task_count = atoi(next);
+        } break;
+        case 'w': {
+            cmd->width = atoi(next);
+        } break;
+        case 'h': {
+            cmd->height = atoi(next);
+        } break;
+        case 'd': {
+            cmd->debug = atoi(next);
+        } break;
+        default: {
+            goto PARSE_OPINIONS_OUT;
+        } break;
+        }
+
+        optindex++;
+    }
+
+    if (!cmd->input_count) {
+        mpp_err("no input file\n");
+        goto PARSE_OPINIONS_OUT;
+    }
+
+    if (cmd->instance <= 0 || cmd->instance > BENCH_MAX_INSTANCE) {
+        mpp_err("invalid instance count %d\n", cmd->instance);
+        goto PARSE_OPINIONS_OUT;
+    }
+
+    if (!cmd->loop)
+        cmd->loop = 1;
+
+    if (!cmd->packet_size)
+        cmd->packet_size = BENCH_PACKET_SIZE;
+
+    if (cmd->task_count <= 0)
+        cmd->task_count = 1;
+    else if (cmd->task_count > BENCH_MAX_TASK_COUNT)
+        cmd->task_count = BENCH_MAX_TASK_COUNT;
+
+    err = 0;
+
+PARSE_OPINIONS_OUT:
+    return err;
+}
+
+int main(int argc, char **argv)
+{
+    MpiDecBenchCmd cmd;
+    RK_U32 buf_debug = 0;
+    RK_S32 ret;
+
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.instance = 1;
+
+    ret = mpi_dec_bench_parse_options(argc, argv, &cmd);
+    if (ret) {
+        mpi_dec_bench_help();
+        return ret;
+    }
+
+    mpp_log("mpi_dec_bench_test instance %d input %d loop %d packet size %d worker %d task %d sync %d\n",
+            cmd.instance, cmd.input_count, cmd.loop, cmd.packet_size, cmd.worker,
+            cmd.task_count, cmd.sync);
+
+    mpp_env_set_u32("mpi_debug", cmd.debug);
+
+    /* keep the default buffer history and count buffer lock contention */
+    mpp_env_get_u32("mpp_buffer_debug", &buf_debug, BENCH_BUF_DBG_OPS_HISTORY);
+    mpp_env_set_u32("mpp_buffer_debug", buf_debug | BENCH_BUF_DBG_LOCK_STAT);
+
+    ret = mpi_dec_bench(&cmd);
+    if (MPP_OK == ret)
+        mpp_log("test success\n");
+    else
+        mpp_err("test failed ret %d\n", ret);
+
+    mpp_env_set_u32("mpi_debug", 0x0);
+    return ret;
+}
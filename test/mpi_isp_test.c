@@ -0,0 +1,457 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(_WIN32)
+#include "vld.h"
+#endif
+
+#define MODULE_TAG "mpi_isp_test"
+
+#include <stdlib.h>
+#include <string.h>
+#include "rk_mpi.h"
+#include "mpp_log.h"
+#include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_common.h"
+
+#define ISP_TEST_WIDTH          256
+#define ISP_TEST_HEIGHT         64
+#define ISP_TEST_ASYNC_COUNT    8
+#define ISP_TEST_BENCH_COUNT    10
+
+typedef struct {
+    MppFrameFormat  fmt;
+    const char      *name;
+} IspTestFmt;
+
+static const IspTestFmt src_fmts[] = {
+    { MPP_FMT_YUV420SP,     "nv12",     },
+    { MPP_FMT_YUV420SP_VU,  "nv21",     },
+    { MPP_FMT_YUV420P,      "i420",     },
+    { MPP_FMT_YUV422SP,     "nv16",     },
+    { MPP_FMT_YUV422SP_VU,  "nv61",     },
+    { MPP_FMT_YUV422P,      "i422",     },
+};
+
+static const IspTestFmt dst_fmts[] = {
+    { MPP_FMT_RGB565,       "rgb565",   },
+    { MPP_FMT_BGR565,       "bgr565",   },
+    { MPP_FMT_RGB888,       "rgb888",   },
+    { MPP_FMT_BGR888,       "bgr888",   },
+    { MPP_FMT_ARGB8888,     "argb8888", },
+    { MPP_FMT_ABGR8888,     "abgr8888", },
+};
+
+/* constant chroma pairs to check the matrix on the whole luma range */
+static const RK_U8 test_uv[][2] = {
+    { 128, 128, }, {  16,  16, }, { 240, 240, }, {  16, 240, },
+    { 240,  16, }, {  90, 240, }, {  54,  34, }, { 166, 110, },
+};
+
+static MppBufferGroup group = NULL;
+
+static MppFrame test_frame_init(MppFrameFormat fmt, RK_S32 w, RK_S32 h)
+{
+    MppFrame frame = NULL;
+    MppBuffer buffer = NULL;
+    RK_S32 hor_stride = MPP_ALIGN(w, 16);
+    RK_S32 ver_stride = MPP_ALIGN(h, 16);
+
+    if (mpp_buffer_get(group, &buffer, hor_stride * ver_stride * 4))
+        return NULL;
+
+    mpp_frame_init(&frame);
+    mpp_frame_set_fmt(frame, fmt);
+    mpp_frame_set_width(frame, w);
+    mpp_frame_set_height(frame, h);
+    mpp_frame_set_hor_stride(frame, hor_stride);
+    mpp_frame_set_ver_stride(frame, ver_stride);
+    mpp_frame_set_buffer(frame, buffer);
+    mpp_buffer_put(buffer);
+    return frame;
+}
+
+/* luma as horizontal + vertical ramp and constant chroma u / v */
+static void test_frame_fill(MppFrame frame, RK_U8 cb, RK_U8 cr)
+{
+    MppFrameFormat fmt = mpp_frame_get_fmt(frame);
+    RK_S32 w  = mpp_frame_get_width(frame);
+    RK_S32 h  = mpp_frame_get_height(frame);
+    RK_S32 hs = mpp_frame_get_hor_stride(frame);
+    RK_S32 vs = mpp_frame_get_ver_stride(frame);
+    RK_U8 *ptr = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(frame));
+    RK_U8 *c = ptr + hs * vs;
+    RK_S32 is422 = (fmt == MPP_FMT_YUV422SP || fmt == MPP_FMT_YUV422SP_VU ||
+                    fmt == MPP_FMT_YUV422P);
+    RK_S32 chroma_size = is422 ? hs * vs : hs * vs / 2;
+    RK_S32 x, y;
+
+    for (y = 0; y < h; y++)
+        for (x = 0; x < w; x++)
+            ptr[y * hs + x] = (RK_U8)(x + y);
+
+    if (fmt == MPP_FMT_YUV420P || fmt == MPP_FMT_YUV422P) {
+        memset(c, cb, chroma_size / 2);
+        memset(c + chroma_size / 2, cr, chroma_size / 2);
+    } else {
+        RK_S32 swap = (fmt == MPP_FMT_YUV420SP_VU || fmt == MPP_FMT_YUV422SP_VU);
+
+        for (x = 0; x < chroma_size; x += 2) {
+            c[x + swap]  = cb;
+            c[x + !swap] = cr;
+        }
+    }
+}
+
+static RK_S32 test_clip(double v)
+{
+    RK_S32 i = (RK_S32)(v + 0.5);
+    return i < 0 ? 0 : (i > 255 ? 255 : i);
+}
+
+/* BT.601 limited range reference */
+static void test_ref_rgb(RK_S32 y, RK_S32 cb, RK_S32 cr, RK_S32 *rgb)
+{
+    double l = 1.164 * (y - 16);
+
+    rgb[0] = test_clip(l + 1.596 * (cr - 128));
+    rgb[1] = test_clip(l - 0.391 * (cb - 128) - 0.813 * (cr - 128));
+    rgb[2] = test_clip(l + 2.018 * (cb - 128));
+}
+
+/* unpack one pixel to r g b, 565 channels are scaled back to 8 bit */
+static void test_get_rgb(RK_U8 *p, MppFrameFormat fmt, RK_S32 *rgb)
+{
+    switch (fmt) {
+    case MPP_FMT_RGB565 :
+    case MPP_FMT_BGR565 : {
+        RK_U16 v = *(RK_U16 *)p;
+        RK_S32 hi = (v >> 11) << 3;
+        RK_S32 lo = (v & 0x1f) << 3;
+
+        rgb[0] = (fmt == MPP_FMT_RGB565) ? hi : lo;
+        rgb[1] = ((v >> 5) & 0x3f) << 2;
+        rgb[2] = (fmt == MPP_FMT_RGB565) ? lo : hi;
+    } break;
+    case MPP_FMT_RGB888 : {
+        rgb[0] = p[0];
+        rgb[1] = p[1];
+        rgb[2] = p[2];
+    } break;
+    case MPP_FMT_BGR888 : {
+        rgb[0] = p[2];
+        rgb[1] = p[1];
+        rgb[2] = p[0];
+    } break;
+    case MPP_FMT_ARGB8888 :
+    case MPP_FMT_ABGR8888 : {
+        RK_U32 v = *(RK_U32 *)p;
+        RK_S32 hi = (v >> 16) & 0xff;
+        RK_S32 lo = v & 0xff;
+
+        rgb[0] = (fmt == MPP_FMT_ARGB8888) ? hi : lo;
+        rgb[1] = (v >> 8) & 0xff;
+        rgb[2] = (fmt == MPP_FMT_ARGB8888) ? lo : hi;
+    } break;
+    default : {
+    } break;
+    }
+}
+
+static RK_S32 test_bpp(MppFrameFormat fmt)
+{
+    if (fmt == MPP_FMT_RGB565 || fmt == MPP_FMT_BGR565)
+        return 2;
+    if (fmt == MPP_FMT_RGB888 || fmt == MPP_FMT_BGR888)
+        return 3;
+    return 4;
+}
+
+/* conversion without scaling against floating point reference */
+static MPP_RET isp_test_convert(MppCtx ctx, MppApi *mpi)
+{
+    MppFrame dst = test_frame_init(MPP_FMT_ARGB8888, ISP_TEST_WIDTH, ISP_TEST_HEIGHT);
+    RK_U32 i, j, k;
+    MPP_RET ret = MPP_OK;
+
+    for (i = 0; i < MPP_ARRAY_ELEMS(src_fmts) && !ret; i++) {
+        MppFrame src = test_frame_init(src_fmts[i].fmt, ISP_TEST_WIDTH, ISP_TEST_HEIGHT);
+
+        for (k = 0; k < MPP_ARRAY_ELEMS(test_uv) && !ret; k++) {
+            test_frame_fill(src, test_uv[k][0], test_uv[k][1]);
+
+            for (j = 0; j < MPP_ARRAY_ELEMS(dst_fmts) && !ret; j++) {
+                MppFrameFormat fmt = dst_fmts[j].fmt;
+                RK_S32 tol = (test_bpp(fmt) == 2) ? 8 : 1;
+                RK_U8 *p = NULL;
+                RK_S32 stride;
+                RK_S32 x, y;
+
+                mpp_frame_set_fmt(dst, fmt);
+                mpp_frame_set_hor_stride(dst, 0);
+                ret = mpi->isp(ctx, dst, src);
+                if (ret) {
+                    mpp_err("isp %s -> %s failed\n", src_fmts[i].name, dst_fmts[j].name);
+                    break;
+                }
+
+                p = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(dst));
+                stride = mpp_frame_get_hor_stride(dst);
+                for (y = 0; y < ISP_TEST_HEIGHT && !ret; y++) {
+                    for (x = 0; x < ISP_TEST_WIDTH; x++) {
+                        RK_S32 ref[3], out[3], c;
+
+                        test_ref_rgb((RK_U8)(x + y), test_uv[k][0], test_uv[k][1], ref);
+                        test_get_rgb(p + y * stride + x * test_bpp(fmt), fmt, out);
+                        for (c = 0; c < 3; c++) {
+                            if (abs(ref[c] - out[c]) > tol) {
+                                mpp_err("%s -> %s uv %d %d pos %d %d ch %d ref %d out %d\n",
+                                        src_fmts[i].name, dst_fmts[j].name,
+                                        test_uv[k][0], test_uv[k][1], x, y,
+                                        c, ref[c], out[c]);
+                                ret = MPP_NOK;
+                                break;
+                            }
+                        }
+                        if (ret)
+                            break;
+                    }
+                }
+            }
+        }
+        mpp_frame_deinit(&src);
+    }
+
+    mpp_frame_deinit(&dst);
+    mpp_log("convert test %s\n", ret ? "failed" : "passed");
+    return ret;
+}
+
+/* crop and 2x downscale of luma ramp in full range gray */
+static MPP_RET isp_test_scale(MppCtx ctx, MppApi *mpi)
+{
+    MppFrame src = test_frame_init(MPP_FMT_YUV420SP, ISP_TEST_WIDTH, ISP_TEST_HEIGHT);
+    MppFrame dst = test_frame_init(MPP_FMT_RGB888, ISP_TEST_WIDTH, ISP_TEST_HEIGHT);
+    MppIspConfig cfg;
+    RK_S32 mode;
+    MPP_RET ret = MPP_OK;
+
+    test_frame_fill(src, 128, 128);
+    mpp_frame_set_color_range(src, MPP_FRAME_RANGE_JPEG);
+
+    for (mode = 0; mode < MPP_ISP_SCALE_BUTT && !ret; mode++) {
+        RK_U8 *p = (RK_U8 *)mpp_buffer_get_ptr(mpp_frame_get_buffer(dst));
+        RK_S32 x, y;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.crop_x = 37;
+        cfg.crop_y = 5;
+        cfg.crop_w = 180;
+        cfg.crop_h = 30;
+        cfg.width  = 90;
+        cfg.height = 15;
+        cfg.format = MPP_FMT_RGB888;
+        cfg.scale_mode = mode;
+
+        ret = mpi->control(ctx, MPP_ISP_SET_CFG, &cfg);
+        if (ret)
+            break;
+
+        /* dst frame without size and format takes the config */
+        mpp_frame_set_fmt(dst, MPP_FMT_YUV420SP);
+        mpp_frame_set_width(dst, 0);
+        mpp_frame_set_height(dst, 0);
+        mpp_frame_set_hor_stride(dst, 0);
+        ret = mpi->isp(ctx, dst, src);
+        if (ret)
+            break;
+
+        if (mpp_frame_get_width(dst) != 90 || mpp_frame_get_height(dst) != 15 ||
+            mpp_frame_get_fmt(dst) != MPP_FMT_RGB888) {
+            mpp_err("invalid output frame %dx%d fmt %x\n",
+                    mpp_frame_get_width(dst), mpp_frame_get_height(dst),
+                    mpp_frame_get_fmt(dst));
+            ret = MPP_NOK;
+            break;
+        }
+
+        for (y = 0; y < 15 && !ret; y++) {
+            RK_U8 *row = p + y * mpp_frame_get_hor_stride(dst);
+
+            for (x = 0; x < 90; x++) {
+                /* average of source 2x2 block */
+                RK_S32 ref = (37 + 2 * x) + (5 + 2 * y) + 1;
+
+                if (abs(row[x * 3] - ref) > 1 ||
+                    row[x * 3] != row[x * 3 + 1] || row[x * 3] != row[x * 3 + 2]) {
+                    mpp_err("scale mode %d pos %d %d ref %d out %d %d %d\n",
+                            mode, x, y, ref, row[x * 3], row[x * 3 + 1], row[x * 3 + 2]);
+                    ret = MPP_NOK;
+                    break;
+                }
+            }
+        }
+    }
+
+    mpp_frame_deinit(&src);
+    mpp_frame_deinit(&dst);
+    mpp_log("scale test %s\n", ret ? "failed" : "passed");
+    return ret;
+}
+
+/* async interface keeps input order and frame info */
+static MPP_RET isp_test_async(MppCtx ctx, MppApi *mpi)
+{
+    MppFrame src = test_frame_init(MPP_FMT_YUV420SP, ISP_TEST_WIDTH, ISP_TEST_HEIGHT);
+    MppIspConfig cfg;
+    RK_S32 put = 0;
+    RK_S32 get = 0;
+    MPP_RET ret = MPP_OK;
+
+    test_frame_fill(src, 128, 128);
+
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.width  = ISP_TEST_WIDTH / 4;
+    cfg.height = ISP_TEST_HEIGHT / 4;
+    cfg.format = MPP_FMT_ARGB8888;
+    cfg.scale_mode = MPP_ISP_SCALE_AREA;
+    ret = mpi->control(ctx, MPP_ISP_SET_CFG, &cfg);
+
+    while (!ret && get < ISP_TEST_ASYNC_COUNT) {
+        MppFrame frame = NULL;
+
+        if (put < ISP_TEST_ASYNC_COUNT) {
+            mpp_frame_set_pts(src, put);
+            if (MPP_OK == mpi->isp_put_frame(ctx, src))
+                put++;
+        }
+
+        ret = mpi->isp_get_frame(ctx, &frame);
+        if (ret || NULL == frame)
+            continue;
+
+        if (mpp_frame_get_pts(frame) != get ||
+            mpp_frame_get_width(frame) != ISP_TEST_WIDTH / 4 ||
+            mpp_frame_get_fmt(frame) != MPP_FMT_ARGB8888 ||
+            mpp_frame_get_errinfo(frame)) {
+            mpp_err("invalid frame %d pts %lld width %d fmt %x\n", get,
+                    mpp_frame_get_pts(frame), mpp_frame_get_width(frame),
+                    mpp_frame_get_fmt(frame));
+            ret = MPP_NOK;
+        }
+        get++;
+        mpp_frame_deinit(&frame);
+    }
+
+    mpp_frame_deinit(&src);
+    mpp_log("async test %s\n", ret ? "failed" : "passed");
+    return ret;
+}
+
+/* 720p nv12 to half size argb throughput */
+static MPP_RET isp_test_bench(MppCtx ctx, MppApi *mpi)
+{
+    MppFrame src = test_frame_init(MPP_FMT_YUV420SP, 1280, 720);
+    MppFrame dst = test_frame_init(MPP_FMT_ARGB8888, 1280, 720);
+    RK_S32 mode;
+    MPP_RET ret = MPP_OK;
+
+    test_frame_fill(src, 90, 240);
+
+    for (mode = 0; mode < MPP_ISP_SCALE_BUTT && !ret; mode++) {
+        MppIspConfig cfg;
+        RK_S64 start;
+        RK_S32 i;
+
+        memset(&cfg, 0, sizeof(cfg));
+        cfg.format = MPP_FMT_ARGB8888;
+        cfg.scale_mode = mode;
+        ret = mpi->control(ctx, MPP_ISP_SET_CFG, &cfg);
+
+        mpp_frame_set_width(dst, 640);
+        mpp_frame_set_height(dst, 360);
+        mpp_frame_set_hor_stride(dst, 0);
+
+        start = mpp_time();
+        for (i = 0; i < ISP_TEST_BENCH_COUNT && !ret; i++)
+            ret = mpi->isp(ctx, dst, src);
+
+        mpp_log("1280x720 nv12 -> 640x360 argb mode %d: %lld us per frame\n",
+                mode, (mpp_time() - start) / ISP_TEST_BENCH_COUNT);
+    }
+
+    mpp_frame_deinit(&src);
+    mpp_frame_deinit(&dst);
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    MPP_RET ret;
+    MppCtx ctx  = NULL;
+    MppApi *mpi = NULL;
+    RK_S64 timeout = MPP_POLL_BLOCK;
+
+    (void)argc;
+    (void)argv;
+
+    mpp_log("mpi_isp_test start\n");
+
+    /* mpp_time works with timing debug for the benchmark */
+    mpp_env_set_u32("mpp_debug", MPP_DBG_TIMING);
+
+    ret = mpp_buffer_group_get_internal(&group, MPP_BUFFER_TYPE_ION);
+    if (ret) {
+        mpp_err("failed to get buffer group\n");
+        return ret;
+    }
+
+    ret = mpp_create(&ctx, &mpi);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_create failed\n");
+        goto MPP_TEST_OUT;
+    }
+
+    ret = mpp_init(ctx, MPP_CTX_ISP, MPP_VIDEO_CodingUnused);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_init failed\n");
+        goto MPP_TEST_OUT;
+    }
+
+    ret = mpi->control(ctx, MPP_SET_OUTPUT_TIMEOUT, &timeout);
+    if (MPP_OK != ret) {
+        mpp_err("mpi->control failed\n");
+        goto MPP_TEST_OUT;
+    }
+
+    ret = isp_test_convert(ctx, mpi);
+    if (MPP_OK == ret)
+        ret = isp_test_scale(ctx, mpi);
+    if (MPP_OK == ret)
+        ret = isp_test_async(ctx, mpi);
+    if (MPP_OK == ret)
+        ret = isp_test_bench(ctx, mpi);
+
+MPP_TEST_OUT:
+    if (ctx)
+        mpp_destroy(ctx);
+
+    mpp_buffer_group_put(group);
+
+    mpp_log("mpi_isp_test %s\n", ret ? "failed" : "success");
+    return ret;
+}
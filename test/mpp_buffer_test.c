@@ -23,6 +23,8 @@
 #endif
 #include "mpp_log.h"
 #include "mpp_env.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
 #include "mpp_buffer.h"
 #include "mpp_allocator.h"
 
@@ -30,6 +32,105 @@
 #define MPP_BUFFER_TEST_SIZE            (SZ_1K*4)
 #define MPP_BUFFER_TEST_COMMIT_COUNT    10
 #define MPP_BUFFER_TEST_NORMAL_COUNT    10
+#define MPP_BUFFER_TEST_THREAD_MAX      8
+#define MPP_BUFFER_TEST_LOOP_COUNT      100000
+
+typedef struct MppBufferTestCtx_t {
+    pthread_t           thread;
+    MppBufferGroup      group;
+    RK_S32              loop;
+    MPP_RET             ret;
+} MppBufferTestCtx;
+
+/*
+ * each thread works on its own group like one decoder / encoder instance
+ * get / inc_ref / put / put is the typical buffer traffic of one frame
+ */
+static void *mpp_buffer_test_thread(void *arg)
+{
+    MppBufferTestCtx *ctx = (MppBufferTestCtx *)arg;
+    MppBuffer buffer = NULL;
+    RK_S32 i;
+
+    for (i = 0; i < ctx->loop; i++) {
+        ctx->ret = mpp_buffer_get(ctx->group, &buffer, MPP_BUFFER_TEST_SIZE);
+        if (MPP_OK != ctx->ret)
+            break;
+
+        mpp_buffer_inc_ref(buffer);
+        mpp_buffer_put(buffer);
+        mpp_buffer_put(buffer);
+        buffer = NULL;
+    }
+
+    return NULL;
+}
+
+static MPP_RET mpp_buffer_test_contention()
+{
+    MPP_RET ret = MPP_OK;
+    MppBufferTestCtx ctxs[MPP_BUFFER_TEST_THREAD_MAX];
+    RK_S32 thread_count;
+    RK_S32 i;
+
+    mpp_debug |= MPP_DBG_TIMING;
+
+    for (thread_count = 1; thread_count <= MPP_BUFFER_TEST_THREAD_MAX; thread_count <<= 1) {
+        RK_S64 time_start;
+        RK_S64 time_end;
+
+        memset(ctxs, 0, sizeof(ctxs));
+
+        for (i = 0; i < thread_count; i++) {
+            ctxs[i].loop = MPP_BUFFER_TEST_LOOP_COUNT;
+            ret = mpp_buffer_group_get_internal(&ctxs[i].group, MPP_BUFFER_TYPE_NORMAL);
+            if (MPP_OK != ret) {
+                mpp_err("mpp_buffer_test contention group get failed\n");
+                goto CONTENTION_failed;
+            }
+        }
+
+        time_start = mpp_time();
+
+        for (i = 0; i < thread_count; i++)
+            pthread_create(&ctxs[i].thread, NULL, mpp_buffer_test_thread, &ctxs[i]);
+
+        for (i = 0; i < thread_count; i++)
+            pthread_join(ctxs[i].thread, NULL);
+
+        time_end = mpp_time();
+
+        for (i = 0; i < thread_count; i++) {
+            if (MPP_OK != ctxs[i].ret)
+                ret = ctxs[i].ret;
+
+            mpp_buffer_group_put(ctxs[i].group);
+            ctxs[i].group = NULL;
+        }
+
+        if (MPP_OK != ret) {
+            mpp_err("mpp_buffer_test contention loop failed\n");
+            break;
+        }
+
+        mpp_log("mpp_buffer_test contention threads %d loops %d cost %lld us %.2f ops/us\n",
+                thread_count, MPP_BUFFER_TEST_LOOP_COUNT, time_end - time_start,
+                (double)thread_count * MPP_BUFFER_TEST_LOOP_COUNT * 4 /
+                (double)((time_end > time_start) ? (time_end - time_start) : 1));
+    }
+
+    mpp_debug &= ~MPP_DBG_TIMING;
+    return ret;
+
+CONTENTION_failed:
+    for (i = 0; i < thread_count; i++) {
+        if (ctxs[i].group)
+            mpp_buffer_group_put(ctxs[i].group);
+    }
+
+    mpp_debug &= ~MPP_DBG_TIMING;
+    return ret;
+}
 
 int main()
 {
@@ -225,6 +326,21 @@ int main()
         }
     }
 
+    /* unused buffers are 1K to 10K now and the best fit should be returned */
+    ret = mpp_buffer_get(group, &normal_buffer[0], SZ_1K * 5 + 1);
+    if (MPP_OK != ret || mpp_buffer_get_size(normal_buffer[0]) != SZ_1K * 6) {
+        mpp_err("mpp_buffer_test mpp_buffer_get best fit failed\n");
+        ret = MPP_NOK;
+        goto MPP_BUFFER_failed;
+    }
+
+    ret = mpp_buffer_put(normal_buffer[0]);
+    normal_buffer[0] = NULL;
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test mpp_buffer_put best fit failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
     mpp_log("mpp_buffer_test normal mode success\n");
 
     if (group) {
@@ -245,9 +361,21 @@ int main()
         mpp_log("mpp_buffer_test mpp_buffer_put legacy buffer failed\n");
         goto MPP_BUFFER_failed;
     }
+    legacy_buffer = NULL;
 
     mpp_env_set_u32("mpp_buffer_debug", 0);
 
+    /* buffer debug log is disabled here to measure the lock contention only */
+    mpp_log("mpp_buffer_test contention start\n");
+
+    ret = mpp_buffer_test_contention();
+    if (MPP_OK != ret) {
+        mpp_err("mpp_buffer_test contention failed\n");
+        goto MPP_BUFFER_failed;
+    }
+
+    mpp_log("mpp_buffer_test contention success\n");
+
     return ret;
 
 MPP_BUFFER_failed:
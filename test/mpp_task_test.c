@@ -0,0 +1,147 @@
+/*
+ * Copyright 2015 Rockchip Electronics Co. LTD
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define MODULE_TAG "mpp_task_test"
+
+#include <string.h>
+
+#include "mpp_log.h"
+#include "mpp_time.h"
+#include "mpp_thread.h"
+#include "mpp_task.h"
+
+#define MPP_TASK_TEST_TASK_COUNT    4
+#define MPP_TASK_TEST_LOOP_COUNT    200000
+
+typedef struct MppTaskTestCtx_t {
+    MppTaskQueue    queue;
+    RK_S32          loop;
+    MPP_RET         ret;
+} MppTaskTestCtx;
+
+/*
+ * worker side works like mpp_dec / mpp_enc thread on the output port
+ */
+static void *mpp_task_test_worker(void *arg)
+{
+    MppTaskTestCtx *ctx = (MppTaskTestCtx *)arg;
+    MppPort port = mpp_task_queue_get_port(ctx->queue, MPP_PORT_OUTPUT);
+    MppTask task = NULL;
+    RK_S32 i;
+
+    for (i = 0; i < ctx->loop; i++) {
+        ctx->ret = mpp_port_poll(port, MPP_POLL_BLOCK);
+        if (ctx->ret)
+            break;
+
+        mpp_port_dequeue(port, &task);
+        if (NULL == task) {
+            ctx->ret = MPP_NOK;
+            break;
+        }
+
+        mpp_port_enqueue(port, task);
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    MPP_RET ret = MPP_NOK;
+    MppTaskTestCtx ctx;
+    MppPort port = NULL;
+    MppTask task = NULL;
+    pthread_t thread;
+    RK_S64 time_start;
+    RK_S64 time_end;
+    RK_S32 i;
+
+    mpp_log("mpp_task_test start\n");
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.loop = MPP_TASK_TEST_LOOP_COUNT;
+
+    ret = mpp_task_queue_init(&ctx.queue);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_task_test mpp_task_queue_init failed\n");
+        goto MPP_TASK_failed;
+    }
+
+    ret = mpp_task_queue_setup(ctx.queue, MPP_TASK_TEST_TASK_COUNT);
+    if (MPP_OK != ret) {
+        mpp_err("mpp_task_test mpp_task_queue_setup failed\n");
+        goto MPP_TASK_failed;
+    }
+
+    port = mpp_task_queue_get_port(ctx.queue, MPP_PORT_INPUT);
+
+    mpp_debug |= MPP_DBG_TIMING;
+    time_start = mpp_time();
+
+    pthread_create(&thread, NULL, mpp_task_test_worker, &ctx);
+
+    /* user side: dequeue idle task from input port and send it to worker */
+    for (i = 0; i < MPP_TASK_TEST_LOOP_COUNT; i++) {
+        ret = mpp_port_poll(port, MPP_POLL_BLOCK);
+        if (ret)
+            break;
+
+        mpp_port_dequeue(port, &task);
+        if (NULL == task) {
+            ret = MPP_NOK;
+            break;
+        }
+
+        mpp_port_enqueue(port, task);
+    }
+
+    pthread_join(thread, NULL);
+    time_end = mpp_time();
+    mpp_debug &= ~MPP_DBG_TIMING;
+
+    if (MPP_OK != ret || MPP_OK != ctx.ret) {
+        mpp_err("mpp_task_test task loop failed\n");
+        ret = MPP_NOK;
+        goto MPP_TASK_failed;
+    }
+
+    /* all task should return to input port, hold status is fine for deinit */
+    for (i = 0; i < MPP_TASK_TEST_TASK_COUNT; i++) {
+        mpp_port_dequeue(port, &task);
+        if (NULL == task) {
+            mpp_err("mpp_task_test task %d is lost\n", i);
+            ret = MPP_NOK;
+            goto MPP_TASK_failed;
+        }
+    }
+
+    mpp_log("mpp_task_test %d round trips cost %lld us %.0f round trips/s\n",
+            MPP_TASK_TEST_LOOP_COUNT, time_end - time_start,
+            (double)MPP_TASK_TEST_LOOP_COUNT * 1000000 /
+            (double)((time_end > time_start) ? (time_end - time_start) : 1));
+
+    mpp_task_queue_deinit(ctx.queue);
+    mpp_log("mpp_task_test success\n");
+    return MPP_OK;
+
+MPP_TASK_failed:
+    if (ctx.queue)
+        mpp_task_queue_deinit(ctx.queue);
+
+    mpp_log("mpp_task_test failed\n");
+    return ret;
+}